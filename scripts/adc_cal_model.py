@@ -0,0 +1,146 @@
+#!/usr/bin/env python3
+"""Host harness for the ADC calibration curve builder (src/adc/adc_cal_curve.h).
+
+Compiles adc_cal_curve_build() and adc_cal_mv() with the host C++ compiler
+and feeds them synthetic eFuse characteristic sets (a raw -> mV table for
+all 4096 codes). For every set it checks that the interpolated curve stays
+within the error bound of the characteristic it was sampled from, at every
+raw code, and that the builder's own max_err_mv (logged at boot) matches
+that error. Exits non-zero if any set fails.
+
+Families (shapes of the IDF raw -> mV conversions):
+  line    line fitting (ESP32 two-point / Vref): mV = a * raw + b
+  bend    line fitting plus the ESP32 12 dB compression near full scale
+  curve   curve fitting (ESP32-S3/C3): line plus a 4th-order error polynomial
+
+    python3 scripts/adc_cal_model.py [--sets N] [--bound MV]
+"""
+
+import argparse
+import os
+import random
+import subprocess
+import sys
+import tempfile
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+HARNESS = r"""
+#include <cstdio>
+#include "adc/adc_cal_curve.h"
+
+// Input: sets of 4096 millivolt values (raw 0..4095). Output per set:
+// "<max_err_mv from the builder> <worst error at any raw code>".
+int main() {
+  static uint16_t table[4096];
+  printf("%u %u\n", static_cast<unsigned>(kAdcCalKnots), static_cast<unsigned>(sizeof(AdcCalCurve::mv)));
+  for (;;) {
+    for (int raw = 0; raw < 4096; ++raw) {
+      unsigned v;
+      if (scanf("%u", &v) != 1) {
+        return 0;
+      }
+      table[raw] = static_cast<uint16_t>(v);
+    }
+    AdcCalCurve curve;
+    adc_cal_curve_build(curve, [](uint16_t raw) { return table[raw]; });
+    int worst = 0;
+    for (int raw = 0; raw < 4096; ++raw) {
+      const int err = int(adc_cal_mv(curve, static_cast<uint16_t>(raw << kAdcFracBits))) - int(table[raw]);
+      worst = err < 0 ? (-err > worst ? -err : worst) : (err > worst ? err : worst);
+    }
+    printf("%u %d\n", static_cast<unsigned>(curve.max_err_mv), worst);
+  }
+}
+"""
+
+
+def clamp_u16(v):
+    return max(0, min(0xFFFF, v))
+
+
+def line_set(rng):
+    gain = rng.uniform(0.72, 0.92)  # mV per count at 12 dB
+    offset = rng.uniform(60.0, 160.0)
+    return lambda raw: clamp_u16(int(round(gain * raw + offset)))
+
+
+def bend_set(rng):
+    gain = rng.uniform(0.72, 0.92)
+    offset = rng.uniform(60.0, 160.0)
+    knee = rng.uniform(3000.0, 3700.0)
+    extra = rng.uniform(0.2, 0.6)  # extra mV per count above the knee
+
+    def f(raw):
+        v = gain * raw + offset
+        if raw > knee:
+            v += extra * (raw - knee) ** 2 / (4095 - knee)
+        return clamp_u16(int(round(v)))
+    return f
+
+
+def curve_set(rng):
+    gain = rng.uniform(0.72, 0.92)
+    offset = rng.uniform(20.0, 80.0)
+    coeffs = [rng.uniform(-15.0, 15.0) for _ in range(5)]  # mV at x^0..x^4
+
+    def f(raw):
+        x = raw / 4095.0
+        err = sum(c * x ** k for k, c in enumerate(coeffs))
+        return clamp_u16(int(round(gain * raw + offset + err)))
+    return f
+
+
+FAMILIES = (("line", line_set), ("bend", bend_set), ("curve", curve_set))
+
+
+def main():
+    p = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    p.add_argument("--sets", type=int, default=200, help="sets per family (default 200)")
+    p.add_argument("--bound", type=int, default=2, help="max error in mV (default 2)")
+    p.add_argument("--seed", type=int, default=1)
+    args = p.parse_args()
+
+    rng = random.Random(args.seed)
+    data = []
+    for _, make in FAMILIES:
+        for _ in range(args.sets):
+            f = make(rng)
+            data.append(" ".join(str(f(raw)) for raw in range(4096)) + "\n")
+
+    with tempfile.TemporaryDirectory() as build_dir:
+        src = os.path.join(build_dir, "harness.cpp")
+        exe = os.path.join(build_dir, "adc_cal")
+        with open(src, "w") as f:
+            f.write(HARNESS)
+        try:
+            subprocess.run([os.environ.get("CXX", "g++"), "-std=gnu++11", "-O2", "-I", os.path.join(ROOT, "src"),
+                            src, "-o", exe], check=True)
+            res = subprocess.run([exe], input="".join(data), capture_output=True, check=True, text=True)
+        except (OSError, subprocess.CalledProcessError) as e:
+            sys.exit(f"build or run failed: {e}")
+
+    lines = res.stdout.splitlines()
+    knots, size = (int(v) for v in lines[0].split())
+    results = [tuple(int(v) for v in line.split()) for line in lines[1:]]
+    if len(results) != len(data):
+        sys.exit(f"harness returned {len(results)} of {len(data)} sets")
+    print(f"{knots} knots ({4096 // (knots - 1)}-count spacing), {size} bytes; bound {args.bound} mV")
+    failed = 0
+    for fi, (name, _) in enumerate(FAMILIES):
+        rows = results[fi * args.sets:(fi + 1) * args.sets]
+        errors = [worst for _, worst in rows]
+        bad = sum(1 for e in errors if e > args.bound)
+        mismatch = sum(1 for reported, worst in rows if reported != worst)
+        failed += bad + mismatch
+        print(f"{name:>6}: {args.sets} sets, max error {max(errors)} mV, "
+              f"mean {sum(errors) / len(errors):.2f} mV, {bad} over bound, "
+              f"{mismatch} with a wrong max_err_mv")
+    if failed:
+        print(f"FAIL: {failed} sets over {args.bound} mV or misreported")
+        sys.exit(1)
+    print("OK")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,151 @@
+#!/usr/bin/env python3
+"""Host harness for the ADC oversampling decimator (src/adc/adc_filter.h).
+
+Compiles AdcDecimator<N> with the host C++ compiler for a few decimation
+factors, feeds it a noisy 12-bit signal and prints the noise reduction, the
+bias and the latency of the filter the firmware uses. The latency is
+measured too: a step is applied at every phase of the block, and "settled"
+is the worst time until value() is within half an LSB of the new level.
+
+    python3 scripts/adc_filter_model.py [--noise LSB] [--service-hz HZ]
+"""
+
+import argparse
+import math
+import os
+import random
+import statistics
+import subprocess
+import sys
+import tempfile
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+FRAC_BITS = 4  # kAdcFracBits
+FACTORS = (1, 4, 16, 64, 256)
+
+HARNESS = r"""
+#include <cstdio>
+#include <cstdlib>
+#include "adc/adc_filter.h"
+
+// Noise: raw samples on stdin, one raw16 line per completed block.
+template <uint16_t N>
+static void noise() {
+  AdcDecimator<N> f;
+  unsigned raw;
+  while (scanf("%u", &raw) == 1) {
+    if (f.push(static_cast<uint16_t>(raw))) {
+      printf("%u\n", f.value());
+    }
+  }
+}
+
+// Step from 1000 to 3000 LSB at every phase of the block; prints the worst
+// number of samples until value() is within half an LSB of 3000.
+template <uint16_t N>
+static void step() {
+  unsigned worst = 0;
+  for (unsigned phase = 0; phase < N; ++phase) {
+    AdcDecimator<N> f;
+    for (unsigned i = 0; i < 4u * N + phase; ++i) {
+      f.push(1000);
+    }
+    unsigned n = 0;
+    do {
+      f.push(3000);
+      ++n;
+    } while (abs(int(f.value()) - (3000 << kAdcFracBits)) > (1 << kAdcFracBits) / 2);
+    worst = n > worst ? n : worst;
+  }
+  printf("%u\n", worst);
+}
+
+template <uint16_t N>
+static int run(bool is_step) {
+  if (is_step) {
+    step<N>();
+  } else {
+    noise<N>();
+  }
+  return 0;
+}
+
+// Usage: adc_filter <N> <noise|step>
+int main(int argc, char **argv) {
+  if (argc < 3) {
+    return 1;
+  }
+  const bool is_step = argv[2][0] == 's';
+  switch (atoi(argv[1])) {
+    case 1: return run<1>(is_step);
+    case 4: return run<4>(is_step);
+    case 16: return run<16>(is_step);
+    case 64: return run<64>(is_step);
+    case 256: return run<256>(is_step);
+    default: return 1;
+  }
+}
+"""
+
+
+def adc_samples(level, noise_lsb, count, rng):
+    for _ in range(count):
+        raw = int(round(level + rng.gauss(0.0, noise_lsb)))
+        yield min(max(raw, 0), 4095)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--noise", type=float, default=6.0,
+                        help="ADC noise, LSB rms (default 6)")
+    parser.add_argument("--service-hz", type=float, default=100.0,
+                        help="input samples per second per pin (default 100: "
+                             "one per 10 ms sensor-task pass)")
+    parser.add_argument("--level", type=float, default=2047.3,
+                        help="true input level, LSB (default 2047.3)")
+    parser.add_argument("--outputs", type=int, default=4000,
+                        help="decimated outputs per factor (default 4000)")
+    args = parser.parse_args()
+
+    rng = random.Random(1)
+    raw = list(adc_samples(args.level, args.noise, args.outputs, rng))
+    in_rms = statistics.pstdev(raw)
+    print(f"input: level={args.level} LSB, noise={in_rms:.2f} LSB rms, "
+          f"{args.service_hz:g} samples/s")
+    print(f"{'N':>5} {'out rms':>9} {'ratio':>7} {'1/sqrt(N)':>9} "
+          f"{'bias':>7} {'period':>9} {'delay':>9} {'settled':>9}")
+
+    with tempfile.TemporaryDirectory() as build_dir:
+        src = os.path.join(build_dir, "harness.cpp")
+        exe = os.path.join(build_dir, "adc_filter")
+        with open(src, "w") as f:
+            f.write(HARNESS)
+        try:
+            subprocess.run([os.environ.get("CXX", "g++"), "-std=gnu++11", "-O2", "-I", os.path.join(ROOT, "src"),
+                            src, "-o", exe], check=True)
+        except (OSError, subprocess.CalledProcessError) as e:
+            sys.exit(f"build failed: {e}")
+        for n in FACTORS:
+            samples = adc_samples(args.level, args.noise, n * args.outputs, rng)
+            try:
+                res = subprocess.run([exe, str(n), "noise"], input=" ".join(str(s) for s in samples),
+                                     capture_output=True, check=True, text=True)
+                settle = subprocess.run([exe, str(n), "step"], capture_output=True, check=True, text=True)
+            except (OSError, subprocess.CalledProcessError) as e:
+                sys.exit(f"run failed: {e}")
+            out = [int(v) / (1 << FRAC_BITS) for v in res.stdout.split()]
+            out_rms = statistics.pstdev(out)
+            bias = statistics.fmean(out) - args.level
+            period_ms = 1000.0 * n / args.service_hz
+            delay_ms = 1000.0 * (n - 1) / 2.0 / args.service_hz
+            settle_ms = 1000.0 * int(settle.stdout) / args.service_hz
+            print(f"{n:>5} {out_rms:>9.3f} {out_rms / in_rms:>7.3f} "
+                  f"{1 / math.sqrt(n):>9.3f} {bias:>+7.3f} "
+                  f"{period_ms:>7.0f}ms {delay_ms:>7.0f}ms {settle_ms:>7.0f}ms")
+    print("period: time between filtered values; delay: group delay of the "
+          "boxcar ((N-1)/2 input samples); settled: worst time from a step "
+          "until the reading shows it, measured.")
+
+
+if __name__ == "__main__":
+    main()
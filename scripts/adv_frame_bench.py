@@ -0,0 +1,287 @@
+#!/usr/bin/env python3
+"""Host check and benchmark for the advertising data update (src/ble/adv_frame.h).
+
+Compiles the firmware headers with the host C++ compiler, with a global
+operator new that counts allocations, and runs one advertising update per
+simulated tick on two paths:
+
+  rebuild  the ADV_RAW_FRAME=0 path: MAC string parsed, payload copied into
+           a std::string, advertising and scan response data assembled AD by
+           AD as NimBLEAdvertisementData does, then copied out
+  raw      the ADV_RAW_FRAME=1 path: buffers laid out once, the Ruuvi
+           payload and battery percent patched in place, then copied out
+
+The copy out stands in for ble_gap_adv_set_data(), which copies the bytes
+into the host. Both paths must give the same bytes on every tick, and the
+raw path must not allocate after setup. Exits non-zero otherwise.
+
+Host timings only compare the two paths; on the device the [ADV] debug line
+reports the update cycles (upd=...cyc) of the running build.
+
+    python3 scripts/adv_frame_bench.py [--ticks 2000000]
+"""
+
+import argparse
+import os
+import subprocess
+import sys
+import tempfile
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+HARNESS = r"""
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#endif
+#include "ble/adv_frame.h"
+#include "ruuvi/ruuvi_encoder.h"
+
+static unsigned long g_allocs = 0;
+
+void *operator new(size_t n) {
+  ++g_allocs;
+  void *p = malloc(n ? n : 1);
+  if (p == nullptr) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+void *operator new[](size_t n) {
+  return operator new(n);
+}
+void operator delete(void *p) noexcept {
+  free(p);
+}
+void operator delete[](void *p) noexcept {
+  free(p);
+}
+void operator delete(void *p, size_t) noexcept {
+  free(p);
+}
+void operator delete[](void *p, size_t) noexcept {
+  free(p);
+}
+
+using Format = RuuviFormatDf5;
+static const uint16_t kCompanyId = 0x0499;
+static const char kName[] = "Ruuvi-ESP32 1.0.0";
+static const uint8_t kMac[6] = {0xD4, 0x12, 0x34, 0x56, 0x78, 0x9A};
+
+// What the host copies per update.
+struct HostCopy {
+  uint8_t adv[kExtAdvMaxLen];
+  uint8_t adv_len;
+  uint8_t sr[kAdvMaxLen];
+  uint8_t sr_len;
+};
+
+static uint8_t battery_pct(uint16_t mv) {
+  return mv <= 3000 ? 0 : mv >= 4200 ? 100 : static_cast<uint8_t>(((mv - 3000) * 100) / 1200);
+}
+
+static SensorSample sample_at(uint32_t i) {
+  SensorSample s = {};
+  s.temperature_cdeg = static_cast<int16_t>(2150 + (i % 97) - 48);
+  s.humidity_df5 = static_cast<uint16_t>(18000 + (i % 301));
+  s.pressure_pa = 101325 + (i % 51);
+  s.battery_mv = static_cast<uint16_t>(3000 + (i % 1300));
+  s.tx_power_dbm = 3;
+  s.accel_x_mg = static_cast<int16_t>(i % 17);
+  s.accel_y_mg = -12;
+  s.accel_z_mg = 1003;
+  s.caps = kSensorCapEnvironment | kSensorCapAccel;
+  return s;
+}
+
+// --- rebuild path (as main.cpp with ADV_RAW_FRAME=0) ---
+
+static std::string mac_to_string() {  // NimBLEAddress::toString()
+  char buf[18];
+  snprintf(buf, sizeof(buf), "%02x:%02x:%02x:%02x:%02x:%02x", kMac[0], kMac[1], kMac[2], kMac[3], kMac[4],
+           kMac[5]);
+  return std::string(buf);
+}
+
+static std::array<uint8_t, 6> parse_mac(const std::string &mac_str) {
+  std::array<uint8_t, 6> mac = {{0}};
+  size_t idx = 0;
+  for (int i = 0; i < 6 && idx + 1 < mac_str.size(); ++i) {
+    mac[i] = static_cast<uint8_t>(strtoul(mac_str.substr(idx, 2).c_str(), nullptr, 16));
+    idx += 3;
+  }
+  return mac;
+}
+
+// NimBLEAdvertisementData: one std::string, each AD appended as built.
+struct AdvData {
+  std::string payload;
+  void addAd(uint8_t type, const std::string &data) {
+    std::string cdata;
+    cdata += static_cast<char>(data.length() + 1);
+    cdata += static_cast<char>(type);
+    cdata += data;
+    payload += cdata;
+  }
+};
+
+static void update_rebuild(const SensorSample &s, const RuuviCounters &c, HostCopy &out) {
+  const std::array<uint8_t, 6> mac = parse_mac(mac_to_string());
+  std::array<uint8_t, Format::kLen> payload{};
+  ruuvi_encode<Format>(payload.data(), s, c);
+  ruuvi_write_mac<Format>(payload.data(), mac.data());
+  std::array<uint8_t, Format::kLen + 2> mfg{};
+  mfg[0] = kCompanyId & 0xFF;
+  mfg[1] = (kCompanyId >> 8) & 0xFF;
+  memcpy(mfg.data() + 2, payload.data(), payload.size());
+
+  AdvData adv;
+  adv.addAd(kAdTypeFlags, std::string(1, static_cast<char>(kAdFlagsGeneralNoBrEdr)));
+  adv.addAd(kAdTypeManufacturer, std::string(reinterpret_cast<char *>(mfg.data()), mfg.size()));
+  AdvData sr;
+  sr.addAd(kAdTypeCompleteName, std::string(kName));
+  std::string svc;
+  svc += static_cast<char>(kBatteryServiceUuid & 0xFF);
+  svc += static_cast<char>(kBatteryServiceUuid >> 8);
+  svc += static_cast<char>(battery_pct(s.battery_mv));
+  sr.addAd(kAdTypeServiceData16, svc);
+
+  out.adv_len = static_cast<uint8_t>(adv.payload.size());
+  memcpy(out.adv, adv.payload.data(), out.adv_len);
+  out.sr_len = static_cast<uint8_t>(sr.payload.size());
+  memcpy(out.sr, sr.payload.data(), out.sr_len);
+}
+
+// --- raw path (as main.cpp with ADV_RAW_FRAME=1) ---
+
+static void update_raw(AdvFrame &f, const SensorSample &s, const RuuviCounters &c, HostCopy &out) {
+  ruuvi_encode<Format>(adv_frame_payload(f), s, c);
+  adv_frame_set_battery_pct(f, battery_pct(s.battery_mv));
+  out.adv_len = f.adv_len;
+  memcpy(out.adv, f.adv, f.adv_len);
+  out.sr_len = f.sr_len;
+  memcpy(out.sr, f.sr, f.sr_len);
+}
+
+static bool same(const HostCopy &a, const HostCopy &b) {
+  return a.adv_len == b.adv_len && a.sr_len == b.sr_len && memcmp(a.adv, b.adv, a.adv_len) == 0 &&
+         memcmp(a.sr, b.sr, a.sr_len) == 0;
+}
+
+struct Result {
+  double ns;
+  double cycles;
+  double allocs;
+};
+
+template <typename F>
+static Result timed(uint32_t ticks, F update) {
+  const unsigned long a0 = g_allocs;
+  const auto t0 = std::chrono::steady_clock::now();
+#ifdef HAVE_TSC
+  const unsigned long long c0 = __rdtsc();
+#endif
+  for (uint32_t i = 0; i < ticks; ++i) {
+    update(i);
+  }
+#ifdef HAVE_TSC
+  const double cycles = static_cast<double>(__rdtsc() - c0) / ticks;
+#else
+  const double cycles = 0;
+#endif
+  const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+  return Result{ns / ticks, cycles, static_cast<double>(g_allocs - a0) / ticks};
+}
+
+int main(int argc, char **argv) {
+  const uint32_t ticks = argc > 1 ? static_cast<uint32_t>(strtoul(argv[1], nullptr, 10)) : 2000000;
+  AdvFrame f;
+  if (!adv_frame_build(f, kCompanyId, Format::kLen, kName)) {
+    printf("FAIL adv_frame_build\n");
+    return 1;
+  }
+  ruuvi_write_mac<Format>(adv_frame_payload(f), kMac);
+
+  // Byte-for-byte agreement, and allocations per update counted on their own.
+  unsigned long raw_allocs = 0;
+  unsigned long mismatches = 0;
+  for (uint32_t i = 0; i < 10000; ++i) {
+    const SensorSample s = sample_at(i);
+    const RuuviCounters c = {static_cast<uint8_t>(i / 7), i};
+    HostCopy a;
+    HostCopy b;
+    update_rebuild(s, c, a);
+    const unsigned long before = g_allocs;
+    update_raw(f, s, c, b);
+    raw_allocs += g_allocs - before;
+    if (!same(a, b)) {
+      ++mismatches;
+    }
+  }
+
+  static volatile uint8_t sink;
+  HostCopy out;
+  const Result rebuild = timed(ticks, [&](uint32_t i) {
+    const RuuviCounters c = {0, i};
+    update_rebuild(sample_at(i), c, out);
+    sink = out.adv[9];
+  });
+  const Result raw = timed(ticks, [&](uint32_t i) {
+    const RuuviCounters c = {0, i};
+    update_raw(f, sample_at(i), c, out);
+    sink = out.adv[9];
+  });
+  printf("%lu %lu\n", raw_allocs, mismatches);
+  printf("rebuild %.3f %.1f %.1f\n", rebuild.allocs, rebuild.ns, rebuild.cycles);
+  printf("raw %.3f %.1f %.1f\n", raw.allocs, raw.ns, raw.cycles);
+  return 0;
+}
+"""
+
+
+def main():
+    p = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    p.add_argument("--ticks", type=int, default=2000000, help="updates timed per path")
+    args = p.parse_args()
+
+    with tempfile.TemporaryDirectory() as build_dir:
+        src = os.path.join(build_dir, "harness.cpp")
+        exe = os.path.join(build_dir, "adv_frame")
+        with open(src, "w") as f:
+            f.write(HARNESS)
+        try:
+            subprocess.run([os.environ.get("CXX", "g++"), "-std=gnu++11", "-O2", "-I", os.path.join(ROOT, "src"),
+                            src, "-o", exe], check=True)
+            res = subprocess.run([exe, str(args.ticks)], capture_output=True, check=True, text=True)
+        except (OSError, subprocess.CalledProcessError) as e:
+            sys.exit(f"build or run failed: {e}")
+
+    lines = res.stdout.splitlines()
+    raw_allocs, mismatches = (int(v) for v in lines[0].split())
+    print(f"{args.ticks} updates per path, DF5 payload, legacy layout")
+    print(f"{'path':>8} {'allocs/upd':>10} {'ns/upd':>8} {'cyc/upd':>8}")
+    for line in lines[1:]:
+        name, allocs, ns, cycles = line.split()
+        cyc = f"{float(cycles):8.1f}" if float(cycles) else "       -"
+        print(f"{name:>8} {float(allocs):10.3f} {float(ns):8.1f} {cyc}")
+
+    failed = False
+    if raw_allocs:
+        print(f"FAIL: raw path allocated {raw_allocs} times in 10000 updates")
+        failed = True
+    if mismatches:
+        print(f"FAIL: {mismatches} of 10000 updates differ between the paths")
+        failed = True
+    if not failed:
+        print("raw path: 0 allocations per update, bytes identical to the rebuild path")
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == "__main__":
+    main()
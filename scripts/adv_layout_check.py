@@ -0,0 +1,208 @@
+#!/usr/bin/env python3
+"""Layout check for the advertising buffers (src/ble/adv_frame.h).
+
+Compiles the frame builders on the host and lays out frames for every
+Ruuvi payload size, with device names from 0 to 120 characters:
+
+  legacy    adv_frame_build(): flags + manufacturer data in the advertising
+            data, name + battery service data in the scan response; each
+            must fit the 31-byte legacy PDU, E1 (40 bytes) must be refused
+  extended  adv_frame_build_extended(): all four ADs in one advertising
+            PDU within kExtAdvMaxLen, no scan response
+
+The buffers are parsed as AD structures by the code below, which does not
+use the firmware's offsets. The payload and battery percent are written
+through adv_frame_payload() and adv_frame_set_battery_pct() and must land
+in the manufacturer data and the battery service data. A name that does not
+fit must go out cut down as a shortened name (0x08), and one that fits as
+the complete name (0x09). The 20-character name in the firmware,
+"Ruuvi-ESP32 " plus an 8-character version, must go out complete.
+
+Exits non-zero if any layout fails.
+
+    python3 scripts/adv_layout_check.py
+"""
+
+import os
+import subprocess
+import sys
+import tempfile
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+HARNESS = r"""
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include "ble/adv_frame.h"
+
+static void hex(const uint8_t *b, uint8_t n) {
+  if (n == 0) {
+    printf("-");
+  }
+  for (uint8_t i = 0; i < n; ++i) {
+    printf("%02x", b[i]);
+  }
+}
+
+// Input lines: "<legacy|extended> <payload_len> <name length>".
+int main() {
+  char mode[16];
+  unsigned payload_len;
+  unsigned name_len;
+  while (scanf("%15s %u %u", mode, &payload_len, &name_len) == 3) {
+    std::string name;
+    for (unsigned i = 0; i < name_len; ++i) {
+      name += static_cast<char>('A' + i % 26);
+    }
+    AdvFrame f;
+    memset(&f, 0xEE, sizeof(f));
+    const bool ext = mode[0] == 'e';
+    const bool ok = ext ? adv_frame_build_extended(f, 0x0499, static_cast<uint8_t>(payload_len), name.c_str())
+                        : adv_frame_build(f, 0x0499, static_cast<uint8_t>(payload_len), name.c_str());
+    if (!ok) {
+      printf("refused\n");
+      continue;
+    }
+    uint8_t *p = adv_frame_payload(f);
+    for (unsigned i = 0; i < payload_len; ++i) {
+      p[i] = static_cast<uint8_t>(0xA0 + i);
+    }
+    adv_frame_set_battery_pct(f, 77);
+    printf("%d ", f.extended ? 1 : 0);
+    hex(f.adv, f.adv_len);
+    printf(" ");
+    hex(f.sr, f.sr_len);
+    printf("\n");
+  }
+  return 0;
+}
+"""
+
+COMPANY_ID = b"\x99\x04"
+LEGACY_MAX = 31
+EXT_MAX = 96  # kExtAdvMaxLen
+FORMATS = (("DF3", 14), ("C5", 12), ("DF5", 24), ("E1", 40))
+FIRMWARE_NAME_LEN = len("Ruuvi-ESP32 v3.31.1a")  # "Ruuvi-ESP32 " FW_VERSION_STR
+
+
+def parse_ads(b):
+    """[(type, data)] or None if the lengths do not add up."""
+    ads, i = [], 0
+    while i < len(b):
+        n = b[i]
+        if n == 0 or i + 1 + n > len(b):
+            return None
+        ads.append((b[i + 1], bytes(b[i + 2:i + 1 + n])))
+        i += 1 + n
+    return ads
+
+
+def expected_name(name_len):
+    return "".join(chr(ord("A") + i % 26) for i in range(name_len)).encode()
+
+
+def check(mode, payload_len, name_len, out):
+    """Error string, or None if the layout is right."""
+    legacy = mode == "legacy"
+    must_refuse = legacy and 3 + 4 + payload_len > LEGACY_MAX
+    if out == "refused":
+        return None if must_refuse else "refused"
+    if must_refuse:
+        return f"accepted a {payload_len}-byte payload"
+    ext, adv_hex, sr_hex = out.split()
+    adv = bytes.fromhex(adv_hex) if adv_hex != "-" else b""
+    sr = bytes.fromhex(sr_hex) if sr_hex != "-" else b""
+    if ext != ("0" if legacy else "1"):
+        return "extended flag"
+    if legacy and (len(adv) > LEGACY_MAX or len(sr) > LEGACY_MAX):
+        return f"legacy lengths adv={len(adv)} sr={len(sr)}"
+    if not legacy and (len(adv) > EXT_MAX or sr):
+        return f"extended lengths adv={len(adv)} sr={len(sr)}"
+
+    adv_ads = parse_ads(adv)
+    name_ads = parse_ads(sr if legacy else adv)
+    if adv_ads is None or name_ads is None:
+        return "AD lengths do not add up"
+    if len(adv_ads) < 2 or adv_ads[0] != (0x01, b"\x06"):
+        return "flags AD"
+    mtype, mdata = adv_ads[1]
+    if mtype != 0xFF or mdata != COMPANY_ID + bytes(0xA0 + i for i in range(payload_len)):
+        return "manufacturer AD"
+    if legacy and len(adv_ads) != 2:
+        return "extra ADs in the advertising data"
+    if not legacy:
+        name_ads = adv_ads[2:]
+
+    if not name_ads or name_ads[-1] != (0x16, b"\x0f\x18" + bytes([77])):
+        return "battery service data AD"
+    names = name_ads[:-1]
+    full = expected_name(name_len)
+    room = (LEGACY_MAX if legacy else EXT_MAX - len(adv_ads[0][1]) - len(mdata) - 4) - 5 - 2
+    if name_len == 0:
+        return None if not names else "name AD for an empty name"
+    if len(names) != 1:
+        return "name AD missing"
+    ntype, ndata = names[0]
+    if name_len <= room:
+        return None if (ntype, ndata) == (0x09, full) else "complete name"
+    if (ntype, ndata) != (0x08, full[:room]):
+        return f"shortened name (type {ntype:#04x}, {len(ndata)} of {room} chars)"
+    return None
+
+
+def main():
+    cases = [(mode, n, name_len) for mode in ("legacy", "extended") for _, n in FORMATS
+             for name_len in range(0, 121)]
+    with tempfile.TemporaryDirectory() as build_dir:
+        src = os.path.join(build_dir, "harness.cpp")
+        exe = os.path.join(build_dir, "adv_layout")
+        with open(src, "w") as f:
+            f.write(HARNESS)
+        try:
+            subprocess.run([os.environ.get("CXX", "g++"), "-std=gnu++11", "-O2", "-I", os.path.join(ROOT, "src"),
+                            src, "-o", exe], check=True)
+            data = "".join(f"{m} {n} {k}\n" for m, n, k in cases)
+            res = subprocess.run([exe], input=data, capture_output=True, check=True, text=True)
+        except (OSError, subprocess.CalledProcessError) as e:
+            sys.exit(f"build or run failed: {e}")
+
+    results = dict(zip(cases, res.stdout.splitlines()))
+    print(f"names of 0-120 characters per row; '{FIRMWARE_NAME_LEN}-char' is the firmware's name length")
+    print(f"{'mode':>8} {'format':>6} {'adv':>4} {'sr':>3} {f'{FIRMWARE_NAME_LEN}-char':>8} "
+          f"{'full name up to':>15} {'failed':>6}")
+    failures = []
+    for mode in ("legacy", "extended"):
+        for fmt, n in FORMATS:
+            bad = 0
+            longest = 0
+            for name_len in range(0, 121):
+                out = results[(mode, n, name_len)]
+                err = check(mode, n, name_len, out)
+                if err:
+                    bad += 1
+                    failures.append(f"{mode} {fmt} name={name_len}: {err}")
+                if out != "refused":
+                    ads = parse_ads(bytes.fromhex(out.split()[2 if mode == "legacy" else 1]))
+                    if ads and any(t == 0x09 for t, _ in ads):
+                        longest = name_len
+            out = results[(mode, n, FIRMWARE_NAME_LEN)]
+            if out == "refused":
+                print(f"{mode:>8} {fmt:>6} {'refused':>17} {'-':>15} {bad:6d}")
+                continue
+            _, adv_hex, sr_hex = out.split()
+            adv_len = len(adv_hex) // 2
+            sr_len = 0 if sr_hex == "-" else len(sr_hex) // 2
+            ads = parse_ads(bytes.fromhex(sr_hex if mode == "legacy" else adv_hex))
+            firmware_name = "complete" if any(t == 0x09 for t, _ in ads) else "SHORT"
+            if firmware_name != "complete":
+                failures.append(f"{mode} {fmt}: the firmware name is shortened")
+            print(f"{mode:>8} {fmt:>6} {adv_len:4d} {sr_len:3d} {firmware_name:>8} {longest:15d} {bad:6d}")
+
+    for f in failures[:20]:
+        print("FAIL " + f)
+    sys.exit(1 if failures else 0)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,301 @@
+#!/usr/bin/env python3
+"""Host simulation of advertising recovery against a mocked GAP layer.
+
+Compiles src/ble/adv_supervisor.h with the host C++ compiler and steps it
+through loop() as src/main.cpp drives it (VIRTUAL_TAGS=1): one recovery
+step per pass, the advertising tick's silent-stop check, and the
+event-driven wait on the next tick or recovery step. The mocked GAP layer
+stops advertising at a random phase, with or without the host's
+advertising-complete event, and can refuse start() a number of times,
+until the stack is restarted, or for minutes on end; bringing the stack
+back up raises the host re-sync event like NimBLE does. Starting,
+deinit and init take a fixed time on the simulated clock (--start-ms,
+--deinit-ms, --init-ms; assumed, not measured).
+
+The loop before this supervisor is modelled alongside: an
+isAdvertising() health check every max(1 s, interval) that restarts,
+waits delay(100), and if advertising is still down deinits the stack,
+waits delay(500) and re-inits, plus the advertising tick's own start().
+
+For each scenario and mode it reports the recovery latency (stop to
+advertising again) and the longest loop pass (time the loop was blocked).
+Exits non-zero if the supervisor misses a bound: the step costs plus its
+backoff, the advertising interval for a stop without an event, and
+ADV_STACK_RETRY_MAX_MS between stack resets while the stack stays down.
+
+    python3 scripts/adv_recovery_sim.py [--trials 200] [--start-ms 2] [--deinit-ms 20] [--init-ms 40]
+"""
+
+import argparse
+import os
+import random
+import re
+import subprocess
+import sys
+import tempfile
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+MODES = (("FAST", 1285), ("SLOW", 8995))
+
+# name, GAP event, start() failures, fail until a stack reset, stack down (ms)
+SCENARIOS = (
+    ("stop event", 1, 0, 0, 0),
+    ("silent stop", 0, 0, 0, 0),
+    ("start fails 2x", 1, 2, 0, 0),
+    ("until stack reset", 1, 0, 1, 0),
+    ("stack down 5 min", 1, 0, 0, 300000),
+)
+
+HARNESS = r"""
+#include <cstdio>
+#include "ble/adv_supervisor.h"
+
+// One trial per input line:
+//   adv_ms inject_ms event start_failures fail_until_reset dead_ms start_ms deinit_ms init_ms
+// Prints:
+//   latency_ms after_dead_ms max_block_ms ev silent fail retries resets max_reset_gap_ms
+int main() {
+  unsigned long adv_ms, inject, dead_ms, start_ms, deinit_ms, init_ms;
+  int event, inject_failures, inject_until_reset;
+  while (scanf("%lu %lu %d %d %d %lu %lu %lu %lu", &adv_ms, &inject, &event, &inject_failures,
+               &inject_until_reset, &dead_ms, &start_ms, &deinit_ms, &init_ms) == 9) {
+    AdvSupervisor sup;
+    bool stack_up = true;
+    bool advertising = false;
+    bool started = false;
+    bool injected = false;
+    int start_failures = 0;
+    int fail_until_reset = 0;
+    uint32_t dead_until = 0;
+    uint32_t restored = 0;
+    uint32_t max_block = 0;
+    uint32_t last_reset = 0;
+    uint32_t max_reset_gap = 0;
+    uint32_t last_adv = 0;
+    bool first = true;
+    const uint32_t end = inject + dead_ms + 4 * ADV_STACK_RETRY_MAX_MS + 4 * adv_ms;
+
+    // startAdvertising(): keeps running advertising, else start().
+    auto start = [&](uint32_t &now) {
+      if (advertising) {
+        return true;
+      }
+      now += start_ms;
+      if (!stack_up || fail_until_reset || static_cast<int32_t>(now - dead_until) < 0) {
+        return false;
+      }
+      if (start_failures > 0) {
+        --start_failures;
+        return false;
+      }
+      advertising = true;
+      started = true;
+      return true;
+    };
+
+    uint32_t t = 0;
+    while (t < end && restored == 0) {
+      uint32_t now = t;
+      const AdvAction action = sup.poll(now);
+      if (action != kAdvActionNone) {
+        bool ok = true;
+        if (action == kAdvActionStart) {
+          ok = start(now);
+        } else if (action == kAdvActionStackDown) {
+          now += deinit_ms;
+          if (last_reset != 0 && now - last_reset > max_reset_gap) {
+            max_reset_gap = now - last_reset;
+          }
+          last_reset = now;
+          stack_up = false;
+          advertising = false;
+          fail_until_reset = 0;
+        } else {
+          now += init_ms;
+          stack_up = true;
+          sup.notifyStopped();  // Host re-sync
+          ok = start(now);
+        }
+        sup.done(now, ok);
+      }
+      if (first || t - last_adv >= adv_ms) {
+        first = false;
+        last_adv = t;
+        if (!sup.recovering()) {
+          if (started && !advertising) {
+            sup.stopped(t, kAdvStopSilent);
+          } else if (!start(now)) {
+            sup.stopped(t, kAdvStopStartFailed);
+          }
+        }
+      }
+      if (now - t > max_block) {
+        max_block = now - t;
+      }
+      if (injected && advertising && !sup.recovering()) {
+        restored = now;
+        break;
+      }
+      uint32_t wait = last_adv + adv_ms > now ? last_adv + adv_ms - now : 0;
+      const uint32_t step = sup.msUntilNext(now);
+      wait = step < wait ? step : wait;
+      uint32_t next = now + wait;
+      if (!injected && inject < next) {
+        // The stop lands while the loop is blocked.
+        injected = true;
+        advertising = false;
+        start_failures = inject_failures;
+        fail_until_reset = inject_until_reset;
+        dead_until = inject + dead_ms;
+        if (event) {
+          sup.notifyStopped();  // signalLoop(kLoopEventAdv) wakes it now
+          next = inject > now ? inject : now;
+        }
+      }
+      t = next;
+    }
+    const AdvSupervisorStats &st = sup.stats();
+    const long after_dead = restored == 0 ? -1 : long(restored) - long(dead_until);
+    printf("%ld %ld %lu %lu %lu %lu %lu %lu %lu\n",
+           restored == 0 ? -1L : long(restored - inject), after_dead,
+           static_cast<unsigned long>(max_block),
+           static_cast<unsigned long>(st.restarts[kAdvStopEvent]),
+           static_cast<unsigned long>(st.restarts[kAdvStopSilent]),
+           static_cast<unsigned long>(st.restarts[kAdvStopStartFailed]),
+           static_cast<unsigned long>(st.retries),
+           static_cast<unsigned long>(st.stack_resets),
+           static_cast<unsigned long>(max_reset_gap));
+  }
+  return 0;
+}
+"""
+
+
+def header_defaults():
+    """The supervisor's tunables, as defaulted in adv_supervisor.h."""
+    with open(os.path.join(ROOT, "src", "ble", "adv_supervisor.h")) as f:
+        text = f.read()
+    return {name: int(v) for name, v in re.findall(r"#define (ADV_\w+) (\d+)", text)}
+
+
+def legacy(adv_ms, inject, start_failures, fail_until_reset, dead_ms, costs):
+    """The loop before the supervisor: returns (latency, longest pass) in ms."""
+    start_ms, deinit_ms, init_ms = costs
+    health_ms = max(1000, adv_ms)
+    dead_until = inject + dead_ms
+    state = {"failures": start_failures, "until_reset": fail_until_reset}
+
+    def start(now):
+        now += start_ms
+        if state["until_reset"] or now < dead_until:
+            return now, False
+        if state["failures"] > 0:
+            state["failures"] -= 1
+            return now, False
+        return now, True
+
+    ticks = sorted({k * adv_ms for k in range(inject // adv_ms + 1, (inject + dead_ms) // adv_ms + 200)} |
+                   {k * health_ms for k in range(inject // health_ms + 1, (inject + dead_ms) // health_ms + 200)})
+    block = 0
+    for t in ticks:
+        now, ok = start(t)                      # Advertising tick or health check
+        if not ok and t % health_ms == 0:
+            now += 100                          # delay(100)
+            now += deinit_ms                    # NimBLEDevice::deinit(true)
+            state["until_reset"] = 0
+            now += 500 + init_ms                # delay(500), init()
+            now, ok = start(now)
+        block = max(block, now - t)
+        if ok:
+            return now - inject, block
+    return -1, block
+
+
+def main():
+    p = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    p.add_argument("--trials", type=int, default=200, help="stops per scenario and mode")
+    p.add_argument("--start-ms", type=int, default=2, help="mock start() time")
+    p.add_argument("--deinit-ms", type=int, default=20, help="mock NimBLEDevice::deinit() time")
+    p.add_argument("--init-ms", type=int, default=40, help="mock NimBLEDevice::init() time")
+    p.add_argument("--seed", type=int, default=1)
+    args = p.parse_args()
+
+    d = header_defaults()
+    retry, attempts = d["ADV_RETRY_MS"], d["ADV_RESTART_ATTEMPTS"]
+    settle, retry_max = d["ADV_STACK_SETTLE_MS"], d["ADV_STACK_RETRY_MAX_MS"]
+    costs = (args.start_ms, args.deinit_ms, args.init_ms)
+    st, de, ini = costs
+    rng = random.Random(args.seed)
+
+    trials = []
+    for si, (name, event, failures, until_reset, dead) in enumerate(SCENARIOS):
+        for mi, (_, adv_ms) in enumerate(MODES):
+            n = args.trials if dead == 0 else max(1, args.trials // 20)
+            for _ in range(n):
+                inject = 3 * adv_ms + rng.randint(0, 10 * adv_ms)
+                trials.append((si, mi, (adv_ms, inject, event, failures, until_reset, dead, st, de, ini)))
+
+    with tempfile.TemporaryDirectory() as build_dir:
+        src = os.path.join(build_dir, "harness.cpp")
+        exe = os.path.join(build_dir, "adv_recovery")
+        with open(src, "w") as f:
+            f.write(HARNESS)
+        cxx = os.environ.get("CXX", "g++")
+        try:
+            subprocess.run([cxx, "-std=gnu++11", "-O2", "-I", os.path.join(ROOT, "src"), src,
+                            "-o", exe], check=True)
+            data = "".join(" ".join(str(v) for v in t[2]) + "\n" for t in trials)
+            res = subprocess.run([exe], input=data, capture_output=True, text=True, check=True)
+        except (OSError, subprocess.CalledProcessError) as e:
+            sys.exit(f"build or run failed: {e}")
+    outs = [tuple(int(v) for v in line.split()) for line in res.stdout.splitlines()]
+
+    # Supervisor bounds per scenario: (latency from the stop, or from the
+    # stack coming back for "stack down"), and the cause it must count.
+    backoff = sum(retry << i for i in range(attempts - 1))
+    bounds = {
+        "stop event": (st, 0),
+        "silent stop": (None, 1),           # adv_ms + 2 * start, per mode
+        "start fails 2x": (sum(retry << i for i in range(2)) + 3 * st, 0),
+        "until stack reset": (backoff + attempts * st + de + settle + ini + st, 0),
+        "stack down 5 min": (retry_max + settle + de + ini + 2 * st, 0),
+    }
+    block_bound = max(st, de, ini + st)
+
+    print(f"mock costs: start={st}ms deinit={de}ms init={ini}ms; ADV_RETRY_MS={retry} "
+          f"ADV_RESTART_ATTEMPTS={attempts} ADV_STACK_SETTLE_MS={settle} ADV_STACK_RETRY_MAX_MS={retry_max}")
+    print(f"{'scenario':>18} {'mode':>4}  {'supervisor mean/max (ms)':>24} {'block':>6}  "
+          f"{'legacy mean/max (ms)':>20} {'block':>6}  {'resets':>6}")
+    failed = []
+    for si, (name, event, failures, until_reset, dead) in enumerate(SCENARIOS):
+        for mi, (mode, adv_ms) in enumerate(MODES):
+            rows = [(t[2], outs[i]) for i, t in enumerate(trials) if t[0] == si and t[1] == mi]
+            lat = [o[1] if dead else o[0] for _, o in rows]
+            block = max(o[2] for _, o in rows)
+            resets = max(o[7] for _, o in rows)
+            leg = [legacy(adv_ms, t[1], failures, until_reset, dead, costs) for t, _ in rows]
+            leg_lat = [(l - dead) if dead else l for l, _ in leg]
+            print(f"{name:>18} {mode:>4}  {sum(lat) / len(lat):12.0f} {max(lat):11d} {block:6d}  "
+                  f"{sum(leg_lat) / len(leg_lat):10.0f} {max(leg_lat):9d} {max(b for _, b in leg):6d}  {resets:6d}")
+
+            bound, cause = bounds[name]
+            if bound is None:
+                bound = adv_ms + 2 * st
+            for _, o in rows:
+                counts = o[3:6]
+                latency = o[1] if dead else o[0]
+                if o[0] < 0 or latency > bound or o[2] > block_bound or counts[cause] != 1 or sum(counts) != 1:
+                    failed.append(f"{name}/{mode}: latency {latency} ms (bound {bound}), "
+                                  f"block {o[2]} ms (bound {block_bound}), causes {counts}")
+                    break
+                if dead and o[8] > retry_max + settle + de + ini + st:
+                    failed.append(f"{name}/{mode}: {o[8]} ms between stack resets")
+                    break
+    if failed:
+        for f in failed:
+            print("FAIL: " + f)
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
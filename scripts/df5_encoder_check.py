@@ -0,0 +1,275 @@
+#!/usr/bin/env python3
+"""Fixed-point DF5 encoding vs. the previous float encoders.
+
+Compiles the firmware's conversion helpers (src/sensors/sensor_interface.h)
+and DF5 writer (src/ruuvi/ruuvi_encoder.h) on the host, next to the float
+encoders they replaced, and compares the encoded fields:
+
+  temperature  every int16 centi-degree value, exact; plus every 0.001 C
+               step over the DF5 range, within one DF5 step (the sample
+               now holds 0.01 C)
+  humidity     every uint16 DF5 value, exact; plus every 0.0001 %RH step
+               from -1 to 164 %RH, within one DF5 step (float rounding)
+  pressure     every whole Pa from 0 to 300000, exact
+
+The temperature and pressure encoders reserve INT16_MIN and 0xFFFF for
+"not available", so a value the float encoder saturated to one of them now
+saturates one below. A NaN reading must convert to a value that the range
+check in readSensorChannel() rejects (temperature outside -40..85 C,
+humidity above 100 %RH).
+
+It then times one DF5 frame on both paths. Host timings only compare the
+two; the device cost shows in the [ADV] update cycles.
+
+Exits non-zero if any comparison fails.
+
+    python3 scripts/df5_encoder_check.py
+"""
+
+import os
+import subprocess
+import sys
+import tempfile
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+HARNESS = r"""
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#endif
+#include "ruuvi/ruuvi_encoder.h"
+
+// The float encoders before the fixed-point sample.
+static uint16_t old_humidity(float rh) {
+  int32_t raw = lroundf(rh / 0.0025f);
+  if (raw < 0) raw = 0;
+  if (raw > 0xFFFF) raw = 0xFFFF;
+  return static_cast<uint16_t>(raw);
+}
+
+static int16_t old_temperature(float c) {
+  int32_t raw = lroundf(c / 0.005f);
+  if (raw < INT16_MIN) raw = INT16_MIN;
+  if (raw > INT16_MAX) raw = INT16_MAX;
+  return static_cast<int16_t>(raw);
+}
+
+static uint16_t old_pressure(float hpa) {
+  int32_t raw = lroundf(hpa * 100.0f - 50000.0f);
+  if (raw < 0) raw = 0;
+  if (raw > 0xFFFF) raw = 0xFFFF;
+  return static_cast<uint16_t>(raw);
+}
+
+static uint16_t old_power(uint16_t battery_mv, int8_t tx_dbm) {
+  if (battery_mv < 1600) battery_mv = 1600;
+  if (battery_mv > 3646) battery_mv = 3646;
+  int32_t batt_bits = battery_mv - 1600;
+  int32_t tx_bits = (tx_dbm + 40) / 2;
+  if (tx_bits < 0) tx_bits = 0;
+  if (tx_bits > 0x1F) tx_bits = 0x1F;
+  return static_cast<uint16_t>((batt_bits << 5) | tx_bits);
+}
+
+struct FloatSample {
+  float temperature_c;
+  float humidity_rh;
+  float pressure_hpa;
+  uint16_t battery_mv;
+  int8_t tx_power_dbm;
+  int16_t accel_x_mg;
+  int16_t accel_y_mg;
+  int16_t accel_z_mg;
+};
+
+static void old_frame(uint8_t *df5, const FloatSample &s, const RuuviCounters &c) {
+  df5[0] = 0x05;
+  ruuvi_be16(df5, 1, old_temperature(s.temperature_c));
+  ruuvi_be16(df5, 3, old_humidity(s.humidity_rh));
+  ruuvi_be16(df5, 5, old_pressure(s.pressure_hpa));
+  ruuvi_be16(df5, 7, s.accel_x_mg);
+  ruuvi_be16(df5, 9, s.accel_y_mg);
+  ruuvi_be16(df5, 11, s.accel_z_mg);
+  ruuvi_be16(df5, 13, old_power(s.battery_mv, s.tx_power_dbm));
+  df5[15] = c.movement;
+  ruuvi_be16(df5, 16, c.sequence & 0xFFFF);
+}
+
+static int16_t new_temperature(float c) {
+  return ruuvi_encode_temperature(sensor_cdeg_from_c(c));
+}
+
+static uint16_t new_humidity(float rh) {
+  return ruuvi_encode_humidity(sensor_humidity_df5_from_rh(rh));
+}
+
+static uint16_t new_pressure(float pa) {
+  return ruuvi_encode_pressure(sensor_pressure_pa_from_pa(pa));
+}
+
+// Reserved "not available" codes move one step in. Humidity is sent as
+// stored; readSensorChannel() rejects anything above 100 %RH first.
+static int32_t expect_temperature(int32_t v) {
+  return v == INT16_MIN ? INT16_MIN + 1 : v;
+}
+
+static int32_t expect_u16(int32_t v) {
+  return v == 0xFFFF ? 0xFFFE : v;
+}
+
+// name exact_inputs exact_mismatches near_inputs near_max_diff
+static void report(const char *name, long exact_n, long exact_bad, long near_n, long near_max) {
+  printf("%s %ld %ld %ld %ld\n", name, exact_n, exact_bad, near_n, near_max);
+}
+
+template <typename F>
+static double cycles_per(F f, long n, double *ns) {
+  const auto t0 = std::chrono::steady_clock::now();
+#ifdef HAVE_TSC
+  const unsigned long long c0 = __rdtsc();
+#endif
+  for (long i = 0; i < n; ++i) {
+    f(i);
+  }
+#ifdef HAVE_TSC
+  const double cyc = static_cast<double>(__rdtsc() - c0) / n;
+#else
+  const double cyc = 0;
+#endif
+  *ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / n;
+  return cyc;
+}
+
+int main() {
+  long bad = 0;
+  long near_max = 0;
+  long near_n = 0;
+
+  // Temperature: centi-degree grid, then 0.001 C steps.
+  for (int32_t cdeg = INT16_MIN; cdeg <= INT16_MAX; ++cdeg) {
+    const float c = cdeg / 100.0f;
+    bad += new_temperature(c) != expect_temperature(old_temperature(c));
+  }
+  for (int32_t mdeg = -163835; mdeg <= 163835; ++mdeg) {
+    const float c = mdeg / 1000.0f;
+    const long d = labs(static_cast<long>(new_temperature(c)) - old_temperature(c));
+    near_max = d > near_max ? d : near_max;
+    ++near_n;
+  }
+  report("temperature", 65536, bad, near_n, near_max);
+
+  // Humidity: DF5 grid, then 0.0001 %RH steps.
+  bad = near_max = near_n = 0;
+  for (int32_t h = 0; h <= 0xFFFF; ++h) {
+    const float rh = h / 400.0f;
+    bad += new_humidity(rh) != old_humidity(rh);
+  }
+  for (int32_t u = -10000; u <= 1640000; ++u) {
+    const float rh = u / 10000.0f;
+    const long d = labs(static_cast<long>(new_humidity(rh)) - old_humidity(rh));
+    near_max = d > near_max ? d : near_max;
+    ++near_n;
+  }
+  report("humidity", 65536, bad, near_n, near_max);
+
+  // Pressure: whole Pa (the old path took hPa).
+  bad = 0;
+  for (int32_t pa = 0; pa <= 300000; ++pa) {
+    bad += new_pressure(static_cast<float>(pa)) != expect_u16(old_pressure(pa / 100.0f));
+  }
+  report("pressure", 300001, bad, 0, 0);
+
+  // NaN and non-positive readings.
+  const float nan = NAN;
+  const int16_t t_nan = sensor_cdeg_from_c(nan);
+  const uint16_t h_nan = sensor_humidity_df5_from_rh(nan);
+  printf("nan %d %d %d %d %d\n",
+         t_nan < -4000 || t_nan > 8500,
+         h_nan > kHumidityDf5Full,
+         sensor_humidity_df5_from_rh(-0.0f) == 0 && sensor_humidity_df5_from_rh(-5.0f) == 0,
+         sensor_pressure_pa_from_pa(nan) == 0,
+         sensor_humidity_df5_from_rh(0.0f) == 0);
+
+  // One DF5 frame per path.
+  const long n = 5000000;
+  static uint8_t out[24];
+  double old_ns;
+  double new_ns;
+  const double old_cyc = cycles_per(
+      [&](long i) {
+        const FloatSample s = {21.5f + (i & 63) * 0.01f, 45.25f + (i & 31) * 0.0025f, 1013.25f + (i & 15) * 0.01f,
+                               3000, 3, 12, -8, 1003};
+        const RuuviCounters c = {0, static_cast<uint32_t>(i)};
+        old_frame(out, s, c);
+        asm volatile("" : : "r"(out) : "memory");  // Keep every store of every frame
+      },
+      n, &old_ns);
+  const double new_cyc = cycles_per(
+      [&](long i) {
+        SensorSample s = {};
+        s.temperature_cdeg = static_cast<int16_t>(2150 + (i & 63));
+        s.humidity_df5 = static_cast<uint16_t>(18100 + (i & 31));
+        s.pressure_pa = 101325 + (i & 15);
+        s.battery_mv = 3000;
+        s.tx_power_dbm = 3;
+        s.accel_x_mg = 12;
+        s.accel_y_mg = -8;
+        s.accel_z_mg = 1003;
+        s.caps = kSensorCapEnvironment | kSensorCapAccel;
+        const RuuviCounters c = {0, static_cast<uint32_t>(i)};
+        RuuviFormatDf5::write(out, s, c);
+        asm volatile("" : : "r"(out) : "memory");  // Keep every store of every frame
+      },
+      n, &new_ns);
+  printf("frame %.1f %.1f %.1f %.1f\n", old_ns, old_cyc, new_ns, new_cyc);
+  return 0;
+}
+"""
+
+
+def main():
+    with tempfile.TemporaryDirectory() as build_dir:
+        src = os.path.join(build_dir, "harness.cpp")
+        exe = os.path.join(build_dir, "df5_check")
+        with open(src, "w") as f:
+            f.write(HARNESS)
+        try:
+            subprocess.run([os.environ.get("CXX", "g++"), "-std=gnu++11", "-O2", "-I", os.path.join(ROOT, "src"),
+                            src, "-o", exe], check=True)
+            res = subprocess.run([exe], capture_output=True, check=True, text=True)
+        except (OSError, subprocess.CalledProcessError) as e:
+            sys.exit(f"build or run failed: {e}")
+
+    failed = []
+    print(f"{'field':>11} {'grid inputs':>11} {'mismatch':>8}  {'fine inputs':>11} {'max diff (steps)':>16}")
+    for line in res.stdout.splitlines():
+        name, *vals = line.split()
+        if name == "nan":
+            t_rej, h_rej, h_neg, p_zero, h_zero = (int(v) for v in vals)
+            print(f"NaN: temperature {'rejected' if t_rej else 'ACCEPTED'}, "
+                  f"humidity {'rejected' if h_rej else 'ACCEPTED'}, pressure -> {'0' if p_zero else '?'}; "
+                  f"humidity <= 0 -> 0: {'yes' if h_neg and h_zero else 'NO'}")
+            if not (t_rej and h_rej and h_neg and p_zero and h_zero):
+                failed.append("NaN/non-positive handling")
+        elif name == "frame":
+            old_ns, old_cyc, new_ns, new_cyc = (float(v) for v in vals)
+            cyc = f", {old_cyc:.0f} -> {new_cyc:.0f} cycles" if old_cyc else ""
+            print(f"DF5 frame: float {old_ns:.1f} ns, fixed point {new_ns:.1f} ns{cyc} (host)")
+        else:
+            grid_n, grid_bad, fine_n, fine_max = (int(v) for v in vals)
+            fine = f"{fine_n:11d} {fine_max:16d}" if fine_n else f"{'-':>11} {'-':>16}"
+            print(f"{name:>11} {grid_n:11d} {grid_bad:8d}  {fine}")
+            if grid_bad or fine_max > 1:
+                failed.append(name)
+
+    if failed:
+        print("FAIL: " + ", ".join(failed))
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,481 @@
+#!/usr/bin/env python3
+"""Re-inflate deferred log frames from a raw serial capture.
+
+A build with -DDEBUG_SERIAL=1 -DDEBUG_LOG_DEFERRED=1 sends hot-path log
+lines as binary frames (format string address, timestamp, raw arguments;
+format in src/util/dlog_ring.h) between the plain text lines. This finds
+the frames in a raw capture, looks each format string up in the firmware
+ELF and prints the text as Serial.printf() would have, with the plain text
+around it unchanged. Profiler records (CYCLE_PROFILER) are skipped; decode
+them with scripts/prof_decode.py.
+
+    stty -F /dev/ttyUSB0 115200 raw && cat /dev/ttyUSB0 > log.bin
+    python3 scripts/dlog_decode.py .pio/build/<env>/firmware.elf log.bin [--timestamps]
+    python3 scripts/dlog_decode.py .pio/build/<env>/firmware.elf --port /dev/ttyUSB0   # needs pyserial
+
+Use the ELF of the exact build that produced the capture: frames carry
+addresses, not strings.
+
+--self-test compiles the ring header on the host, decodes frames from a
+known set of calls (plus a damaged frame and a drop report) against the
+harness's own ELF, and runs the ring with four producer threads against
+one consumer. --bench times one hot-path log line on the host: formatting
+it with snprintf(), the work Serial.printf() does before the UART, against
+pushing it into the ring. Host timings only compare the two; on the
+device the boot log prints the cycles of both for one line.
+"""
+
+import argparse
+import os
+import re
+import struct
+import subprocess
+import sys
+import tempfile
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from prof_decode import MAGIC as PROF_MAGIC, parse_record as parse_prof_record  # noqa: E402
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+SYNC = b"\xdb\x7e"
+ARG_BYTES = 64
+HEADER = 11
+
+HARNESS = r"""
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#endif
+#include "util/dlog_ring.h"
+
+static DlogRing<32> ring;
+
+static void drain(FILE *out) {
+  DlogEntry e;
+  uint8_t f[kDlogFrameMax];
+  while (ring.pop(e)) {
+    fwrite(f, 1, dlog_frame(e, f), out);
+  }
+}
+
+// Frames on stdout, the text they stand for on stderr.
+#define CALL(fmt, ...)                      \
+  do {                                      \
+    ring.push(fmt, t_us += 1500, __VA_ARGS__); \
+    drain(stdout);                          \
+    fprintf(stderr, fmt, __VA_ARGS__);      \
+  } while (0)
+#define TEXT(s)          \
+  do {                   \
+    fputs(s, stdout);    \
+    fputs(s, stderr);    \
+  } while (0)
+
+static int frames() {
+  uint32_t t_us = 1000000;
+  TEXT("[BOOT] plain text before\n");
+  CALL("T=%s%ld.%02ldC H=%u.%02u%% P=%lu.%02luhPa\n", "-", 12L, 5L, 56u, 7u, 1013UL, 25UL);
+  CALL("Accel=[%d,%d,%d] Tx=%+ddBm\n", -1003, 12, 0, 3);
+  CALL("[MOVEMENT] Delta: dx=%d dy=%d dz=%d max=%d (threshold=%d)\n", -3, 245, 89, 245, 120);
+  CALL("[ADV] Mode=%-4s interval=%lums seq=%5u caps=0x%02x\n", "FAST", 1285UL, 42u, 0x1fu);
+  CALL("[BAT] %.3fV %c %llu %hd %%\n", 4.125, 'x', 123456789012ULL, static_cast<short>(-7));
+  TEXT("[STATUS] plain text between\n");
+  // Strings are cut to kDlogStrMax characters.
+  ring.push("[MOVEMENT] %s (count=%u)\n", t_us += 1500, "Wake-on-motion and more", 3u);
+  drain(stdout);
+  fputs("[MOVEMENT] Wake-on-motion  (count=3)\n", stderr);
+  // A damaged frame is dropped.
+  uint8_t f[kDlogFrameMax];
+  DlogEntry e;
+  ring.push("[LOST] %u\n", t_us += 1500, 99u);
+  ring.pop(e);
+  const size_t n = dlog_frame(e, f);
+  f[n - 3] ^= 0x40;
+  fwrite(f, 1, n, stdout);
+  fwrite(f, 1, dlog_drop_frame(4, t_us += 1500, f), stdout);
+  fputs("[dlog] 4 entries dropped\n", stderr);
+  TEXT("tail without newline");
+  return 0;
+}
+
+// Four producers against one consumer: every entry arrives exactly once
+// or is counted as dropped, and each producer's entries stay in order.
+static int stress() {
+  constexpr int kProducers = 4;
+  constexpr uint32_t kPerProducer = 200000;
+  std::atomic<int> running(kProducers);
+  std::vector<std::thread> producers;
+  for (int p = 0; p < kProducers; ++p) {
+    producers.emplace_back([p, &running] {
+      for (uint32_t i = 0; i < kPerProducer; ++i) {
+        ring.push("%u %u\n", 0, p, i);
+        if ((i & 7) == 7) {
+          std::this_thread::yield();  // Let the consumer keep up (also on one CPU)
+        }
+      }
+      running.fetch_sub(1);
+    });
+  }
+  uint32_t next[kProducers] = {};
+  uint64_t popped = 0;
+  uint64_t dropped = 0;
+  int errors = 0;
+  DlogEntry e;
+  for (;;) {
+    const bool done = running.load() == 0;
+    while (ring.pop(e)) {
+      uint32_t p;
+      uint32_t i;
+      memcpy(&p, e.args, 4);
+      memcpy(&i, e.args + 4, 4);
+      if (e.len != 8 || p >= kProducers || i < next[p]) {
+        ++errors;
+      } else {
+        next[p] = i + 1;
+      }
+      ++popped;
+    }
+    dropped += ring.takeDropped();
+    if (done && !ring.pending()) {
+      break;
+    }
+  }
+  for (auto &t : producers) {
+    t.join();
+  }
+  dropped += ring.takeDropped();
+  printf("%llu %llu %llu %d\n", static_cast<unsigned long long>(kProducers) * kPerProducer,
+         static_cast<unsigned long long>(popped), static_cast<unsigned long long>(dropped), errors);
+  return 0;
+}
+
+static inline uint64_t ticks() {
+#ifdef HAVE_TSC
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+
+// The advertising debug line of startAdvertising(), with the argument
+// widths it has on the ESP32 (long is 32 bits there).
+#define ADV_LINE "T=%s%d.%02dC H=%u.%02u%% P=%u.%02uhPa Batt=%umV Accel=[%d,%d,%d] Tx=%ddBm Mov=%u\n"
+#define ADV_ARGS(i) "-", 12, 5 + (i & 7), 56u, 7u, 1013u, 25u, 4120u - (i & 15), -1003, 12 + (i & 3), 0, 3, 8u
+
+static int bench() {
+  constexpr int kRounds = 20000;
+  constexpr int kBatch = 16;  // Below the ring size: no drops
+  char buf[160];
+  volatile size_t sink = 0;
+  double ns[2] = {};
+  double cyc[2] = {};
+  for (int pass = 0; pass < 2; ++pass) {
+    for (int round = 0; round < kRounds; ++round) {
+      const auto t0 = std::chrono::steady_clock::now();
+      const uint64_t c0 = ticks();
+      for (int i = 0; i < kBatch; ++i) {
+        if (pass == 0) {
+          sink += snprintf(buf, sizeof(buf), ADV_LINE, ADV_ARGS(i));
+        } else {
+          sink += ring.push(ADV_LINE, i, ADV_ARGS(i));
+        }
+      }
+      cyc[pass] += ticks() - c0;
+      ns[pass] += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+      DlogEntry e;
+      while (ring.pop(e)) {
+        sink += e.len;
+      }
+    }
+  }
+  printf("%.1f %.1f %.1f %.1f %d\n", ns[0] / (kRounds * kBatch), cyc[0] / (kRounds * kBatch),
+         ns[1] / (kRounds * kBatch), cyc[1] / (kRounds * kBatch), int(snprintf(buf, sizeof(buf), ADV_LINE, ADV_ARGS(0))));
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  const char *mode = argc > 1 ? argv[1] : "";
+  if (!strcmp(mode, "frames")) {
+    return frames();
+  }
+  if (!strcmp(mode, "stress")) {
+    return stress();
+  }
+  if (!strcmp(mode, "bench")) {
+    return bench();
+  }
+  return 2;
+}
+"""
+
+SPEC = re.compile(r"%(?P<flags>[-+ #0]*)(?P<width>\d+)?(?:\.(?P<prec>\d+))?"
+                  r"(?P<len>hh|h|ll|l|L|z|j|t)?(?P<conv>[diouxXcsfFeEgGp%])")
+
+
+class Elf:
+    """Allocated sections of a little-endian ELF, for string lookups."""
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            self.data = f.read()
+        d = self.data
+        if d[:4] != b"\x7fELF" or d[5] != 1:
+            raise ValueError(f"{path}: not a little-endian ELF file")
+        if d[4] == 1:
+            shoff, = struct.unpack_from("<I", d, 0x20)
+            shentsize, shnum = struct.unpack_from("<HH", d, 0x2E)
+            shfmt = "<IIIIIIIIII"
+            self.long_bytes = 4
+        else:
+            shoff, = struct.unpack_from("<Q", d, 0x28)
+            shentsize, shnum = struct.unpack_from("<HH", d, 0x3A)
+            shfmt = "<IIQQQQIIQQ"
+            self.long_bytes = 8
+        self.sections = []
+        for i in range(shnum):
+            _, sh_type, flags, addr, offset, size = struct.unpack_from(shfmt, d, shoff + i * shentsize)[:6]
+            if flags & 0x2 and sh_type != 8 and size > 0:  # SHF_ALLOC, not SHT_NOBITS
+                self.sections.append((addr, size, offset))
+        self.cache = {}
+
+    def string(self, addr):
+        if addr in self.cache:
+            return self.cache[addr]
+        s = None
+        for base, size, offset in self.sections:
+            if base <= addr < base + size:
+                start = offset + addr - base
+                end = self.data.find(b"\0", start, offset + size)
+                if end >= 0:
+                    s = self.data[start:end].decode("utf-8", "replace")
+                break
+        self.cache[addr] = s
+        return s
+
+
+def inflate(fmt, args, long_bytes):
+    """printf() of `fmt` over the raw argument bytes, or None if they do not match."""
+    out, pos, last = [], 0, 0
+    for m in SPEC.finditer(fmt):
+        out.append(fmt[last:m.start()])
+        last = m.end()
+        conv, length = m.group("conv"), m.group("len") or ""
+        if conv == "%":
+            out.append("%")
+            continue
+        spec = "%" + m.group("flags") + (m.group("width") or "")
+        if m.group("prec") is not None:
+            spec += "." + m.group("prec")
+        try:
+            if conv == "s":
+                n = args[pos]
+                value = args[pos + 1:pos + 1 + n].decode("utf-8", "replace")
+                pos += 1 + n
+                if pos > len(args):
+                    return None
+                out.append((spec + "s") % value)
+            elif conv in "fFeEgG":
+                value, = struct.unpack_from("<f", args, pos)
+                pos += 4
+                out.append((spec + conv) % value)
+            else:
+                size = 8 if length in ("ll", "j") or (length in ("l", "z", "t") and long_bytes == 8) else 4
+                if conv == "p":
+                    size = long_bytes
+                value = int.from_bytes(args[pos:pos + size], "little")
+                if pos + size > len(args):
+                    return None
+                pos += size
+                bits = {"hh": 8, "h": 16}.get(length, size * 8)
+                value &= (1 << bits) - 1
+                if conv in "di" and value >> (bits - 1):
+                    value -= 1 << bits
+                if conv == "c":
+                    out.append((spec + "c") % chr(value & 0xFF))
+                elif conv == "p":
+                    out.append(f"0x{value:x}")
+                else:
+                    out.append((spec + ("d" if conv in "diu" else conv)) % value)
+        except (IndexError, struct.error, ValueError, OverflowError):
+            return None
+    out.append(fmt[last:])
+    return "".join(out) if pos == len(args) else None
+
+
+def parse_frame(data, pos, elf):
+    """Frame at data[pos:]: (text or None if damaged, end, t_us), or None if incomplete."""
+    if pos + HEADER + 1 > len(data):
+        return None
+    n = data[pos + 2]
+    end = pos + HEADER + n + 1
+    if n > ARG_BYTES or end > len(data):
+        return (None, pos + 2, 0) if n > ARG_BYTES else None
+    if (~sum(data[pos + 2:end - 1])) & 0xFF != data[end - 1]:
+        return None, end, 0
+    fmt_addr, t_us = struct.unpack_from("<II", data, pos + 3)
+    args = data[pos + HEADER:end - 1]
+    if fmt_addr == 0:
+        dropped, = struct.unpack_from("<I", args, 0)
+        return f"[dlog] {dropped} entries dropped\n", end, t_us
+    fmt = elf.string(fmt_addr)
+    text = inflate(fmt, args, elf.long_bytes) if fmt is not None else None
+    return text, end, t_us
+
+
+def decode(data, elf, timestamps=False):
+    """Text of a capture and the number of damaged frames."""
+    out, pos, text_start, damaged, line_start = [], 0, 0, 0, True
+
+    def emit(s):
+        nonlocal line_start
+        if s:
+            out.append(s)
+            line_start = s.endswith("\n")
+
+    while True:
+        frame = data.find(SYNC, pos)
+        prof = data.find(PROF_MAGIC, pos)
+        if frame < 0 and prof < 0:
+            break
+        if prof >= 0 and (frame < 0 or prof < frame):
+            rec = parse_prof_record(data, prof)
+            if rec is None:
+                pos = prof + 1
+                continue
+            emit(data[text_start:prof].decode("utf-8", "replace"))
+            pos = text_start = rec[1]
+            continue
+        parsed = parse_frame(data, frame, elf)
+        if parsed is None:
+            break  # Cut off at the end of the capture
+        text, end, t_us = parsed
+        emit(data[text_start:frame].decode("utf-8", "replace"))
+        if text is None:
+            damaged += 1
+        else:
+            if timestamps and line_start:
+                text = f"[{t_us / 1e6:12.6f}] " + text
+            emit(text)
+        pos = text_start = end
+    emit(data[text_start:].decode("utf-8", "replace"))
+    return "".join(out), damaged
+
+
+def build(build_dir):
+    src = os.path.join(build_dir, "harness.cpp")
+    exe = os.path.join(build_dir, "dlog_harness")
+    with open(src, "w") as f:
+        f.write(HARNESS)
+    cxx = os.environ.get("CXX", "g++")
+    # -no-pie: format string addresses in the frames match the ELF.
+    subprocess.run([cxx, "-std=gnu++11", "-O2", "-no-pie", "-pthread", "-I", os.path.join(ROOT, "src"), src,
+                    "-o", exe], check=True)
+    return exe
+
+
+def self_test():
+    errors = []
+    with tempfile.TemporaryDirectory() as build_dir:
+        try:
+            exe = build(build_dir)
+            res = subprocess.run([exe, "frames"], capture_output=True, check=True)
+            stress = subprocess.run([exe, "stress"], capture_output=True, check=True, text=True)
+        except (OSError, subprocess.CalledProcessError) as e:
+            sys.exit(f"build or run failed: {e}")
+        text, damaged = decode(res.stdout, Elf(exe))
+    expected = res.stderr.decode()
+    print(f"{len(res.stdout)} bytes of frames and text -> {len(text)} chars, {damaged} damaged frame(s)")
+    print(text)
+    if text != expected:
+        errors.append("decoded text differs from printf():")
+        for got, want in zip(text.splitlines(), expected.splitlines()):
+            if got != want:
+                errors.append(f"  got  {got!r}\n  want {want!r}")
+    if damaged != 1:
+        errors.append(f"expected 1 damaged frame, got {damaged}")
+
+    pushed, popped, dropped, order_errors = (int(v) for v in stress.stdout.split())
+    print(f"\nstress: 4 producers, {pushed} pushes: {popped} delivered, {dropped} dropped (ring full), "
+          f"{order_errors} out of order")
+    if popped + dropped != pushed or order_errors:
+        errors.append("ring lost, duplicated or reordered entries")
+    for e in errors:
+        print("FAIL: " + e)
+    if errors:
+        sys.exit(1)
+
+
+def bench():
+    with tempfile.TemporaryDirectory() as build_dir:
+        try:
+            exe = build(build_dir)
+            res = subprocess.run([exe, "bench"], capture_output=True, check=True, text=True)
+        except (OSError, subprocess.CalledProcessError) as e:
+            sys.exit(f"build or run failed: {e}")
+    fmt_ns, fmt_cyc, push_ns, push_cyc, chars = res.stdout.split()
+    print(f"one startAdvertising() debug line ({chars} chars, 13 arguments), host, per call:")
+    print(f"{'path':>22} {'ns':>7} {'TSC cyc':>8}")
+    print(f"{'snprintf (printf)':>22} {float(fmt_ns):7.1f} {float(fmt_cyc):8.1f}")
+    print(f"{'ring push (DLOG)':>22} {float(push_ns):7.1f} {float(push_cyc):8.1f}")
+    print("Serial.printf() also waits for the UART once its FIFO is full "
+          f"(~{int(chars) * 10 / 115200 * 1e3:.1f} ms for this line at 115200 baud); DLOG() never does.")
+
+
+def main():
+    p = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    p.add_argument("elf", nargs="?", help="firmware ELF of the build that produced the capture")
+    p.add_argument("capture", nargs="?", help="raw serial capture (- for stdin)")
+    p.add_argument("--port", help="read from a serial port instead (pyserial)")
+    p.add_argument("--baud", type=int, default=115200)
+    p.add_argument("--seconds", type=float, default=60, help="how long to read --port")
+    p.add_argument("--timestamps", action="store_true", help="prefix deferred lines with the time of the call")
+    p.add_argument("--self-test", action="store_true", help="round-trip and multi-producer check on the host")
+    p.add_argument("--bench", action="store_true", help="host cost of one log line, snprintf vs ring push")
+    args = p.parse_args()
+
+    if args.self_test:
+        self_test()
+        return
+    if args.bench:
+        bench()
+        return
+    if not args.elf:
+        p.error("give the firmware ELF")
+    try:
+        elf = Elf(args.elf)
+    except (OSError, ValueError, struct.error) as e:
+        sys.exit(f"cannot read {args.elf}: {e}")
+    if args.port:
+        try:
+            import serial
+        except ImportError:
+            sys.exit("--port needs pyserial (pip install pyserial)")
+        import time
+        data = bytearray()
+        with serial.Serial(args.port, args.baud, timeout=0.5) as port:
+            end = time.monotonic() + args.seconds
+            while time.monotonic() < end:
+                data += port.read(4096)
+        data = bytes(data)
+    elif args.capture and args.capture != "-":
+        with open(args.capture, "rb") as f:
+            data = f.read()
+    elif args.capture == "-":
+        data = sys.stdin.buffer.read()
+    else:
+        p.error("give a capture file, - or --port")
+
+    text, damaged = decode(data, elf, args.timestamps)
+    sys.stdout.write(text)
+    if damaged:
+        print(f"({damaged} damaged frames skipped)", file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,233 @@
+#!/usr/bin/env python3
+"""Generate src/ntc_table.h: raw ADC counts -> centi-degrees C for the NTC.
+
+The table folds the ADC linearization (the coarse kAdcLut in src/ntc_lut.h,
+or with USE_FULL_NTC_LUT the 4096-entry ADC_LUT in src/ntc_lut_full.h) and the
+Beta / series-resistor model into one int16 piecewise-linear table with
+evenly spaced knots. A third table has no linearization, for ADC values
+already corrected with the chip's eFuse calibration (src/adc/adc_cal.h). The firmware looks up the filtered ADC value (raw16,
+4 fractional bits) with a shift, two loads and one multiply.
+
+The knot spacing is the widest power of two whose maximum error against
+the model (the float ntc_read_celsius() of NTC_TABLE=0, without the
+truncation of its integer LUT interpolation) at every ADC count stays
+within --max-error over --min-c..--max-c. The error against the float
+path itself is reported too. Outside that
+range the table is only clamped to --clamp-c, which keeps an open or
+shorted thermistor far out of the valid range.
+
+    python3 scripts/gen_ntc_table.py            # regenerate src/ntc_table.h
+    python3 scripts/gen_ntc_table.py --check    # only report accuracy/size
+"""
+
+import argparse
+import math
+import os
+import re
+import sys
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+ADC_MAX = 4095
+FRAC_BITS = 4  # raw16 = raw * 16, as produced by src/adc/adc_filter.h
+
+
+def parse_coarse_lut():
+    with open(os.path.join(ROOT, "src", "ntc_lut.h")) as f:
+        text = f.read()
+    body = re.search(r"kAdcLut\[33\]\s*=\s*\{([^}]*)\}", text).group(1)
+    return [int(v) for v in body.replace("\n", " ").split(",") if v.strip()]
+
+
+def parse_full_lut():
+    with open(os.path.join(ROOT, "src", "ntc_lut_full.h")) as f:
+        text = f.read()
+    body = re.search(r"^const float ADC_LUT\[4096\][^{]*\{([^}]*)\}", text, re.M).group(1)
+    values = [float(v) for v in body.replace("\n", " ").split(",") if v.strip()]
+    if len(values) != 4096:
+        sys.exit(f"ntc_lut_full.h: expected 4096 values, got {len(values)}")
+    return values
+
+
+IDENTITY = "identity"
+
+
+def linearize(raw, coarse, full):
+    """ntc_linearize_adc() (integer result)."""
+    if full is IDENTITY:
+        return raw
+    if full is not None:
+        return int(full[min(raw, ADC_MAX)])  # static_cast<uint16_t>
+    idx = raw // 128
+    if idx >= 32:
+        return coarse[32]
+    base, nxt = coarse[idx], coarse[idx + 1]
+    return base + ((nxt - base) * (raw % 128)) // 128
+
+
+def linearize_smooth(x, coarse, full):
+    """Same linearization without the integer truncation, for any real x."""
+    if full is IDENTITY:
+        return x
+    if full is not None:
+        i = min(int(x), ADC_MAX - 1)
+        return full[i] + (full[i + 1] - full[i]) * (x - i)
+    i = min(int(x // 128), 31)
+    return coarse[i] + (coarse[i + 1] - coarse[i]) * (x - 128 * i) / 128
+
+
+def celsius_from_corrected(corrected, args):
+    ratio = corrected / 4095.0
+    resistance = args.series * ratio / (1.0 - ratio + 1e-6)
+    if resistance <= 0.0:
+        return -273.15  # logf(0) = -inf -> 1/-inf = -0 K
+    inv_t = math.log(resistance / args.nominal) / args.beta + 1.0 / (args.nominal_c + 273.15)
+    return 1.0 / inv_t - 273.15
+
+
+def celsius_legacy(raw, args, coarse, full):
+    """The float path ntc_read_celsius() (NTC_TABLE=0)."""
+    return celsius_from_corrected(linearize(raw, coarse, full), args)
+
+
+def celsius_model(x, args, coarse, full):
+    """The same model, smooth in x (what the table approximates)."""
+    return celsius_from_corrected(linearize_smooth(x, coarse, full), args)
+
+
+def build(step_bits, args, coarse, full):
+    step = 1 << step_bits
+    lo, hi = -args.clamp_c * 100, args.clamp_c * 100
+    knots = []
+    for i in range(4096 // step + 1):
+        cdeg = round(celsius_model(i * step, args, coarse, full) * 100)
+        knots.append(max(lo, min(hi, cdeg)))
+    return knots
+
+
+def lookup(knots, step_bits, raw16):
+    """Integer interpolation exactly as ntc_table_lookup()."""
+    shift = step_bits + FRAC_BITS
+    idx = raw16 >> shift
+    frac = raw16 & ((1 << shift) - 1)
+    a, b = knots[idx], knots[idx + 1]
+    d = (b - a) * frac
+    # C++ division truncates toward zero; so does this.
+    return a + int(d / (1 << shift)) if d < 0 else a + (d >> shift)
+
+
+def max_error(knots, step_bits, ref, args):
+    """Worst |table - ref| (C) over the ADC counts whose ref is in range."""
+    worst = 0.0
+    for raw in range(ADC_MAX + 1):
+        t = ref[raw]
+        if not args.min_c <= t <= args.max_c:
+            continue
+        worst = max(worst, abs(lookup(knots, step_bits, raw << FRAC_BITS) / 100.0 - t))
+    return worst
+
+
+def in_range_span(ref, args):
+    raws = [r for r in range(ADC_MAX + 1) if args.min_c <= ref[r] <= args.max_c]
+    return (raws[0], raws[-1]) if raws else (0, 0)
+
+
+def fmt_float(v):
+    return f"{v:.1f}f"
+
+
+def emit(variants, args):
+    out = []
+    out.append("// Generated by scripts/gen_ntc_table.py -- do not edit.")
+    out.append("#pragma once")
+    out.append("")
+    out.append("#include <stdint.h>")
+    out.append("")
+    out.append("// Raw ADC -> centi-degrees C for the NTC, with the ADC linearization")
+    out.append("// and the Beta / series-resistor model folded in. Evenly spaced knots,")
+    out.append("// linear interpolation in between (see ntc_table_lookup()). The float")
+    out.append("// path truncates its LUT interpolation to whole counts, so it steps by up")
+    out.append("// to ~0.2 C at the hot end; the tables interpolate instead.")
+    out.append("// Regenerate after changing the NTC_* parameters or either LUT.")
+    out.append("//")
+    out.append(f"// Generated for NTC_SERIES_OHMS={args.series:g}, NTC_NOMINAL_OHMS={args.nominal:g},")
+    out.append(f"// NTC_NOMINAL_TEMP_C={args.nominal_c:g}, NTC_BETA={args.beta:g}. Knots are clamped")
+    out.append(f"// to +/-{args.clamp_c:g} C, so an open or shorted NTC still reads far out of range.")
+    out.append(f"#define NTC_TABLE_SERIES_OHMS {fmt_float(args.series)}")
+    out.append(f"#define NTC_TABLE_NOMINAL_OHMS {fmt_float(args.nominal)}")
+    out.append(f"#define NTC_TABLE_NOMINAL_TEMP_C {fmt_float(args.nominal_c)}")
+    out.append(f"#define NTC_TABLE_BETA {fmt_float(args.beta)}")
+    for name, cond, prefix, step_bits, knots, err, err_legacy, span in variants:
+        out.append("")
+        if cond:
+            out.append(f"{cond}  // {name}")
+        else:
+            out.append(f"// {name}")
+        out.append(f"// Step {1 << step_bits} counts, {len(knots)} knots, {len(knots) * 2} bytes. Max error over")
+        out.append(f"// {args.min_c:g}..{args.max_c:g} C (ADC {span[0]}..{span[1]}): {err:.3f} C vs. the model,")
+        out.append(f"// {err_legacy:.3f} C vs. the float path (NTC_TABLE=0).")
+        out.append(f"constexpr uint8_t {prefix}StepBits = {step_bits};")
+        out.append(f"static const int16_t {prefix}[{len(knots)}] = {{")
+        for j in range(0, len(knots), 10):
+            row = ", ".join(f"{v:6d}" for v in knots[j:j + 10])
+            out.append(f"    {row},")
+        out.append("};")
+        if cond == "#else":
+            out.append("#endif")
+    out.append("")
+    return "\n".join(out)
+
+
+def main():
+    p = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    p.add_argument("--series", type=float, default=10000.0, help="NTC_SERIES_OHMS")
+    p.add_argument("--nominal", type=float, default=10000.0, help="NTC_NOMINAL_OHMS")
+    p.add_argument("--nominal-c", type=float, default=25.0, help="NTC_NOMINAL_TEMP_C")
+    p.add_argument("--beta", type=float, default=3950.0, help="NTC_BETA")
+    p.add_argument("--max-error", type=float, default=0.1,
+                   help="max table error in C (default 0.1)")
+    p.add_argument("--min-c", type=float, default=-40.0, help="accuracy range low end")
+    p.add_argument("--max-c", type=float, default=125.0, help="accuracy range high end")
+    p.add_argument("--clamp-c", type=float, default=300.0,
+                   help="knot clamp, +/- C (default 300)")
+    p.add_argument("--check", action="store_true", help="report only, do not write")
+    args = p.parse_args()
+
+    coarse = parse_coarse_lut()
+    full = parse_full_lut()
+    variants = []
+    for name, cond, prefix, lut in (
+            ("ntc_lut_full.h", "#if defined(USE_FULL_NTC_LUT)", "kNtcTable", full),
+            ("ntc_lut.h coarse LUT", "#else", "kNtcTable", None),
+            ("No linearization: for eFuse-calibrated input (NTC_ADC_CAL)", "",
+             "kNtcTableCal", IDENTITY)):
+        model = [celsius_model(raw, args, coarse, lut) for raw in range(ADC_MAX + 1)]
+        legacy = [celsius_legacy(raw, args, coarse, lut) for raw in range(ADC_MAX + 1)]
+        chosen = None
+        for step_bits in range(7, -1, -1):
+            knots = build(step_bits, args, coarse, lut)
+            err = max_error(knots, step_bits, model, args)
+            if err <= args.max_error:
+                chosen = (step_bits, knots, err)
+                break
+        if chosen is None:
+            sys.exit(f"{name}: cannot meet --max-error {args.max_error}")
+        step_bits, knots, err = chosen
+        err_legacy = max_error(knots, step_bits, legacy, args)
+        span = in_range_span(model, args)
+        print(f"{name}: step {1 << step_bits} counts, {len(knots)} knots, "
+              f"{len(knots) * 2} bytes, max error {err:.3f} C vs. model, "
+              f"{err_legacy:.3f} C vs. float path, "
+              f"{args.min_c:g}..{args.max_c:g} C (ADC {span[0]}..{span[1]})")
+        variants.append((name, cond, prefix, step_bits, knots, err, err_legacy, span))
+
+    if args.check:
+        return
+    # Full-LUT variant first (#if defined), coarse one in the #else branch.
+    path = os.path.join(ROOT, "src", "ntc_table.h")
+    with open(path, "w") as f:
+        f.write(emit(variants, args))
+    print(f"wrote {os.path.relpath(path, ROOT)}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,146 @@
+#!/usr/bin/env python3
+"""Debug LCD refresh cost: full redraw vs. dirty regions.
+
+Builds the overlay rows board_debug_refresh() draws for ten simulated
+minutes in each mode and feeds them to the firmware's retained text frame
+(src/util/lcd_text_frame.h, compiled on the host). For each refresh it
+counts the pixel bytes sent to the 240x135 panel (16-bit pixels, 12x16
+character cells):
+
+  full redraw    clear() of the whole panel plus every character cell
+                 (LCD_DIRTY_REGIONS=0, the old behaviour)
+  dirty regions  only the changed column span of each changed row
+
+and the wire time at --spi-mhz. The model counts pixel data only, not
+commands or rendering time. On the device the [LCD] status line reports
+the bytes and the measured refresh time for whichever build is running.
+
+The simulated state: the sequence number steps once per refresh, the
+battery reading drifts down with a few mV of noise, movement now and then,
+the FAST countdown in HYBRID mode, and (with --load) the load monitor line
+every 10 s.
+
+    python3 scripts/lcd_refresh_model.py [--spi-mhz 40] [--load]
+"""
+
+import argparse
+import os
+import random
+import subprocess
+import sys
+import tempfile
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+WIDTH, HEIGHT = 240, 135
+CHAR_W, CHAR_H = 12, 16
+ROWS, COLS = 6, 20
+SIM_MS = 10 * 60 * 1000
+MODES = (("DEV", 211), ("FAST", 1285), ("SLOW", 8995), ("HYBRID", None))
+
+HARNESS = r"""
+#include <cstdio>
+#include <cstring>
+#include "util/lcd_text_frame.h"
+
+// Input: ROWS lines per refresh. Output per refresh: the changed columns.
+int main() {
+  LcdTextFrame<6, 20> frame;
+  char line[64];
+  int row = 0;
+  unsigned cols = 0;
+  while (fgets(line, sizeof(line), stdin)) {
+    line[strcspn(line, "\n")] = '\0';
+    uint8_t first;
+    uint8_t last;
+    if (frame.update(static_cast<uint8_t>(row), line, first, last)) {
+      cols += last - first + 1u;
+    }
+    if (++row == 6) {
+      printf("%u\n", cols);
+      row = 0;
+      cols = 0;
+    }
+  }
+  return 0;
+}
+"""
+
+
+def trace(mode, adv_ms, load, rng):
+    """Overlay rows for every refresh of a SIM_MS run."""
+    t, seq, mov, batt, fast_until = 0, 0, 0, 4105.0, 60000
+    load_line = ""
+    refreshes = []
+    while t < SIM_MS:
+        if mode == "HYBRID":
+            if rng.random() < 0.01:  # Movement: another FAST minute
+                mov = (mov + 1) % 256
+                fast_until = t + 60000
+            label = "FAST" if t < fast_until else "SLOW"
+            interval = 1285 if label == "FAST" else 8995
+        else:
+            label, interval = mode, adv_ms
+            if rng.random() < 0.005:
+                mov = (mov + 1) % 256
+        batt -= interval / 3_600_000 * 40  # ~40 mV per hour
+        mv = int(batt + rng.gauss(0, 3))
+        if load and t // 10000 != (t - interval) // 10000:
+            load_line = f"C:{rng.choice(('~1', '~2', '~3'))}% W:{rng.randint(990, 2010)}"
+        countdown = (fast_until - t) // 1000 if mode == "HYBRID" and t < fast_until else 0
+        rows = [
+            f"U:N M:{label:<4}",
+            f"S:{seq % 65536:<5} V:{mov:<3}",
+            f"F:{countdown:<3}s" if countdown else "F:---",
+            f"B:{mv:<4}mV",
+            f"L:{max(0, min(100, (mv - 3000) * 100 // 1200)):<3}%",
+            load_line,
+        ]
+        refreshes.append(rows)
+        seq += 1
+        t += interval
+    return refreshes
+
+
+def main():
+    p = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    p.add_argument("--spi-mhz", type=float, default=40.0, help="SPI write clock (default 40)")
+    p.add_argument("--load", action="store_true", help="LOAD_MONITOR_LCD row")
+    p.add_argument("--seed", type=int, default=1)
+    args = p.parse_args()
+
+    with tempfile.TemporaryDirectory() as build_dir:
+        src = os.path.join(build_dir, "harness.cpp")
+        exe = os.path.join(build_dir, "lcd_frame")
+        with open(src, "w") as f:
+            f.write(HARNESS)
+        try:
+            subprocess.run([os.environ.get("CXX", "g++"), "-std=gnu++11", "-O2", "-I", os.path.join(ROOT, "src"),
+                            src, "-o", exe], check=True)
+        except (OSError, subprocess.CalledProcessError) as e:
+            sys.exit(f"build failed: {e}")
+
+        cell = CHAR_W * CHAR_H * 2
+        print(f"{SIM_MS // 60000} min per mode, {WIDTH}x{HEIGHT} panel, wire time at {args.spi_mhz:g} MHz SPI"
+              f"{', load row on' if args.load else ''}")
+        print(f"{'mode':>6} {'refreshes':>9}  {'full B/refresh':>14} {'dirty B/refresh':>15} {'ratio':>6}  "
+              f"{'full ms':>7} {'dirty ms':>8}  {'dirty max B':>11}")
+        rng = random.Random(args.seed)
+        for mode, adv_ms in MODES:
+            refreshes = trace(mode, adv_ms, args.load, rng)
+            data = "".join("\n".join(rows) + "\n" for rows in refreshes)
+            try:
+                res = subprocess.run([exe], input=data, capture_output=True, check=True, text=True)
+            except (OSError, subprocess.CalledProcessError) as e:
+                sys.exit(f"run failed: {e}")
+            dirty = [int(v) * cell for v in res.stdout.split()]
+            full = [WIDTH * HEIGHT * 2 + sum(len(r) for r in rows) * cell for rows in refreshes]
+            # The first refresh after boot draws every row whole; report steady state.
+            n = len(refreshes) - 1
+            full_avg, dirty_avg = sum(full[1:]) / n, sum(dirty[1:]) / n
+            ms = lambda b: b * 8 / (args.spi_mhz * 1e3)  # noqa: E731
+            print(f"{mode:>6} {len(refreshes):9d}  {full_avg:14.0f} {dirty_avg:15.0f} {full_avg / dirty_avg:5.0f}x  "
+                  f"{ms(full_avg):7.2f} {ms(dirty_avg):8.3f}  {max(dirty[1:]):11d}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,162 @@
+#!/usr/bin/env python3
+"""Host model of the firmware scheduler: CPU wakeups per minute.
+
+Steps loop() and the sensor task through ten simulated minutes in each
+advertising mode, once with the fixed 10 ms loop (LOOP_EVENT_DRIVEN=0) and
+once event-driven, following the deadline rules in src/main.cpp:
+
+  loop()       advertisement, the 10 s status line with DEBUG_SERIAL, and
+               without the sensor task the sensor work below (advertising
+               recovery only runs after a stop, so it is not modelled)
+  sensor task  base-interval poll (plus the conversion wait), battery sample
+               every BATTERY_SAMPLE_MS, wake-on-motion INT_STATUS poll every
+               IMU_WOM_POLL_MS without an interrupt pin, and the ADC engine
+               tick while ADC pins are in use
+
+Every return from a blocking wait counts as a wakeup. For each run it
+reports wakeups per minute per task and the mean and longest stretch with
+every task blocked (what automatic light sleep gets to use). BLE controller
+events come on top, one per advertising interval.
+
+    python3 scripts/loop_wakeup_model.py [--wom poll|pin|off] [--adc] [--debug] [--no-task]
+"""
+
+import argparse
+import heapq
+
+MODES = (("DEV", 211), ("FAST", 1285), ("SLOW", 8995))
+SENSOR_POLL_MIN_MS = 2000
+BATTERY_SAMPLE_MS = 1000
+WOM_POLL_MS = 500
+TASK_TICK_MS = 10
+CONVERSION_MS = 20      # triggerSensors() wait (SHT30 + QMP6988)
+STATUS_MS = 10000
+SIM_MS = 10 * 60 * 1000
+
+
+class Battery:
+    """BatterySampler: keeps its cadence, restarts after a stall."""
+
+    def __init__(self):
+        self.next = None
+
+    def due(self, now):
+        if self.next is not None and now < self.next:
+            return False
+        self.next = self.next + BATTERY_SAMPLE_MS if self.next is not None and \
+            now - self.next < BATTERY_SAMPLE_MS else now + BATTERY_SAMPLE_MS
+        return True
+
+    def until(self, now):
+        return 0 if self.next is None else max(0, self.next - now)
+
+
+class SensorOwner:
+    """Sensor work shared by the task and (without it) loop()."""
+
+    def __init__(self, args, poll_ms):
+        self.args = args
+        self.poll_ms = poll_ms
+        self.battery = Battery()
+        self.wom_last = 0
+        self.last_poll = None
+
+    def service(self, now):
+        self.battery.due(now)
+        if self.args.wom == "poll" and now - self.wom_last >= WOM_POLL_MS:
+            self.wom_last = now
+
+    def poll_due(self, now):
+        return self.last_poll is None or now - self.last_poll >= self.poll_ms
+
+    def wait(self, now):
+        w = self.battery.until(now)
+        if self.args.wom == "poll":
+            w = min(w, max(0, WOM_POLL_MS - (now - self.wom_last)))
+        if self.args.adc:
+            w = min(w, TASK_TICK_MS)
+        return w
+
+
+def run(args, adv_ms, event_driven):
+    """Returns (loop wakeups, sensor task wakeups, wake instants)."""
+    poll_ms = max(adv_ms, SENSOR_POLL_MIN_MS)
+    owner = SensorOwner(args, poll_ms)
+    wakes = []
+    counts = {"loop": 0, "sensors": 0}
+    queue = [(0, "loop"), (0, "sensors")] if not args.no_task else [(0, "loop")]
+    st = {"last_adv": None, "last_status": 0, "collect": None}
+
+    while queue:
+        t, task = heapq.heappop(queue)
+        if t >= SIM_MS:
+            continue
+        counts[task] += 1
+        wakes.append(t)
+        end = t
+        if task == "sensors":
+            owner.service(t)
+            if owner.poll_due(t):
+                owner.last_poll = t
+                counts["sensors"] += 1          # Conversion wait ends
+                wakes.append(t + CONVERSION_MS)
+                end = t + CONVERSION_MS
+            nxt = end + (min(max(0, owner.last_poll + poll_ms - end), owner.wait(end))
+                         if event_driven else TASK_TICK_MS)
+        else:
+            if args.debug and t - st["last_status"] >= STATUS_MS:
+                st["last_status"] = t
+            if args.no_task:
+                owner.service(t)
+                if owner.poll_due(t):
+                    owner.last_poll = t
+                    st["collect"] = t + CONVERSION_MS  # Split phase: collected on a later pass
+                elif st["collect"] is not None and t >= st["collect"]:
+                    st["collect"] = None
+            if st["last_adv"] is None or t - st["last_adv"] >= adv_ms:
+                st["last_adv"] = t
+            if event_driven:
+                w = max(0, st["last_adv"] + adv_ms - end)
+                if args.debug:
+                    w = min(w, max(0, st["last_status"] + STATUS_MS - end))
+                if args.no_task:
+                    w = min(w, max(0, owner.last_poll + poll_ms - end), owner.wait(end))
+                    if st["collect"] is not None:
+                        w = min(w, max(0, st["collect"] - end))
+                nxt = end + max(w, 1)
+            else:
+                nxt = end + 10
+        heapq.heappush(queue, (nxt, task))
+    return counts["loop"], counts["sensors"], sorted(wakes)
+
+
+def idle_stats(wakes):
+    gaps = [b - a for a, b in zip(wakes, wakes[1:]) if b > a]
+    return (sum(gaps) / len(gaps), max(gaps)) if gaps else (0.0, 0)
+
+
+def main():
+    p = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    p.add_argument("--wom", choices=("poll", "pin", "off"), default="poll",
+                   help="wake-on-motion: INT_STATUS poll (default), interrupt pin, or off")
+    p.add_argument("--adc", action="store_true", help="ADC engine pins in use (NTC, battery divider)")
+    p.add_argument("--debug", action="store_true", help="DEBUG_SERIAL status line")
+    p.add_argument("--no-task", action="store_true", help="SENSOR_TASK_ENABLE=0")
+    args = p.parse_args()
+
+    minutes = SIM_MS / 60000
+    print(f"wom={args.wom} adc={'on' if args.adc else 'off'} debug={'on' if args.debug else 'off'} "
+          f"sensor task={'off' if args.no_task else 'on'}, {minutes:.0f} min per run")
+    print(f"{'mode':>5} {'scheduler':>12}  {'loop/min':>8} {'task/min':>8} {'total/min':>9}  "
+          f"{'idle mean/max (ms)':>18}  {'BLE/min':>7}")
+    for name, adv_ms in MODES:
+        for event_driven in (False, True):
+            loop_n, task_n, wakes = run(args, adv_ms, event_driven)
+            mean, longest = idle_stats(wakes)
+            print(f"{name:>5} {'event-driven' if event_driven else '10 ms loop':>12}  "
+                  f"{loop_n / minutes:8.0f} {task_n / minutes:8.0f} {(loop_n + task_n) / minutes:9.0f}  "
+                  f"{mean:9.0f} {longest:8d}  {60000 / adv_ms:7.1f}")
+
+
+if __name__ == "__main__":
+    main()
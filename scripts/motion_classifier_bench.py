@@ -0,0 +1,279 @@
+#!/usr/bin/env python3
+"""Host benchmark and labelled-trace check for src/motion/motion_classifier.h.
+
+Compiles the firmware header with the host C++ compiler and feeds it an
+accelerometer trace at the FIFO output rate, in the batches the firmware
+drains (one per sensor base tick):
+
+  * cost: nanoseconds (and TSC cycles on x86) per batch, for the FAST and
+    SLOW base intervals;
+  * accuracy against the labels: movements detected, movements started in
+    still periods (vibration, sensor noise) per hour, and the share of
+    windows whose moving/still state matches the label.
+
+The previous detector (120 mg max-axis delta between two instantaneous
+reads, one per SLOW advertising interval) is scored alongside.
+
+Without --trace a synthetic labelled day is used: a device at rest with
+sensor noise, compressor vibration, knocks, handling sessions and slow tilts
+(10-45 degrees over 20-90 s). With --trace, give a CSV with columns
+t_s, ax_mg, ay_mg, az_mg, moving (0/1) sampled at --odr-hz.
+
+Exits non-zero if the classifier finds fewer than 95% of the movements or
+starts more than 1 movement per hour in still periods.
+
+    python3 scripts/motion_classifier_bench.py [--trace FILE.csv] [--hours 12]
+"""
+
+import argparse
+import csv
+import math
+import os
+import random
+import subprocess
+import sys
+import tempfile
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+HARNESS = r"""
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#endif
+#include "motion/motion_classifier.h"
+
+int main(int argc, char **argv) {
+  std::vector<AccelMg> in;
+  int x, y, z;
+  while (scanf("%d %d %d", &x, &y, &z) == 3) {
+    in.push_back({int16_t(x), int16_t(y), int16_t(z)});
+  }
+  // Per window: moving, started, variance, energy, tilt.
+  MotionClassifier c;
+  for (size_t i = 0; i < in.size(); ++i) {
+    const bool started = c.push(in[i]);
+    if ((i + 1) % IMU_MOTION_WINDOW == 0) {
+      printf("%d %d %u %u %u\n", c.moving() ? 1 : 0, started ? 1 : 0, c.variance(), c.energy(),
+             c.tilt());
+    }
+  }
+  // Timing: each batch size in argv, repeated passes with a fresh classifier.
+  for (int a = 1; a < argc; ++a) {
+    const size_t batch = static_cast<size_t>(atoi(argv[a]));
+    const size_t batches = in.size() / batch;
+    const int passes = batches ? 2000000 / static_cast<int>(batches * batch) + 1 : 0;
+    volatile uint32_t sink = 0;
+    const auto t0 = std::chrono::steady_clock::now();
+#ifdef HAVE_TSC
+    const unsigned long long c0 = __rdtsc();
+#endif
+    for (int k = 0; k < passes; ++k) {
+      MotionClassifier f;
+      for (size_t b = 0; b < batches; ++b) {
+        sink = sink + f.push_batch(&in[b * batch], static_cast<uint16_t>(batch));
+      }
+    }
+#ifdef HAVE_TSC
+    const unsigned long long cycles = __rdtsc() - c0;
+#else
+    const unsigned long long cycles = 0;
+#endif
+    const double ns = std::chrono::duration<double, std::nano>(
+                          std::chrono::steady_clock::now() - t0).count();
+    const double n = static_cast<double>(passes) * batches;
+    fprintf(stderr, "%zu %.1f %.1f\n", batch, n ? ns / n : 0.0, n ? cycles / n : 0.0);
+  }
+  return 0;
+}
+"""
+
+FAST_POLL_S = 2.0    # SENSOR_POLL_MIN_INTERVAL_MS
+SLOW_ADV_S = 8.995
+
+
+def rotate(g, pitch_deg):
+    """Gravity vector (mg) after tilting by pitch about the x axis."""
+    a = math.radians(pitch_deg)
+    return (g[0], g[1] * math.cos(a) - g[2] * math.sin(a), g[1] * math.sin(a) + g[2] * math.cos(a))
+
+
+def synthetic(hours, odr, seed):
+    """Rows of (x, y, z, moving) at `odr` Hz and the list of movement segments."""
+    rng = random.Random(seed)
+    rows, segments = [], []
+    pitch = 0.0
+    n_total = int(hours * 3600 * odr)
+    vib_phase = 0.0
+
+    def rest(n, vibration):
+        nonlocal vib_phase
+        g = rotate((0.0, 0.0, 1000.0), pitch)
+        amp = rng.uniform(8.0, 25.0) if vibration else 0.0
+        freq = rng.uniform(0.5, 4.5)  # Compressor hum aliased down past the 10 Hz low-pass
+        for _ in range(n):
+            vib_phase += 2 * math.pi * freq / odr
+            v = amp * math.sin(vib_phase)
+            rows.append((g[0] + rng.gauss(0, 3) + 0.3 * v, g[1] + rng.gauss(0, 3) + 0.5 * v,
+                         g[2] + rng.gauss(0, 3) + v, 0))
+
+    def knock():
+        g = rotate((0.0, 0.0, 1000.0), pitch)
+        peak = rng.uniform(150.0, 600.0)
+        axis = rng.randrange(3)
+        for k in range(rng.randint(2, 4)):
+            d = [0.0, 0.0, 0.0]
+            d[axis] = peak * (-0.5) ** k  # Ring-down
+            rows.append((g[0] + d[0] + rng.gauss(0, 3), g[1] + d[1] + rng.gauss(0, 3),
+                         g[2] + d[2] + rng.gauss(0, 3), 1))
+
+    def handling(n):
+        nonlocal pitch
+        target = pitch + rng.uniform(-40.0, 40.0)
+        for i in range(n):
+            p = pitch + (target - pitch) * i / n
+            g = rotate((0.0, 0.0, 1000.0), p)
+            rows.append((g[0] + rng.gauss(0, 60), g[1] + rng.gauss(0, 60), g[2] + rng.gauss(0, 60), 1))
+        pitch = target
+
+    def slow_tilt(n):
+        nonlocal pitch
+        target = pitch + rng.choice((-1, 1)) * rng.uniform(10.0, 45.0)
+        for i in range(n):
+            g = rotate((0.0, 0.0, 1000.0), pitch + (target - pitch) * i / n)
+            rows.append((g[0] + rng.gauss(0, 3), g[1] + rng.gauss(0, 3), g[2] + rng.gauss(0, 3), 1))
+        pitch = target
+
+    while len(rows) < n_total:
+        rest(int(rng.uniform(60, 900) * odr), vibration=rng.random() < 0.4)
+        start = len(rows)
+        kind = rng.choice(("knock", "handling", "tilt"))
+        if kind == "knock":
+            knock()
+        elif kind == "handling":
+            handling(int(rng.uniform(3, 30) * odr))
+        else:
+            slow_tilt(int(rng.uniform(20, 90) * odr))
+        segments.append((start, len(rows), kind))
+    return [(int(round(x)), int(round(y)), int(round(z)), m) for x, y, z, m in rows], segments
+
+
+def load_trace(path):
+    rows = []
+    with open(path, newline="") as f:
+        for row in csv.DictReader(f):
+            rows.append((int(float(row["ax_mg"])), int(float(row["ay_mg"])),
+                         int(float(row["az_mg"])), int(row["moving"])))
+    segments = []
+    start = None
+    for i, r in enumerate(rows + [(0, 0, 0, 0)]):
+        if r[3] and start is None:
+            start = i
+        elif not r[3] and start is not None:
+            segments.append((start, i, "labelled"))
+            start = None
+    return rows, segments
+
+
+def legacy_events(rows, odr):
+    """Sample indices where the two-read 120 mg delta fires (SLOW cadence)."""
+    step = int(round(SLOW_ADV_S * odr))
+    events = []
+    last = None
+    for i in range(0, len(rows), step):
+        cur = rows[i][:3]
+        if last is not None and max(abs(a - b) for a, b in zip(cur, last)) >= 120:
+            events.append(i)
+        last = cur
+    return events
+
+
+def score(events, segments, n_rows, slack):
+    """Movements found, total, and events outside movements (+ slack samples)."""
+    found = 0
+    moving = bytearray(n_rows)
+    for start, end, _ in segments:
+        for i in range(start, min(n_rows, end + slack)):
+            moving[i] = 1
+    for start, end, _ in segments:
+        if any(start <= e < end + slack for e in events):
+            found += 1
+    false_events = sum(1 for e in events if not moving[min(e, n_rows - 1)])
+    return found, len(segments), false_events
+
+
+def main():
+    p = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    p.add_argument("--trace", help="CSV trace (t_s,ax_mg,ay_mg,az_mg,moving)")
+    p.add_argument("--hours", type=float, default=12.0, help="synthetic trace length")
+    p.add_argument("--odr-hz", type=int, default=10, help="IMU_FIFO_ODR_HZ")
+    p.add_argument("--seed", type=int, default=1)
+    args = p.parse_args()
+
+    rows, segments = load_trace(args.trace) if args.trace else synthetic(args.hours, args.odr_hz, args.seed)
+    hours = len(rows) / args.odr_hz / 3600
+    fast_batch = int(FAST_POLL_S * args.odr_hz)
+    slow_batch = int(SLOW_ADV_S * args.odr_hz)
+
+    with tempfile.TemporaryDirectory() as build_dir:
+        src = os.path.join(build_dir, "harness.cpp")
+        exe = os.path.join(build_dir, "motion_bench")
+        with open(src, "w") as f:
+            f.write(HARNESS)
+        cxx = os.environ.get("CXX", "g++")
+        try:
+            subprocess.run([cxx, "-std=gnu++11", "-O2", "-I", os.path.join(ROOT, "src"), src,
+                            "-o", exe], check=True)
+            data = "".join(f"{x} {y} {z}\n" for x, y, z, _ in rows)
+            res = subprocess.run([exe, str(fast_batch), str(slow_batch)], input=data,
+                                 capture_output=True, text=True, check=True)
+        except (OSError, subprocess.CalledProcessError) as e:
+            sys.exit(f"build or run failed: {e}")
+
+    windows = [tuple(int(v) for v in line.split()) for line in res.stdout.splitlines()]
+    window = len(rows) // len(windows) if windows else 1
+    events = [(w + 1) * window - 1 for w, out in enumerate(windows) if out[1]]
+    agree = 0
+    for w, out in enumerate(windows):
+        labels = [r[3] for r in rows[w * window:(w + 1) * window]]
+        agree += int(out[0] == (2 * sum(labels) >= len(labels)))
+
+    print(f"trace: {args.trace or 'synthetic'}, {hours:.1f} h at {args.odr_hz} Hz, "
+          f"{len(segments)} movements, {window}-sample windows")
+    for line in res.stderr.splitlines():
+        batch, ns, cycles = line.split()
+        cyc = f", {float(cycles):.0f} TSC cycles" if float(cycles) else ""
+        print(f"  batch of {batch:>3} samples: {float(ns):8.0f} ns{cyc}")
+
+    print(f"{'detector':>22}  {'found':>9}  {'false/h':>7}  {'window acc':>10}")
+    slack = 3 * window * 3  # Exit windows after a movement still belong to it
+    found, total, false_events = score(events, segments, len(rows), slack)
+    print(f"{'windowed classifier':>22}  {found:>4}/{total:<4}  {false_events / hours:7.2f}  "
+          f"{100.0 * agree / max(1, len(windows)):9.1f}%")
+    by_kind = {}
+    for seg in segments:
+        k = seg[2]
+        f_k, t_k, _ = score(events, [seg], len(rows), slack)
+        by_kind[k] = (by_kind.get(k, (0, 0))[0] + f_k, by_kind.get(k, (0, 0))[1] + t_k)
+    legacy = legacy_events(rows, args.odr_hz)
+    l_found, _, l_false = score(legacy, segments, len(rows), slack)
+    print(f"{'legacy 2-read delta':>22}  {l_found:>4}/{total:<4}  {l_false / hours:7.2f}  {'-':>10}")
+    l_kind = {}
+    for seg in segments:
+        f_k, t_k, _ = score(legacy, [seg], len(rows), slack)
+        l_kind[seg[2]] = (l_kind.get(seg[2], (0, 0))[0] + f_k, l_kind.get(seg[2], (0, 0))[1] + t_k)
+    for k in sorted(by_kind):
+        print(f"  {k:>10}: classifier {by_kind[k][0]}/{by_kind[k][1]}, legacy {l_kind[k][0]}/{l_kind[k][1]}")
+
+    if found < 0.95 * total or false_events / hours > 1.0:
+        print("FAIL: classifier below 95% of movements or above 1 false start per hour")
+        sys.exit(1)
+    print("OK")
+
+
+if __name__ == "__main__":
+    main()
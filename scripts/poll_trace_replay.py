@@ -0,0 +1,219 @@
+#!/usr/bin/env python3
+"""Replay a sensor trace through the adaptive poll scheduler.
+
+Compiles AdaptivePollScheduler (src/sensors/poll_scheduler.h) with the
+host C++ compiler and drives it the way sensorTask() in src/main.cpp does:
+a base tick every --base-ms (the task wakes at last_poll_ms + poll_ms),
+setBase() on every tick, and an environmental poll only on ticks where
+due() says so. The value polled is the latest trace row at the tick. The
+same trace is also replayed with SENSOR_POLL_ADAPTIVE=0 (a poll on every
+tick). Reports the number of polls, the longest gap between polls and the
+worst-case difference between what each schedule reports (the latest
+polled value) and what fixed polling reports, and against the trace
+itself.
+
+Trace: CSV with a header row and columns t_s, temp_c and optionally rh and
+hpa (one row per second or denser). Without --trace a synthetic cold-room
+day is used: a flat 4 C room with sensor noise, slow drift, defrost cycles
+and door openings.
+
+    python3 scripts/poll_trace_replay.py [--trace FILE.csv] [--base-ms 8995] [--max-ms 20000]
+"""
+
+import argparse
+import csv
+import math
+import os
+import random
+import subprocess
+import sys
+import tempfile
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+FIELDS = 3
+
+HARNESS = r"""
+#include <cstdio>
+#include <vector>
+#include "sensors/poll_scheduler.h"
+
+struct Row {
+  unsigned long t;
+  long cdeg;
+  long rh;  // DF5 units, -1 = not in the trace
+  long pa;  // -1 = not in the trace
+};
+
+// Input: base_ms, then one trace row per line: "<t_ms> <cdeg> <rh> <pa>".
+// Output: one "<t_ms> <row>" line per environmental poll.
+int main() {
+  unsigned long base_ms;
+  if (scanf("%lu", &base_ms) != 1 || base_ms == 0) {
+    return 1;
+  }
+  std::vector<Row> rows;
+  Row r;
+  while (scanf("%lu %ld %ld %ld", &r.t, &r.cdeg, &r.rh, &r.pa) == 4) {
+    rows.push_back(r);
+  }
+  if (rows.empty()) {
+    return 1;
+  }
+
+  AdaptivePollScheduler<1> sched;
+  size_t i = 0;
+  // sensorTask(): one base tick per poll_ms; the scheduler decides whether
+  // the tick polls the environmental sensors.
+  for (unsigned long now = rows[0].t; now <= rows.back().t; now += base_ms) {
+    while (i + 1 < rows.size() && rows[i + 1].t <= now) {
+      ++i;
+    }
+    const uint32_t now_ms = static_cast<uint32_t>(now);
+    sched.setBase(base_ms);
+    if (!sched.due(now_ms, base_ms)) {
+      continue;
+    }
+    SensorSample s = {};
+    s.temperature_cdeg = static_cast<int16_t>(rows[i].cdeg);
+    s.caps = kSensorCapTemperature;
+    if (rows[i].rh >= 0) {
+      s.humidity_df5 = static_cast<uint16_t>(rows[i].rh);
+      s.caps |= kSensorCapHumidity;
+    }
+    if (rows[i].pa >= 0) {
+      s.pressure_pa = static_cast<uint32_t>(rows[i].pa);
+      s.caps |= kSensorCapPressure;
+    }
+    sched.update(&s, now_ms, base_ms);
+    printf("%lu %lu\n", now, static_cast<unsigned long>(i));
+  }
+  return 0;
+}
+"""
+
+
+def synthetic_cold_room(hours, seed):
+    """Per-second (temp_c, rh, hpa) for a cold room."""
+    rng = random.Random(seed)
+    rows = []
+    doors = sorted(rng.uniform(0, hours * 3600) for _ in range(int(hours / 3)))
+    defrost_period = 6 * 3600
+    for t in range(int(hours * 3600)):
+        temp = 4.0 + 0.15 * math.sin(2 * math.pi * t / 86400)
+        # Defrost: 20 min ramp up by 1.5 C, then recovery.
+        phase = t % defrost_period
+        if phase < 1200:
+            temp += 1.5 * phase / 1200
+        elif phase < 3000:
+            temp += 1.5 * math.exp(-(phase - 1200) / 400)
+        for d in doors:
+            if t >= d:
+                age = t - d
+                temp += 2.0 * (1 - math.exp(-age / 30)) * math.exp(-age / 600) if age < 4000 else 0
+        rh = 85.0 - 4.0 * (temp - 4.0)
+        hpa = 1013.0 + 0.5 * math.sin(2 * math.pi * t / 43200)
+        temp += rng.gauss(0, 0.01)
+        rh += rng.gauss(0, 0.1)
+        hpa += rng.gauss(0, 0.02)
+        rows.append((t * 1000, temp, rh, hpa))
+    return rows
+
+
+def load_trace(path):
+    rows = []
+    with open(path, newline="") as f:
+        for row in csv.DictReader(f):
+            rh = row.get("rh")
+            hpa = row.get("hpa")
+            rows.append((int(float(row["t_s"]) * 1000), float(row["temp_c"]),
+                         float(rh) if rh else None, float(hpa) if hpa else None))
+    return rows
+
+
+def to_fixed(row):
+    _, temp, rh, hpa = row
+    return (round(temp * 100),
+            round(rh * 400) if rh is not None else None,
+            round(hpa * 100) if hpa is not None else None)
+
+
+def build(build_dir, name, defines):
+    src = os.path.join(build_dir, "harness.cpp")
+    exe = os.path.join(build_dir, name)
+    with open(src, "w") as f:
+        f.write(HARNESS)
+    try:
+        subprocess.run([os.environ.get("CXX", "g++"), "-std=gnu++11", "-O2"] + defines
+                       + ["-I", os.path.join(ROOT, "src"), src, "-o", exe], check=True)
+    except (OSError, subprocess.CalledProcessError) as e:
+        sys.exit(f"build failed: {e}")
+    return exe
+
+
+def replay(exe, rows, truth, base_ms):
+    """Reported value at every trace row, the number of polls and the longest gap."""
+    data = f"{base_ms}\n" + "".join(
+        f"{row[0]} {v[0]} {-1 if v[1] is None else v[1]} {-1 if v[2] is None else v[2]}\n"
+        for row, v in zip(rows, truth))
+    try:
+        res = subprocess.run([exe], input=data, capture_output=True, check=True, text=True)
+    except (OSError, subprocess.CalledProcessError) as e:
+        sys.exit(f"run failed: {e}")
+    polls = [tuple(int(x) for x in line.split()) for line in res.stdout.splitlines()]
+    reported = []
+    current = None
+    p = 0
+    for row in rows:
+        while p < len(polls) and polls[p][0] <= row[0]:
+            current = truth[polls[p][1]]
+            p += 1
+        reported.append(current)
+    gap = max((b[0] - a[0] for a, b in zip(polls, polls[1:])), default=0)
+    return reported, len(polls), gap
+
+
+def worst(a, b):
+    out = [0, 0, 0]
+    for x, y in zip(a, b):
+        for f in range(FIELDS):
+            if x[f] is not None and y[f] is not None:
+                out[f] = max(out[f], abs(x[f] - y[f]))
+    return out
+
+
+def fmt(err):
+    return f"{err[0] / 100:.2f} C, {err[1] / 400:.2f} %RH, {err[2] / 100:.2f} hPa"
+
+
+def main():
+    p = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    p.add_argument("--trace", help="CSV trace (t_s,temp_c[,rh,hpa])")
+    p.add_argument("--base-ms", type=int, default=8995,
+                   help="base poll interval (default 8995: SLOW mode)")
+    p.add_argument("--max-ms", type=int, help="SENSOR_POLL_MAX_INTERVAL_MS (default: the header's)")
+    p.add_argument("--hours", type=float, default=24.0, help="synthetic trace length")
+    p.add_argument("--seed", type=int, default=1)
+    args = p.parse_args()
+
+    rows = load_trace(args.trace) if args.trace else synthetic_cold_room(args.hours, args.seed)
+    truth = [to_fixed(r) for r in rows]
+    cap = [f"-DSENSOR_POLL_MAX_INTERVAL_MS={args.max_ms}"] if args.max_ms else []
+    with tempfile.TemporaryDirectory() as build_dir:
+        fixed_exe = build(build_dir, "poll_fixed", ["-DSENSOR_POLL_ADAPTIVE=0"])
+        adapt_exe = build(build_dir, "poll_adaptive", cap)
+        fixed, fixed_polls, fixed_gap = replay(fixed_exe, rows, truth, args.base_ms)
+        adapt, adapt_polls, adapt_gap = replay(adapt_exe, rows, truth, args.base_ms)
+
+    span_h = (rows[-1][0] - rows[0][0]) / 3.6e6
+    print(f"trace: {args.trace or 'synthetic cold room'}, {span_h:.1f} h, "
+          f"base {args.base_ms} ms, max {args.max_ms or 'header default'}")
+    print(f"fixed:    {fixed_polls} polls, longest gap {fixed_gap} ms")
+    print(f"adaptive: {adapt_polls} polls ({100 * (1 - adapt_polls / fixed_polls):.0f}% fewer), "
+          f"longest gap {adapt_gap} ms")
+    print(f"worst adaptive vs. fixed: {fmt(worst(adapt, fixed))}")
+    print(f"worst fixed vs. trace:    {fmt(worst(fixed, truth))}")
+    print(f"worst adaptive vs. trace: {fmt(worst(adapt, truth))}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,280 @@
+#!/usr/bin/env python3
+"""Decode hot-path profiler records from a raw serial capture.
+
+A build with -DCYCLE_PROFILER=1 writes one binary record per
+CYCLE_PROFILER_DUMP_MS window onto the serial port, between the text log
+lines (format in src/util/cycle_hist.h). This finds the records in a raw
+capture, checks them, and prints per stage the call count and min, avg,
+p50, p99 and max, in CPU cycles and in microseconds at the clock the
+record carries (PM_MAX_FREQ_MHZ). Percentiles come from the histogram
+buckets: upper bounds, at most 25% high. Min, avg and max are exact.
+
+Capture the port raw (not through a line-based monitor), e.g.
+
+    stty -F /dev/ttyUSB0 115200 raw && cat /dev/ttyUSB0 > prof.bin
+    python3 scripts/prof_decode.py prof.bin [--merge]
+    python3 scripts/prof_decode.py --port /dev/ttyUSB0 --seconds 120   # needs pyserial
+
+--merge sums every window into one report. --self-test compiles the
+histogram header on the host, encodes records from known samples with
+log text and a corrupted record around them, decodes them back, and exits
+non-zero if a statistic is off.
+"""
+
+import argparse
+import os
+import random
+import struct
+import subprocess
+import sys
+import tempfile
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+MAGIC = b"PROF"
+VERSION = 1
+BUCKETS = 124
+
+HARNESS = r"""
+#include <cstdio>
+#include <cstring>
+#include "util/cycle_hist.h"
+
+// Input: "<stage> <cycles>" lines for stages 0..2. Output (binary): log
+// text, a record, a corrupted copy of it, text, an empty record.
+static const char *const kNames[3] = {"loop", "payload", "adv_host"};
+
+int main() {
+  static CycleHist hist[3];
+  unsigned stage;
+  unsigned long cycles;
+  while (scanf("%u %lu", &stage, &cycles) == 2 && stage < 3) {
+    hist[stage].add(static_cast<uint32_t>(cycles));
+  }
+  static uint8_t buf[cycle_record_max(3, 8)];
+  CycleRecordWriter w(buf, sizeof(buf));
+  w.begin(3, 60000, 80);
+  for (int i = 0; i < 3; ++i) {
+    w.stage(kNames[i], hist[i]);
+  }
+  const size_t n = w.finish();
+  if (n == 0) {
+    return 1;
+  }
+  fputs("[BOOT] text before\n", stdout);
+  fwrite(buf, 1, n, stdout);
+  buf[n / 2] ^= 0x55;
+  fwrite(buf, 1, n, stdout);
+  fputs("[STATUS] text between PROF\n", stdout);
+  CycleHist empty = {};
+  w.begin(1, 1000, 80);
+  w.stage("idle", empty);
+  fwrite(buf, 1, w.finish(), stdout);
+  // p50/p99 as the header computes them, for the decoder to match.
+  for (int i = 0; i < 3; ++i) {
+    fprintf(stderr, "%lu %lu\n", static_cast<unsigned long>(hist[i].percentile(500)),
+            static_cast<unsigned long>(hist[i].percentile(990)));
+  }
+  return 0;
+}
+"""
+
+
+def bucket_high(b):
+    if b + 1 >= BUCKETS:
+        return 0xFFFFFFFF
+    b += 1
+    low = b if b < 4 else (4 + b % 4) << (b // 4 - 1)
+    return low - 1
+
+
+def fletcher16(data):
+    s1 = s2 = 0
+    for byte in data:
+        s1 = (s1 + byte) % 255
+        s2 = (s2 + s1) % 255
+    return s2 << 8 | s1
+
+
+def parse_record(data, pos):
+    """Record at data[pos:] (starting with the magic): (record, end) or None."""
+    try:
+        version, stages, window_ms, mhz = struct.unpack_from("<BBIH", data, pos + 4)
+        if version != VERSION:
+            return None
+        p = pos + 12
+        out = []
+        for _ in range(stages):
+            n = data[p]
+            name = data[p + 1:p + 1 + n].decode("ascii")
+            p += 1 + n
+            count, lo, hi, sum_lo, sum_hi, used = struct.unpack_from("<IIIIIB", data, p)
+            p += 21
+            buckets = {}
+            for _ in range(used):
+                b, c = struct.unpack_from("<BH", data, p)
+                buckets[b] = c
+                p += 3
+            out.append({"name": name, "count": count, "min": lo, "max": hi,
+                        "sum": sum_hi << 32 | sum_lo, "buckets": buckets})
+        (check,) = struct.unpack_from("<H", data, p)
+    except (IndexError, struct.error, UnicodeDecodeError):
+        return None
+    if fletcher16(data[pos + 4:p]) != check:
+        return None
+    return {"window_ms": window_ms, "mhz": mhz, "stages": out}, p + 2
+
+
+def find_records(data):
+    """All valid records in a capture, and how many magics failed to parse."""
+    records, bad, pos = [], 0, 0
+    while True:
+        pos = data.find(MAGIC, pos)
+        if pos < 0:
+            return records, bad
+        parsed = parse_record(data, pos)
+        if parsed is None:
+            bad += 1
+            pos += 1
+        else:
+            records.append(parsed[0])
+            pos = parsed[1]
+
+
+def percentile(stage, permille):
+    """Same rule as CycleHist::percentile()."""
+    if stage["count"] == 0:
+        return 0
+    rank = (stage["count"] * permille + 999) // 1000
+    seen = 0
+    for b in sorted(stage["buckets"]):
+        seen += stage["buckets"][b]
+        if seen >= rank:
+            return min(bucket_high(b), stage["max"])
+    return stage["max"]
+
+
+def merge(records):
+    by_name = {}
+    for rec in records:
+        for st in rec["stages"]:
+            m = by_name.setdefault(st["name"], {"name": st["name"], "count": 0, "min": None, "max": 0,
+                                                "sum": 0, "buckets": {}})
+            if st["count"]:
+                m["min"] = st["min"] if m["min"] is None else min(m["min"], st["min"])
+            m["count"] += st["count"]
+            m["max"] = max(m["max"], st["max"])
+            m["sum"] += st["sum"]
+            for b, c in st["buckets"].items():
+                m["buckets"][b] = m["buckets"].get(b, 0) + c
+    for m in by_name.values():
+        m["min"] = m["min"] or 0
+    return {"window_ms": sum(r["window_ms"] for r in records), "mhz": records[-1]["mhz"],
+            "stages": list(by_name.values())}
+
+
+def render(rec):
+    mhz = rec["mhz"] or 1
+    print(f"window {rec['window_ms'] / 1000:.1f} s, us at {mhz} MHz")
+    print(f"{'stage':>12} {'calls':>7}  {'min':>9} {'avg':>9} {'p50':>9} {'p99':>9} {'max':>10}  "
+          f"{'avg us':>8} {'p99 us':>8} {'max us':>9}")
+    for st in rec["stages"]:
+        avg = st["sum"] / st["count"] if st["count"] else 0
+        p50, p99 = percentile(st, 500), percentile(st, 990)
+        print(f"{st['name']:>12} {st['count']:7d}  {st['min']:9d} {avg:9.0f} {p50:9d} {p99:9d} {st['max']:10d}  "
+              f"{avg / mhz:8.1f} {p99 / mhz:8.1f} {st['max'] / mhz:9.1f}")
+
+
+def self_test():
+    rng = random.Random(1)
+    samples = [
+        [int(rng.lognormvariate(10, 0.3)) for _ in range(5000)] + [2_000_000],  # loop, one outlier
+        [rng.randint(900, 1100) for _ in range(5000)],                          # payload
+        [rng.choice((3000, 3000, 3000, 150_000)) + rng.randint(0, 99) for _ in range(777)],
+    ]
+    with tempfile.TemporaryDirectory() as build_dir:
+        src = os.path.join(build_dir, "harness.cpp")
+        exe = os.path.join(build_dir, "prof_record")
+        with open(src, "w") as f:
+            f.write(HARNESS)
+        cxx = os.environ.get("CXX", "g++")
+        try:
+            subprocess.run([cxx, "-std=gnu++11", "-O2", "-I", os.path.join(ROOT, "src"), src,
+                            "-o", exe], check=True)
+            data = "".join(f"{i} {v}\n" for i, vals in enumerate(samples) for v in vals)
+            res = subprocess.run([exe], input=data.encode(), capture_output=True, check=True)
+        except (OSError, subprocess.CalledProcessError) as e:
+            sys.exit(f"build or run failed: {e}")
+
+    records, bad = find_records(res.stdout)
+    device_pcts = [tuple(int(v) for v in line.split()) for line in res.stderr.decode().splitlines()]
+    print(f"{len(res.stdout)} bytes: {len(records)} records, {bad} rejected")
+    errors = []
+    if len(records) != 2 or bad < 1:
+        errors.append("expected 2 valid records and the corrupted one rejected")
+    else:
+        render(records[0])
+        for st, vals, pcts in zip(records[0]["stages"], samples, device_pcts):
+            s = sorted(vals)
+            exact = {"count": len(s), "min": s[0], "max": s[-1], "sum": sum(s)}
+            for k, v in exact.items():
+                if st[k] != v:
+                    errors.append(f"{st['name']}: {k} {st[k]} != {v}")
+            for permille, got in ((500, percentile(st, 500)), (990, percentile(st, 990))):
+                true = s[(len(s) * permille + 999) // 1000 - 1]
+                if not true <= got <= max(true * 1.25, true + 1):
+                    errors.append(f"{st['name']}: p{permille // 10} {got} vs exact {true}")
+            if (percentile(st, 500), percentile(st, 990)) != pcts:
+                errors.append(f"{st['name']}: decoder percentiles differ from CycleHist::percentile()")
+        if records[1]["stages"][0]["count"] != 0:
+            errors.append("empty record decoded with samples")
+    for e in errors:
+        print("FAIL: " + e)
+    if errors:
+        sys.exit(1)
+
+
+def main():
+    p = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    p.add_argument("capture", nargs="?", help="raw serial capture (- for stdin)")
+    p.add_argument("--port", help="read from a serial port instead (pyserial)")
+    p.add_argument("--baud", type=int, default=115200)
+    p.add_argument("--seconds", type=float, default=120, help="how long to read --port")
+    p.add_argument("--merge", action="store_true", help="one report over every window")
+    p.add_argument("--self-test", action="store_true", help="round-trip check against the C++ encoder")
+    args = p.parse_args()
+
+    if args.self_test:
+        self_test()
+        return
+    if args.port:
+        try:
+            import serial
+        except ImportError:
+            sys.exit("--port needs pyserial (pip install pyserial)")
+        import time
+        data = bytearray()
+        with serial.Serial(args.port, args.baud, timeout=0.5) as port:
+            end = time.monotonic() + args.seconds
+            while time.monotonic() < end:
+                data += port.read(4096)
+        data = bytes(data)
+    elif args.capture and args.capture != "-":
+        with open(args.capture, "rb") as f:
+            data = f.read()
+    elif args.capture == "-":
+        data = sys.stdin.buffer.read()
+    else:
+        p.error("give a capture file, - or --port")
+
+    records, bad = find_records(data)
+    if not records:
+        sys.exit(f"no profiler records found ({bad} damaged); is the build using -DCYCLE_PROFILER=1?")
+    if bad:
+        print(f"({bad} damaged records skipped)")
+    for rec in [merge(records)] if args.merge else records:
+        render(rec)
+        print()
+
+
+if __name__ == "__main__":
+    main()
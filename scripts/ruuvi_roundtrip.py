@@ -0,0 +1,363 @@
+#!/usr/bin/env python3
+"""Round trip for the Ruuvi payload encoders (src/ruuvi/ruuvi_encoder.h).
+
+Compiles every format writer (DF3, DF5, Cut-RAWv2 0xC5, Extended v1 0xE1)
+on the host, encodes a set of samples with each, and decodes the bytes
+again with the reference decoders below. The decoders follow the Ruuvi
+format specifications and share no code with the firmware. Every decoded
+field must match the sample within the format's resolution, or the
+documented clamp:
+
+  temperature   DF5/C5/E1 clamp to +-163.835 C; -163.84 C (0x8000) is
+                "not available" only, so INT16_MIN clamps to 0x8001.
+                DF3 clamps to +-127.99 C.
+  pressure      50000..115534 Pa; 0xFFFF is "not available" only, so the
+                top clamps to 0xFFFE
+  battery, TX   1600..3646 mV; -40..+20 dBm in 2 dB steps (all ones in
+                either field is "not available")
+  acceleration  DF5 clamps to +-32767 mg; -32768 (0x8000) is "not
+                available"
+  caps          fields without their kSensorCap bit decode as "not
+                available" (DF3 has no such value and sends them raw)
+
+The samples are edge values plus random ones. Each format is then timed
+over repeated frames. Host timings only compare the formats.
+
+Exits non-zero if any field fails.
+
+    python3 scripts/ruuvi_roundtrip.py [--random 5000] [--seed 1]
+"""
+
+import argparse
+import os
+import random
+import subprocess
+import sys
+import tempfile
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+HARNESS = r"""
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "ruuvi/ruuvi_encoder.h"
+
+static const uint8_t kMac[6] = {0xD4, 0x12, 0x34, 0x56, 0x78, 0x9A};
+
+struct Input {
+  SensorSample s;
+  RuuviCounters c;
+};
+
+template <typename Format>
+static void dump(const Input &in) {
+  uint8_t out[Format::kLen];
+  memset(out, 0xAA, sizeof(out));  // Unwritten bytes show up in the decode
+  ruuvi_write_mac<Format>(out, kMac);
+  ruuvi_encode<Format>(out, in.s, in.c);
+  for (uint8_t i = 0; i < Format::kLen; ++i) {
+    printf("%02x", out[i]);
+  }
+  printf(Format::kId == RUUVI_FORMAT_E1 ? "\n" : " ");
+}
+
+template <typename Format>
+static void bench(const char *name, const std::vector<Input> &in) {
+  uint8_t out[Format::kLen];
+  const long n = 4000000;
+  const auto t0 = std::chrono::steady_clock::now();
+  for (long i = 0; i < n; ++i) {
+    ruuvi_encode<Format>(out, in[i % in.size()].s, in[i % in.size()].c);
+    asm volatile("" : : "r"(out) : "memory");
+  }
+  const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+  printf("bench %s %.2f\n", name, ns / n);
+}
+
+int main() {
+  std::vector<Input> in;
+  int t, h, tx, ax, ay, az, caps, mov;
+  unsigned p, batt, seq;
+  while (scanf("%d %d %u %u %d %d %d %d %d %d %u", &t, &h, &p, &batt, &tx, &ax, &ay, &az, &caps, &mov, &seq) ==
+         11) {
+    Input i = {};
+    i.s.temperature_cdeg = static_cast<int16_t>(t);
+    i.s.humidity_df5 = static_cast<uint16_t>(h);
+    i.s.pressure_pa = p;
+    i.s.battery_mv = static_cast<uint16_t>(batt);
+    i.s.tx_power_dbm = static_cast<int8_t>(tx);
+    i.s.accel_x_mg = static_cast<int16_t>(ax);
+    i.s.accel_y_mg = static_cast<int16_t>(ay);
+    i.s.accel_z_mg = static_cast<int16_t>(az);
+    i.s.caps = static_cast<uint8_t>(caps);
+    i.c.movement = static_cast<uint8_t>(mov);
+    i.c.sequence = seq;
+    in.push_back(i);
+    dump<RuuviFormatDf3>(i);
+    dump<RuuviFormatDf5>(i);
+    dump<RuuviFormatC5>(i);
+    dump<RuuviFormatE1>(i);
+  }
+  if (in.empty()) {
+    return 1;
+  }
+  bench<RuuviFormatDf3>("DF3", in);
+  bench<RuuviFormatDf5>("DF5", in);
+  bench<RuuviFormatC5>("C5", in);
+  bench<RuuviFormatE1>("E1", in);
+  return 0;
+}
+"""
+
+MAC = bytes((0xD4, 0x12, 0x34, 0x56, 0x78, 0x9A))
+CAP_T, CAP_H, CAP_P, CAP_A = 0x01, 0x02, 0x04, 0x08
+NA = None
+
+
+def u16(b, i):
+    return (b[i] << 8) | b[i + 1]
+
+
+def s16(b, i):
+    v = u16(b, i)
+    return v - 0x10000 if v & 0x8000 else v
+
+
+# --- Reference decoders (Ruuvi specifications) ---
+
+def decode_df3(b):
+    t = (b[2] & 0x7F) + b[3] / 100
+    return {
+        "fmt": b[0],
+        "humidity": b[1] * 0.5,
+        "temperature": -t if b[2] & 0x80 else t,
+        "pressure": u16(b, 4) + 50000,
+        "accel": (s16(b, 6), s16(b, 8), s16(b, 10)),
+        "battery": u16(b, 12),
+    }
+
+
+def decode_env(b):
+    """Temperature, humidity and pressure at bytes 1-6 (DF5, C5, E1)."""
+    return {
+        "fmt": b[0],
+        "temperature": NA if u16(b, 1) == 0x8000 else s16(b, 1) * 0.005,
+        "humidity": NA if u16(b, 3) == 0xFFFF else u16(b, 3) * 0.0025,
+        "pressure": NA if u16(b, 5) == 0xFFFF else u16(b, 5) + 50000,
+    }
+
+
+def decode_power(b, i):
+    v = u16(b, i)
+    return (NA if v >> 5 == 0x7FF else (v >> 5) + 1600), (NA if v & 0x1F == 0x1F else (v & 0x1F) * 2 - 40)
+
+
+def decode_df5(b):
+    d = decode_env(b)
+    d["accel"] = tuple(NA if u16(b, i) == 0x8000 else s16(b, i) for i in (7, 9, 11))
+    d["battery"], d["tx"] = decode_power(b, 13)
+    d["movement"] = b[15]
+    d["sequence"] = u16(b, 16)
+    d["mac"] = bytes(b[18:24])
+    return d
+
+
+def decode_c5(b):
+    d = decode_env(b)
+    d["battery"], d["tx"] = decode_power(b, 7)
+    d["movement"] = b[9]
+    d["sequence"] = u16(b, 10)
+    return d
+
+
+def decode_e1(b):
+    d = decode_env(b)
+    # PM1.0, PM2.5, PM4.0, PM10, CO2: u16 each; VOC, NOx: 9 bits (u8 + flag
+    # bit); luminosity: u24. All ones is "not available".
+    d["pm"] = tuple(NA if u16(b, i) == 0xFFFF else u16(b, i) / 10 for i in (7, 9, 11, 13))
+    d["co2"] = NA if u16(b, 15) == 0xFFFF else u16(b, 15)
+    d["voc"] = NA if (b[17] << 1 | (b[28] >> 6) & 1) == 0x1FF else b[17] << 1 | (b[28] >> 6) & 1
+    d["nox"] = NA if (b[18] << 1 | (b[28] >> 7) & 1) == 0x1FF else b[18] << 1 | (b[28] >> 7) & 1
+    lum = (b[19] << 16) | (b[20] << 8) | b[21]
+    d["luminosity"] = NA if lum == 0xFFFFFF else lum / 100
+    d["reserved"] = bytes(b[22:25]) + bytes(b[29:34])
+    d["sequence"] = (b[25] << 16) | (b[26] << 8) | b[27]
+    d["mac"] = bytes(b[34:40])
+    return d
+
+
+# --- Expected values from the sample ---
+
+def clamp(v, lo, hi):
+    return lo if v < lo else hi if v > hi else v
+
+
+def expect_env(s):
+    t, h, p, batt, tx, ax, ay, az, caps, mov, seq = s
+    return {
+        "temperature": clamp(t / 100, -163.835, 163.835) if caps & CAP_T else NA,
+        "humidity": h * 0.0025 if caps & CAP_H else NA,
+        "pressure": clamp(p, 50000, 115534) if caps & CAP_P else NA,
+        "battery": clamp(batt, 1600, 3646),
+        "tx": clamp((tx + 40) // 2, 0, 30) * 2 - 40,
+        "accel": tuple(clamp(a, -32767, 32767) if caps & CAP_A else NA for a in (ax, ay, az)),
+        "movement": mov,
+    }
+
+
+def close(a, b, tol):
+    if a is NA or b is NA:
+        return a is b
+    return abs(a - b) <= tol
+
+
+def check(fmt, s, d):
+    """List of failed fields for one decoded frame."""
+    t, h, p, batt, tx, ax, ay, az, caps, mov, seq = s
+    e = expect_env(s)
+    bad = []
+
+    def want(field, ok):
+        if not ok:
+            bad.append(field)
+
+    if fmt == "DF3":
+        want("fmt", d["fmt"] == 0x03)
+        want("humidity", close(d["humidity"], clamp(h / 400, 0, 127.5), 0.25 + 1e-9))
+        want("temperature", close(d["temperature"], clamp(t / 100, -127.99, 127.99), 1e-9))
+        want("pressure", d["pressure"] == clamp(p, 50000, 115534))
+        want("accel", d["accel"] == (ax, ay, az))
+        want("battery", d["battery"] == batt)
+        return bad
+
+    want("fmt", d["fmt"] == {"DF5": 0x05, "C5": 0xC5, "E1": 0xE1}[fmt])
+    want("temperature", close(d["temperature"], e["temperature"], 1e-9))
+    want("humidity", close(d["humidity"], e["humidity"], 1e-9))
+    want("pressure", d["pressure"] == e["pressure"])
+    if fmt in ("DF5", "C5"):
+        want("battery", d["battery"] == e["battery"])
+        want("tx", d["tx"] == e["tx"])
+        want("movement", d["movement"] == mov)
+        want("sequence", d["sequence"] == seq & 0xFFFF)
+    if fmt == "DF5":
+        want("accel", d["accel"] == e["accel"])
+        want("mac", d["mac"] == MAC)
+    if fmt == "E1":
+        want("air quality NA", d["pm"] == (NA,) * 4 and d["co2"] is NA and d["voc"] is NA and d["nox"] is NA
+             and d["luminosity"] is NA)
+        want("reserved", d["reserved"] == b"\xff" * 8)
+        want("sequence", d["sequence"] == seq & 0xFFFFFF)
+        want("mac", d["mac"] == MAC)
+    return bad
+
+
+ALL = CAP_T | CAP_H | CAP_P | CAP_A
+BASE = (2150, 18000, 101325, 3000, 3, 12, -8, 1003, ALL, 5, 1234)
+
+
+def edge_samples():
+    """(label, sample) pairs; sample = t_cdeg h_df5 pa mv dbm ax ay az caps mov seq."""
+    def s(**kw):
+        keys = ("t", "h", "p", "batt", "tx", "ax", "ay", "az", "caps", "mov", "seq")
+        v = dict(zip(keys, BASE))
+        v.update(kw)
+        return tuple(v[k] for k in keys)
+
+    return [
+        ("nominal", s()),
+        ("temperature INT16_MIN", s(t=-32768)),
+        ("temperature -163.84 C", s(t=-16384)),
+        ("temperature -163.835 C", s(t=-16383)),
+        ("temperature +163.84 C", s(t=16384)),
+        ("temperature INT16_MAX", s(t=32767)),
+        ("temperature -0.01 C", s(t=-1)),
+        ("DF3 temperature -127.99 C", s(t=-12799)),
+        ("humidity 0", s(h=0)),
+        ("humidity 100 %RH", s(h=40000)),
+        ("pressure 0 Pa", s(p=0)),
+        ("pressure 50000 Pa", s(p=50000)),
+        ("pressure 0xFFFE", s(p=50000 + 0xFFFE)),
+        ("pressure 0xFFFF", s(p=50000 + 0xFFFF)),
+        ("pressure 200000 Pa", s(p=200000)),
+        ("pressure > INT32_MAX", s(p=0xFFFFFFFF)),
+        ("battery 0 mV", s(batt=0)),
+        ("battery 3646 mV", s(batt=3646)),
+        ("battery 3647 mV", s(batt=3647)),
+        ("TX -40 dBm", s(tx=-40)),
+        ("TX +20 dBm", s(tx=20)),
+        ("TX -128 dBm", s(tx=-128)),
+        ("TX +127 dBm", s(tx=127)),
+        ("accel extremes", s(ax=-32768, ay=32767, az=-32767)),
+        ("caps none", s(caps=0)),
+        ("caps no temperature", s(caps=ALL & ~CAP_T)),
+        ("caps no humidity", s(caps=ALL & ~CAP_H)),
+        ("caps no pressure", s(caps=ALL & ~CAP_P)),
+        ("caps no accel", s(caps=ALL & ~CAP_A)),
+        ("sequence 0xFFFF", s(seq=0xFFFF)),
+        ("sequence 0x10000", s(seq=0x10000)),
+        ("sequence 0xFFFFFF", s(seq=0xFFFFFF)),
+        ("sequence 0xFFFFFFFF", s(seq=0xFFFFFFFF)),
+        ("movement 255", s(mov=255)),
+    ]
+
+
+def random_samples(n, rng):
+    out = []
+    for _ in range(n):
+        out.append((rng.randint(-32768, 32767), rng.randint(0, 40000), rng.randint(0, 250000),
+                    rng.randint(0, 5000), rng.randint(-60, 30), rng.randint(-32768, 32767),
+                    rng.randint(-32768, 32767), rng.randint(-32768, 32767), rng.randint(0, 15),
+                    rng.randint(0, 255), rng.randint(0, 0xFFFFFFFF)))
+    return out
+
+
+def main():
+    p = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    p.add_argument("--random", type=int, default=5000, help="random samples on top of the edge values")
+    p.add_argument("--seed", type=int, default=1)
+    args = p.parse_args()
+
+    edges = edge_samples()
+    samples = [s for _, s in edges] + random_samples(args.random, random.Random(args.seed))
+    labels = [label for label, _ in edges] + ["random"] * args.random
+
+    with tempfile.TemporaryDirectory() as build_dir:
+        src = os.path.join(build_dir, "harness.cpp")
+        exe = os.path.join(build_dir, "ruuvi_roundtrip")
+        with open(src, "w") as f:
+            f.write(HARNESS)
+        try:
+            subprocess.run([os.environ.get("CXX", "g++"), "-std=gnu++11", "-O2", "-I", os.path.join(ROOT, "src"),
+                            src, "-o", exe], check=True)
+            data = "".join(" ".join(str(v) for v in s) + "\n" for s in samples)
+            res = subprocess.run([exe], input=data, capture_output=True, check=True, text=True)
+        except (OSError, subprocess.CalledProcessError) as e:
+            sys.exit(f"build or run failed: {e}")
+
+    lines = res.stdout.splitlines()
+    decoders = (("DF3", 14, decode_df3), ("DF5", 24, decode_df5), ("C5", 12, decode_c5), ("E1", 40, decode_e1))
+    failures = {name: [] for name, _, _ in decoders}
+    for label, s, line in zip(labels, samples, lines):
+        for (name, length, decode), hexstr in zip(decoders, line.split()):
+            b = bytes.fromhex(hexstr)
+            bad = ["length"] if len(b) != length else check(name, s, decode(b))
+            if bad:
+                failures[name].append(f"{label} {s}: {', '.join(bad)}")
+    ns = {line.split()[1]: float(line.split()[2]) for line in lines[len(samples):] if line.startswith("bench")}
+
+    print(f"{len(edges)} edge + {args.random} random samples per format")
+    print(f"{'format':>6} {'bytes':>5} {'failed':>6} {'ns/frame':>8} {'Mframes/s':>9}")
+    for name, length, _ in decoders:
+        print(f"{name:>6} {length:5d} {len(failures[name]):6d} {ns[name]:8.2f} {1e3 / ns[name]:9.1f}")
+    failed = False
+    for name, _, _ in decoders:
+        for f in failures[name][:10]:
+            print(f"FAIL {name} {f}")
+            failed = True
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == "__main__":
+    main()
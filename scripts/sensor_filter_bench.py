@@ -0,0 +1,214 @@
+#!/usr/bin/env python3
+"""Host benchmark for the sensor filter stage (src/sensors/sensor_filter.h).
+
+Compiles the firmware header with the host C++ compiler, once per filter
+configuration, and feeds it a polled trace:
+
+  * cost: nanoseconds (and TSC cycles on x86) per filtered sample, i.e. per
+    field of one channel, timed over repeated passes of the trace;
+  * noise rejection: RMS and worst error of the reported values against the
+    reference and the number of polls with an error above the spike
+    threshold, outside the polls right after a step;
+  * step delay: polls until a 2 C step is reported within 0.1 C.
+
+Without --trace a synthetic cold room is used (4 C, sensor noise, in-range
+spikes on 1% of polls, door-opening steps) and the reference is the clean
+signal. With --trace (CSV t_s,temp_c[,rh,hpa], as for poll_trace_replay.py)
+the reference is a centred 15-poll moving median of the recording.
+
+Host timings only rank configurations; on the device the [SENSOR] debug
+line reports the cycles of each filter pass.
+
+    python3 scripts/sensor_filter_bench.py [--trace FILE.csv] [--poll-s 9]
+"""
+
+import argparse
+import csv
+import math
+import os
+import random
+import statistics
+import subprocess
+import sys
+import tempfile
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+HARNESS = r"""
+#include <chrono>
+#include <cstdio>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#endif
+#include "sensors/sensor_filter.h"
+
+int main() {
+  std::vector<SensorSample> in;
+  int t, h;
+  unsigned p;
+  while (scanf("%d %d %u", &t, &h, &p) == 3) {
+    SensorSample s = {};
+    s.temperature_cdeg = static_cast<int16_t>(t);
+    s.humidity_df5 = static_cast<uint16_t>(h);
+    s.pressure_pa = p;
+    s.caps = kSensorCapEnvironment;
+    in.push_back(s);
+  }
+  SensorSampleFilter<1> filter;
+  for (SensorSample s : in) {
+    filter.apply(&s);
+    printf("%d %u %u\n", s.temperature_cdeg, s.humidity_df5, s.pressure_pa);
+  }
+  // Timing: repeated passes over the trace with a fresh filter each pass.
+  const int passes = in.empty() ? 0 : 2000000 / static_cast<int>(in.size()) + 1;
+  volatile uint32_t sink = 0;
+  const auto t0 = std::chrono::steady_clock::now();
+#ifdef HAVE_TSC
+  const unsigned long long c0 = __rdtsc();
+#endif
+  for (int k = 0; k < passes; ++k) {
+    SensorSampleFilter<1> f;
+    for (SensorSample s : in) {
+      f.apply(&s);
+      sink = sink + s.pressure_pa;
+    }
+  }
+#ifdef HAVE_TSC
+  const unsigned long long cycles = __rdtsc() - c0;
+#else
+  const unsigned long long cycles = 0;
+#endif
+  const double ns = std::chrono::duration<double, std::nano>(
+                        std::chrono::steady_clock::now() - t0).count();
+  const double fields = 3.0 * passes * in.size();
+  fprintf(stderr, "%.2f %.2f\n", ns / fields, cycles / fields);
+  return 0;
+}
+"""
+
+CONFIGS = (
+    ("raw", ["-DSENSOR_FILTER_ENABLE=0"]),
+    ("median3", ["-DSENSOR_FILTER_MEDIAN=3", "-DSENSOR_FILTER_IIR_SHIFT=0"]),
+    ("iir1", ["-DSENSOR_FILTER_MEDIAN=1", "-DSENSOR_FILTER_IIR_SHIFT=1"]),
+    ("median3+iir1", []),  # Firmware defaults
+    ("median5+iir2", ["-DSENSOR_FILTER_MEDIAN=5", "-DSENSOR_FILTER_IIR_SHIFT=2"]),
+)
+
+
+def synthetic(polls, poll_s, seed):
+    """(noisy, clean) polls of (cdeg, humidity_df5, pa) and step indices."""
+    rng = random.Random(seed)
+    noisy, clean, steps = [], [], []
+    level = 0.0
+    for i in range(polls):
+        if i % 400 == 200:
+            level = 2.0  # Door open
+            steps.append(i)
+        elif i % 400 == 260:
+            level = 0.0
+            steps.append(i)
+        temp = 4.0 + level + 0.1 * math.sin(2 * math.pi * i * poll_s / 86400)
+        rh = 85.0 - 4.0 * (temp - 4.0)
+        hpa = 1013.0 + 0.5 * math.sin(2 * math.pi * i * poll_s / 43200)
+        clean.append((round(temp * 100), round(rh * 400), round(hpa * 100)))
+        nt = temp + rng.gauss(0, 0.03)
+        nh = rh + rng.gauss(0, 0.15)
+        np_ = hpa + rng.gauss(0, 0.03)
+        if rng.random() < 0.01:  # In-range spike (ADC glitch, SHT30 transient)
+            nt += rng.choice((-1, 1)) * rng.uniform(0.5, 3.0)
+            nh += rng.choice((-1, 1)) * rng.uniform(2.0, 8.0)
+        noisy.append((round(nt * 100), round(nh * 400), round(np_ * 100)))
+    return noisy, clean, steps
+
+
+def load_trace(path, poll_s):
+    rows = []
+    with open(path, newline="") as f:
+        next_t = None
+        for row in csv.DictReader(f):
+            t = float(row["t_s"])
+            if next_t is not None and t < next_t:
+                continue
+            next_t = t + poll_s
+            rh = float(row["rh"]) if row.get("rh") else 0.0
+            hpa = float(row["hpa"]) if row.get("hpa") else 0.0
+            rows.append((round(float(row["temp_c"]) * 100), round(rh * 400), round(hpa * 100)))
+    ref = []
+    for i in range(len(rows)):
+        win = rows[max(0, i - 7):i + 8]
+        ref.append(tuple(int(statistics.median(r[f] for r in win)) for f in range(3)))
+    return rows, ref
+
+
+def run(build_dir, name, flags, polls):
+    exe = os.path.join(build_dir, name)
+    src = os.path.join(build_dir, "harness.cpp")
+    cxx = os.environ.get("CXX", "g++")
+    subprocess.run([cxx, "-std=gnu++11", "-O2", "-I", os.path.join(ROOT, "src"), *flags,
+                    src, "-o", exe], check=True)
+    data = "".join(f"{t} {h} {p}\n" for t, h, p in polls)
+    res = subprocess.run([exe], input=data, capture_output=True, text=True, check=True)
+    out = [tuple(int(v) for v in line.split()) for line in res.stdout.splitlines()]
+    ns, cycles = (float(v) for v in res.stderr.split())
+    return out, ns, cycles
+
+
+SCALE = (100, 400, 100)  # Units per C, %RH, hPa
+SPIKE = (30, 400, 50)    # Error counted as a spike: 0.3 C, 1 %RH, 0.5 hPa
+STEP_WINDOW = 8          # Polls after a step that count towards the step delay only
+
+
+def score(out, ref, steps):
+    settling = set(i + d for i in steps for d in range(STEP_WINDOW))
+    steady = [i for i in range(len(out)) if i not in settling]
+    rms, worst, spikes = [], [], []
+    for f in range(3):
+        err = [out[i][f] - ref[i][f] for i in steady]
+        rms.append(math.sqrt(sum(e * e for e in err) / len(err)) / SCALE[f])
+        worst.append(max(abs(e) for e in err) / SCALE[f])
+        spikes.append(sum(1 for e in err if abs(e) > SPIKE[f]))
+    delays = []
+    for i in steps:
+        d = 0
+        while i + d < len(out) and abs(out[i + d][0] - ref[i + d][0]) > 10:
+            d += 1
+        delays.append(d)
+    return rms, worst, spikes, max(delays) if delays else None
+
+
+def main():
+    p = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    p.add_argument("--trace", help="CSV trace (t_s,temp_c[,rh,hpa])")
+    p.add_argument("--poll-s", type=float, default=9.0, help="poll interval in s (default 9)")
+    p.add_argument("--polls", type=int, default=20000, help="synthetic trace length")
+    p.add_argument("--seed", type=int, default=1)
+    args = p.parse_args()
+
+    if args.trace:
+        polls, ref = load_trace(args.trace, args.poll_s)
+        steps = []
+    else:
+        polls, ref, steps = synthetic(args.polls, args.poll_s, args.seed)
+
+    print(f"trace: {args.trace or 'synthetic cold room'}, {len(polls)} polls every {args.poll_s:g} s")
+    print(f"{'config':>13} {'ns/smp':>7} {'cyc/smp':>7}  {'rms C':>6} {'%RH':>6} {'hPa':>6}  "
+          f"{'max C':>6} {'%RH':>6}  {'spikes C/%RH/hPa':>16}  step")
+    with tempfile.TemporaryDirectory() as build_dir:
+        with open(os.path.join(build_dir, "harness.cpp"), "w") as f:
+            f.write(HARNESS)
+        for name, flags in CONFIGS:
+            try:
+                out, ns, cycles = run(build_dir, name, flags, polls)
+            except (OSError, subprocess.CalledProcessError) as e:
+                sys.exit(f"{name}: build or run failed: {e}")
+            rms, worst, spikes, delay = score(out, ref, steps)
+            cyc = f"{cycles:7.1f}" if cycles else "      -"
+            step = "-" if delay is None else f"{delay} polls"
+            print(f"{name:>13} {ns:7.1f} {cyc}  {rms[0]:6.3f} {rms[1]:6.3f} {rms[2]:6.3f}  "
+                  f"{worst[0]:6.2f} {worst[1]:6.2f}  {spikes[0]:>5}/{spikes[1]}/{spikes[2]:<5}  {step}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,195 @@
+#!/usr/bin/env python3
+"""Host stress test for the seqlock snapshot (src/util/snapshot.h).
+
+Compiles SeqlockSnapshot on the host with std::thread. One writer publishes
+a struct whose fields all hold the same counter, as fast as it can, while
+several readers read it in a loop. A reader must never see:
+
+  torn        fields from two different publishes (not all equal)
+  backwards   an older value after a newer one
+  version     version() behind the value it just read
+
+The same loop runs on an unprotected copy of the struct as a control. Its
+torn reads show that the test can catch tearing on this host; with few
+cores there may be none, so the control is reported, not required.
+
+Exits non-zero if the seqlock shows any torn, backwards or version error.
+
+    python3 scripts/snapshot_stress.py [--readers 3] [--seconds 2] [--words 64]
+"""
+
+import argparse
+import os
+import subprocess
+import sys
+import tempfile
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+HARNESS = r"""
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+#include "util/snapshot.h"
+
+#ifndef WORDS
+#define WORDS 64
+#endif
+
+struct Payload {
+  uint32_t v[WORDS];
+};
+
+struct Counts {
+  unsigned long reads = 0;
+  unsigned long torn = 0;
+  unsigned long backwards = 0;
+  unsigned long version = 0;
+};
+
+static bool all_equal(const Payload &p) {
+  for (int i = 1; i < WORDS; ++i) {
+    if (p.v[i] != p.v[0]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Unprotected control: the same copy without the sequence counter.
+struct Plain {
+  void publish(const Payload &p) {
+    value_ = p;
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+  }
+  Payload read() const {
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+    Payload out = value_;
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+    return out;
+  }
+  uint32_t version() const { return 0; }  // Not checked
+  Payload value_{};
+};
+
+template <typename Snap, bool kCheckVersion>
+static unsigned long run(Snap &snap, int readers, double seconds, std::vector<Counts> &counts) {
+  std::atomic<bool> stop(false);
+  std::atomic<unsigned long> published(0);
+  counts.assign(readers, Counts());
+  std::thread writer([&] {
+    Payload p;
+    uint32_t n = 0;
+    while (!stop.load(std::memory_order_relaxed)) {
+      ++n;
+      for (int i = 0; i < WORDS; ++i) {
+        p.v[i] = n;
+      }
+      snap.publish(p);
+    }
+    published = n;
+  });
+  std::vector<std::thread> threads;
+  for (int r = 0; r < readers; ++r) {
+    threads.emplace_back([&, r] {
+      Counts &c = counts[r];
+      uint32_t last = 0;
+      while (!stop.load(std::memory_order_relaxed)) {
+        const Payload p = snap.read();
+        ++c.reads;
+        if (!all_equal(p)) {
+          ++c.torn;
+          continue;
+        }
+        if (p.v[0] < last) {
+          ++c.backwards;
+        }
+        last = p.v[0];
+        if (kCheckVersion && snap.version() < p.v[0]) {
+          ++c.version;
+        }
+      }
+    });
+  }
+  std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+  stop = true;
+  writer.join();
+  for (std::thread &t : threads) {
+    t.join();
+  }
+  return published;
+}
+
+static void report(const char *name, unsigned long published, const std::vector<Counts> &counts) {
+  Counts sum;
+  for (const Counts &c : counts) {
+    sum.reads += c.reads;
+    sum.torn += c.torn;
+    sum.backwards += c.backwards;
+    sum.version += c.version;
+  }
+  printf("%s %lu %lu %lu %lu %lu\n", name, published, sum.reads, sum.torn, sum.backwards, sum.version);
+}
+
+int main(int argc, char **argv) {
+  const int readers = argc > 1 ? atoi(argv[1]) : 3;
+  const double seconds = argc > 2 ? atof(argv[2]) : 2.0;
+  std::vector<Counts> counts;
+
+  static SeqlockSnapshot<Payload> snap;
+  unsigned long published = run<SeqlockSnapshot<Payload>, true>(snap, readers, seconds, counts);
+  report("seqlock", published, counts);
+
+  static Plain plain;
+  published = run<Plain, false>(plain, readers, seconds, counts);
+  report("unprotected", published, counts);
+  return 0;
+}
+"""
+
+
+def main():
+    p = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    p.add_argument("--readers", type=int, default=3)
+    p.add_argument("--seconds", type=float, default=2.0, help="run time per variant")
+    p.add_argument("--words", type=int, default=64, help="uint32 fields in the published struct")
+    args = p.parse_args()
+
+    with tempfile.TemporaryDirectory() as build_dir:
+        src = os.path.join(build_dir, "harness.cpp")
+        exe = os.path.join(build_dir, "snapshot_stress")
+        with open(src, "w") as f:
+            f.write(HARNESS)
+        try:
+            subprocess.run([os.environ.get("CXX", "g++"), "-std=gnu++11", "-O2", "-pthread", f"-DWORDS={args.words}",
+                            "-I", os.path.join(ROOT, "src"), src, "-o", exe], check=True)
+            res = subprocess.run([exe, str(args.readers), str(args.seconds)], capture_output=True, check=True,
+                                 text=True)
+        except (OSError, subprocess.CalledProcessError) as e:
+            sys.exit(f"build or run failed: {e}")
+
+    print(f"1 writer, {args.readers} readers, {args.words * 4}-byte struct, {args.seconds:g} s each, "
+          f"{os.cpu_count()} CPUs")
+    print(f"{'variant':>11} {'publishes':>10} {'reads':>10} {'torn':>8} {'backwards':>9} {'version':>7}")
+    failed = False
+    for line in res.stdout.splitlines():
+        name, published, reads, torn, backwards, version = line.split()
+        print(f"{name:>11} {int(published):10d} {int(reads):10d} {int(torn):8d} {int(backwards):9d} "
+              f"{version if name == 'seqlock' else '-':>7}")
+        if name == "seqlock":
+            if int(reads) == 0 or int(published) == 0:
+                print("FAIL: no reads or publishes")
+                failed = True
+            if int(torn) or int(backwards) or int(version):
+                print("FAIL: seqlock returned an inconsistent value")
+                failed = True
+        elif int(torn) == 0:
+            print("note: the control saw no torn reads either; rerun with more readers or a larger struct")
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == "__main__":
+    main()
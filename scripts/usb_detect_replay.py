@@ -0,0 +1,234 @@
+#!/usr/bin/env python3
+"""Replay battery traces through the USB trend detector.
+
+Compiles src/power/battery_monitor.h with the host C++ compiler and feeds
+UsbTrendDetector a battery trace sampled at several cadences. The legacy
+float detector (the per-call EWMA it replaces) is modelled alongside, run at
+the 10 ms loop cadence it used to see and at 1 s. For each run it reports:
+
+  * detection latency: time from each plug/unplug until the output matches
+    (a transition not detected before the next one counts as missed);
+  * false toggles: output changes to the wrong state, per hour.
+
+Trace: CSV with a header row and columns t_s, batt_mv and optionally usb
+(0/1, the ground truth). Rows are held until the next row, so any recording
+rate works. Without --trace a synthetic day is used: 1S Li-ion discharging
+under load, USB sessions with the charge-current voltage jump, CC rise and
+CV plateau, short plugs, PMIC noise and TX-burst dips.
+
+    python3 scripts/usb_detect_replay.py [--trace FILE.csv] [--hours 24]
+"""
+
+import argparse
+import bisect
+import csv
+import os
+import random
+import subprocess
+import sys
+import tempfile
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+HARNESS = r"""
+#include <cstdio>
+#include "power/battery_monitor.h"
+
+int main() {
+  UsbTrendDetector det;
+  unsigned long t;
+  unsigned mv;
+  int usb = 0;
+  while (scanf("%lu %u", &t, &mv) == 2) {
+    const UsbTrendDetector::State s = det.update(static_cast<uint32_t>(t), static_cast<uint16_t>(mv));
+    if (s == UsbTrendDetector::kCharging) {
+      usb = 1;
+    } else if (s == UsbTrendDetector::kDischarging) {
+      usb = 0;
+    }
+    printf("%d\n", usb);
+  }
+  return 0;
+}
+"""
+
+
+class LegacyDetector:
+    """The float detector from before battery_monitor.h (per-call EWMA)."""
+
+    def __init__(self):
+        self.vf = 0.0
+        self.vf_prev = 0.0
+        self.sf = 0.0
+        self.score = 0
+        self.state = 0
+        self.last_mv = 0
+        self.usb = False
+
+    def update(self, mv):
+        if self.vf == 0.0:
+            self.vf = self.vf_prev = float(mv)
+        spike = self.last_mv != 0 and abs(mv - self.last_mv) > 30
+        self.vf += 0.05 * (mv - self.vf)
+        slope = self.vf - self.vf_prev
+        self.vf_prev = self.vf
+        self.sf += 0.04 * (slope - self.sf)
+        slope_min = self.sf * 60.0
+        if not spike:
+            if slope_min > 8.0:
+                self.score += 2
+            elif slope_min < -3.0:
+                self.score -= 1
+            elif self.score > 0:
+                self.score -= 1
+            elif self.score < 0:
+                self.score += 1
+            self.score = max(-12, min(12, self.score))
+        if self.score >= 12:
+            self.state = 1
+        elif self.score <= -12:
+            self.state = 2
+        if self.vf > 4150.0 and slope_min > -2.0:
+            self.state = 1
+        self.last_mv = mv
+        if self.state == 1:
+            self.usb = True
+        elif self.state == 2:
+            self.usb = False
+        return int(self.usb)
+
+
+def synthetic(hours, seed):
+    """Per-second (t_ms, mv, usb) rows."""
+    rng = random.Random(seed)
+    rows = []
+    soc_mv = 3900.0
+    usb = False
+    t = 0
+    end = int(hours * 3600)
+    # Alternate battery and USB sessions; every third USB session is a
+    # short plug (10-40 s).
+    sessions = []
+    k = 0
+    while t < end:
+        dur = rng.randint(1800, 7200) if not usb else (
+            rng.randint(10, 40) if k % 3 == 2 else rng.randint(1200, 5400))
+        sessions.append((t, usb))
+        t += dur
+        if usb:
+            k += 1
+        usb = not usb
+    starts = [s[0] for s in sessions]
+    for t in range(end):
+        usb = sessions[bisect.bisect_right(starts, t) - 1][1]
+        if usb:
+            soc_mv = min(4190.0, soc_mv + rng.uniform(0.25, 0.45))  # ~15-27 mV/min CC
+            # Charge current IR rise, tapering off in the CV phase.
+            mv = soc_mv + 40.0 * min(1.0, (4190.0 - soc_mv) / 140.0 + 0.1)
+        else:
+            soc_mv = max(3300.0, soc_mv - rng.uniform(0.01, 0.05))  # ~0.6-3 mV/min under load
+            mv = soc_mv
+        mv += rng.gauss(0, 3.0)
+        if rng.random() < 0.02:
+            mv -= rng.uniform(20.0, 60.0)  # TX burst dip
+        rows.append((t * 1000, int(round(mv)), int(usb)))
+    return rows
+
+
+def load_trace(path):
+    rows = []
+    with open(path, newline="") as f:
+        for row in csv.DictReader(f):
+            usb = row.get("usb")
+            rows.append((int(float(row["t_s"]) * 1000), int(float(row["batt_mv"])),
+                         int(usb) if usb not in (None, "") else None))
+    return rows
+
+
+def resample(rows, period_ms):
+    """Zero-order hold of the trace at a fixed cadence."""
+    out = []
+    i = 0
+    t = rows[0][0]
+    while t <= rows[-1][0]:
+        while i + 1 < len(rows) and rows[i + 1][0] <= t:
+            i += 1
+        out.append((t, rows[i][1], rows[i][2]))
+        t += period_ms
+    return out
+
+
+def run_fixed(exe, samples):
+    data = "".join(f"{t} {mv}\n" for t, mv, _ in samples)
+    res = subprocess.run([exe], input=data, capture_output=True, text=True, check=True)
+    return [int(v) for v in res.stdout.split()]
+
+
+def run_legacy(samples):
+    det = LegacyDetector()
+    return [det.update(mv) for _, mv, _ in samples]
+
+
+def score(samples, out):
+    """Latencies (s) per truth transition, missed count, false toggles."""
+    latencies, missed, false_toggles = [], 0, 0
+    transitions = [i for i in range(1, len(samples))
+                   if samples[i][2] is not None and samples[i][2] != samples[i - 1][2]]
+    for n, i in enumerate(transitions):
+        stop = transitions[n + 1] if n + 1 < len(transitions) else len(samples)
+        j = i
+        while j < stop and out[j] != samples[i][2]:
+            j += 1
+        if j < stop:
+            latencies.append((samples[j][0] - samples[i][0]) / 1000)
+        else:
+            missed += 1
+    for i in range(1, len(out)):
+        if out[i] != out[i - 1] and samples[i][2] is not None and out[i] != samples[i][2]:
+            false_toggles += 1
+    return latencies, missed, false_toggles, len(transitions)
+
+
+def main():
+    p = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    p.add_argument("--trace", help="CSV trace (t_s,batt_mv[,usb])")
+    p.add_argument("--hours", type=float, default=24.0, help="synthetic trace length")
+    p.add_argument("--seed", type=int, default=1)
+    p.add_argument("--no-legacy-10ms", action="store_true",
+                   help="skip the (slow) 10 ms legacy run")
+    args = p.parse_args()
+
+    rows = load_trace(args.trace) if args.trace else synthetic(args.hours, args.seed)
+    span_h = (rows[-1][0] - rows[0][0]) / 3.6e6
+    runs = [("fixed-point, 100 ms", 100, False),
+            ("fixed-point, 1 s", 1000, False),
+            ("fixed-point, 5 s", 5000, False),
+            ("legacy, 1 s", 1000, True)]
+    if not args.no_legacy_10ms:
+        runs.append(("legacy, 10 ms", 10, True))
+
+    print(f"trace: {args.trace or 'synthetic'}, {span_h:.1f} h")
+    print(f"{'detector':>20}  {'median':>7} {'worst':>7}  {'missed':>9}  {'false/h':>7}")
+    with tempfile.TemporaryDirectory() as build_dir:
+        src = os.path.join(build_dir, "harness.cpp")
+        exe = os.path.join(build_dir, "usb_detect")
+        with open(src, "w") as f:
+            f.write(HARNESS)
+        cxx = os.environ.get("CXX", "g++")
+        try:
+            subprocess.run([cxx, "-std=gnu++11", "-O2", "-I", os.path.join(ROOT, "src"), src,
+                            "-o", exe], check=True)
+        except (OSError, subprocess.CalledProcessError) as e:
+            sys.exit(f"build failed: {e}")
+        for name, period, legacy in runs:
+            samples = resample(rows, period)
+            out = run_legacy(samples) if legacy else run_fixed(exe, samples)
+            lat, missed, false_toggles, n = score(samples, out)
+            lat.sort()
+            med = f"{lat[len(lat) // 2]:6.0f}s" if lat else "      -"
+            worst = f"{lat[-1]:6.0f}s" if lat else "      -"
+            print(f"{name:>20}  {med} {worst}  {missed:>4}/{n:<4}  {false_toggles / span_h:7.2f}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,289 @@
+#!/usr/bin/env python3
+"""Virtual-clock check of the virtual tag scheduler (src/ble/vtag_scheduler.h).
+
+Compiles VirtualTagScheduler on the host and drives it the way loop() does
+(serviceVirtualTags(): at most one tag per pass, the most overdue one),
+on a virtual clock, through:
+
+  FAST 1285 ms -> SLOW 8995 ms -> FAST 1285 ms   mode switches
+  a 15 s stall in SLOW and a 4 s stall in FAST   loop() blocked elsewhere
+
+once with extended advertising (a tag can go as soon as it is due) and once
+with legacy slots (one tag on air per VTAG_SLOT_MS). It checks:
+
+  stagger       once settled, consecutive updates of different tags are at
+                least 3/4 of interval / N apart
+  period        once settled, each tag's updates are one interval apart
+  switch        after a switch to a shorter interval every tag updates
+                within the new interval
+  skip          after a stall every tag sends one catch-up update, not one
+                per missed interval (at most 4 updates in the 3 intervals
+                after it), never two within half an interval, and goes
+                back to its place in the stagger
+  rate          rateCentiPerMin() over each settled window matches the
+                updates counted here, and 60000 / interval per minute
+                within 3% (or one update, for short windows); "rate off"
+                is the worst difference, in updates per window
+
+Exits non-zero if any check fails.
+
+    python3 scripts/vtag_scheduler_sim.py [--tags 3]
+"""
+
+import argparse
+import os
+import subprocess
+import sys
+import tempfile
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+HARNESS = r"""
+#include <cstdio>
+#include <cstdlib>
+#include "ble/vtag_scheduler.h"
+
+#ifndef TAGS
+#define TAGS 3
+#endif
+
+struct Phase {
+  uint32_t start_ms;
+  uint32_t interval_ms;
+};
+
+// Input: slot_ms, then "phase <start> <interval>", "stall <start> <end>",
+// "rate <start> <end>" lines, then "end <ms>". Output: "send <t> <tag>" and
+// "rate <end> <tag> <centi/min>" lines.
+int main() {
+  unsigned slot_ms;
+  if (scanf("%u", &slot_ms) != 1) {
+    return 1;
+  }
+  Phase phases[16];
+  unsigned stalls[16][2];
+  unsigned rates[16][2];
+  int np = 0, ns = 0, nr = 0;
+  unsigned end_ms = 0;
+  char kind[16];
+  unsigned a, b;
+  while (scanf("%15s %u", kind, &a) == 2) {
+    if (kind[0] == 'e') {
+      end_ms = a;
+      break;
+    }
+    if (scanf("%u", &b) != 1) {
+      return 1;
+    }
+    if (kind[0] == 'p') {
+      phases[np++] = Phase{a, b};
+    } else if (kind[0] == 's') {
+      stalls[ns][0] = a;
+      stalls[ns++][1] = b;
+    } else {
+      rates[nr][0] = a;
+      rates[nr++][1] = b;
+    }
+  }
+
+  const uint8_t base[6] = {0xD4, 0x12, 0x34, 0x56, 0x78, 0x9A};
+  VirtualTagScheduler<TAGS> vt;
+  vt.begin(base, 0, 0);
+  uint32_t slot_end = 0;
+  uint32_t now = 0;
+  while (now < end_ms) {
+    for (int i = 0; i < ns; ++i) {
+      if (now >= stalls[i][0] && now < stalls[i][1]) {
+        now = stalls[i][1];
+      }
+    }
+    for (int i = 0; i < nr; ++i) {
+      if (now >= rates[i][0] && now < rates[i][0] + 10) {
+        vt.resetRateWindow(now);
+      }
+      if (now >= rates[i][1] && now < rates[i][1] + 10) {
+        for (size_t k = 0; k < TAGS; ++k) {
+          printf("rate %u %u %u\n", rates[i][1], static_cast<unsigned>(k), vt.rateCentiPerMin(k, now));
+        }
+      }
+    }
+    uint32_t interval = 0;
+    for (int i = 0; i < np; ++i) {
+      if (now >= phases[i].start_ms) {
+        interval = phases[i].interval_ms;
+      }
+    }
+    // serviceVirtualTags()
+    vt.setInterval(now, interval);
+    if (static_cast<int32_t>(now - slot_end) >= 0) {
+      const int k = vt.due(now);
+      if (k >= 0) {
+        vt.markSent(static_cast<size_t>(k), now);
+        printf("send %u %d\n", now, k);
+        slot_end = now + slot_ms;
+      }
+    }
+    // loop() sleeps until the next tag is due (at least 1 ms, at most 10 ms
+    // so the stalls and rate windows above are seen on time).
+    uint32_t wait = vt.msUntilNext(now);
+    if (slot_ms && static_cast<int32_t>(slot_end - now) > static_cast<int32_t>(wait)) {
+      wait = slot_end - now;
+    }
+    now += wait < 1 ? 1 : (wait > 10 ? 10 : wait);
+  }
+  return 0;
+}
+"""
+
+FAST, SLOW = 1285, 8995
+PHASES = ((0, FAST), (120000, SLOW), (300000, FAST))
+STALLS = ((200000, 215000), (350000, 354000))
+END = 420000
+SETTLE = 2  # Intervals after a switch or stall before the steady-state checks
+
+
+def unsettled(t):
+    """True during a stall and for SETTLE intervals after a switch or stall."""
+    if any(s <= t < e for s, e in STALLS):
+        return True
+    for b in [s for s, _ in PHASES] + [e for _, e in STALLS]:
+        settle = SETTLE * max(interval_at(b - 1) if b else 0, interval_at(b))
+        if b <= t < b + settle:
+            return True
+    return False
+
+
+def interval_at(t):
+    current = PHASES[0][1]
+    for start, interval in PHASES:
+        if t >= start:
+            current = interval
+    return current
+
+
+def rate_windows():
+    """Settled windows of at least 30 s without a switch or stall."""
+    bounds = sorted(set([s for s, _ in PHASES] + [s for s, _ in STALLS] + [e for _, e in STALLS] + [END]))
+    out = []
+    for start, end in zip(bounds, bounds[1:]):
+        if any(s <= start < e for s, e in STALLS):
+            continue
+        settle = start + SETTLE * max(interval_at(start - 1) if start else 0, interval_at(start))
+        if end - settle >= 30000:
+            out.append((settle, end))
+    return out
+
+
+def check(tags, slot_ms, sends, rates):
+    failures = []
+    by_tag = {k: [t for t, tag in sends if tag == k] for k in range(tags)}
+
+    # Stagger and period, settled only.
+    min_stagger = None
+    for (t0, k0), (t1, k1) in zip(sends, sends[1:]):
+        if k0 != k1 and not unsettled(t0) and not unsettled(t1) and interval_at(t0) == interval_at(t1):
+            gap = t1 - t0
+            want = 0.75 * interval_at(t1) / tags
+            min_stagger = gap if min_stagger is None else min(min_stagger, gap)
+            if gap < want:
+                failures.append(f"stagger: tag{k0}@{t0} -> tag{k1}@{t1} only {gap} ms apart")
+    worst_period = 0
+    for k, ts in by_tag.items():
+        for t0, t1 in zip(ts, ts[1:]):
+            if not unsettled(t0) and not unsettled(t1) and interval_at(t0) == interval_at(t1):
+                err = abs((t1 - t0) - interval_at(t1))
+                worst_period = max(worst_period, err)
+                if err > max(10, slot_ms):
+                    failures.append(f"period: tag{k} {t0} -> {t1}")
+
+    # A switch to a shorter interval reaches every tag within the new interval.
+    for (start, interval), (_, prev) in zip(PHASES[1:], PHASES):
+        if interval < prev:
+            for k, ts in by_tag.items():
+                first = next((t for t in ts if t >= start), None)
+                if first is None or first - start > interval + slot_ms:
+                    failures.append(f"switch: tag{k} not updated within {interval} ms of {start}")
+
+    # Skip, don't burst.
+    min_gap = None
+    for k, ts in by_tag.items():
+        for t0, t1 in zip(ts, ts[1:]):
+            if any(t0 < start <= t1 for start, _ in PHASES):
+                continue  # A switch may update a tag at once (checked above)
+            gap = t1 - t0
+            min_gap = gap if min_gap is None else min(min_gap, gap)
+            if gap < interval_at(t1) / 2:
+                failures.append(f"burst: tag{k} {t0} -> {t1}")
+        for _, end in STALLS:
+            after = [t for t in ts if end <= t < end + 3 * interval_at(end)]
+            if not after or len(after) > 4:
+                failures.append(f"skip: tag{k} updated {len(after)} times in 3 intervals after the stall at {end}")
+
+    # Rate.
+    worst_rate = 0.0
+    for (start, end), per_tag in rates.items():
+        for k, centi in per_tag.items():
+            counted = sum(1 for t in by_tag[k] if start <= t < end) * 6000000 / (end - start)
+            expected = 6000000 / interval_at(start)
+            worst_rate = max(worst_rate, abs(centi - expected) * (end - start) / 6000000)  # In updates
+            tolerance = max(0.03 * expected, 6000000 / (end - start))
+            if abs(centi - counted) > 1 or abs(centi - expected) > tolerance:
+                failures.append(f"rate: tag{k} [{start},{end}) {centi / 100:.2f}/min, counted {counted / 100:.2f}, "
+                                f"expected {expected / 100:.2f}")
+    return failures, min_stagger, worst_period, min_gap, worst_rate
+
+
+def main():
+    p = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    p.add_argument("--tags", type=int, default=3)
+    args = p.parse_args()
+
+    windows = rate_windows()
+    script = "".join(f"phase {s} {i}\n" for s, i in PHASES)
+    script += "".join(f"stall {s} {e}\n" for s, e in STALLS)
+    script += "".join(f"rate {s} {e}\n" for s, e in windows)
+    script += f"end {END}\n"
+
+    print(f"{args.tags} tags, FAST {FAST} ms / SLOW {SLOW} ms, stalls "
+          + ", ".join(f"{(e - s) / 1000:g} s at {s / 1000:g} s" for s, e in STALLS))
+    print(f"{'mode':>8} {'updates':>7} {'min stagger':>11} {'period err':>10} {'min gap':>7} "
+          f"{'rate off':>8} {'failed':>6}")
+    all_failures = []
+    with tempfile.TemporaryDirectory() as build_dir:
+        src = os.path.join(build_dir, "harness.cpp")
+        exe = os.path.join(build_dir, "vtag_sim")
+        with open(src, "w") as f:
+            f.write(HARNESS)
+        try:
+            subprocess.run([os.environ.get("CXX", "g++"), "-std=gnu++11", "-O2", f"-DTAGS={args.tags}",
+                            "-I", os.path.join(ROOT, "src"), src, "-o", exe], check=True)
+        except (OSError, subprocess.CalledProcessError) as e:
+            sys.exit(f"build failed: {e}")
+        for name, slot_ms in (("extended", 0), ("legacy", 60)):
+            try:
+                res = subprocess.run([exe], input=f"{slot_ms}\n" + script, capture_output=True, check=True,
+                                     text=True)
+            except (OSError, subprocess.CalledProcessError) as e:
+                sys.exit(f"run failed: {e}")
+            sends, rates = [], {}
+            for line in res.stdout.splitlines():
+                f = line.split()
+                if f[0] == "send":
+                    sends.append((int(f[1]), int(f[2])))
+                else:
+                    end = int(f[1])
+                    start = next(s for s, e in windows if e == end)
+                    rates.setdefault((start, end), {})[int(f[2])] = int(f[3])
+            failures, stagger, period, gap, rate = check(args.tags, slot_ms, sends, rates)
+            ms = lambda v, w: f"{v:{w}d}ms" if v is not None else f"{'-':>{w + 2}}"  # noqa: E731
+            print(f"{name:>8} {len(sends):7d} {ms(stagger, 9)} {ms(period, 8)} {ms(gap, 5)} {rate:8.2f} "
+                  f"{len(failures):6d}")
+            all_failures += [f"{name} {f}" for f in failures]
+
+    for f in all_failures[:20]:
+        print("FAIL " + f)
+    sys.exit(1 if all_failures else 0)
+
+
+if __name__ == "__main__":
+    main()
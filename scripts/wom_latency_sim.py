@@ -0,0 +1,179 @@
+#!/usr/bin/env python3
+"""Host simulation of the wake-on-motion path and the FAST-mode transition.
+
+Steps a 1 ms clock through the firmware's motion path in HYBRID mode and
+throws random bumps at it while the device sits in SLOW mode:
+
+  legacy   accelerometer read on every sensor base tick (8.995 s in SLOW),
+           compared at advertising ticks (updateMovementCounter())
+  wom-pin  MPU6886 wake-on-motion latch -> GPIO ISR -> noteMotion() ->
+           loop() pass -> immediate advertisement (src/motion/imu_wom.h)
+  wom-poll the same latch, read from INT_STATUS every IMU_WOM_POLL_MS by
+           the sensor task
+
+For each path it reports bumps missed, the latency from the start of a
+bump to FAST mode (gFastUntilMs extended) and to the first advertisement
+in FAST mode, and the idle IMU I2C reads per hour. Exits non-zero if a WOM
+path misses a bump that lasts at least one IMU sample period (shorter ones
+can fall between two samples and are listed separately) or exceeds its
+latency bound (one IMU sample period plus the poll period and two loop
+passes). The IMU's low-pass filter, which spreads a short knock over the
+following samples, is not modelled.
+
+    python3 scripts/wom_latency_sim.py [--bumps 200] [--odr-hz 10] [--poll-ms 500]
+"""
+
+import argparse
+import random
+import sys
+
+LOOP_MS = 10           # loop() idle delay
+TASK_TICK_MS = 10      # SENSOR_TASK_TICK_MS
+SLOW_ADV_MS = 8995
+FAST_ADV_MS = 1285
+SLOW_POLL_MS = 8995    # Sensor base tick in SLOW mode
+FAST_MOVEMENT_MS = 60000
+ADV_UPDATE_MS = 50     # startAdvertising() plus its settle delay
+
+
+def make_bumps(n, seed):
+    """Bump durations (ms): mostly short knocks, some handling."""
+    rng = random.Random(seed)
+    return [rng.choice((rng.randint(20, 200), rng.randint(200, 1500), rng.randint(1500, 6000)))
+            for _ in range(n)]
+
+
+def simulate(path, dur, odr_ms, poll_ms, rng):
+    """One bump hitting a device that has been in SLOW mode for a while.
+
+    Returns (ms to FAST mode, ms to the first FAST advertisement), or None
+    if the bump went unnoticed. Timer phases are random; the bump starts at
+    t = 0.
+    """
+    fast_until = -10 ** 9     # Long back in SLOW mode
+    pending = 0               # kMotionSeen | kMotionEnteredFast
+    isr_fired = False
+    wom_latch = False
+    force_adv = False
+    last_adv = -rng.randint(0, SLOW_ADV_MS - 1)
+    last_poll = -rng.randint(0, SLOW_POLL_MS - 1)
+    last_wom_poll = -rng.randint(0, poll_ms - 1)
+    loop_phase = rng.randint(0, LOOP_MS - 1)
+    task_phase = rng.randint(0, TASK_TICK_MS - 1)
+    odr_phase = rng.randint(0, odr_ms - 1)
+    accel_read = 0            # Latest base-tick sample (0 = rest, 1 = displaced)
+    last_compared = 0
+    prev_sample = False
+    to_fast = None
+
+    def note_motion(t):
+        nonlocal fast_until, pending, to_fast
+        if to_fast is None:
+            to_fast = t
+        bits = 1
+        if t >= fast_until:
+            bits |= 2
+        fast_until = max(fast_until, t + FAST_MOVEMENT_MS)
+        pending |= bits
+
+    for t in range(-LOOP_MS, dur + SLOW_ADV_MS + SLOW_POLL_MS):
+        in_bump = 0 <= t < dur
+
+        # IMU samples at its output data rate; WOM compares each sample
+        # with the previous one and latches the INT line.
+        if path != "legacy" and (t - odr_phase) % odr_ms == 0:
+            if in_bump != prev_sample:
+                if not wom_latch and path == "wom-pin":
+                    isr_fired = True  # onImuWomIsr() on the rising edge
+                    note_motion(t)
+                wom_latch = True
+            prev_sample = in_bump
+
+        # Sensor task tick (serviceImuWom(), base-interval accel read).
+        if (t - task_phase) % TASK_TICK_MS == 0:
+            base = FAST_ADV_MS if t < fast_until else SLOW_POLL_MS
+            if path == "legacy" and t - last_poll >= max(base, 2000):
+                last_poll = t
+                accel_read = 1 if in_bump else 0
+            if path == "wom-pin" and isr_fired:
+                isr_fired = False
+                wom_latch = False  # imu_wom_take() reads INT_STATUS
+            if path == "wom-poll" and t - last_wom_poll >= poll_ms:
+                last_wom_poll = t
+                if wom_latch:
+                    wom_latch = False
+                    note_motion(t)
+
+        # loop() pass.
+        if (t - loop_phase) % LOOP_MS == 0:
+            if pending:
+                if pending & 2:
+                    force_adv = True
+                pending = 0
+            in_fast = t < fast_until  # Mode is decided at the top of loop()
+            if force_adv or t - last_adv >= (FAST_ADV_MS if in_fast else SLOW_ADV_MS):
+                last_adv = t
+                force_adv = False
+                if t >= 0 and in_fast:
+                    return to_fast, t + ADV_UPDATE_MS
+                if path == "legacy" and accel_read != last_compared:
+                    last_compared = accel_read
+                    if to_fast is None:
+                        to_fast = t
+                    if t >= fast_until:
+                        force_adv = True  # Next pass advertises in FAST mode
+                    fast_until = max(fast_until, t + FAST_MOVEMENT_MS)
+    return None
+
+
+def pct(values, q):
+    if not values:
+        return float("nan")
+    values = sorted(values)
+    return values[min(len(values) - 1, int(q * len(values)))]
+
+
+def main():
+    p = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    p.add_argument("--bumps", type=int, default=200)
+    p.add_argument("--odr-hz", type=int, default=10, help="IMU sample rate (IMU_FIFO_ODR_HZ)")
+    p.add_argument("--poll-ms", type=int, default=500, help="IMU_WOM_POLL_MS")
+    p.add_argument("--seed", type=int, default=1)
+    args = p.parse_args()
+
+    odr_ms = max(1, round(1000 / args.odr_hz))
+    bumps = make_bumps(args.bumps, args.seed)
+    bounds = {"wom-pin": odr_ms + 2 * LOOP_MS + ADV_UPDATE_MS,
+              "wom-poll": odr_ms + args.poll_ms + TASK_TICK_MS + 2 * LOOP_MS + ADV_UPDATE_MS}
+    # IMU reads per hour while still: the accel read on every SLOW base tick,
+    # one INT_STATUS byte per poll, or nothing with the interrupt pin.
+    idle_reads = {"legacy": 3.6e6 / SLOW_POLL_MS, "wom-pin": 0.0, "wom-poll": 3.6e6 / args.poll_ms}
+    print(f"{len(bumps)} bumps in SLOW mode, IMU {args.odr_hz} Hz, INT_STATUS poll {args.poll_ms} ms")
+    print(f"{'path':>9}  {'missed':>6} {'short':>5}  {'to FAST p50/p95/max (ms)':>26}  "
+          f"{'to FAST adv p50/max (ms)':>25}  {'idle reads/h':>12}")
+    failed = False
+    for path in ("legacy", "wom-pin", "wom-poll"):
+        rng = random.Random(args.seed)
+        to_fast, to_adv, missed, short = [], [], 0, 0
+        for dur in bumps:
+            res = simulate(path, dur, odr_ms, args.poll_ms, rng)
+            if res is None and path != "legacy" and dur < odr_ms:
+                short += 1  # Between two IMU samples
+            elif res is None:
+                missed += 1
+            else:
+                to_fast.append(res[0])
+                to_adv.append(res[1])
+        print(f"{path:>9}  {missed:>6} {short:>5}  {pct(to_fast, 0.5):>8.0f} {pct(to_fast, 0.95):>8.0f} "
+              f"{pct(to_fast, 1.0):>8.0f}  {pct(to_adv, 0.5):>12.0f} {pct(to_adv, 1.0):>12.0f}  "
+              f"{idle_reads[path]:>12.0f}")
+        if path in bounds and (missed or pct(to_adv, 1.0) > bounds[path]):
+            print(f"FAIL: {path} missed {missed} bumps or exceeded {bounds[path]} ms")
+            failed = True
+    if failed:
+        sys.exit(1)
+    print("OK")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,209 @@
+#pragma once
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include <stdint.h>
+
+#include "adc_cal_curve.h"
+
+#if defined(ESP_ARDUINO_VERSION_MAJOR) && ESP_ARDUINO_VERSION_MAJOR >= 3
+#include <esp_adc/adc_cali.h>
+#include <esp_adc/adc_cali_scheme.h>
+#else
+#include <esp_adc_cal.h>
+#endif
+
+// Per-chip ADC calibration.
+//
+// The first boot turns the eFuse calibration (two-point, Vref or curve
+// fitting, whatever the chip carries) into an AdcCalCurve and stores it in
+// NVS; later boots only load the blob. Chips without eFuse calibration data
+// stay uncalibrated and callers keep their nominal conversion.
+
+#ifndef ADC_CAL_ENABLE
+#define ADC_CAL_ENABLE 1
+#endif
+// Keep the curve in NVS so later boots skip the IDF calibration code.
+#ifndef ADC_CAL_CACHE
+#define ADC_CAL_CACHE 1
+#endif
+// Attenuation the calibrated pins are sampled with (one setting for all
+// ADC engine pins).
+#ifndef ADC_CAL_ATTEN
+#ifdef BATTERY_ADC_ATTENUATION
+#define ADC_CAL_ATTEN BATTERY_ADC_ATTENUATION
+#else
+#define ADC_CAL_ATTEN ADC_ATTEN_DB_12
+#endif
+#endif
+
+enum AdcCalSource : uint8_t {
+  kAdcCalNone = 0,
+  kAdcCalEfuseTwoPoint = 1,
+  kAdcCalEfuseVref = 2,
+  kAdcCalEfuseCurve = 3,
+};
+
+constexpr uint8_t kAdcCalVersion = 1;
+
+// NVS blob ("adc_cal"/"curve").
+struct AdcCalBlob {
+  uint8_t version;
+  uint8_t atten;
+  uint8_t source;
+  uint8_t knot_bits;
+  AdcCalCurve curve;
+};
+
+static AdcCalBlob gAdcCal = {};
+static bool gAdcCalReady = false;
+static bool gAdcCalTried = false;
+static bool gAdcCalCached = false;   // Loaded from NVS this boot
+static uint32_t gAdcCalBeginUs = 0;  // Time adc_cal_begin() took
+
+inline const char *adc_cal_source_name(uint8_t source) {
+  switch (source) {
+    case kAdcCalEfuseTwoPoint:
+      return "eFuse two-point";
+    case kAdcCalEfuseVref:
+      return "eFuse Vref";
+    case kAdcCalEfuseCurve:
+      return "eFuse curve fitting";
+    default:
+      return "none";
+  }
+}
+
+// Build the curve from the IDF calibration; kAdcCalNone if the chip has no
+// eFuse calibration data.
+inline uint8_t adc_cal_characterize(AdcCalCurve &curve) {
+#if defined(ESP_ARDUINO_VERSION_MAJOR) && ESP_ARDUINO_VERSION_MAJOR >= 3
+  adc_cali_handle_t handle = nullptr;
+  uint8_t source = kAdcCalNone;
+#if ADC_CALI_SCHEME_CURVE_FITTING_SUPPORTED
+  adc_cali_curve_fitting_config_t cfg = {};
+  cfg.unit_id = ADC_UNIT_1;
+  cfg.atten = static_cast<adc_atten_t>(ADC_CAL_ATTEN);
+  cfg.bitwidth = ADC_BITWIDTH_12;
+  if (adc_cali_create_scheme_curve_fitting(&cfg, &handle) == ESP_OK) {
+    source = kAdcCalEfuseCurve;
+  }
+#elif ADC_CALI_SCHEME_LINE_FITTING_SUPPORTED
+  adc_cali_line_fitting_efuse_val_t efuse = ADC_CALI_LINE_FITTING_EFUSE_VAL_DEFAULT_VREF;
+#if CONFIG_IDF_TARGET_ESP32
+  adc_cali_scheme_line_fitting_check_efuse(&efuse);
+#else
+  efuse = ADC_CALI_LINE_FITTING_EFUSE_VAL_EFUSE_TP;
+#endif
+  adc_cali_line_fitting_config_t cfg = {};
+  cfg.unit_id = ADC_UNIT_1;
+  cfg.atten = static_cast<adc_atten_t>(ADC_CAL_ATTEN);
+  cfg.bitwidth = ADC_BITWIDTH_12;
+  if (efuse != ADC_CALI_LINE_FITTING_EFUSE_VAL_DEFAULT_VREF &&
+      adc_cali_create_scheme_line_fitting(&cfg, &handle) == ESP_OK) {
+    source = efuse == ADC_CALI_LINE_FITTING_EFUSE_VAL_EFUSE_VREF ? kAdcCalEfuseVref
+                                                                 : kAdcCalEfuseTwoPoint;
+  }
+#endif
+  if (source == kAdcCalNone) {
+    return kAdcCalNone;
+  }
+  adc_cal_curve_build(curve, [handle](uint16_t raw) {
+    int mv = 0;
+    adc_cali_raw_to_voltage(handle, raw, &mv);
+    return static_cast<uint16_t>(mv < 0 ? 0 : mv);
+  });
+#if ADC_CALI_SCHEME_CURVE_FITTING_SUPPORTED
+  adc_cali_delete_scheme_curve_fitting(handle);
+#elif ADC_CALI_SCHEME_LINE_FITTING_SUPPORTED
+  adc_cali_delete_scheme_line_fitting(handle);
+#endif
+  return source;
+#else
+  esp_adc_cal_characteristics_t chars;
+  const esp_adc_cal_value_t type = esp_adc_cal_characterize(
+      ADC_UNIT_1, static_cast<adc_atten_t>(ADC_CAL_ATTEN), ADC_WIDTH_BIT_12, 1100, &chars);
+  uint8_t source = kAdcCalNone;
+  switch (type) {
+    case ESP_ADC_CAL_VAL_EFUSE_TP:
+      source = kAdcCalEfuseTwoPoint;
+      break;
+    case ESP_ADC_CAL_VAL_EFUSE_VREF:
+      source = kAdcCalEfuseVref;
+      break;
+    case ESP_ADC_CAL_VAL_EFUSE_TP_FIT:
+      source = kAdcCalEfuseCurve;
+      break;
+    default:
+      return kAdcCalNone;  // Default Vref only: no better than nominal
+  }
+  adc_cal_curve_build(curve, [&chars](uint16_t raw) {
+    return static_cast<uint16_t>(esp_adc_cal_raw_to_voltage(raw, &chars));
+  });
+  return source;
+#endif
+}
+
+inline bool adc_cal_load(AdcCalBlob &blob) {
+  Preferences prefs;
+  if (!prefs.begin("adc_cal", true)) {
+    return false;
+  }
+  const size_t len = prefs.getBytes("curve", &blob, sizeof(blob));
+  prefs.end();
+  return len == sizeof(blob) && blob.version == kAdcCalVersion &&
+         blob.atten == static_cast<uint8_t>(ADC_CAL_ATTEN) &&
+         blob.knot_bits == kAdcCalKnotBits && blob.source != kAdcCalNone;
+}
+
+inline void adc_cal_store(const AdcCalBlob &blob) {
+  Preferences prefs;
+  if (!prefs.begin("adc_cal", false)) {
+    return;
+  }
+  prefs.putBytes("curve", &blob, sizeof(blob));
+  prefs.end();
+}
+
+// Load (or build and cache) the calibration curve. Safe to call more than
+// once; only the first call does anything.
+inline bool adc_cal_begin() {
+  if (!ADC_CAL_ENABLE || gAdcCalTried) {
+    return gAdcCalReady;
+  }
+  gAdcCalTried = true;
+  const uint32_t start_us = micros();
+#if ADC_CAL_CACHE
+  if (adc_cal_load(gAdcCal)) {
+    gAdcCalCached = true;
+    gAdcCalReady = true;
+    gAdcCalBeginUs = micros() - start_us;
+    return true;
+  }
+#endif
+  gAdcCal.version = kAdcCalVersion;
+  gAdcCal.atten = static_cast<uint8_t>(ADC_CAL_ATTEN);
+  gAdcCal.knot_bits = kAdcCalKnotBits;
+  gAdcCal.source = adc_cal_characterize(gAdcCal.curve);
+  gAdcCalReady = gAdcCal.source != kAdcCalNone;
+#if ADC_CAL_CACHE
+  if (gAdcCalReady) {
+    adc_cal_store(gAdcCal);
+  }
+#endif
+  gAdcCalBeginUs = micros() - start_us;
+  return gAdcCalReady;
+}
+
+inline bool adc_cal_ready() {
+  return gAdcCalReady;
+}
+
+// raw16 -> millivolts * 16 at the pin. False without calibration.
+inline bool adc_cal_mv16_from_raw16(uint16_t raw16, uint32_t &mv16) {
+  if (!gAdcCalReady) {
+    return false;
+  }
+  mv16 = adc_cal_mv16(gAdcCal.curve, raw16);
+  return true;
+}
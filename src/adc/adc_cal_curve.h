@@ -0,0 +1,66 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "adc_filter.h"
+
+// Per-chip ADC correction curve: millivolts at evenly spaced raw codes,
+// linear interpolation in between.
+//
+// The curve is sampled once from the chip's eFuse calibration (see
+// adc_cal.h) and cached in NVS, so readers never call into the IDF
+// calibration code. With 64-count knots (130 bytes) the curve stays within
+// 2 mV of the IDF conversion; adc_cal_curve_build() measures the error at
+// every raw code and stores it with the curve. scripts/adc_cal_model.py
+// compiles this builder on the host and runs it against synthetic
+// characteristic sets.
+constexpr uint8_t kAdcCalKnotBits = 6;  // 64-count knot spacing
+constexpr uint8_t kAdcCalKnots = (4096 >> kAdcCalKnotBits) + 1;
+
+struct AdcCalCurve {
+  uint16_t mv[kAdcCalKnots];  // Millivolts at raw = i << kAdcCalKnotBits
+  uint16_t max_err_mv;        // Worst interpolation error at build time
+};
+
+// raw16 (raw * 16) -> millivolts * 16.
+inline uint32_t adc_cal_mv16(const AdcCalCurve &curve, uint16_t raw16) {
+  constexpr uint8_t shift = kAdcCalKnotBits + kAdcFracBits;
+  const uint16_t idx = raw16 >> shift;
+  if (idx >= kAdcCalKnots - 1) {
+    return uint32_t(curve.mv[kAdcCalKnots - 1]) << kAdcFracBits;
+  }
+  const int32_t a = curve.mv[idx];
+  const int32_t b = curve.mv[idx + 1];
+  const int32_t frac = raw16 & ((1u << shift) - 1);
+  // (a + (b - a) * frac / 2^shift) * 16, kept in one division.
+  return static_cast<uint32_t>((a << kAdcFracBits) +
+                               (b - a) * frac / (1 << kAdcCalKnotBits));
+}
+
+inline uint16_t adc_cal_mv(const AdcCalCurve &curve, uint16_t raw16) {
+  return static_cast<uint16_t>((adc_cal_mv16(curve, raw16) + 8) >> kAdcFracBits);
+}
+
+// Sample `raw_to_mv` at every knot, then measure the worst error of the
+// interpolated curve over all 4096 raw codes. The last knot (raw 4096) is
+// extrapolated from the last segment, as the ADC tops out at 4095.
+template <typename RawToMv>
+inline void adc_cal_curve_build(AdcCalCurve &curve, RawToMv raw_to_mv) {
+  for (uint8_t i = 0; i < kAdcCalKnots - 1; ++i) {
+    curve.mv[i] = raw_to_mv(static_cast<uint16_t>(i << kAdcCalKnotBits));
+  }
+  const int32_t below = raw_to_mv(static_cast<uint16_t>(4095 - (1 << kAdcCalKnotBits)));
+  const int32_t top = raw_to_mv(4095);
+  int32_t last = top + (top - below) / ((1 << kAdcCalKnotBits) - 1);
+  curve.mv[kAdcCalKnots - 1] = static_cast<uint16_t>(last < 0 ? 0 : (last > 0xFFFF ? 0xFFFF : last));
+
+  uint16_t worst = 0;
+  for (uint16_t raw = 0; raw < 4096; ++raw) {
+    const int32_t err = int32_t(adc_cal_mv(curve, raw << kAdcFracBits)) - int32_t(raw_to_mv(raw));
+    const uint16_t abs_err = static_cast<uint16_t>(err < 0 ? -err : err);
+    if (abs_err > worst) {
+      worst = abs_err;
+    }
+  }
+  curve.max_err_mv = worst;
+}
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <Arduino.h>
+#include <stdint.h>
+
+#include "adc_cal.h"
+#include "adc_filter.h"
+#include "power/pm_lock.h"
+
+// Shared background ADC acquisition.
+//
+// Users (NTC channels, battery divider) register their pins once; the
+// engine samples them in the background and feeds each pin through an
+// oversampling decimator. Readers get the latest filtered value without
+// touching the ADC.
+//
+// On Arduino-ESP32 3.x the ADC runs in continuous (DMA) mode and every
+// frame already averages ADC_ENGINE_CONVERSIONS_PER_PIN conversions per pin.
+// On 2.x each adc_engine_service() call takes one analogRead() per pin
+// (tens of microseconds), so sampling is spread over loop passes instead of
+// bursts of blocking reads. adc_engine_service() is called once per pass of
+// whichever task owns the sensors.
+
+#ifndef ADC_ENGINE_ENABLE
+#define ADC_ENGINE_ENABLE 1
+#endif
+// Decimation factor: service-rate samples averaged per filtered value.
+#ifndef ADC_OVERSAMPLE
+#define ADC_OVERSAMPLE 16
+#endif
+#ifndef ADC_ENGINE_MAX_PINS
+#define ADC_ENGINE_MAX_PINS 4
+#endif
+// Continuous mode (3.x only): conversions averaged per pin per frame, and
+// the ADC sample rate (ESP32 minimum is 20 kHz, ESP32-S3 611 Hz).
+#ifndef ADC_ENGINE_CONVERSIONS_PER_PIN
+#define ADC_ENGINE_CONVERSIONS_PER_PIN 16
+#endif
+#ifndef ADC_ENGINE_SAMPLE_HZ
+#define ADC_ENGINE_SAMPLE_HZ 20000
+#endif
+
+#if defined(ESP_ARDUINO_VERSION_MAJOR) && ESP_ARDUINO_VERSION_MAJOR >= 3
+#define ADC_ENGINE_CONTINUOUS 1
+#else
+#define ADC_ENGINE_CONTINUOUS 0
+#endif
+
+struct AdcEnginePin {
+  uint8_t pin;
+  AdcDecimator<ADC_OVERSAMPLE> filter;
+};
+
+static AdcEnginePin gAdcPins[ADC_ENGINE_MAX_PINS];
+static uint8_t gAdcPinCount = 0;
+static bool gAdcRunning = false;
+#if ADC_ENGINE_CONTINUOUS
+static volatile bool gAdcFrameReady = false;
+
+inline void ARDUINO_ISR_ATTR adc_engine_on_frame() {
+  gAdcFrameReady = true;
+}
+#endif
+
+inline int adc_engine_find(uint8_t pin) {
+  for (uint8_t i = 0; i < gAdcPinCount; ++i) {
+    if (gAdcPins[i].pin == pin) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+// (Re)start sampling of every registered pin.
+inline bool adc_engine_start() {
+#if ADC_ENGINE_CONTINUOUS
+  if (gAdcRunning) {
+    analogContinuousStop();
+    analogContinuousDeinit();
+    gAdcRunning = false;
+  }
+  if (gAdcPinCount == 0) {
+    return false;
+  }
+  uint8_t pins[ADC_ENGINE_MAX_PINS];
+  for (uint8_t i = 0; i < gAdcPinCount; ++i) {
+    pins[i] = gAdcPins[i].pin;
+  }
+  if (!analogContinuous(pins, gAdcPinCount, ADC_ENGINE_CONVERSIONS_PER_PIN,
+                        ADC_ENGINE_SAMPLE_HZ, adc_engine_on_frame)) {
+    return false;
+  }
+  gAdcRunning = analogContinuousStart();
+#else
+  gAdcRunning = gAdcPinCount > 0;
+#endif
+  return gAdcRunning;
+}
+
+// Register a pin; restarts sampling if the engine is already running.
+// Returns false if the pin table is full. The first pin also brings up the
+// ADC calibration.
+inline bool adc_engine_add(uint8_t pin) {
+  adc_cal_begin();
+  if (!ADC_ENGINE_ENABLE || adc_engine_find(pin) >= 0) {
+    return ADC_ENGINE_ENABLE;
+  }
+  if (gAdcPinCount >= ADC_ENGINE_MAX_PINS) {
+    return false;
+  }
+  gAdcPins[gAdcPinCount].pin = pin;
+  gAdcPins[gAdcPinCount].filter = AdcDecimator<ADC_OVERSAMPLE>();
+  gAdcPinCount++;
+  return gAdcRunning ? adc_engine_start() : true;
+}
+
+inline void adc_engine_service();
+
+// Start sampling. In continuous mode, also waits (a few ms at most) for the
+// first frame so readers never fall back to analogRead() on a pin the DMA
+// driver owns.
+inline bool adc_engine_begin() {
+  if (!ADC_ENGINE_ENABLE || !adc_engine_start()) {
+    return false;
+  }
+#if ADC_ENGINE_CONTINUOUS
+  const uint32_t start_ms = millis();
+  while (!gAdcFrameReady && millis() - start_ms < 20) {
+    delay(1);
+  }
+#endif
+  adc_engine_service();
+  return true;
+}
+
+// Move new samples into the filters. Never waits for the ADC.
+inline void adc_engine_service() {
+  if (!gAdcRunning) {
+    return;
+  }
+#if ADC_ENGINE_CONTINUOUS
+  if (!gAdcFrameReady) {
+    return;
+  }
+  gAdcFrameReady = false;
+  adc_continuous_data_t *frame = nullptr;
+  if (!analogContinuousRead(&frame, 0)) {
+    return;
+  }
+  for (uint8_t i = 0; i < gAdcPinCount; ++i) {
+    const int idx = adc_engine_find(frame[i].pin);
+    if (idx >= 0) {
+      gAdcPins[idx].filter.push(static_cast<uint16_t>(frame[i].avg_read_raw));
+    }
+  }
+#else
+  PmLock bus(kPmLockBus);
+  for (uint8_t i = 0; i < gAdcPinCount; ++i) {
+    gAdcPins[i].filter.push(static_cast<uint16_t>(analogRead(gAdcPins[i].pin)));
+  }
+#endif
+}
+
+// True while pins are being sampled: the owner then has to keep calling
+// adc_engine_service() at its regular pace.
+inline bool adc_engine_active() {
+  return gAdcRunning && gAdcPinCount > 0;
+}
+
+// Latest filtered value of `pin` in raw16 units (raw * 16). False until the
+// pin has been sampled at least once.
+inline bool adc_engine_read_raw16(uint8_t pin, uint16_t &raw16) {
+  const int i = adc_engine_find(pin);
+  if (!gAdcRunning || i < 0 || !gAdcPins[i].filter.primed()) {
+    return false;
+  }
+  raw16 = gAdcPins[i].filter.value();
+  return true;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <stdint.h>
+
+// Oversampling decimator for 12-bit ADC samples.
+//
+// Sums N samples and outputs their mean with 4 fractional bits (raw16 =
+// raw * 16), then starts over. For white noise the output noise is
+// 1/sqrt(N) of the input; the output rate is the input rate / N and the
+// group delay (N - 1) / 2 input samples. Until the first block is complete
+// value() is the mean of the samples so far, so readers get a (noisier)
+// value from the first sample on. scripts/adc_filter_model.py compiles this
+// filter on the host and measures its noise and step response.
+constexpr uint8_t kAdcFracBits = 4;
+
+template <uint16_t N>
+class AdcDecimator {
+ public:
+  static_assert(N >= 1 && N <= 4096, "decimation factor out of range");
+
+  // Returns true when a new output is ready.
+  bool push(uint16_t raw) {
+    sum_ += raw;
+    if (++count_ < N) {
+      if (!ready_) {
+        value_ = mean(count_);
+      }
+      return false;
+    }
+    value_ = mean(N);
+    sum_ = 0;
+    count_ = 0;
+    ready_ = true;
+    return true;
+  }
+
+  // Latest mean in raw16 units (0..65520).
+  uint16_t value() const { return value_; }
+  // True once a full block has been averaged.
+  bool ready() const { return ready_; }
+  // True once any sample has been pushed.
+  bool primed() const { return ready_ || count_ > 0; }
+
+ private:
+  uint16_t mean(uint16_t n) const {
+    return static_cast<uint16_t>(((sum_ << kAdcFracBits) + n / 2) / n);
+  }
+
+  uint32_t sum_ = 0;
+  uint16_t count_ = 0;
+  uint16_t value_ = 0;
+  bool ready_ = false;
+};
+
+// raw16 back to a 12-bit ADC code (rounded).
+inline uint16_t adc_raw12_from_raw16(uint16_t raw16) {
+  const uint32_t raw = (uint32_t(raw16) + (1u << (kAdcFracBits - 1))) >> kAdcFracBits;
+  return static_cast<uint16_t>(raw > 4095 ? 4095 : raw);
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+// Preformatted advertising buffers.
+//
+// The buffers are laid out once at boot (flags, manufacturer header, MAC,
+// name, battery service UUID). Afterwards only the measurement bytes and the
+// battery percentage change, so each advertising tick patches those bytes in
+// place and hands the raw buffers to the BLE stack without any heap traffic.
+//
+// Legacy (adv_frame_build):
+//   Advertising data:   [02 01 06] [len FF <company id LE> <payload...>]
+//   Scan response data: [len 09 <name...>] [04 16 0F 18 <battery %>]
+//
+// Extended (adv_frame_build_extended), one non-scannable PDU, no scan response:
+//   [02 01 06] [len FF <company id LE> <payload...>] [len 09 <name...>] [04 16 0F 18 <battery %>]
+
+constexpr uint8_t kAdvMaxLen = 31;  // Legacy advertising PDU data limit.
+// Extended frame budget: room for the largest Ruuvi format plus name and
+// battery data, and well under the 254-byte AUX_ADV_IND limit so the frame
+// never needs an AUX_CHAIN_IND.
+constexpr uint8_t kExtAdvMaxLen = 96;
+
+constexpr uint8_t kAdTypeFlags = 0x01;
+constexpr uint8_t kAdTypeShortName = 0x08;
+constexpr uint8_t kAdTypeCompleteName = 0x09;
+constexpr uint8_t kAdTypeServiceData16 = 0x16;
+constexpr uint8_t kAdTypeManufacturer = 0xFF;
+constexpr uint8_t kAdFlagsGeneralNoBrEdr = 0x06;  // LE General Discoverable | BR/EDR not supported
+constexpr uint16_t kBatteryServiceUuid = 0x180F;
+
+struct AdvFrame {
+  uint8_t adv[kExtAdvMaxLen];
+  uint8_t adv_len;
+  uint8_t sr[kAdvMaxLen];
+  uint8_t sr_len;
+  uint8_t payload_offset;  // Offset of the manufacturer payload (after company id) in adv[].
+  uint8_t payload_len;
+  uint8_t battery_offset;  // Offset of the battery percent byte in sr[] (or adv[] when extended).
+  bool extended;
+};
+
+inline uint8_t *adv_frame_payload(AdvFrame &f) {
+  return f.adv + f.payload_offset;
+}
+
+inline void adv_frame_set_battery_pct(AdvFrame &f, uint8_t pct) {
+  (f.extended ? f.adv : f.sr)[f.battery_offset] = pct;
+}
+
+// Appends [name AD][battery service data AD] at buf[n], using at most
+// `room` bytes. Returns the new length; battery_offset receives the position
+// of the battery percent byte.
+inline uint8_t adv_frame_put_name_battery(uint8_t *buf,
+                                          uint8_t n,
+                                          size_t room,
+                                          const char *name,
+                                          uint8_t &battery_offset) {
+  // Battery service data goes last so the name can take whatever is left.
+  constexpr uint8_t kBattAdLen = 5;
+  size_t name_len = name ? strlen(name) : 0;
+  const size_t name_room = room - kBattAdLen - 2;
+  const bool shortened = name_len > name_room;
+  if (shortened) {
+    name_len = name_room;
+  }
+  if (name_len > 0) {
+    buf[n++] = static_cast<uint8_t>(name_len + 1);
+    buf[n++] = shortened ? kAdTypeShortName : kAdTypeCompleteName;
+    memcpy(buf + n, name, name_len);
+    n += name_len;
+  }
+  buf[n++] = 4;
+  buf[n++] = kAdTypeServiceData16;
+  buf[n++] = kBatteryServiceUuid & 0xFF;
+  buf[n++] = (kBatteryServiceUuid >> 8) & 0xFF;
+  battery_offset = n;
+  buf[n++] = 0;
+  return n;
+}
+
+// Flags + manufacturer header at the start of adv[]; returns the length.
+inline uint8_t adv_frame_put_flags_mfg(AdvFrame &f, uint16_t company_id, uint8_t payload_len) {
+  uint8_t n = 0;
+  f.adv[n++] = 2;
+  f.adv[n++] = kAdTypeFlags;
+  f.adv[n++] = kAdFlagsGeneralNoBrEdr;
+  f.adv[n++] = static_cast<uint8_t>(3 + payload_len);
+  f.adv[n++] = kAdTypeManufacturer;
+  f.adv[n++] = company_id & 0xFF;
+  f.adv[n++] = (company_id >> 8) & 0xFF;
+  f.payload_offset = n;
+  f.payload_len = payload_len;
+  return static_cast<uint8_t>(n + payload_len);
+}
+
+// Lay out both buffers. Returns false if the payload or name does not fit a
+// legacy PDU. An over-long name is cut down and sent as a shortened name.
+inline bool adv_frame_build(AdvFrame &f,
+                            uint16_t company_id,
+                            uint8_t payload_len,
+                            const char *name) {
+  memset(&f, 0, sizeof(f));
+  if (3 + 4 + payload_len > kAdvMaxLen) {
+    return false;
+  }
+  f.adv_len = adv_frame_put_flags_mfg(f, company_id, payload_len);
+  f.sr_len = adv_frame_put_name_battery(f.sr, 0, kAdvMaxLen, name, f.battery_offset);
+  return true;
+}
+
+// Single-PDU layout for BLE 5 extended advertising: name and battery data
+// ride in the advertising data, so there is no scan request/response.
+inline bool adv_frame_build_extended(AdvFrame &f,
+                                     uint16_t company_id,
+                                     uint8_t payload_len,
+                                     const char *name) {
+  memset(&f, 0, sizeof(f));
+  constexpr uint8_t kMinNameBattLen = 2 + 5;
+  if (3 + 4 + payload_len + kMinNameBattLen > kExtAdvMaxLen) {
+    return false;
+  }
+  f.extended = true;
+  const uint8_t n = adv_frame_put_flags_mfg(f, company_id, payload_len);
+  f.adv_len = adv_frame_put_name_battery(f.adv, n, kExtAdvMaxLen - n, name, f.battery_offset);
+  return true;
+}
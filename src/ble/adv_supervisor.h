@@ -0,0 +1,204 @@
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+
+// Advertising supervision driven by GAP events.
+//
+// The BLE host reports advertising it stopped on its own (the
+// advertising-complete event, an extended instance's onStopped(), the
+// re-sync after a host reset). The callback only calls notifyStopped();
+// loop() then recovers one non-blocking step per pass:
+//
+//   restart     start advertising again at once; if start() fails, retry
+//               after ADV_RETRY_MS, doubling, ADV_RESTART_ATTEMPTS times
+//   stack down  deinit the BLE stack
+//   stack up    ADV_STACK_SETTLE_MS later: init the stack and restart. If
+//               that fails too, the next stack reset waits twice as long,
+//               up to ADV_STACK_RETRY_MAX_MS
+//
+// Nothing waits: poll() hands out the step that is due, the caller reports
+// its result through done(), and msUntilNext() tells an event-driven loop
+// when the next step is due. Advertising found stopped at an advertising
+// tick without an event enters the same recovery, and so do
+// ADV_RESTART_ATTEMPTS failed virtual tag slots in a row (slotFailed()).
+//
+// The supervisor is pure logic on the caller's clock (millis() on the
+// device); scripts/adv_recovery_sim.py steps it against a mocked GAP layer.
+
+// First retry after a failed start(); doubles per attempt.
+#ifndef ADV_RETRY_MS
+#define ADV_RETRY_MS 20
+#endif
+// Failed start() attempts before the BLE stack is restarted.
+#ifndef ADV_RESTART_ATTEMPTS
+#define ADV_RESTART_ATTEMPTS 3
+#endif
+// Time between stack deinit and init.
+#ifndef ADV_STACK_SETTLE_MS
+#define ADV_STACK_SETTLE_MS 500
+#endif
+// Longest wait between stack resets while the stack keeps failing. Kept
+// short: after the stack is usable again, advertising waits for the next
+// reset, so this bounds the time off-air, at the price of a deinit/init
+// every few seconds while the stack stays down.
+#ifndef ADV_STACK_RETRY_MAX_MS
+#define ADV_STACK_RETRY_MAX_MS 4000
+#endif
+
+static_assert(ADV_RESTART_ATTEMPTS >= 1, "ADV_RESTART_ATTEMPTS must be at least 1");
+
+enum AdvStopCause : uint8_t {
+  kAdvStopEvent = 0,        // GAP event: advertising complete / instance stopped
+  kAdvStopSilent = 1,       // Found stopped at an advertising tick, no event
+  kAdvStopStartFailed = 2,  // start() refused at an advertising tick
+  kAdvStopCauses = 3,
+};
+
+// Step for the caller to run next.
+enum AdvAction : uint8_t {
+  kAdvActionNone = 0,
+  kAdvActionStart = 1,      // Start advertising; done(ok = started)
+  kAdvActionStackDown = 2,  // Deinit the BLE stack; done(true)
+  kAdvActionStackUp = 3,    // Init the stack and start advertising; done(ok = started)
+};
+
+struct AdvSupervisorStats {
+  uint32_t restarts[kAdvStopCauses];  // Recoveries entered, per cause
+  uint32_t retries;                   // Failed start() attempts during recovery
+  uint32_t stack_resets;              // Stack deinit/init cycles
+  uint32_t last_recovery_ms;          // Stop to advertising again, last recovery
+  uint32_t max_recovery_ms;
+};
+
+class AdvSupervisor {
+ public:
+  // From the BLE host task (GAP callback). Wait-free.
+  void notifyStopped() { stop_events_.fetch_add(1, std::memory_order_relaxed); }
+
+  // From loop(): a stop found without an event, or a failed start().
+  // Ignored while a recovery is already running.
+  void stopped(uint32_t now_ms, AdvStopCause cause) {
+    if (state_ == kRunning) {
+      enter(now_ms, cause);
+    }
+  }
+
+  // Picks up stops reported by the host and returns the step due now.
+  // Call again only after done() for a returned step.
+  AdvAction poll(uint32_t now_ms) {
+    if (stop_events_.exchange(0, std::memory_order_relaxed) != 0 && state_ == kRunning) {
+      enter(now_ms, kAdvStopEvent);
+    }
+    if (state_ == kRunning || static_cast<int32_t>(now_ms - next_ms_) < 0) {
+      return kAdvActionNone;
+    }
+    switch (state_) {
+      case kRestart:
+        return kAdvActionStart;
+      case kStackDown:
+        return kAdvActionStackDown;
+      default:
+        return kAdvActionStackUp;
+    }
+  }
+
+  // Result of the step poll() returned.
+  void done(uint32_t now_ms, bool ok) {
+    switch (state_) {
+      case kRestart:
+        if (ok) {
+          finish(now_ms);
+        } else if (++attempt_ >= ADV_RESTART_ATTEMPTS) {
+          ++stats_.retries;
+          state_ = kStackDown;
+          next_ms_ = now_ms;
+        } else {
+          ++stats_.retries;
+          next_ms_ = now_ms + (uint32_t(ADV_RETRY_MS) << (attempt_ - 1));
+        }
+        break;
+      case kStackDown:
+        ++stats_.stack_resets;
+        state_ = kStackUp;
+        next_ms_ = now_ms + ADV_STACK_SETTLE_MS;
+        break;
+      case kStackUp:
+        if (ok) {
+          finish(now_ms);
+        } else {
+          ++stats_.retries;
+          stack_backoff_ms_ = stack_backoff_ms_ == 0 ? ADV_STACK_SETTLE_MS : stack_backoff_ms_ * 2;
+          if (stack_backoff_ms_ > ADV_STACK_RETRY_MAX_MS) {
+            stack_backoff_ms_ = ADV_STACK_RETRY_MAX_MS;
+          }
+          state_ = kStackDown;
+          next_ms_ = now_ms + stack_backoff_ms_;
+        }
+        break;
+      default:
+        break;
+    }
+  }
+
+  // A failed start() the caller retries on its own schedule (virtual tag
+  // slots). ADV_RESTART_ATTEMPTS of them in a row enter recovery as a
+  // failed start, so a stuck stack is still restarted.
+  void slotFailed(uint32_t now_ms) {
+    ++stats_.retries;
+    if (++slot_failures_ >= ADV_RESTART_ATTEMPTS) {
+      slot_failures_ = 0;
+      stopped(now_ms, kAdvStopStartFailed);
+    }
+  }
+
+  // A virtual tag slot started.
+  void slotStarted() { slot_failures_ = 0; }
+
+  bool recovering() const { return state_ != kRunning; }
+
+  // Milliseconds until poll() has a step (UINT32_MAX: none pending).
+  // Stops reported by the host wake the loop through its own event.
+  uint32_t msUntilNext(uint32_t now_ms) const {
+    if (state_ == kRunning) {
+      return UINT32_MAX;
+    }
+    const int32_t d = static_cast<int32_t>(next_ms_ - now_ms);
+    return d > 0 ? static_cast<uint32_t>(d) : 0;
+  }
+
+  const AdvSupervisorStats &stats() const { return stats_; }
+
+ private:
+  enum State : uint8_t { kRunning, kRestart, kStackDown, kStackUp };
+
+  void enter(uint32_t now_ms, AdvStopCause cause) {
+    ++stats_.restarts[cause];
+    state_ = kRestart;
+    attempt_ = 0;
+    since_ms_ = now_ms;
+    next_ms_ = now_ms;
+  }
+
+  void finish(uint32_t now_ms) {
+    const uint32_t took = now_ms - since_ms_;
+    stats_.last_recovery_ms = took;
+    if (took > stats_.max_recovery_ms) {
+      stats_.max_recovery_ms = took;
+    }
+    state_ = kRunning;
+    stack_backoff_ms_ = 0;
+    // The stack reports the stop it caused itself while coming back up
+    // (host re-sync); advertising is running again, so drop it.
+    stop_events_.store(0, std::memory_order_relaxed);
+  }
+
+  std::atomic<uint32_t> stop_events_{0};
+  State state_ = kRunning;
+  uint8_t attempt_ = 0;
+  uint8_t slot_failures_ = 0;
+  uint32_t since_ms_ = 0;
+  uint32_t next_ms_ = 0;
+  uint32_t stack_backoff_ms_ = 0;
+  AdvSupervisorStats stats_ = {};
+};
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Virtual tag scheduler: one ESP32 emulating N RuuviTags.
+//
+// Each virtual tag has its own static random MAC, measurement sequence and
+// movement counter, and is due once per advertising interval. Due times are
+// staggered by interval / N so the tags never all update at once, and a tag
+// that falls behind skips ahead instead of bursting to catch up.
+//
+// The scheduler is pure logic driven by the caller's clock (millis() on the
+// device), so it can be stepped with a virtual clock off-target.
+
+struct VirtualTag {
+  uint8_t mac[6];  // Static random address, big-endian (as printed).
+  uint16_t seq;
+  uint8_t movement;
+  uint32_t next_due_ms;
+  uint32_t adv_count;     // Advertisements since the last rate window reset.
+  uint32_t window_start_ms;
+};
+
+// Derive a stable static random address for tag `index` from the chip's
+// base MAC, so gateways see the same N tags after every reboot.
+inline void vtag_derive_mac(const uint8_t base[6], uint8_t index, uint8_t out[6]) {
+  // FNV-1a over base MAC + index, spread over 6 bytes.
+  uint32_t h = 2166136261u;
+  for (size_t i = 0; i < 6; ++i) {
+    h = (h ^ base[i]) * 16777619u;
+  }
+  h = (h ^ index) * 16777619u;
+  const uint32_t h2 = (h ^ 0xA5u) * 16777619u;
+  out[0] = (h >> 24) & 0xFF;
+  out[1] = (h >> 16) & 0xFF;
+  out[2] = (h >> 8) & 0xFF;
+  out[3] = h & 0xFF;
+  out[4] = (h2 >> 8) & 0xFF;
+  out[5] = (h2 & 0xFF) ^ index;
+  // Static random address: two most significant bits set.
+  out[0] |= 0xC0;
+}
+
+template <size_t N>
+class VirtualTagScheduler {
+ public:
+  static_assert(N > 0, "need at least one virtual tag");
+
+  // The interval may be 0 (not known yet); due times are then staggered on
+  // the first setInterval().
+  void begin(const uint8_t base_mac[6], uint32_t now_ms, uint32_t interval_ms) {
+    interval_ms_ = interval_ms;
+    for (size_t i = 0; i < N; ++i) {
+      VirtualTag &t = tags_[i];
+      vtag_derive_mac(base_mac, static_cast<uint8_t>(i), t.mac);
+      t.seq = 1;
+      t.movement = 0;
+      t.next_due_ms = now_ms + stagger(i);
+      t.adv_count = 0;
+      t.window_start_ms = now_ms;
+    }
+  }
+
+  // Change the per-tag interval (mode switch). Due times are staggered
+  // afresh from now, so a switch to a shorter interval takes effect
+  // immediately and a switch to a longer one spreads the tags over it.
+  void setInterval(uint32_t now_ms, uint32_t interval_ms) {
+    if (interval_ms == interval_ms_) {
+      return;
+    }
+    interval_ms_ = interval_ms;
+    for (size_t i = 0; i < N; ++i) {
+      tags_[i].next_due_ms = now_ms + stagger(i);
+    }
+  }
+
+  // Index of the most overdue tag, or -1 if none is due yet.
+  int due(uint32_t now_ms) const {
+    int best = -1;
+    int32_t best_late = -1;
+    for (size_t i = 0; i < N; ++i) {
+      const int32_t late = static_cast<int32_t>(now_ms - tags_[i].next_due_ms);
+      if (late >= 0 && late > best_late) {
+        best = static_cast<int>(i);
+        best_late = late;
+      }
+    }
+    return best;
+  }
+
+  // Index of the tag due next: the most overdue one, or the one due
+  // soonest if none is due yet.
+  size_t next() const {
+    size_t best = 0;
+    for (size_t i = 1; i < N; ++i) {
+      if (static_cast<int32_t>(tags_[i].next_due_ms - tags_[best].next_due_ms) < 0) {
+        best = i;
+      }
+    }
+    return best;
+  }
+
+  // Milliseconds until the next tag is due (0 if one is due now).
+  uint32_t msUntilNext(uint32_t now_ms) const {
+    int32_t soonest = INT32_MAX;
+    for (size_t i = 0; i < N; ++i) {
+      const int32_t d = static_cast<int32_t>(tags_[i].next_due_ms - now_ms);
+      if (d < soonest) {
+        soonest = d;
+      }
+    }
+    return soonest > 0 ? static_cast<uint32_t>(soonest) : 0;
+  }
+
+  // Record that tag `idx` was advertised; returns the sequence number used.
+  uint16_t markSent(size_t idx, uint32_t now_ms) {
+    VirtualTag &t = tags_[idx];
+    const uint16_t seq = t.seq++;
+    t.adv_count++;
+    t.next_due_ms += interval_ms_;
+    const uint32_t half = interval_ms_ / 2;
+    if (interval_ms_ > 0 && static_cast<int32_t>(t.next_due_ms - now_ms) < static_cast<int32_t>(half)) {
+      // Fell behind: skip the missed updates instead of bursting, but stay
+      // on the tag's own grid so the stagger survives. The next update is
+      // at least half an interval away.
+      const uint32_t short_ms = now_ms + half - t.next_due_ms;
+      t.next_due_ms += (short_ms + interval_ms_ - 1) / interval_ms_ * interval_ms_;
+    }
+    return seq;
+  }
+
+  void countMovement() {
+    for (size_t i = 0; i < N; ++i) {
+      tags_[i].movement++;
+    }
+  }
+
+  // Effective advertising rate of tag `idx` in 1/100 advertisements per
+  // minute over the current window.
+  uint32_t rateCentiPerMin(size_t idx, uint32_t now_ms) const {
+    const VirtualTag &t = tags_[idx];
+    const uint32_t elapsed = now_ms - t.window_start_ms;
+    if (elapsed == 0) {
+      return 0;
+    }
+    return static_cast<uint32_t>((uint64_t(t.adv_count) * 6000000u) / elapsed);
+  }
+
+  void resetRateWindow(uint32_t now_ms) {
+    for (size_t i = 0; i < N; ++i) {
+      tags_[i].adv_count = 0;
+      tags_[i].window_start_ms = now_ms;
+    }
+  }
+
+  const VirtualTag &tag(size_t idx) const { return tags_[idx]; }
+  uint32_t interval() const { return interval_ms_; }
+  static constexpr size_t size() { return N; }
+
+ private:
+  uint32_t stagger(size_t i) const { return static_cast<uint32_t>((uint64_t(interval_ms_) * i) / N); }
+
+  VirtualTag tags_[N] = {};
+  uint32_t interval_ms_ = 0;
+};
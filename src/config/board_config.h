@@ -7,6 +7,10 @@
 #include <driver/adc.h>
 #endif
 
+#include "adc/adc_engine.h"
+#include "power/power_mgmt.h"
+#include "util/lcd_text_frame.h"
+
 // Board profiles
 #define BOARD_PROFILE_GENERIC 0
 #define BOARD_PROFILE_M5STICKCPLUS2 1
@@ -34,6 +38,12 @@
 #define LCD_BRIGHTNESS 3  // ~1% brightness (3/255 ≈ 1.2%)
 #endif
 
+// LCD refresh: 1 = push only the characters that changed (default),
+// 0 = clear and redraw the whole panel on every refresh (for comparison).
+#ifndef LCD_DIRTY_REGIONS
+#define LCD_DIRTY_REGIONS 1
+#endif
+
 // USB mode override:
 //  -1 = auto detect (default)
 //   0 = force battery mode (ignore USB detection)
@@ -120,7 +130,8 @@
 #define BATTERY_VDIV_R2 100000  // 100k ohm (bottom resistor, to GND)
 #endif
 
-// ADC reference voltage in millivolts (ESP32-S3 default with 12dB atten)
+// ADC reference voltage in millivolts (ESP32-S3 default with 12dB atten).
+// Only used on chips without eFuse ADC calibration (see adc/adc_cal.h).
 #ifndef BATTERY_ADC_VREF_MV
 #define BATTERY_ADC_VREF_MV 3300
 #endif
@@ -135,7 +146,21 @@
 #define BATTERY_FIXED_MV 3300
 #endif
 
-inline void board_init() {
+// Board bring-up in two stages. board_init_early() is what every boot
+// needs before anything else (power hold, battery ADC); board_init_late()
+// starts M5Unified (display, PMIC, IMU), the heavy part a deep-sleep wake
+// burst skips where it can (power/deep_sleep.h). Each stage runs once, also
+// when a wake burst falls back to setup().
+//
+// board_init_late(true) leaves the display setup and the IMU for
+// board_init_deferred(), so a fast boot can advertise first. M5.begin()
+// itself (panel reset, PMIC) cannot be split: the battery reading needs it.
+inline void board_init_early() {
+  static bool done = false;
+  if (done) {
+    return;
+  }
+  done = true;
 #if BOARD_PROFILE == BOARD_PROFILE_M5STICKCPLUS2
   if (BOARD_POWER_HOLD_ENABLE) {
     rtc_gpio_hold_dis(static_cast<gpio_num_t>(BOARD_POWER_HOLD_PIN));
@@ -143,22 +168,105 @@ inline void board_init() {
     digitalWrite(BOARD_POWER_HOLD_PIN, HIGH);
     rtc_gpio_hold_en(static_cast<gpio_num_t>(BOARD_POWER_HOLD_PIN));
   }
-  auto cfg = M5.config();
-  cfg.serial_baudrate = DEBUG_SERIAL ? 115200 : 0;
-  M5.begin(cfg);
+#endif
+#if BATTERY_SOURCE == 2
+  analogSetAttenuation(static_cast<adc_attenuation_t>(BATTERY_ADC_ATTENUATION));
+  adc_engine_add(BATTERY_ADC_PIN);
+#endif
+}
+
+static bool gBoardDeferred = false;  // board_init_deferred() has work left
+
+// Debug overlay: text size 2 (12x16 px cells), one row per field.
+constexpr uint8_t kLcdRows = 6;
+constexpr uint8_t kLcdCols = 20;  // 240 px in landscape
+constexpr uint8_t kLcdCharW = 12;
+constexpr uint8_t kLcdCharH = 16;
+
+// Overlay refreshes since the last board_lcd_stats_take().
+struct LcdStats {
+  uint32_t refreshes;
+  uint32_t bytes;   // Pixel data sent to the panel, 2 bytes per pixel
+  uint32_t us;      // Render and transfer time, summed
+  uint32_t max_us;
+};
+
+static LcdStats gLcdStats = {};
+static LcdTextFrame<kLcdRows, kLcdCols> gLcdFrame;
+
+inline LcdStats board_lcd_stats_take() {
+  const LcdStats s = gLcdStats;
+  gLcdStats = LcdStats();
+  return s;
+}
+
+#if BOARD_PROFILE == BOARD_PROFILE_M5STICKCPLUS2
+// One overlay row, rendered off-screen and pushed through a clip rectangle
+// around the changed columns (8-bit, 240x16: 3.8 KB).
+static M5Canvas gLcdRow(&M5.Display);
+#endif
+
+inline void board_display_begin() {
+#if BOARD_PROFILE == BOARD_PROFILE_M5STICKCPLUS2
   if (DEBUG_LCD) {
     M5.Display.setBrightness(LCD_BRIGHTNESS);
     M5.Display.wakeup();
     M5.Display.setRotation(1);
     M5.Display.clear(BLACK);
+    gLcdFrame.invalidate();
+    if (LCD_DIRTY_REGIONS && gLcdRow.getBuffer() == nullptr) {
+      gLcdRow.setColorDepth(8);
+      gLcdRow.createSprite(kLcdCols * kLcdCharW, kLcdCharH);  // Full redraws if this fails
+      gLcdRow.setTextSize(2);
+      gLcdRow.setTextColor(WHITE, BLACK);
+    }
   } else {
     M5.Display.setBrightness(0);
     M5.Display.sleep();
   }
-  setCpuFrequencyMhz(80);
 #endif
 }
 
+inline void board_init_late(bool defer = false) {
+  static bool done = false;
+  if (done) {
+    return;
+  }
+  done = true;
+#if BOARD_PROFILE == BOARD_PROFILE_M5STICKCPLUS2
+  auto cfg = M5.config();
+  cfg.serial_baudrate = DEBUG_SERIAL ? 115200 : 0;
+  cfg.clear_display = false;  // board_display_begin() clears it or turns it off
+  cfg.internal_imu = !defer;
+  M5.begin(cfg);
+  if (!defer) {
+    board_display_begin();
+  }
+  gBoardDeferred = defer;
+  setCpuFrequencyMhz(PM_MAX_FREQ_MHZ);  // DFS lowers it when idle (power_mgmt_begin())
+#else
+  (void)defer;
+#endif
+}
+
+// Display setup and IMU after board_init_late(true); no-op otherwise.
+inline void board_init_deferred() {
+  if (!gBoardDeferred) {
+    return;
+  }
+  gBoardDeferred = false;
+#if BOARD_PROFILE == BOARD_PROFILE_M5STICKCPLUS2
+  board_display_begin();
+  PmLock bus(kPmLockBus);
+  M5.Imu.begin(&M5.In_I2C, M5.getBoard());
+#endif
+}
+
+inline void board_init() {
+  board_init_early();
+  board_init_late();
+}
+
 inline void board_wake_pulse_led() {
 #if BOARD_PROFILE == BOARD_PROFILE_M5STICKCPLUS2
   if (WAKE_PULSE_MS == 0) {
@@ -170,10 +278,13 @@ inline void board_wake_pulse_led() {
 #endif
 }
 
+inline uint16_t board_read_battery_mv();
+
 inline int board_read_battery_level() {
 #if BATTERY_SOURCE == 1
   // Internal power management IC
 #if BOARD_PROFILE == BOARD_PROFILE_M5STICKCPLUS2
+  PmLock bus(kPmLockBus);  // PMIC on the internal I2C bus
   return M5.Power.getBatteryLevel();
 #else
   return -1;
@@ -223,6 +334,7 @@ inline uint16_t board_read_battery_mv() {
 #if BATTERY_SOURCE == 1
   // Internal power management IC (M5StickC Plus2)
 #if BOARD_PROFILE == BOARD_PROFILE_M5STICKCPLUS2
+  PmLock bus(kPmLockBus);  // PMIC on the internal I2C bus
   uint32_t mv = M5.Power.getBatteryVoltage();
   if (mv > 0 && mv < 10000) {
     return static_cast<uint16_t>(mv);
@@ -235,22 +347,32 @@ inline uint16_t board_read_battery_mv() {
   return 3300;
 
 #elif BATTERY_SOURCE == 2
-  // External ADC with voltage divider
-  analogSetAttenuation(static_cast<adc_attenuation_t>(BATTERY_ADC_ATTENUATION));
-  
-  // Average multiple samples for stability
-  uint32_t sum = 0;
-  for (int i = 0; i < BATTERY_ADC_SAMPLES; i++) {
-    sum += analogRead(BATTERY_ADC_PIN);
-    if (i < BATTERY_ADC_SAMPLES - 1) {
-      delay(1);
+  // External ADC with voltage divider. The ADC engine keeps a filtered
+  // value in the background; the blocking average below is only used until
+  // its first value is ready (or with ADC_ENGINE_ENABLE=0).
+  uint16_t adc_avg16 = 0;
+  if (!adc_engine_read_raw16(BATTERY_ADC_PIN, adc_avg16)) {
+    PmLock bus(kPmLockBus);
+    analogSetAttenuation(static_cast<adc_attenuation_t>(BATTERY_ADC_ATTENUATION));
+
+    // Average multiple samples for stability
+    uint32_t sum = 0;
+    for (int i = 0; i < BATTERY_ADC_SAMPLES; i++) {
+      sum += analogRead(BATTERY_ADC_PIN);
+      if (i < BATTERY_ADC_SAMPLES - 1) {
+        delay(1);
+      }
     }
+    adc_avg16 = static_cast<uint16_t>((sum << kAdcFracBits) / BATTERY_ADC_SAMPLES);
   }
-  uint32_t adc_avg = sum / BATTERY_ADC_SAMPLES;
   
-  // Convert ADC reading to millivolts at the ADC pin
-  // ESP32 ADC is 12-bit (0-4095)
-  uint32_t vadc_mv = (adc_avg * BATTERY_ADC_VREF_MV) / 4095;
+  // Convert ADC reading to millivolts at the ADC pin: the chip's eFuse
+  // calibration curve, or a linear 0..BATTERY_ADC_VREF_MV scale without it.
+  // ESP32 ADC is 12-bit (0-4095); adc_avg16 carries 4 extra fractional bits.
+  uint32_t vadc_mv16 = 0;
+  uint32_t vadc_mv = adc_cal_mv16_from_raw16(adc_avg16, vadc_mv16)
+                         ? (vadc_mv16 + 8) >> kAdcFracBits
+                         : (uint32_t(adc_avg16) * BATTERY_ADC_VREF_MV) / (4095u << kAdcFracBits);
   
   // Calculate battery voltage using voltage divider ratio
   // Vbat = Vadc * (R1 + R2) / R2
@@ -264,60 +386,101 @@ inline uint16_t board_read_battery_mv() {
 #endif
 }
 
+// Battery values come from the caller's last sample: no PMIC reads here.
 inline void board_debug_refresh(const char *mode_label,
                                bool usb_connected,
                                uint32_t fast_countdown_ms,
                                uint16_t seq,
-                               uint8_t mov) {
+                               uint8_t mov,
+                               uint16_t batt_mv,
+                               uint8_t batt_pct,
+                               const char *load_line = nullptr) {
 #if BOARD_PROFILE == BOARD_PROFILE_M5STICKCPLUS2
   if (!DEBUG_LCD) {
     return;
   }
 
-  // Pre-read hardware to avoid delays while screen is active
-  const uint16_t mv = board_read_battery_mv();
-  const int lvl = board_read_battery_level();
-
-  // Force brightness and ensure it's awake
-  M5.Display.wakeup();
-  M5.Display.setBrightness(LCD_BRIGHTNESS);
-  
-  M5.Display.startWrite();
-  M5.Display.setCursor(0, 0);
-  M5.Display.setTextSize(2);
-  M5.Display.setTextColor(WHITE, BLACK);
-  
-  // Clear the screen once per refresh inside startWrite to avoid flicker
-  M5.Display.clear(BLACK);
-
-  M5.Display.printf("U:%s M:%-4s\n", usb_connected ? "Y" : "N", mode_label);
-  M5.Display.printf("S:%-5u V:%-3u\n", seq, mov);
-  
+  char rows[kLcdRows][kLcdCols + 1];
+  snprintf(rows[0], sizeof(rows[0]), "U:%s M:%-4s", usb_connected ? "Y" : "N", mode_label);
+  snprintf(rows[1], sizeof(rows[1]), "S:%-5u V:%-3u", seq, mov);
   if (fast_countdown_ms > 0) {
-    M5.Display.printf("F:%-3us\n", static_cast<unsigned>(fast_countdown_ms / 1000));
+    snprintf(rows[2], sizeof(rows[2]), "F:%-3us", static_cast<unsigned>(fast_countdown_ms / 1000));
   } else {
-    M5.Display.printf("F:---\n");
+    snprintf(rows[2], sizeof(rows[2]), "F:---");
   }
+  snprintf(rows[3], sizeof(rows[3]), "B:%-4umV", batt_mv);
+  snprintf(rows[4], sizeof(rows[4]), "L:%-3u%%", batt_pct);
+  snprintf(rows[5], sizeof(rows[5]), "%s", load_line != nullptr ? load_line : "");
 
-  M5.Display.printf("B:%-4umV\n", mv);
-  M5.Display.printf("L:%-3d%%\n", lvl);
-  
+  // Rendering and the SPI transfer run at full clock; the lock is dropped
+  // as soon as the frame is out.
+  PmLock cpu(kPmLockCpu);
+  const uint32_t t0 = micros();
+  uint32_t bytes = 0;
+
+  M5.Display.startWrite();
+  if (LCD_DIRTY_REGIONS && gLcdRow.getBuffer() != nullptr) {
+    for (uint8_t r = 0; r < kLcdRows; ++r) {
+      uint8_t first;
+      uint8_t last;
+      if (!gLcdFrame.update(r, rows[r], first, last)) {
+        continue;
+      }
+      const int32_t x = first * kLcdCharW;
+      const int32_t w = (last - first + 1) * kLcdCharW;
+      char span[kLcdCols + 1];
+      memcpy(span, gLcdFrame.row(r) + first, last - first + 1);
+      span[last - first + 1] = '\0';
+      gLcdRow.fillRect(x, 0, w, kLcdCharH, BLACK);
+      gLcdRow.setCursor(x, 0);
+      gLcdRow.print(span);
+      M5.Display.setClipRect(x, r * kLcdCharH, w, kLcdCharH);
+      gLcdRow.pushSprite(&M5.Display, 0, r * kLcdCharH);
+      M5.Display.clearClipRect();
+      bytes += static_cast<uint32_t>(w) * kLcdCharH * 2;
+    }
+  } else {
+    M5.Display.setCursor(0, 0);
+    M5.Display.setTextSize(2);
+    M5.Display.setTextColor(WHITE, BLACK);
+    // Clear the screen once per refresh inside startWrite to avoid flicker
+    M5.Display.clear(BLACK);
+    bytes = static_cast<uint32_t>(M5.Display.width()) * M5.Display.height() * 2;
+    for (uint8_t r = 0; r < kLcdRows; ++r) {
+      if (rows[r][0] != '\0') {
+        M5.Display.printf("%s\n", rows[r]);
+        bytes += static_cast<uint32_t>(strlen(rows[r])) * kLcdCharW * kLcdCharH * 2;
+      }
+    }
+  }
   M5.Display.endWrite();
+
+  const uint32_t us = micros() - t0;
+  ++gLcdStats.refreshes;
+  gLcdStats.bytes += bytes;
+  gLcdStats.us += us;
+  if (us > gLcdStats.max_us) {
+    gLcdStats.max_us = us;
+  }
 #endif
 }
 
 // board_debug_off() removed: keeping LCD on for development.
 
-inline void board_read_accel_mg(int16_t &x_mg, int16_t &y_mg, int16_t &z_mg) {
+// Returns false (and zeros) on boards without an IMU or when the read fails.
+inline bool board_read_accel_mg(int16_t &x_mg, int16_t &y_mg, int16_t &z_mg) {
   x_mg = 0;
   y_mg = 0;
   z_mg = 0;
 #if BOARD_PROFILE == BOARD_PROFILE_M5STICKCPLUS2
+  PmLock bus(kPmLockBus);
   float ax, ay, az;
   if (M5.Imu.getAccelData(&ax, &ay, &az)) {
     x_mg = static_cast<int16_t>(ax * 1000.0f);
     y_mg = static_cast<int16_t>(ay * 1000.0f);
     z_mg = static_cast<int16_t>(az * 1000.0f);
+    return true;
   }
 #endif
+  return false;
 }
@@ -4,10 +4,29 @@
 #include <string>
 #include <esp_attr.h>
 #include <esp_random.h>
-#include <WiFi.h>
+#include <soc/soc_caps.h>
+#include <esp_wifi.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/event_groups.h>
 
 #include "config/board_config.h"
 #include "sensors/sensor_select.h"
+#include "sensors/poll_scheduler.h"
+#include "sensors/sensor_filter.h"
+#include "power/battery_monitor.h"
+#include "power/power_mgmt.h"
+#include "power/deep_sleep.h"
+#include "power/load_monitor.h"
+#include "motion/imu_wom.h"
+#include "motion/imu_fifo.h"
+#include "ble/adv_frame.h"
+#include "ble/adv_supervisor.h"
+#include "ble/vtag_scheduler.h"
+#include "ruuvi/ruuvi_encoder.h"
+#include "util/boot_timeline.h"
+#include "util/cycle_profiler.h"
+#include "util/deferred_log.h"
+#include "util/snapshot.h"
 
 // Minimal Ruuvi RAWv2 (DF5) advertisement with sensor framework:
 // - Fake data (default fallback)
@@ -36,7 +55,8 @@
 #endif
 
 // Ruuvi-aligned advertising intervals (ms) - continuous advertising mode.
-// Deep sleep disabled, using interval-based continuous advertising instead.
+// DEEP_SLEEP_ENABLE=1 replaces SLOW mode with a deep-sleep duty cycle at the
+// same interval (power/deep_sleep.h).
 #ifndef DEV_ADV_MS
 #define DEV_ADV_MS 211
 #endif
@@ -53,7 +73,56 @@
 #define SENSOR_POLL_MIN_INTERVAL_MS 2000  // 2 seconds minimum
 #endif
 
-// Advertising burst duration (how long to advertise before stopping and restarting).
+// Split-phase sensor acquisition:
+//  1 = start conversions on one loop pass and collect them on a later pass
+//      once the conversion time has passed (loop() never waits on I2C)
+//  0 = measure synchronously inside the poll (the sensor library waits)
+#ifndef SENSOR_SPLIT_PHASE
+#define SENSOR_SPLIT_PHASE 1
+#endif
+
+// Sensor task: sensor, battery and USB acquisition run in a FreeRTOS task
+// pinned to the core loop() does not use, and loop() reads the latest
+// results from a lock-free snapshot. Defaults on for dual-core chips.
+#ifndef SENSOR_TASK_ENABLE
+#if defined(CONFIG_FREERTOS_UNICORE) && CONFIG_FREERTOS_UNICORE
+#define SENSOR_TASK_ENABLE 0
+#else
+#define SENSOR_TASK_ENABLE 1
+#endif
+#endif
+#ifndef SENSOR_TASK_CORE
+#define SENSOR_TASK_CORE (ARDUINO_RUNNING_CORE == 0 ? 1 : 0)
+#endif
+#ifndef SENSOR_TASK_STACK
+#define SENSOR_TASK_STACK 4096
+#endif
+// Service period of the ADC engine while it has pins to sample (NTC,
+// battery divider); without ADC pins the sensor owner sleeps until its next
+// deadline instead.
+#ifndef SENSOR_TASK_TICK_MS
+#define SENSOR_TASK_TICK_MS 10
+#endif
+
+// Event-driven scheduling: loop() and the sensor task block until their
+// next deadline (advertisement, sensor poll, battery sample, ...) or an
+// event (motion) instead of waking every 10 ms. With nothing runnable the
+// chip can sit in automatic light sleep (ENABLE_LIGHT_SLEEP, see
+// power/power_mgmt.h). 0 restores the fixed 10 ms loop.
+#ifndef LOOP_EVENT_DRIVEN
+#define LOOP_EVENT_DRIVEN 1
+#endif
+
+// Fast boot: the first advertisement goes out from setup() as soon as the
+// BLE stack and sensor channel 0 are up; the display setup, IMU, other
+// sensors, sensor task and power management follow it. 0 brings up
+// everything before the first advertisement.
+#ifndef FAST_BOOT
+#define FAST_BOOT 0
+#endif
+
+// Deep-sleep duty cycle: how long each wake advertises (at
+// DEEP_SLEEP_ADV_MS) before going back to sleep.
 #ifndef ADV_BURST_MS
 #define ADV_BURST_MS 300
 #endif
@@ -77,6 +146,71 @@
 #define FAST_MODE_MOVEMENT_MS 60000  // 60 seconds
 #endif
 
+// Preformatted advertising frames:
+//  1 = build raw advertising/scan response buffers once at boot and patch the
+//      DF5 bytes in place each tick (no heap allocation in steady state)
+//  0 = rebuild NimBLEAdvertisementData objects on every advertisement
+#ifndef ADV_RAW_FRAME
+#define ADV_RAW_FRAME 1
+#endif
+
+// BLE 5 extended advertising: DF5, name and battery data in one
+// non-scannable PDU (no scan request/response round trip). Needs a BLE 5
+// controller (ESP32-S3/C3) and NimBLE built with CONFIG_BT_NIMBLE_EXT_ADV=1;
+// defaults on when both are present and falls back to legacy advertising on
+// classic ESP32 (M5StickC Plus2).
+#ifndef BLE_EXT_ADV
+#if defined(SOC_BLE_50_SUPPORTED) && defined(CONFIG_BT_NIMBLE_EXT_ADV) && CONFIG_BT_NIMBLE_EXT_ADV
+#define BLE_EXT_ADV 1
+#else
+#define BLE_EXT_ADV 0
+#endif
+#endif
+#if BLE_EXT_ADV && !(defined(CONFIG_BT_NIMBLE_EXT_ADV) && CONFIG_BT_NIMBLE_EXT_ADV)
+#error "BLE_EXT_ADV requires CONFIG_BT_NIMBLE_EXT_ADV=1"
+#endif
+#if BLE_EXT_ADV && !ADV_RAW_FRAME
+#error "BLE_EXT_ADV requires ADV_RAW_FRAME=1"
+#endif
+
+// Extended advertising on the LE Coded PHY (primary and secondary): roughly
+// 4x range at the same TX power, but only scanners that scan Coded PHY see it.
+#ifndef BLE_EXT_ADV_CODED_PHY
+#define BLE_EXT_ADV_CODED_PHY 0
+#endif
+
+// Virtual tags: advertise VIRTUAL_TAGS independent Ruuvi streams, one per
+// sensor channel (NTC_ADC_PINS, ENV3_UNITS, FAKE_SENSOR_CHANNELS). Each tag
+// has its own static random MAC, sequence and movement counter. With
+// BLE_EXT_ADV every tag gets its own advertising instance; otherwise the tags
+// take turns on the single legacy advertising set.
+#ifndef VIRTUAL_TAGS
+#define VIRTUAL_TAGS 1
+#endif
+// Legacy time slicing: each tag is on air for VTAG_SLOT_MS at a
+// VTAG_SLOT_ADV_MS interval (a few PDUs per slot) once per advertising
+// interval. Tags that do not fit the interval are skipped, not queued.
+#ifndef VTAG_SLOT_MS
+#define VTAG_SLOT_MS 60
+#endif
+#ifndef VTAG_SLOT_ADV_MS
+#define VTAG_SLOT_ADV_MS 20
+#endif
+#if VIRTUAL_TAGS > 1 && !ADV_RAW_FRAME
+#error "VIRTUAL_TAGS > 1 requires ADV_RAW_FRAME=1"
+#endif
+#if VIRTUAL_TAGS > 1 && BLE_EXT_ADV && defined(CONFIG_BT_NIMBLE_MAX_EXT_ADV_INSTANCES) && \
+    CONFIG_BT_NIMBLE_MAX_EXT_ADV_INSTANCES < VIRTUAL_TAGS
+#error "VIRTUAL_TAGS needs CONFIG_BT_NIMBLE_MAX_EXT_ADV_INSTANCES >= VIRTUAL_TAGS"
+#endif
+
+#if DEEP_SLEEP_ENABLE && VIRTUAL_TAGS > 1
+#error "DEEP_SLEEP_ENABLE supports a single tag (VIRTUAL_TAGS=1)"
+#endif
+#if FAST_BOOT && VIRTUAL_TAGS > 1
+#error "FAST_BOOT supports a single tag (VIRTUAL_TAGS=1)"
+#endif
+
 #ifndef JITTER_MS_MAX
 #define JITTER_MS_MAX 10
 #endif
@@ -90,9 +224,10 @@
 #define DEBUG_LCD_FORCE_AWAKE 0
 #endif
 
-// NOTE: Light sleep is NOT compatible with BLE advertising on ESP32.
-// According to ESP-IDF documentation, light sleep powers down Wi-Fi and Bluetooth.
-// The ESP32 BLE stack automatically uses Modem-sleep mode instead, which:
+// NOTE: Light sleep only keeps BLE advertising alive when the controller can
+// time its events from a low-power clock (ESP32-S3/C3, or an ESP32 with an
+// external 32 kHz crystal); power/power_mgmt.h enables it only then.
+// Otherwise the BLE stack uses Modem-sleep, which:
 // - Keeps BLE radio active for advertising
 // - Allows CPU to sleep between BLE events
 // - Maintains connections automatically
@@ -103,18 +238,56 @@
 namespace {
 
 constexpr uint16_t kCompanyId = 0x0499; // Ruuvi
+#if BLE_EXT_ADV
+using BleAdvertising = NimBLEExtAdvertising;
+constexpr uint8_t kExtAdvInstance = 0;
+#if BLE_EXT_ADV_CODED_PHY
+constexpr uint8_t kExtAdvPrimaryPhy = BLE_HCI_LE_PHY_CODED;
+constexpr uint8_t kExtAdvSecondaryPhy = BLE_HCI_LE_PHY_CODED;
+#else
+constexpr uint8_t kExtAdvPrimaryPhy = BLE_HCI_LE_PHY_1M;
+constexpr uint8_t kExtAdvSecondaryPhy = BLE_HCI_LE_PHY_1M;
+#endif
+static_assert(RuuviFormat::kLen + 7 + 7 <= kExtAdvMaxLen,
+              "RUUVI_DATA_FORMAT does not fit the extended advertising frame");
+#else
+using BleAdvertising = NimBLEAdvertising;
+static_assert(RuuviFormat::kLen + 7 <= kAdvMaxLen,
+              "RUUVI_DATA_FORMAT does not fit a legacy advertising PDU (enable BLE_EXT_ADV)");
+#endif
+static_assert(VIRTUAL_TAGS >= 1 && VIRTUAL_TAGS <= kSensorChannelCount,
+              "VIRTUAL_TAGS exceeds the sensor channels of the selected SENSOR_PROFILE");
 uint16_t gMeasurementSeq = 1;
 uint8_t gMovementCounter = 0;
 uint32_t gUptimeMs = 0;
-uint32_t gFastUntilMs = 0;
-uint16_t gLastBattMv = 0;
-uint32_t gAdvRestartCount = 0;  // Track advertising restart events for diagnostics
+volatile uint32_t gFastUntilMs = 0;  // Also set from the wake-on-motion ISR
+AdvSupervisor gAdvSupervisor;   // Advertising stops, recovery and per-cause restart counters
+uint32_t gAdvUpdateCycles = 0;  // CPU cycles spent on the last advertising data update
+uint32_t gAdvIntervalMs = 0;    // Interval the running advertisement was started with (0 = not started)
+uint32_t gSensorBlockMaxUs = 0; // Longest sensor poll stage since the last status line
+uint32_t gLoopBusyMaxUs = 0;    // Longest loop() pass (excluding the idle delay) since the last status line
+uint32_t gFirstAdvMs = 0;       // millis() when advertising first started (0 = not yet)
+std::atomic<uint32_t> gSensorPollCount(0);  // Environmental polls since boot
+AdaptivePollScheduler<VIRTUAL_TAGS> gPollScheduler;  // Owned by whichever task polls
+SensorSampleFilter<VIRTUAL_TAGS> gSensorFilter;      // Same owner as gPollScheduler
+uint32_t gSensorFilterCycles = 0;                    // CPU cycles spent on the last filter pass
+BatterySampler gBatterySampler;     // Owned by whichever task reads the battery
+UsbTrendDetector gUsbDetector;      // Same owner
 bool gUsbState = false;
-float gVf = 0.0f;
-float gSf = 0.0f;
-int gPowerScore = 0;
-uint8_t gPowerState = 0;
-float gVfPrev = 0.0f;
+std::atomic<uint8_t> gMotionPending(0);      // kMotion* bits not yet handled by loop()
+std::atomic<bool> gImuWomIsrFired(false);    // IMU INT latched; cleared by the sensor owner
+std::atomic<uint32_t> gLastMotionMs(0);      // millis() of the last wake-on-motion event
+MotionClassifier gMotionClassifier;  // Owned by whichever task drains the IMU FIFO
+EventGroupHandle_t gLoopEvents = nullptr;    // Wakes loop() before its next deadline
+uint32_t gLoopWakeups = 0;                   // loop() passes since the last status line
+std::atomic<uint32_t> gSensorWakeups(0);     // Sensor task passes since the last status line
+uint32_t gMotionClassifyCycles = 0;  // CPU cycles spent classifying the last FIFO batch
+#if SENSOR_TASK_ENABLE
+TaskHandle_t gSensorTask = nullptr;
+#endif
+#if VIRTUAL_TAGS > 1
+VirtualTagScheduler<VIRTUAL_TAGS> gVtags;
+#endif
 
 using SensorSample = ::SensorSample;
 
@@ -130,60 +303,6 @@ std::array<uint8_t, 6> parseMac(const std::string &mac_str) {
   return mac;
 }
 
-inline void writeBE16(std::array<uint8_t, 24> &buf, size_t offset, int32_t val) {
-  buf[offset] = (val >> 8) & 0xFF;
-  buf[offset + 1] = val & 0xFF;
-}
-
-uint16_t encodeHumidity(float rh) {
-  int32_t raw = lroundf(rh / 0.0025f);
-  if (raw < 0)
-    raw = 0;
-  if (raw > 0xFFFF)
-    raw = 0xFFFF;
-  return static_cast<uint16_t>(raw);
-}
-
-int16_t encodeTemperature(float c) {
-  int32_t raw = lroundf(c / 0.005f);
-  if (raw < INT16_MIN)
-    raw = INT16_MIN;
-  if (raw > INT16_MAX)
-    raw = INT16_MAX;
-  return static_cast<int16_t>(raw);
-}
-
-uint16_t encodePressure(float hpa) {
-  int32_t raw = lroundf(hpa * 100.0f - 50000.0f);
-  if (raw < 0)
-    raw = 0;
-  if (raw > 0xFFFF)
-    raw = 0xFFFF;
-  return static_cast<uint16_t>(raw);
-}
-
-uint16_t encodePower(uint16_t battery_mv, int8_t tx_dbm) {
-  if (battery_mv < 1600) {
-    battery_mv = 1600;
-  }
-  if (battery_mv > 3646) {
-    battery_mv = 3646;
-  }
-  int32_t batt_bits = battery_mv - 1600;
-  if (batt_bits < 0)
-    batt_bits = 0;
-  if (batt_bits > 0x7FE)
-    batt_bits = 0x7FE;
-
-  int32_t tx_bits = (tx_dbm + 40) / 2;
-  if (tx_bits < 0)
-    tx_bits = 0;
-  if (tx_bits > 0x1F)
-    tx_bits = 0x1F;
-
-  return static_cast<uint16_t>((batt_bits << 5) | tx_bits);
-}
-
 uint16_t mapBatteryMv(uint16_t real_mv) {
 #if BATTERY_REPORT_MODE == 2
   if (real_mv < BATTERY_REAL_MIN_MV) {
@@ -208,58 +327,135 @@ uint16_t mapBatteryMv(uint16_t real_mv) {
 #endif
 }
 
-std::array<uint8_t, 24> buildDf5Payload(const SensorSample &sample,
-                                        const std::array<uint8_t, 6> &mac) {
-  std::array<uint8_t, 24> df5{};
-  df5[0] = 0x05; // data format
-  writeBE16(df5, 1, encodeTemperature(sample.temperature_c));
-  writeBE16(df5, 3, encodeHumidity(sample.humidity_rh));
-  writeBE16(df5, 5, encodePressure(sample.pressure_hpa));
-
-  // Accel X/Y/Z in milli-g.
-  writeBE16(df5, 7, sample.accel_x_mg);
-  writeBE16(df5, 9, sample.accel_y_mg);
-  writeBE16(df5, 11, sample.accel_z_mg);
+std::array<uint8_t, RuuviFormat::kLen> buildPayload(const SensorSample &sample,
+                                                    const std::array<uint8_t, 6> &mac) {
+  std::array<uint8_t, RuuviFormat::kLen> payload{};
+  const RuuviCounters counters = {gMovementCounter, gMeasurementSeq++};
+  ruuvi_encode<RuuviFormat>(payload.data(), sample, counters);
+  ruuvi_write_mac<RuuviFormat>(payload.data(), mac.data());
+  return payload;
+}
 
-  writeBE16(df5, 13, encodePower(sample.battery_mv, sample.tx_power_dbm));
-  df5[15] = gMovementCounter;
-  writeBE16(df5, 16, gMeasurementSeq++);
+std::string buildManufacturerData(const std::array<uint8_t, RuuviFormat::kLen> &payload) {
+  std::array<uint8_t, RuuviFormat::kLen + 2> mfg{};
+  mfg[0] = kCompanyId & 0xFF;
+  mfg[1] = (kCompanyId >> 8) & 0xFF;
+  memcpy(mfg.data() + 2, payload.data(), payload.size());
+  return std::string(reinterpret_cast<char *>(mfg.data()), mfg.size());
+}
 
-  // MAC big-endian.
-  for (size_t i = 0; i < mac.size(); ++i) {
-    df5[18 + i] = mac[i];
+// Environmental fields of one sensor channel; a failed read (fewer fields
+// than the driver provides) or an out-of-range reading is replaced by that
+// channel's last good one.
+SensorSample readSensorChannel(uint8_t channel) {
+  static SensorSample last[kSensorChannelCount] = {};
+  static bool primed[kSensorChannelCount] = {};
+  if (!primed[channel]) {
+    last[channel] = sensors_read(channel);
+    primed[channel] = true;
   }
-  return df5;
+  SensorSample current = sensors_read(channel);
+
+  const uint8_t expected = sensors_caps(channel);
+  const bool incomplete = (current.caps & expected) != expected;
+  const bool bad_h = (current.caps & kSensorCapHumidity) && current.humidity_df5 > kHumidityDf5Full;
+  const bool bad_t = (current.caps & kSensorCapTemperature) &&
+                     (current.temperature_cdeg < -4000 || current.temperature_cdeg > 8500);
+  if (incomplete || bad_h || bad_t) {
+    if (DEBUG_SERIAL) {
+      DLOG("Sensor ch%u invalid (caps=0x%02x/0x%02x t=%dcC h=%u/400%%); using last\n",
+           channel,
+           current.caps,
+           expected,
+           current.temperature_cdeg,
+           current.humidity_df5);
+    }
+    current = last[channel];
+  } else {
+    last[channel] = current;
+  }
+  return current;
 }
 
-std::string buildManufacturerData(const std::array<uint8_t, 24> &df5) {
-  std::array<uint8_t, 26> payload{};
-  payload[0] = kCompanyId & 0xFF;
-  payload[1] = (kCompanyId >> 8) & 0xFF;
-  memcpy(payload.data() + 2, df5.data(), df5.size());
-  return std::string(reinterpret_cast<char *>(payload.data()), payload.size());
+// Start a measurement on every channel in use; returns the ms until all of
+// them can be collected.
+uint32_t triggerSensors() {
+  uint32_t wait_ms = 0;
+  for (uint8_t ch = 0; ch < VIRTUAL_TAGS; ++ch) {
+    const uint32_t ms = sensors_trigger(ch);
+    if (ms > wait_ms) {
+      wait_ms = ms;
+    }
+  }
+  return wait_ms;
 }
 
-SensorSample readSensors() {
-  static SensorSample last = sensors_read();
-  SensorSample current = sensors_read();
-
-  if (current.humidity_rh < 0.0f || current.humidity_rh > 100.0f ||
-      current.temperature_c < -40.0f || current.temperature_c > 85.0f) {
-    if (DEBUG_SERIAL) {
-      Serial.printf("Sensor invalid t/h (t=%.2f h=%.2f); using last\n",
-                    current.temperature_c,
-                    current.humidity_rh);
+// Sensor-side state consumed by loop(): one sample per channel in use (board
+// fields filled in) and the raw battery/USB readings.
+struct SensorSnapshot {
+  SensorSample samples[VIRTUAL_TAGS];
+  uint16_t batt_mv_raw;
+  bool usb;
+};
+
+bool classifyImuFifo(SensorSample &board);
+
+// Battery, TX power and acceleration are board-wide: fill them into every
+// channel in use. The battery value is the latest one from sampleBattery().
+// Cheap compared to the environmental sensors, so this also runs on
+// base-interval ticks where the adaptive scheduler skips the environmental
+// poll (movement detection needs fresh acceleration).
+void updateBoardFields(SensorSample *samples, uint16_t batt_mv_raw) {
+  SensorSample &board = samples[0];
+  board.battery_mv = mapBatteryMv(batt_mv_raw);
+  board.tx_power_dbm = BLE_TX_POWER_DBM;
+  // With wake-on-motion the IMU watches for movement itself: while the
+  // device is still, the last reading is current and the I2C read is
+  // skipped.
+  const bool accel_idle = imu_wom_active() && (board.caps & kSensorCapAccel) &&
+                          millis() - gLastMotionMs.load(std::memory_order_relaxed) >=
+                              FAST_MODE_MOVEMENT_MS;
+  if (imu_fifo_active()) {
+    if (classifyImuFifo(board)) {
+      board.caps |= kSensorCapAccel;
+    } else {
+      board.caps &= ~kSensorCapAccel;
     }
-    current = last;
+  } else if (accel_idle) {
+    // Keep the previous reading
+  } else if (board_read_accel_mg(board.accel_x_mg, board.accel_y_mg, board.accel_z_mg)) {
+    board.caps |= kSensorCapAccel;
   } else {
-    last = current;
+    board.caps &= ~kSensorCapAccel;
+  }
+  for (uint8_t ch = 1; ch < VIRTUAL_TAGS; ++ch) {
+    SensorSample &s = samples[ch];
+    s.battery_mv = board.battery_mv;
+    s.tx_power_dbm = board.tx_power_dbm;
+    s.accel_x_mg = board.accel_x_mg;
+    s.accel_y_mg = board.accel_y_mg;
+    s.accel_z_mg = board.accel_z_mg;
+    s.caps = (s.caps & ~kSensorCapAccel) | (board.caps & kSensorCapAccel);
   }
+}
 
-  current.battery_mv = mapBatteryMv(board_read_battery_mv());
-  current.tx_power_dbm = BLE_TX_POWER_DBM;
-  board_read_accel_mg(current.accel_x_mg, current.accel_y_mg, current.accel_z_mg);
-  return current;
+// Read every channel in use, then the board-wide fields.
+void readAllChannels(SensorSample *samples, uint16_t batt_mv_raw) {
+  PROF_SCOPE(kProfSensorRead);
+  for (uint8_t ch = 0; ch < VIRTUAL_TAGS; ++ch) {
+    samples[ch] = readSensorChannel(ch);
+  }
+  updateBoardFields(samples, batt_mv_raw);
+}
+
+// Median + IIR stage between the drivers and the encoder. Runs after the
+// poll scheduler has seen the unfiltered samples: a spike still shortens
+// the poll interval, so the median gets its next sample sooner.
+void filterSamples(SensorSample *samples) {
+  const uint32_t t0 = ESP.getCycleCount();
+  gSensorFilter.apply(samples);
+  gSensorFilterCycles = ESP.getCycleCount() - t0;
+  prof_record(kProfFilter, gSensorFilterCycles);
 }
 
 uint8_t batteryPercentFromMv(uint16_t mv) {
@@ -272,13 +468,152 @@ uint8_t batteryPercentFromMv(uint16_t mv) {
   return static_cast<uint8_t>(((mv - 3000) * 100) / 1200);
 }
 
+// Count one movement event (shared by all virtual tags), at most one per
+// 300 ms.
+bool countMovement(uint32_t now_ms) {
+  static uint32_t last_movement_ms = 0;
+  if (now_ms - last_movement_ms <= 300) {
+    return false;
+  }
+  last_movement_ms = now_ms;
+  gMovementCounter++;
+#if VIRTUAL_TAGS > 1
+  gVtags.countMovement();  // One IMU: movement is shared by all virtual tags.
+#endif
+  return true;
+}
+
+constexpr EventBits_t kLoopEventMotion = 1 << 0;  // noteMotion(): count, maybe advertise now
+constexpr EventBits_t kLoopEventAdv = 1 << 1;     // The BLE host stopped advertising
+constexpr EventBits_t kLoopEventAll = kLoopEventMotion | kLoopEventAdv;
+
+// Wake loop() from a task or an ISR.
+void IRAM_ATTR signalLoop(EventBits_t bits) {
+  if (gLoopEvents == nullptr) {
+    return;
+  }
+  if (xPortInIsrContext()) {
+    BaseType_t woken = pdFALSE;
+    xEventGroupSetBitsFromISR(gLoopEvents, bits, &woken);
+    portYIELD_FROM_ISR(woken);
+  } else {
+    xEventGroupSetBits(gLoopEvents, bits);
+  }
+}
+
+// Milliseconds from now_ms until deadline_ms (0 once it has passed).
+uint32_t msUntil(uint32_t deadline_ms, uint32_t now_ms) {
+  const int32_t d = static_cast<int32_t>(deadline_ms - now_ms);
+  return d > 0 ? static_cast<uint32_t>(d) : 0;
+}
+
+// Block timeout for a wait of `ms`, rounded up so a wait never ends before
+// the deadline it was computed for.
+TickType_t ticksFor(uint32_t ms) {
+  return static_cast<TickType_t>((ms + portTICK_PERIOD_MS - 1) / portTICK_PERIOD_MS);
+}
+
+// Longest the sensor owner may block before the battery sample, the
+// wake-on-motion poll or (ADC pins in use) the next ADC sample is due.
+uint32_t sensorOwnerWaitMs(uint32_t now_ms) {
+  uint32_t wait_ms = gBatterySampler.ms_until_due(now_ms);
+  wait_ms = min(wait_ms, imu_wom_ms_until_poll(now_ms));
+  if (adc_engine_active()) {
+    wait_ms = min(wait_ms, static_cast<uint32_t>(SENSOR_TASK_TICK_MS));
+  }
+  return wait_ms;
+}
+
+constexpr uint8_t kMotionSeen = 0x01;         // Wake-on-motion latch (GPIO ISR or INT_STATUS poll)
+constexpr uint8_t kMotionEnteredFast = 0x02;  // The event started a FAST window
+constexpr uint8_t kMotionClassified = 0x04;   // The FIFO classifier saw a movement start
+
+// Motion seen by the IMU (`kind`: kMotionSeen or kMotionClassified).
+// ISR-safe: extends the FAST window right away and leaves counting and the
+// advertisement to loop().
+void IRAM_ATTR noteMotion(uint32_t now_ms, uint8_t kind) {
+  uint8_t bits = kind;
+  gLastMotionMs.store(now_ms, std::memory_order_relaxed);
+  if (OPERATING_MODE == 2) {
+    const uint32_t until_ms = gFastUntilMs;
+    if (now_ms >= until_ms && now_ms >= FAST_MODE_INITIAL_MS) {
+      bits |= kMotionEnteredFast;
+    }
+    if (now_ms + FAST_MODE_MOVEMENT_MS > until_ms) {
+      gFastUntilMs = now_ms + FAST_MODE_MOVEMENT_MS;
+    }
+  }
+  gMotionPending.fetch_or(bits, std::memory_order_release);
+  signalLoop(kLoopEventMotion);
+}
+
+void IRAM_ATTR onImuWomIsr() {
+  gImuWomIsrFired.store(true, std::memory_order_relaxed);
+  noteMotion(millis(), kMotionSeen);
+#if SENSOR_TASK_ENABLE
+  if (gSensorTask != nullptr) {
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(gSensorTask, &woken);  // Clear the IMU latch
+    portYIELD_FROM_ISR(woken);
+  }
+#endif
+}
+
+// Clear the IMU's latched interrupt after the ISR fired, or poll it when
+// no interrupt pin is wired. Runs wherever the IMU's I2C bus is owned (the
+// sensor task, or loop() without it).
+void serviceImuWom(uint32_t now_ms) {
+  const bool isr_fired = gImuWomIsrFired.exchange(false, std::memory_order_relaxed);
+  if (imu_wom_take(now_ms, isr_fired) && !isr_fired) {
+    noteMotion(now_ms, kMotionSeen);
+  }
+}
+
+// Drain the IMU FIFO (one burst read) and run the batch through the motion
+// classifier. Each movement it starts counts once and opens a FAST window;
+// the last window mean is the acceleration advertised. Returns false if
+// the IMU did not answer.
+bool classifyImuFifo(SensorSample &board) {
+  PROF_SCOPE(kProfMotion);
+  const int n = imu_fifo_drain();
+  if (n == kImuFifoError) {
+    return false;
+  }
+  if (n == kImuFifoOverflow) {
+    if (DEBUG_SERIAL) {
+      Serial.println("[MOTION] IMU FIFO overflowed, batch dropped");
+    }
+    return true;
+  }
+  const uint32_t t0 = ESP.getCycleCount();
+  const uint16_t started = gMotionClassifier.push_batch(gImuFifoBatch, static_cast<uint16_t>(n));
+  gMotionClassifyCycles = ESP.getCycleCount() - t0;
+  if (started > 0) {
+    noteMotion(millis(), kMotionClassified);
+  }
+  if (gMotionClassifier.windows() > 0) {
+    const AccelMg mean = gMotionClassifier.mean();
+    board.accel_x_mg = mean.x;
+    board.accel_y_mg = mean.y;
+    board.accel_z_mg = mean.z;
+  }
+  if (DEBUG_SERIAL && n > 0) {
+    DLOG("[MOTION] %d samples, %s var=%lu energy=%lu tilt=%u (%lu cycles)\n",
+         n, gMotionClassifier.moving() ? "moving" : "still",
+         gMotionClassifier.variance(), gMotionClassifier.energy(),
+         gMotionClassifier.tilt(), gMotionClassifyCycles);
+  }
+  return true;
+}
+
+// Fallback without the IMU FIFO or wake-on-motion: compare the
+// accelerometer readings taken at advertising ticks.
 bool updateMovementCounter(const SensorSample &sample) {
   // Simple motion detection: if accel delta exceeds threshold, increment.
   constexpr int16_t kDeltaThresholdMg = 120; // tune as needed
   static int16_t last_ax = 0;
   static int16_t last_ay = 0;
   static int16_t last_az = 0;
-  static uint32_t last_movement_ms = 0;
   static bool first_call = true;
 
   // Initialize on first call to avoid false trigger
@@ -297,13 +632,11 @@ bool updateMovementCounter(const SensorSample &sample) {
   const uint32_t now = millis();
 
   if (DEBUG_SERIAL && max_delta >= kDeltaThresholdMg) {
-    Serial.printf("[MOVEMENT] Delta: dx=%d dy=%d dz=%d max=%d (threshold=%d)\n",
-                  dx, dy, dz, max_delta, kDeltaThresholdMg);
+    DLOG("[MOVEMENT] Delta: dx=%d dy=%d dz=%d max=%d (threshold=%d)\n",
+         dx, dy, dz, max_delta, kDeltaThresholdMg);
   }
 
-  if (max_delta >= kDeltaThresholdMg && (now - last_movement_ms) > 300) {
-    gMovementCounter++;
-    last_movement_ms = now;
+  if (max_delta >= kDeltaThresholdMg && countMovement(now)) {
     last_ax = sample.accel_x_mg;
     last_ay = sample.accel_y_mg;
     last_az = sample.accel_z_mg;
@@ -320,7 +653,9 @@ uint32_t jitterMs() {
   return esp_random() % (JITTER_MS_MAX + 1);
 }
 
-bool detectUsbFromBattery(uint16_t batt_mv) {
+// USB presence from the battery voltage trend (see power/battery_monitor.h);
+// keeps the last decided state while the trend is inconclusive.
+bool detectUsbFromBattery(uint32_t now_ms, uint16_t batt_mv) {
   const int override = board_usb_override_mode();
   if (override == 0) {
     return false;
@@ -328,109 +663,433 @@ bool detectUsbFromBattery(uint16_t batt_mv) {
   if (override == 1) {
     return true;
   }
+  const UsbTrendDetector::State state = gUsbDetector.update(now_ms, batt_mv);
+  if (state == UsbTrendDetector::kCharging) {
+    gUsbState = true;
+  } else if (state == UsbTrendDetector::kDischarging) {
+    gUsbState = false;
+  }
+  return gUsbState;
+}
+
+// Read the battery and update USB detection once per BATTERY_SAMPLE_MS;
+// between samples the snapshot keeps the last values.
+void sampleBattery(uint32_t now_ms, SensorSnapshot &snap) {
+  if (!gBatterySampler.due(now_ms)) {
+    return;
+  }
+  PROF_SCOPE(kProfBattery);
+  snap.batt_mv_raw = board_read_battery_mv();
+  snap.usb = detectUsbFromBattery(now_ms, snap.batt_mv_raw);
+}
+
+#if SENSOR_TASK_ENABLE
+SeqlockSnapshot<SensorSnapshot> gSensorSnapshot;
+std::atomic<uint32_t> gSensorPollIntervalMs(SENSOR_POLL_MIN_INTERVAL_MS);  // Set by loop() per mode
+
+// Owns all sensor, battery and USB-detection state; loop() only reads
+// gSensorSnapshot. Conversions are waited out with vTaskDelay(), so the
+// task sleeps instead of spinning while the sensors convert.
+void sensorTask(void *) {
+  SensorSnapshot snap = {};
+  uint32_t last_poll_ms = 0;
+  bool polled = false;
+  for (;;) {
+    const uint32_t pass_start_us = micros();
+    uint32_t convert_us = 0;  // Conversion wait, not counted as busy
+    adc_engine_service();
+    const uint32_t now_ms = millis();
+    sampleBattery(now_ms, snap);
+    serviceImuWom(now_ms);
+
+    const uint32_t poll_ms = gSensorPollIntervalMs.load(std::memory_order_relaxed);
+    gPollScheduler.setBase(poll_ms);
+    if (!polled || now_ms - last_poll_ms >= poll_ms) {
+      polled = true;
+      last_poll_ms = now_ms;
+      if (gPollScheduler.due(now_ms, poll_ms)) {
+        const uint32_t wait_ms = triggerSensors();
+        if (wait_ms > 0) {
+          const uint32_t wait_start_us = micros();
+          vTaskDelay(pdMS_TO_TICKS(wait_ms) + 1);
+          convert_us = micros() - wait_start_us;
+        }
+        readAllChannels(snap.samples, snap.batt_mv_raw);
+        const uint32_t env_ms = gPollScheduler.update(snap.samples, now_ms, poll_ms);
+        filterSamples(snap.samples);
+        gSensorPollCount.fetch_add(1, std::memory_order_relaxed);
+        if (DEBUG_SERIAL) {
+          DLOG("[SENSOR] Polled at uptime=%lus on core %d (interval=%lums, next env poll in %lums, filter=%lu cycles)\n",
+               now_ms / 1000, xPortGetCoreID(), poll_ms, env_ms, gSensorFilterCycles);
+        }
+      } else {
+        updateBoardFields(snap.samples, snap.batt_mv_raw);
+      }
+    }
+    gSensorSnapshot.publish(snap);
+    gSensorWakeups.fetch_add(1, std::memory_order_relaxed);
+    load_task_pass(kLoadTaskSensors, micros() - pass_start_us - convert_us);
+#if LOOP_EVENT_DRIVEN
+    // Block until the next poll, battery sample or wake-on-motion poll; the
+    // IMU ISR and loop() (shorter poll interval) notify the task early.
+    const uint32_t wake_ms = millis();
+    const uint32_t wait_ms = min(msUntil(last_poll_ms + poll_ms, wake_ms), sensorOwnerWaitMs(wake_ms));
+    ulTaskNotifyTake(pdTRUE, ticksFor(wait_ms));
+#else
+    vTaskDelay(pdMS_TO_TICKS(SENSOR_TASK_TICK_MS));
+#endif
+  }
+}
 
-  // EWMA filtering and trend state machine.
-  // Higher ALPHA = faster response, lower = more smoothing
-#ifndef VBAT_ALPHA
-#define VBAT_ALPHA 0.05f  // Slower response, less jitter
+// Start the task and wait (bounded) for its first snapshot so the first
+// advertisement carries real data.
+void startSensorTask() {
+  xTaskCreatePinnedToCore(sensorTask, "sensors", SENSOR_TASK_STACK, nullptr, 1,
+                          &gSensorTask, SENSOR_TASK_CORE);
+  const uint32_t start_ms = millis();
+  while (gSensorSnapshot.version() == 0 && millis() - start_ms < 1000) {
+    delay(1);
+  }
+}
 #endif
-#ifndef VBAT_BETA
-#define VBAT_BETA 0.04f  // Slower slope tracking
+
+// Record time-to-first-advertisement.
+void noteAdvStarted() {
+  if (gFirstAdvMs == 0) {
+    gFirstAdvMs = millis();
+    boot_mark("adv");
+  }
+}
+
+uint16_t intervalUnitsFromMs(uint32_t ms) {
+  uint32_t units = (ms * 1000) / 625;
+  if (units < 32) {
+    units = 32;
+  }
+  if (units > 16384) {
+    units = 16384;
+  }
+  return static_cast<uint16_t>(units);
+}
+
+#if ADV_RAW_FRAME
+AdvFrame gAdvFrame;
+
+// Lay out a frame for the active advertising mode and write its MAC
+// (big-endian) into the payload.
+void buildAdvFrame(AdvFrame &f, const uint8_t mac[6]) {
+#if BLE_EXT_ADV
+  adv_frame_build_extended(f, kCompanyId, RuuviFormat::kLen, "Ruuvi-ESP32 " FW_VERSION_STR);
+#else
+  adv_frame_build(f, kCompanyId, RuuviFormat::kLen, "Ruuvi-ESP32 " FW_VERSION_STR);
 #endif
-#ifndef VBAT_SPIKE_MV
-#define VBAT_SPIKE_MV 30  // Increased: ignore bigger spikes
+  ruuvi_write_mac<RuuviFormat>(adv_frame_payload(f), mac);
+}
+
+// Lay out the advertising buffers once. The legacy layout is also registered
+// with NimBLE so that start() and host resets use the same layout; extended
+// instances are configured on start. Call after NimBLEDevice::init().
+void initAdvFrame(BleAdvertising *adv) {
+  // MAC big-endian in the payload; NimBLE stores the address little-endian.
+  const NimBLEAddress addr = NimBLEDevice::getAddress();
+  const uint8_t *val = addr.getVal();
+  uint8_t mac[6];
+  for (size_t i = 0; i < 6; ++i) {
+    mac[i] = val[5 - i];
+  }
+  buildAdvFrame(gAdvFrame, mac);
+
+#if BLE_EXT_ADV
+  (void)adv;
+#else
+  NimBLEAdvertisementData advData;
+  advData.addData(gAdvFrame.adv, gAdvFrame.adv_len);
+  NimBLEAdvertisementData srData;
+  srData.addData(gAdvFrame.sr, gAdvFrame.sr_len);
+  adv->setAdvertisementData(advData);
+  adv->setScanResponseData(srData);
 #endif
-#ifndef VBAT_T_CHARGE
-#define VBAT_T_CHARGE 8.0f  // Increased: require stronger charging signal
+  gAdvIntervalMs = 0;  // (Re)configure on the next start.
+}
+
+// Patch the measurement bytes in place.
+void patchAdvFrame(AdvFrame &f, const SensorSample &sample, const RuuviCounters &counters) {
+  ruuvi_encode<RuuviFormat>(adv_frame_payload(f), sample, counters);
+  adv_frame_set_battery_pct(f, batteryPercentFromMv(sample.battery_mv));
+}
+
+// Hand the raw buffers to the host. Legacy data can be set at any time;
+// extended data needs a configured instance.
+void pushAdvFrame(const AdvFrame &f, uint8_t instance) {
+#if BLE_EXT_ADV
+  // Extended data goes through an mbuf from the host's preallocated pool;
+  // ble_gap_ext_adv_set_data() takes ownership of it.
+  struct os_mbuf *buf = os_msys_get_pkthdr(f.adv_len, 0);
+  if (buf == nullptr) {
+    return;
+  }
+  if (os_mbuf_append(buf, f.adv, f.adv_len) != 0) {
+    os_mbuf_free_chain(buf);
+    return;
+  }
+  ble_gap_ext_adv_set_data(instance, buf);
+#else
+  (void)instance;
+  ble_gap_adv_set_data(f.adv, f.adv_len);
+  ble_gap_adv_rsp_set_data(f.sr, f.sr_len);
 #endif
-#ifndef VBAT_T_DISCHARGE
-#define VBAT_T_DISCHARGE 3.0f  // Increased: require stronger discharge signal
+}
 #endif
-#ifndef VBAT_SCORE_MAX
-#define VBAT_SCORE_MAX 12  // Increased: need more evidence to switch
+
+#if BLE_EXT_ADV
+// Non-connectable, non-scannable extended instance carrying the whole frame.
+// random_mac (big-endian) gives the instance its own static random address;
+// nullptr keeps the device address.
+bool configureExtAdv(BleAdvertising *adv,
+                     uint8_t instance,
+                     const AdvFrame &f,
+                     uint32_t adv_ms,
+                     const uint8_t *random_mac) {
+  NimBLEExtAdvertisement ext(kExtAdvPrimaryPhy, kExtAdvSecondaryPhy);
+  ext.setLegacyAdvertising(false);
+  ext.setConnectable(false);
+  ext.setScannable(false);
+  ext.setTxPower(BLE_TX_POWER_DBM);
+  ext.setMinInterval(intervalUnitsFromMs(adv_ms));
+  ext.setMaxInterval(intervalUnitsFromMs(adv_ms + JITTER_MS_MAX));
+  ext.setData(f.adv, f.adv_len);
+  if (random_mac != nullptr) {
+    char addr_str[18];
+    snprintf(addr_str, sizeof(addr_str), "%02x:%02x:%02x:%02x:%02x:%02x",
+             random_mac[0], random_mac[1], random_mac[2],
+             random_mac[3], random_mac[4], random_mac[5]);
+    ext.setAddress(NimBLEAddress(std::string(addr_str), BLE_ADDR_RANDOM));
+  }
+  return adv->setInstanceData(instance, ext);
+}
 #endif
 
-  enum PowerState : uint8_t { POWER_UNKNOWN = 0, POWER_CHARGING = 1, POWER_DISCHARGING = 2 };
+#if VIRTUAL_TAGS > 1
+AdvFrame gVtagFrames[VIRTUAL_TAGS];
+#if BLE_EXT_ADV
+uint32_t gVtagInstanceMs[VIRTUAL_TAGS] = {};  // Interval each instance was started with (0 = not started)
+#else
+uint32_t gVtagSlotEndMs = 0;  // End of the running legacy slot
+#endif
 
-  // Initialize filter on first sample.
-  if (gVf == 0.0f) {
-    gVf = batt_mv;
-    gVfPrev = gVf;
+// Hand the tag frames to a fresh advertising instance. Call after every
+// NimBLEDevice::init(); the tags keep their MACs and sequence numbers.
+void attachVirtualTags(BleAdvertising *adv) {
+#if BLE_EXT_ADV
+  (void)adv;
+  for (size_t i = 0; i < VIRTUAL_TAGS; ++i) {
+    gVtagInstanceMs[i] = 0;
   }
+#else
+  // The legacy set advertises from the static random address, which is
+  // switched to the tag's MAC at the start of every slot.
+  NimBLEDevice::setOwnAddrType(BLE_OWN_ADDR_RANDOM);
+  NimBLEAdvertisementData advData;
+  advData.addData(gVtagFrames[0].adv, gVtagFrames[0].adv_len);
+  NimBLEAdvertisementData srData;
+  srData.addData(gVtagFrames[0].sr, gVtagFrames[0].sr_len);
+  adv->setAdvertisementData(advData);
+  adv->setScanResponseData(srData);
+  gVtagSlotEndMs = 0;
+#endif
+}
 
-  // Compute delta for spike detection.
-  const int16_t delta_raw = static_cast<int16_t>(batt_mv) - static_cast<int16_t>(gLastBattMv);
-  const bool spike = (gLastBattMv != 0) && (abs(delta_raw) > VBAT_SPIKE_MV);
+// Derive the tag MACs and lay out one frame per tag. Call once, after the
+// first NimBLEDevice::init().
+void initVirtualTags(BleAdvertising *adv) {
+  const NimBLEAddress addr = NimBLEDevice::getAddress();
+  const uint8_t *val = addr.getVal();
+  uint8_t base[6];
+  for (size_t i = 0; i < 6; ++i) {
+    base[i] = val[5 - i];
+  }
+  gVtags.begin(base, millis(), 0);
+  for (size_t i = 0; i < VIRTUAL_TAGS; ++i) {
+    buildAdvFrame(gVtagFrames[i], gVtags.tag(i).mac);
+  }
+  attachVirtualTags(adv);
 
-  // Update filtered voltage.
-  gVf = gVf + VBAT_ALPHA * (batt_mv - gVf);
+  if (DEBUG_SERIAL) {
+    for (size_t i = 0; i < VIRTUAL_TAGS; ++i) {
+      const uint8_t *m = gVtags.tag(i).mac;
+      Serial.printf("[VTAG] tag%u MAC %02X:%02X:%02X:%02X:%02X:%02X\n",
+                    static_cast<unsigned>(i), m[0], m[1], m[2], m[3], m[4], m[5]);
+    }
+  }
+}
 
-  // Estimate slope (mV/s) from filtered voltage change.
-  // Assuming this is called regularly (every ~1-9 seconds).
-  const float slope = (gVf - gVfPrev);  // mV change since last call
-  gVfPrev = gVf;
-  gSf = gSf + VBAT_BETA * (slope - gSf);
-  const float slope_mV_min = gSf * 60.0f;  // Approximate mV/min
+// Milliseconds until serviceVirtualTags() has work: the next tag due, but
+// not before the running legacy slot ends.
+uint32_t msUntilVirtualTagWork(uint32_t now_ms) {
+  uint32_t wait_ms = gVtags.msUntilNext(now_ms);
+#if !BLE_EXT_ADV
+  wait_ms = max(wait_ms, msUntil(gVtagSlotEndMs, now_ms));
+#endif
+  return wait_ms;
+}
 
-  if (!spike) {
-    if (slope_mV_min > VBAT_T_CHARGE) {
-      gPowerScore += 2;
-    } else if (slope_mV_min < -VBAT_T_DISCHARGE) {
-      gPowerScore -= 1;
-    } else {
-      if (gPowerScore > 0) {
-        gPowerScore -= 1;
-      } else if (gPowerScore < 0) {
-        gPowerScore += 1;
-      }
-    }
-    if (gPowerScore > VBAT_SCORE_MAX) {
-      gPowerScore = VBAT_SCORE_MAX;
+// Advertise virtual tag `k` now. Returns false if start() failed (the
+// tag still counts as sent; it goes again at its next due time).
+bool advertiseVirtualTag(BleAdvertising *adv,
+                         const SensorSample *samples,
+                         int k,
+                         uint32_t now_ms,
+                         uint32_t adv_ms) {
+  bool ok = true;
+  PmLock cpu(kPmLockCpu);
+  const uint32_t t0 = ESP.getCycleCount();
+  const VirtualTag &tag = gVtags.tag(k);
+  RuuviCounters counters;
+  counters.movement = tag.movement;
+  counters.sequence = gVtags.markSent(k, now_ms);
+  AdvFrame &f = gVtagFrames[k];
+  patchAdvFrame(f, samples[k], counters);
+  const uint32_t prof_payload_end = prof_now();
+  prof_record(kProfPayload, prof_payload_end - t0);
+
+#if BLE_EXT_ADV
+  // The controller interleaves the instances; only the data changes here.
+  const uint8_t instance = static_cast<uint8_t>(k);
+  if (gVtagInstanceMs[k] != adv_ms || !adv->isActive(instance)) {
+    if (adv->isActive(instance)) {
+      adv->stop(instance);
     }
-    if (gPowerScore < -VBAT_SCORE_MAX) {
-      gPowerScore = -VBAT_SCORE_MAX;
+    gVtagInstanceMs[k] = 0;
+    if (configureExtAdv(adv, instance, f, adv_ms, tag.mac) && adv->start(instance)) {
+      gVtagInstanceMs[k] = adv_ms;
+      noteAdvStarted();
+    } else {
+      ok = false;  // The instance is retried when the tag is next due
     }
+  } else {
+    pushAdvFrame(f, instance);
   }
-
-  if (gPowerScore >= VBAT_SCORE_MAX) {
-    gPowerState = POWER_CHARGING;
-  } else if (gPowerScore <= -VBAT_SCORE_MAX) {
-    gPowerState = POWER_DISCHARGING;
+#else
+  if (adv->isAdvertising()) {
+    adv->stop();
   }
-
-  // Near-full handling.
-  if (gVf > 4150.0f && slope_mV_min > -2.0f) {
-    gPowerState = POWER_CHARGING;
+  // NimBLE stores addresses little-endian.
+  uint8_t addr_le[6];
+  for (size_t i = 0; i < 6; ++i) {
+    addr_le[i] = tag.mac[5 - i];
   }
+  ble_hs_id_set_rnd(addr_le);
+  adv->setMinInterval(intervalUnitsFromMs(VTAG_SLOT_ADV_MS));
+  adv->setMaxInterval(intervalUnitsFromMs(VTAG_SLOT_ADV_MS + JITTER_MS_MAX));
+  pushAdvFrame(f, 0);
+  if (adv->start(VTAG_SLOT_MS)) {
+    gVtagSlotEndMs = now_ms + VTAG_SLOT_MS;
+    noteAdvStarted();
+    pushAdvFrame(f, 0);
+  } else {
+    ok = false;  // The next slot tries again
+  }
+#endif
+  gAdvUpdateCycles = ESP.getCycleCount() - t0;
+  prof_record(kProfAdvHost, prof_now() - prof_payload_end);
 
-  // Update last raw voltage.
-  gLastBattMv = batt_mv;
-
-  if (gPowerState == POWER_CHARGING) {
-    gUsbState = true;
-  } else if (gPowerState == POWER_DISCHARGING) {
-    gUsbState = false;
+  if (DEBUG_SERIAL) {
+    const SensorSample &s = samples[k];
+    const int32_t t_abs = abs(s.temperature_cdeg);
+    DLOG("[VTAG] tag%d seq=%lu mov=%u T=%s%ld.%02ldC H=%u.%02u%% upd=%lucyc\n",
+         k,
+         static_cast<unsigned long>(counters.sequence),
+         counters.movement,
+         s.temperature_cdeg < 0 ? "-" : "",
+         static_cast<long>(t_abs / 100),
+         static_cast<long>(t_abs % 100),
+         s.humidity_df5 / 400,
+         (s.humidity_df5 % 400) / 4,
+         gAdvUpdateCycles);
   }
-  return gUsbState;
+  return ok;
 }
 
-uint16_t intervalUnitsFromMs(uint32_t ms) {
-  uint32_t units = (ms * 1000) / 625;
-  if (units < 32) {
-    units = 32;
+// Advertise the most overdue virtual tag, if any. Called every loop pass;
+// never blocks (a running legacy slot is left to finish). Repeated start()
+// failures hand advertising to serviceAdvRecovery() until it is back.
+void serviceVirtualTags(BleAdvertising *adv,
+                        const SensorSample *samples,
+                        uint32_t now_ms,
+                        uint32_t adv_ms) {
+  gVtags.setInterval(now_ms, adv_ms);
+  if (gAdvSupervisor.recovering()) {
+    return;
   }
-  if (units > 16384) {
-    units = 16384;
+#if !BLE_EXT_ADV
+  if (adv->isAdvertising() && static_cast<int32_t>(now_ms - gVtagSlotEndMs) < 0) {
+    return;
   }
-  return static_cast<uint16_t>(units);
+#endif
+  const int k = gVtags.due(now_ms);
+  if (k < 0) {
+    return;
+  }
+  if (advertiseVirtualTag(adv, samples, k, now_ms, adv_ms)) {
+    gAdvSupervisor.slotStarted();
+  } else {
+    gAdvSupervisor.slotFailed(now_ms);
+  }
+}
+#endif
+
+#if VIRTUAL_TAGS == 1
+// GAP callbacks, on the BLE host task: advertising stopped without loop()
+// asking (gAdvSupervisor recovers it).
+#if BLE_EXT_ADV
+class AdvStopCallbacks : public NimBLEExtAdvertisingCallbacks {
+  void onStopped(NimBLEExtAdvertising *, int, uint8_t instance) override {
+    if (instance == kExtAdvInstance) {
+      gAdvSupervisor.notifyStopped();
+      signalLoop(kLoopEventAdv);
+    }
+  }
+};
+AdvStopCallbacks gAdvStopCallbacks;
+#else
+void onAdvComplete(NimBLEAdvertising *) {
+  gAdvSupervisor.notifyStopped();
+  signalLoop(kLoopEventAdv);
+}
+#endif
+
+// Report host-side stops to gAdvSupervisor. Call after NimBLEDevice::init()
+// (deinit(true) deletes the advertising instance with its callbacks).
+void watchAdvertising(BleAdvertising *adv) {
+#if BLE_EXT_ADV
+  adv->setCallbacks(&gAdvStopCallbacks, false);
+#else
+  adv->setAdvertisingCompleteCallback(onAdvComplete);
+#endif
 }
 
-void startAdvertising(NimBLEAdvertising *adv,
+bool advertisingRunning(BleAdvertising *adv) {
+#if BLE_EXT_ADV
+  return adv->isActive(kExtAdvInstance);
+#else
+  return adv->isAdvertising();
+#endif
+}
+#endif
+
+// Returns false if advertising is not running afterwards (start() failed).
+bool startAdvertising(BleAdvertising *adv,
                       const SensorSample &sample,
                       uint32_t adv_ms) {
+  PmLock cpu(kPmLockCpu);  // Payload patch and host calls at full clock
+  const uint32_t t0 = ESP.getCycleCount();
+#if ADV_RAW_FRAME
+  const RuuviCounters counters = {gMovementCounter, gMeasurementSeq++};
+  patchAdvFrame(gAdvFrame, sample, counters);
+#else
   const auto mac = parseMac(NimBLEDevice::getAddress().toString());
-  const auto df5 = buildDf5Payload(sample, mac);
-  const auto mfg = buildManufacturerData(df5);
+  const auto payload = buildPayload(sample, mac);
+  const auto mfg = buildManufacturerData(payload);
 
   NimBLEAdvertisementData advData;
   advData.setFlags(BLE_HS_ADV_F_DISC_GEN | BLE_HS_ADV_F_BREDR_UNSUP);
@@ -448,7 +1107,34 @@ void startAdvertising(NimBLEAdvertising *adv,
   // Update advertising data (this can be done while advertising is running)
   adv->setAdvertisementData(advData);
   adv->setScanResponseData(srData);
-  
+#endif
+  const uint32_t prof_payload_end = prof_now();
+  prof_record(kProfPayload, prof_payload_end - t0);
+
+  // Advertising parameters only take effect on start(), so a mode change
+  // (e.g. FAST -> SLOW) needs a stop/start to reach the air.
+  const bool interval_changed = (adv_ms != gAdvIntervalMs);
+
+  bool running = true;
+#if BLE_EXT_ADV
+  if (interval_changed || !adv->isActive(kExtAdvInstance)) {
+    if (adv->isActive(kExtAdvInstance)) {
+      adv->stop(kExtAdvInstance);
+    }
+    running = configureExtAdv(adv, kExtAdvInstance, gAdvFrame, adv_ms, nullptr) &&
+              adv->start(kExtAdvInstance);
+    if (running) {
+      gAdvIntervalMs = adv_ms;
+      noteAdvStarted();
+    }
+  } else {
+    pushAdvFrame(gAdvFrame, kExtAdvInstance);
+  }
+#else
+#if ADV_RAW_FRAME
+  pushAdvFrame(gAdvFrame, 0);
+#endif
+
   // BLE spec requires random jitter to avoid collisions with other advertisers
   // Set min/max to create a range, BLE stack picks random interval in this window
   uint16_t minIntervalUnits = intervalUnitsFromMs(adv_ms);
@@ -456,30 +1142,331 @@ void startAdvertising(NimBLEAdvertising *adv,
   adv->setMinInterval(minIntervalUnits);
   adv->setMaxInterval(maxIntervalUnits);
 
+  if (interval_changed && adv->isAdvertising()) {
+    adv->stop();
+  }
   // Only start if not already advertising (keep it running continuously)
   if (!adv->isAdvertising()) {
-    adv->start();
+    running = adv->start();
+    if (running) {
+      gAdvIntervalMs = adv_ms;
+      noteAdvStarted();
+    }
+#if ADV_RAW_FRAME
+    // start() may re-apply NimBLE's boot-time copy after a host reset.
+    pushAdvFrame(gAdvFrame, 0);
+#endif
+  }
+#endif
+  gAdvUpdateCycles = ESP.getCycleCount() - t0;
+  prof_record(kProfAdvHost, prof_now() - prof_payload_end);
+
+  if (DEBUG_SERIAL) {
+    const int32_t t_abs = abs(sample.temperature_cdeg);
+    DLOG("T=%s%ld.%02ldC H=%u.%02u%% P=%lu.%02luhPa Batt=%umV Accel=[%d,%d,%d] Tx=%ddBm Mov=%u\n",
+         sample.temperature_cdeg < 0 ? "-" : "",
+         static_cast<long>(t_abs / 100),
+         static_cast<long>(t_abs % 100),
+         sample.humidity_df5 / 400,
+         (sample.humidity_df5 % 400) / 4,
+         static_cast<unsigned long>(sample.pressure_pa / 100),
+         static_cast<unsigned long>(sample.pressure_pa % 100),
+         sample.battery_mv,
+         sample.accel_x_mg,
+         sample.accel_y_mg,
+         sample.accel_z_mg,
+         sample.tx_power_dbm,
+         gMovementCounter);
+  }
+  return running;
+}
+
+#if DEEP_SLEEP_ENABLE
+// Counters, USB detector and FAST window for the next boot.
+void saveRetainedState() {
+  RtcRetained &r = gRtcRetained;
+  const uint32_t now_ms = millis();
+  r.seq = gMeasurementSeq;
+  r.movement = gMovementCounter;
+  r.usb = gUsbDetector;
+  r.usb_state = gUsbState;
+  r.fast_remaining_ms = msUntil(gFastUntilMs, now_ms);
+  r.saved_ms = now_ms;
+  r.saved_us = deep_sleep_clock_us();
+}
+
+// Inverse of saveRetainedState() after a wake; millis() restarted, so the
+// time-based state is moved into the new time base.
+void restoreRetainedState() {
+  RtcRetained &r = gRtcRetained;
+  const uint32_t now_ms = millis();
+  const uint32_t slept_ms = static_cast<uint32_t>((deep_sleep_clock_us() - r.saved_us) / 1000);
+  gMeasurementSeq = r.seq;
+  gMovementCounter = r.movement;
+  gUsbDetector = r.usb;
+  gUsbDetector.rebase(r.saved_ms + slept_ms, now_ms);
+  gUsbState = r.usb_state;
+  gFastUntilMs = r.fast_remaining_ms > slept_ms ? now_ms + r.fast_remaining_ms - slept_ms : 0;
+  r.wakes++;
+}
+
+// Advertise `sample` for ADV_BURST_MS at DEEP_SLEEP_ADV_MS, then deep sleep
+// until the next SLOW interval. Does not return.
+void advertiseBurstAndSleep(const SensorSample &sample, bool timer_wake) {
+  startAdvertising(NimBLEDevice::getAdvertising(), sample, DEEP_SLEEP_ADV_MS);
+  const uint32_t adv_ms = millis();
+  if (timer_wake) {
+    deep_sleep_note_first_adv();
+    board_wake_pulse_led();  // After the latency sample; the burst runs anyway
+  }
+  const uint32_t on_air_ms = millis() - adv_ms;
+  if (on_air_ms < ADV_BURST_MS) {
+    delay(ADV_BURST_MS - on_air_ms);
+  }
+  const int64_t wake_at_us = deep_sleep_next_wake_us(timer_wake, SLOW_ADV_MS);
+  if (DEBUG_SERIAL) {
+    const DeepSleepLatency &l = gRtcRetained.latency;
+    if (timer_wake) {
+      Serial.printf("[SLEEP] wake #%lu: first adv %lu.%lums after the timer (%lums in app), min/mean/max %lu/%lu/%lums\n",
+                    gRtcRetained.wakes,
+                    l.last_us / 1000, (l.last_us / 100) % 10,
+                    l.app_ms,
+                    l.min_us / 1000,
+                    static_cast<uint32_t>(l.sum_us / l.count / 1000),
+                    l.max_us / 1000);
+    }
+    Serial.printf("[SLEEP] deep sleep for %lums\n",
+                  static_cast<uint32_t>((wake_at_us - deep_sleep_clock_us()) / 1000));
+    Serial.flush();
+  }
+  NimBLEDevice::deinit(true);
+  saveRetainedState();
+  deep_sleep_start(wake_at_us, IMU_WOM_INT_PIN);
+}
+
+// Timer wake of the duty cycle: read the sensors, send one burst and go
+// back to sleep without the rest of setup(). Returns only when the device
+// has to stay awake (USB power, DEV mode); setup() then boots normally.
+void runWakeBurst() {
+  board_init_early();
+#if BOARD_PROFILE == BOARD_PROFILE_M5STICKCPLUS2
+  board_init_late();           // PMIC and IMU are only reachable through M5Unified
+  imu_wom_begin(onImuWomIsr);  // M5.begin() reset the IMU; re-arm the wake source
+#endif
+  const uint16_t batt_mv_raw = board_read_battery_mv();
+  if (detectUsbFromBattery(millis(), batt_mv_raw) || board_dev_mode_enabled() ||
+      (DEBUG_LCD && DEBUG_LCD_FORCE_AWAKE)) {
+    return;
+  }
+  sensors_init(true);  // Cached topology, channel 0 only: no bus scan
+  const uint32_t conversion_ms = triggerSensors();
+  const uint32_t trigger_ms = millis();
+  NimBLEDevice::init("Ruuvi-ESP32");
+  NimBLEDevice::setPower(BLE_TX_POWER);
+#if ADV_RAW_FRAME
+  initAdvFrame(NimBLEDevice::getAdvertising());
+#endif
+  const uint32_t waited_ms = millis() - trigger_ms;
+  if (waited_ms < conversion_ms) {
+    delay(conversion_ms - waited_ms);  // The BLE init usually covers it
+  }
+  SensorSample samples[VIRTUAL_TAGS];
+  for (uint8_t ch = 0; ch < VIRTUAL_TAGS; ++ch) {
+    samples[ch] = sensors_read(ch);
+  }
+  updateBoardFields(samples, batt_mv_raw);
+  advertiseBurstAndSleep(samples[0], true);
+}
+#endif
+
+// The firmware never starts Wi-Fi. WiFi.mode(WIFI_OFF) can initialise the
+// driver just to switch it off, so only stop it if something started it.
+void wifiOff() {
+  wifi_mode_t mode;
+  if (esp_wifi_get_mode(&mode) == ESP_OK) {
+    esp_wifi_stop();
+    esp_wifi_deinit();
   }
+}
 
+// IMU wake-on-motion and FIFO classifier; after the IMU is up.
+void beginMotion() {
+  const bool wom = imu_wom_begin(onImuWomIsr);
+  const bool fifo = imu_fifo_begin();
   if (DEBUG_SERIAL) {
-    Serial.printf("T=%.2fC H=%.2f%% P=%.2fhPa Batt=%umV Accel=[%d,%d,%d] Tx=%ddBm Mov=%u\n",
-                  sample.temperature_c,
-                  sample.humidity_rh,
-                  sample.pressure_hpa,
-                  sample.battery_mv,
-                  sample.accel_x_mg,
-                  sample.accel_y_mg,
-                  sample.accel_z_mg,
-                  sample.tx_power_dbm,
-                  gMovementCounter);
+    if (fifo) {
+      Serial.printf("Motion: IMU FIFO at %uHz, %u-sample window classifier\n",
+                    IMU_FIFO_ODR_HZ, IMU_MOTION_WINDOW);
+    }
+    if (wom && IMU_WOM_INT_PIN >= 0) {
+      Serial.printf("Motion: IMU wake-on-motion, %umg, INT on GPIO%d\n",
+                    IMU_WOM_THRESHOLD_MG, IMU_WOM_INT_PIN);
+    } else if (wom) {
+      Serial.printf("Motion: IMU wake-on-motion, %umg, INT_STATUS polled every %ums\n",
+                    IMU_WOM_THRESHOLD_MG, IMU_WOM_POLL_MS);
+    } else if (!fifo) {
+      Serial.println("Motion: accelerometer compare at advertising ticks");
+    }
   }
 }
 
+// One step of advertising recovery (adv_supervisor.h), if one is due. Runs
+// on every loop pass; never waits, the supervisor schedules the next step.
+// With virtual tags a step advertises the tag due next.
+void serviceAdvRecovery(uint32_t now_ms, const SensorSample *samples, uint32_t adv_ms) {
+  const AdvAction action = gAdvSupervisor.poll(now_ms);
+  if (action == kAdvActionNone) {
+    return;
+  }
+  const AdvSupervisorStats &st = gAdvSupervisor.stats();
+  bool ok = true;
+  switch (action) {
+    case kAdvActionStart:
+#if VIRTUAL_TAGS > 1
+      ok = advertiseVirtualTag(NimBLEDevice::getAdvertising(), samples, static_cast<int>(gVtags.next()),
+                               now_ms, adv_ms);
+#else
+      ok = startAdvertising(NimBLEDevice::getAdvertising(), samples[0], adv_ms);
+#endif
+      if (DEBUG_SERIAL && !ok) {
+        Serial.printf("[ADV] Restart failed at uptime=%lus (retries=%lu)\n",
+                      now_ms / 1000, st.retries + 1);
+      }
+      break;
+    case kAdvActionStackDown:
+      if (DEBUG_SERIAL) {
+        Serial.printf("[ADV] Restarting the BLE stack (reset #%lu)\n", st.stack_resets + 1);
+      }
+      NimBLEDevice::deinit(true);
+      break;
+    default: {
+      NimBLEDevice::init("Ruuvi-ESP32");
+      NimBLEDevice::setPower(BLE_TX_POWER);
+      // deinit(true) deleted the old advertising instance.
+      BleAdvertising *adv = NimBLEDevice::getAdvertising();
+#if VIRTUAL_TAGS > 1
+      attachVirtualTags(adv);
+      ok = advertiseVirtualTag(adv, samples, static_cast<int>(gVtags.next()), millis(), adv_ms);
+#else
+#if ADV_RAW_FRAME
+      initAdvFrame(adv);
+#endif
+      watchAdvertising(adv);
+      gAdvIntervalMs = 0;
+      ok = startAdvertising(adv, samples[0], adv_ms);
+#endif
+      if (DEBUG_SERIAL && !ok) {
+        Serial.println("[ADV] ERROR: Advertising still down after the BLE stack restart");
+      }
+      break;
+    }
+  }
+  gAdvSupervisor.done(millis(), ok);
+  if (DEBUG_SERIAL && ok && !gAdvSupervisor.recovering()) {
+    Serial.printf("[ADV] Advertising restored after %lums\n", st.last_recovery_ms);
+  }
+}
+
+#if FAST_BOOT
+// First advertisement straight from setup(): channel 0 and the battery,
+// without acceleration (the IMU is not up yet). loop() advertises again on
+// its first pass with the sensor task's data.
+void advertiseFirstFrame() {
+  SensorSample samples[VIRTUAL_TAGS] = {};
+  const uint32_t conversion_ms = sensors_trigger(0);
+  if (conversion_ms > 0) {
+    delay(conversion_ms);
+  }
+  samples[0] = sensors_read(0);
+  updateBoardFields(samples, board_read_battery_mv());
+  const bool dev_mode = board_dev_mode_enabled() || (DEBUG_LCD && DEBUG_LCD_FORCE_AWAKE);
+  startAdvertising(NimBLEDevice::getAdvertising(), samples[0],
+                   dev_mode ? DEV_ADV_MS : (OPERATING_MODE == 1 ? SLOW_ADV_MS : FAST_ADV_MS));
+}
+#endif
+
+#if LOAD_MONITOR
+char gLoadLcdLine[24] = "";  // Last window, for the debug LCD
+
+// [LOAD] line for the window that just ended, and once a minute the
+// totals per operating mode since boot.
+void reportLoad() {
+  static const char *const kModeNames[kLoadModes] = {"DEV", "FAST", "SLOW"};
+  static uint8_t windows = 0;
+  char line[160];
+  char top[64];
+  const LoadTotals w = load_monitor_take_window();
+  load_format(line, sizeof(line), w);
+  load_format_top(top, sizeof(top), w);
+  // Busiest core and all core wakeups; without run-time stats the busier
+  // of our two tasks stands in for the load (a lower bound, marked "~").
+  int32_t load_pm = load_core_permille(w, 0);
+  for (uint8_t c = 1; c < kLoadCores && load_pm >= 0; ++c) {
+    load_pm = max(load_pm, load_core_permille(w, c));
+  }
+  const bool estimated = load_pm < 0;
+  if (estimated) {
+    load_pm = static_cast<int32_t>(max(load_busy_permille(w, kLoadTaskLoop), load_busy_permille(w, kLoadTaskSensors)));
+  }
+  snprintf(gLoadLcdLine, sizeof(gLoadLcdLine), "C:%s%ld%% W:%lu", estimated ? "~" : "",
+           static_cast<long>((load_pm + 5) / 10), static_cast<unsigned long>(load_core_wakes_per_s(w)));
+  if (DEBUG_SERIAL) {
+    Serial.printf("[LOAD] window=%lums %s%s%s\n", static_cast<unsigned long>(w.us / 1000), line,
+                  top[0] ? " top=" : "", top);
+  }
+  if (!DEBUG_SERIAL || ++windows < 6) {
+    return;
+  }
+  windows = 0;
+  for (uint8_t m = 0; m < kLoadModes; ++m) {
+    const LoadTotals &t = load_monitor_mode_totals(static_cast<LoadMode>(m));
+    if (t.us == 0) {
+      continue;
+    }
+    load_format(line, sizeof(line), t);
+    Serial.printf("[LOAD] mode=%s total=%lus %s\n", kModeNames[m],
+                  static_cast<unsigned long>(t.us / 1000000), line);
+  }
+}
+#endif
+
+#if DEBUG_LOG_DEFERRED
+// What one hot-path log line costs its caller, deferred and as a direct
+// Serial.printf() into an empty UART FIFO (the best case for the direct
+// call: a fuller FIFO makes it wait for the UART).
+void measureLogCost() {
+  Serial.flush();
+  uint32_t t0 = ESP.getCycleCount();
+  Serial.printf("[DLOG] direct   T=%s%ld.%02ldC H=%u.%02u%% Mode=%s seq=%u\n", "-", 12L, 34L, 56u, 78u, "FAST", 42u);
+  const uint32_t direct = ESP.getCycleCount() - t0;
+  t0 = ESP.getCycleCount();
+  DLOG("[DLOG] deferred T=%s%ld.%02ldC H=%u.%02u%% Mode=%s seq=%u\n", "-", 12L, 34L, 56u, 78u, "FAST", 42u);
+  const uint32_t deferred = ESP.getCycleCount() - t0;
+  Serial.printf("Deferred log: %lu cycles per call, direct Serial.printf %lu cycles (decode with scripts/dlog_decode.py)\n",
+                deferred, direct);
+}
+#endif
+
 } // namespace
 
 void setup() {
-  if (DEBUG_SERIAL) {
+  boot_mark("start");
+  if (DEBUG_SERIAL || CYCLE_PROFILER) {
     Serial.begin(115200);
+  }
+  if (DEBUG_SERIAL && DEBUG_LOG_DEFERRED) {
+    dlog_begin();
+  }
+#if DEEP_SLEEP_ENABLE
+  const DeepSleepWake wake = deep_sleep_wake_cause();
+  if (wake != kDeepSleepWakeNone) {
+    restoreRetainedState();
+  }
+  if (wake == kDeepSleepWakeTimer) {
+    runWakeBurst();  // Only returns to stay awake
+  }
+#endif
+  if (DEBUG_SERIAL) {
     delay(50);
      Serial.println("\n=== Ruuvi DF5 Advertiser (Continuous Mode, BLE Modem-sleep) ===");
     const char *op_mode_str = (OPERATING_MODE == 0) ? "FAST_ONLY" :
@@ -499,14 +1486,32 @@ void setup() {
     Serial.println("========================================================\n");
   }
 
-  board_init();
+  boot_mark("serial");
+
+  gLoopEvents = xEventGroupCreate();
+  board_init_early();
+  board_init_late(FAST_BOOT);  // FAST_BOOT: display setup and IMU after the first advertisement
+  boot_mark("board");
+#if !FAST_BOOT
   board_wake_pulse_led();
+  beginMotion();
+  boot_mark("imu");
+#endif
 
-  WiFi.mode(WIFI_OFF);
-  WiFi.disconnect(true, true);
+  wifiOff();
+  boot_mark("wifi");
 
   NimBLEDevice::init("Ruuvi-ESP32");
   NimBLEDevice::setPower(BLE_TX_POWER);
+#if VIRTUAL_TAGS > 1
+  initVirtualTags(NimBLEDevice::getAdvertising());
+#else
+#if ADV_RAW_FRAME
+  initAdvFrame(NimBLEDevice::getAdvertising());
+#endif
+  watchAdvertising(NimBLEDevice::getAdvertising());
+#endif
+  boot_mark("ble");
   
   if (DEBUG_SERIAL) {
     Serial.print("BLE MAC: ");
@@ -514,25 +1519,138 @@ void setup() {
     Serial.printf("BLE TX Power: %ddBm\n", BLE_TX_POWER_DBM);
   }
 
+  uint32_t sensors_start_ms = millis();
+#if FAST_BOOT
+  sensors_init(true);  // Channel 0 first (cached topology)
+  uint32_t sensors_ms = millis() - sensors_start_ms;
+  boot_mark("sensor0");
+  advertiseFirstFrame();
+  board_init_deferred();
+  boot_mark("lcd");
+  board_wake_pulse_led();
+  beginMotion();
+  boot_mark("imu");
+  sensors_start_ms = millis();
+  sensors_finish_init();
+  sensors_ms += millis() - sensors_start_ms;
+#else
   sensors_init();
+  const uint32_t sensors_ms = millis() - sensors_start_ms;
+#endif
+  boot_mark("sensors");
+  if (DEBUG_SERIAL) {
+    char found[48];
+    sensor_registry_describe(found, sizeof(found));
+    Serial.printf("Sensors: %s (%u channels, %s in %lums)\n",
+                  found[0] ? found : "none",
+                  sensors_channel_count(),
+                  sensors_topology_cached() ? "cached topology" : "probed",
+                  sensors_ms);
+  }
+  if (DEBUG_SERIAL && gAdcCalTried) {
+    Serial.printf("ADC calibration: %s (%s in %luus, max error %umV)\n",
+                  adc_cal_source_name(gAdcCal.source),
+                  gAdcCalCached ? "cached" : "built",
+                  gAdcCalBeginUs,
+                  gAdcCal.curve.max_err_mv);
+  }
+  adc_engine_begin();
+#if SENSOR_TASK_ENABLE
+  startSensorTask();
+  boot_mark("task");
+#endif
+  power_mgmt_begin();
+  boot_mark("pm");
+  if (DEBUG_SERIAL) {
+    Serial.printf("Power: %s, %s\n",
+                  LOOP_EVENT_DRIVEN ? "event-driven loop" : "10ms loop",
+                  power_mgmt_status());
+  }
+#if LOAD_MONITOR
+  const bool load_hooks = load_monitor_begin();
+  if (DEBUG_SERIAL) {
+    Serial.printf("Load monitor: idle hooks %s, %s\n", load_hooks ? "on" : "failed",
+                  LOAD_RUNTIME_STATS ? "run-time stats on"
+                                     : "no run-time stats in this sdkconfig (task busy time only)");
+  }
+#endif
+#if DEBUG_LOG_DEFERRED
+  if (DEBUG_SERIAL) {
+    measureLogCost();
+  }
+#endif
+#if DEEP_SLEEP_ENABLE
+  if (wake == kDeepSleepWakeMotion) {
+    noteMotion(millis(), kMotionSeen);
+  }
+  if (DEBUG_SERIAL) {
+    Serial.printf("Deep sleep: duty cycle in SLOW mode (%lums bursts), %s\n",
+                  static_cast<uint32_t>(ADV_BURST_MS),
+                  wake == kDeepSleepWakeNone     ? "cold boot"
+                  : wake == kDeepSleepWakeMotion ? "woken by motion"
+                                                 : "woken, staying awake (USB power or DEV mode)");
+  }
+#endif
 }
 
 void loop() {
   static uint32_t last_adv_ms = 0;
   static uint32_t last_status_ms = 0;
+#if !SENSOR_TASK_ENABLE
   static uint32_t last_sensor_poll_ms = 0;
-  static uint32_t last_adv_health_check_ms = 0;
-  static SensorSample cached_sample = {};  // Cached sensor reading
+  static uint32_t sensor_collect_ms = 0;
+  static bool sensor_pending = false;  // Conversions triggered, not collected yet
+#endif
   static bool force_immediate_adv = false;  // Force next advertisement immediately after movement
   static bool first_loop = true;  // Track first loop iteration
   const uint32_t now_ms = millis();
+  const uint32_t loop_start_us = micros();
+  const uint32_t prof_loop_start = prof_now();
   
   // Update uptime
   gUptimeMs = now_ms;
 
+  // Latest sensor, battery and USB state
+#if SENSOR_TASK_ENABLE
+  const uint32_t snapshot_start_us = micros();
+  const SensorSnapshot snap = gSensorSnapshot.read();
+  const uint32_t snapshot_us = micros() - snapshot_start_us;
+  if (snapshot_us > gSensorBlockMaxUs) {
+    gSensorBlockMaxUs = snapshot_us;
+  }
+#else
+  static SensorSnapshot snap = {};  // Polled below
+  adc_engine_service();
+  sampleBattery(now_ms, snap);
+  serviceImuWom(now_ms);
+#endif
+  const uint16_t batt_mv_raw = snap.batt_mv_raw;
+  const bool usb = snap.usb;
+
+  // Motion from the IMU: the ISR, INT_STATUS poll or FIFO classifier has
+  // already extended the FAST window; count the movement, and advertise
+  // right away if it just switched to FAST (later events only extend the
+  // window). With the FIFO classifier running, only its movement starts
+  // count: wake-on-motion then just opens the FAST window early.
+  const uint8_t motion = gMotionPending.exchange(0, std::memory_order_acquire);
+  if (motion & (kMotionSeen | kMotionClassified)) {
+    const char *source = (motion & kMotionClassified) ? "Classifier" : "Wake-on-motion";
+    const bool counted =
+        ((motion & kMotionClassified) || !imu_fifo_active()) && countMovement(now_ms);
+    if (motion & kMotionEnteredFast) {
+      force_immediate_adv = true;
+      if (DEBUG_SERIAL) {
+        DLOG("[MOVEMENT] %s %lums ago: FAST mode until uptime=%lus\n",
+             source,
+             millis() - gLastMotionMs.load(std::memory_order_relaxed),
+             gFastUntilMs / 1000);
+      }
+    } else if (DEBUG_SERIAL && counted) {
+      DLOG("[MOVEMENT] %s (count=%u)\n", source, gMovementCounter);
+    }
+  }
+
   // Determine mode
-  const uint16_t batt_mv_raw = board_read_battery_mv();
-  const bool usb = detectUsbFromBattery(batt_mv_raw);
   
   // DEV mode logic: explicit opt-in only (no auto-trigger from USB)
   const bool force_awake = DEBUG_LCD && DEBUG_LCD_FORCE_AWAKE;
@@ -567,13 +1685,16 @@ void loop() {
     mode_label = fast_mode ? "FAST" : "SLOW";
     adv_interval_ms = fast_mode ? FAST_ADV_MS : SLOW_ADV_MS;
   }
+  load_monitor_mode(dev_mode ? kLoadModeDev : fast_mode ? kLoadModeFast : kLoadModeSlow);
   
   // Periodic status output (every 10s)
   if (DEBUG_SERIAL && (now_ms - last_status_ms >= 10000)) {
+    PROF_SCOPE(kProfStatus);
     last_status_ms = now_ms;
     const char *op_mode_str = (OPERATING_MODE == 0) ? " [FAST_ONLY]" :
                               (OPERATING_MODE == 1) ? " [SLOW_ONLY]" : " [HYBRID]";
-    Serial.printf("[STATUS] Mode=%s%s interval=%lums uptime=%lus seq=%u batt=%umV USB=%s adv_restarts=%lu\n",
+    const AdvSupervisorStats &adv_stats = gAdvSupervisor.stats();
+    Serial.printf("[STATUS] Mode=%s%s interval=%lums uptime=%lus seq=%u batt=%umV USB=%s adv_restarts(ev/silent/fail)=%lu/%lu/%lu retries=%lu stack_resets=%lu recovery_max=%lums sensor_max=%luus loop_max=%luus polls=%lu wakeups/min=%lu+%lu\n",
                   mode_label,
                   op_mode_str,
                   adv_interval_ms,
@@ -581,7 +1702,50 @@ void loop() {
                   gMeasurementSeq,
                   batt_mv_raw,
                   usb ? "YES" : "NO",
-                  gAdvRestartCount);
+                  adv_stats.restarts[kAdvStopEvent],
+                  adv_stats.restarts[kAdvStopSilent],
+                  adv_stats.restarts[kAdvStopStartFailed],
+                  adv_stats.retries,
+                  adv_stats.stack_resets,
+                  adv_stats.max_recovery_ms,
+                  gSensorBlockMaxUs,
+                  gLoopBusyMaxUs,
+                  gSensorPollCount.load(std::memory_order_relaxed),
+                  gLoopWakeups * 6,
+                  gSensorWakeups.exchange(0, std::memory_order_relaxed) * 6);
+    gSensorBlockMaxUs = 0;
+    gLoopBusyMaxUs = 0;
+    gLoopWakeups = 0;
+    // Time at each frequency level our PM locks asked for (power/pm_lock.h).
+    const PmResidency pm = pm_residency_take();
+    const uint64_t pm_total_us = pm.us[kPmLevelMin] + pm.us[kPmLevelApb] + pm.us[kPmLevelMax];
+    uint32_t pm_permille[kPmLevels] = {};
+    for (uint8_t i = 0; i < kPmLevels; ++i) {
+      pm_permille[i] = pm_total_us ? static_cast<uint32_t>(pm.us[i] * 1000 / pm_total_us) : 0;
+    }
+    Serial.printf("[POWER] %s idle@%dMHz=%lu.%lu%% bus@%dMHz=%lu.%lu%% cpu@%dMHz=%lu.%lu%% locks=%lu\n",
+                  power_mgmt_dfs() ? "DFS" : "fixed",
+                  power_mgmt_dfs() ? PM_MIN_FREQ_MHZ : PM_MAX_FREQ_MHZ,
+                  pm_permille[kPmLevelMin] / 10, pm_permille[kPmLevelMin] % 10,
+                  PM_MAX_FREQ_MHZ < 80 ? PM_MAX_FREQ_MHZ : 80,
+                  pm_permille[kPmLevelApb] / 10, pm_permille[kPmLevelApb] % 10,
+                  PM_MAX_FREQ_MHZ,
+                  pm_permille[kPmLevelMax] / 10, pm_permille[kPmLevelMax] % 10,
+                  pm.acquires);
+#if LOAD_MONITOR
+    reportLoad();
+#endif
+    if (DEBUG_LCD) {
+      // Debug overlay cost: pixel bytes sent to the panel and render + transfer time.
+      const LcdStats lcd = board_lcd_stats_take();
+      Serial.printf("[LCD] %s refreshes=%lu bytes/refresh=%lu refresh_avg=%luus refresh_max=%luus\n",
+                    LCD_DIRTY_REGIONS ? "dirty-regions" : "full-redraw",
+                    lcd.refreshes,
+                    lcd.refreshes ? lcd.bytes / lcd.refreshes : 0,
+                    lcd.refreshes ? lcd.us / lcd.refreshes : 0,
+                    lcd.max_us);
+    }
+    power_mgmt_dump_profile();
     if (OPERATING_MODE == 2) {
       const uint32_t fast_countdown_s = (gFastUntilMs > gUptimeMs) ? (gFastUntilMs - gUptimeMs) / 1000 : 0;
       Serial.printf("[HYBRID] fast_until=%lus, FAST_INITIAL=%lus, FAST_MOVEMENT=%lus\n",
@@ -589,39 +1753,24 @@ void loop() {
                     FAST_MODE_INITIAL_MS / 1000,
                     FAST_MODE_MOVEMENT_MS / 1000);
     }
-  }
-
-  // Aggressive advertising health check (every 1s) - ensure it's still running
-  // This catches any cases where BLE stack stops advertising unexpectedly
-  if ((now_ms - last_adv_health_check_ms >= 1000) || last_adv_health_check_ms == 0) {
-    last_adv_health_check_ms = now_ms;
-    auto *adv_check = NimBLEDevice::getAdvertising();
-    if (!adv_check->isAdvertising()) {
-      gAdvRestartCount++;
-      // CRITICAL: Advertising stopped! Restart immediately
-      if (DEBUG_SERIAL) {
-        Serial.printf("[ADV] CRITICAL: Advertising stopped at uptime=%lus! (restart #%lu) Restarting immediately...\n",
-                      now_ms / 1000, gAdvRestartCount);
-      }
-      // Force restart with current cached sample and current interval
-      startAdvertising(adv_check, cached_sample, adv_interval_ms);
-      
-      // Verify it actually started
-      delay(100);
-      if (!adv_check->isAdvertising()) {
-        if (DEBUG_SERIAL) {
-          Serial.println("[ADV] ERROR: Failed to restart advertising! Attempting full BLE restart...");
-        }
-        // Last resort: stop and restart BLE stack
-        NimBLEDevice::deinit(true);
-        delay(500);
-        NimBLEDevice::init("Ruuvi-ESP32");
-        NimBLEDevice::setPower(BLE_TX_POWER);
-        startAdvertising(adv_check, cached_sample, adv_interval_ms);
-      }
+#if VIRTUAL_TAGS > 1
+    for (size_t i = 0; i < VIRTUAL_TAGS; ++i) {
+      const uint32_t rate = gVtags.rateCentiPerMin(i, now_ms);
+      Serial.printf("[VTAG] tag%u rate=%lu.%02lu/min seq=%u\n",
+                    static_cast<unsigned>(i),
+                    static_cast<unsigned long>(rate / 100),
+                    static_cast<unsigned long>(rate % 100),
+                    gVtags.tag(i).seq);
     }
+    gVtags.resetRateWindow(now_ms);
+#endif
   }
 
+  // Advertising stopped by the host (GAP event), found stopped at an
+  // advertising tick or failing its virtual tag slots: one recovery step
+  // when due, no waiting here.
+  serviceAdvRecovery(now_ms, snap.samples, adv_interval_ms);
+
   // Poll sensors at the same rate as advertising (or minimum interval, whichever is longer)
   // This minimizes I2C transactions while ensuring fresh data for each advertisement
   // In SLOW mode: poll every 8.995s (same as advertising) - no wasted polls
@@ -629,14 +1778,54 @@ void loop() {
   const uint32_t sensor_poll_interval_ms = (adv_interval_ms > SENSOR_POLL_MIN_INTERVAL_MS) 
                                             ? adv_interval_ms 
                                             : SENSOR_POLL_MIN_INTERVAL_MS;
+#if SENSOR_TASK_ENABLE
+  const uint32_t prev_poll_ms =
+      gSensorPollIntervalMs.exchange(sensor_poll_interval_ms, std::memory_order_relaxed);
+  if (LOOP_EVENT_DRIVEN && sensor_poll_interval_ms < prev_poll_ms && gSensorTask != nullptr) {
+    xTaskNotifyGive(gSensorTask);  // Re-plan its sleep for the shorter interval
+  }
+#else
+  const uint32_t sensor_start_us = micros();
+  bool collect_now = false;
+  gPollScheduler.setBase(sensor_poll_interval_ms);
   if ((now_ms - last_sensor_poll_ms >= sensor_poll_interval_ms) || last_sensor_poll_ms == 0) {
+    if (!gPollScheduler.due(now_ms, sensor_poll_interval_ms)) {
+      updateBoardFields(snap.samples, snap.batt_mv_raw);  // Environment stable: skip this poll
+    } else {
+#if SENSOR_SPLIT_PHASE
+      // The very first poll is collected synchronously so the first
+      // advertisement carries real data.
+      if (last_sensor_poll_ms != 0) {
+        sensor_collect_ms = now_ms + triggerSensors();
+        sensor_pending = true;
+      } else {
+        collect_now = true;
+      }
+#else
+      collect_now = true;
+#endif
+    }
     last_sensor_poll_ms = now_ms;
-    cached_sample = readSensors();
+  }
+  if (sensor_pending && static_cast<int32_t>(now_ms - sensor_collect_ms) >= 0) {
+    sensor_pending = false;
+    collect_now = true;
+  }
+  if (collect_now) {
+    readAllChannels(snap.samples, snap.batt_mv_raw);
+    const uint32_t env_ms = gPollScheduler.update(snap.samples, now_ms, sensor_poll_interval_ms);
+    filterSamples(snap.samples);
+    gSensorPollCount.fetch_add(1, std::memory_order_relaxed);
     if (DEBUG_SERIAL) {
-      Serial.printf("[SENSOR] Polled at uptime=%lus (interval=%lums, adv_interval=%lums)\n", 
-                    now_ms / 1000, sensor_poll_interval_ms, adv_interval_ms);
+      DLOG("[SENSOR] Polled at uptime=%lus (interval=%lums, adv_interval=%lums, next env poll in %lums, filter=%lu cycles)\n",
+           now_ms / 1000, sensor_poll_interval_ms, adv_interval_ms, env_ms, gSensorFilterCycles);
     }
   }
+  const uint32_t sensor_us = micros() - sensor_start_us;
+  if (sensor_us > gSensorBlockMaxUs) {
+    gSensorBlockMaxUs = sensor_us;
+  }
+#endif
 
   // Force immediate advertising on first loop iteration
   if (first_loop) {
@@ -656,60 +1845,126 @@ void loop() {
     if (DEBUG_LCD) {
       const uint32_t fast_countdown_ms =
           (gFastUntilMs > gUptimeMs) ? (gFastUntilMs - gUptimeMs) : 0;
+#if LOAD_MONITOR && LOAD_MONITOR_LCD
+      const char *load_line = gLoadLcdLine;
+#else
+      const char *load_line = nullptr;
+#endif
+      PROF_SCOPE(kProfLcd);
       board_debug_refresh(mode_label, usb, fast_countdown_ms, 
-                          gMeasurementSeq, gMovementCounter);
+                          gMeasurementSeq, gMovementCounter,
+                          batt_mv_raw, batteryPercentFromMv(batt_mv_raw), load_line);
     }
     
     auto *adv = NimBLEDevice::getAdvertising();
-    // Use cached sensor reading instead of polling every advertisement
-    SensorSample sample = cached_sample;
+    // Use the latest sensor reading instead of polling every advertisement
+    const SensorSample &sample = snap.samples[0];
     
     // Update movement counter (always), but only trigger FAST mode in HYBRID mode
-    if (updateMovementCounter(sample) && OPERATING_MODE == 2) {
+    if (!imu_wom_active() && !imu_fifo_active() && updateMovementCounter(sample) &&
+        OPERATING_MODE == 2) {
       if (gUptimeMs + FAST_MODE_MOVEMENT_MS > gFastUntilMs) {
         gFastUntilMs = gUptimeMs + FAST_MODE_MOVEMENT_MS;
         force_immediate_adv = true;  // Trigger next advertisement immediately
         if (DEBUG_SERIAL) {
-          Serial.printf("[MOVEMENT] Triggered FAST mode until uptime=%lus (current=%lus, duration=%lus)\n",
-                        gFastUntilMs / 1000,
-                        gUptimeMs / 1000,
-                        FAST_MODE_MOVEMENT_MS / 1000);
+          DLOG("[MOVEMENT] Triggered FAST mode until uptime=%lus (current=%lus, duration=%lus)\n",
+               gFastUntilMs / 1000,
+               gUptimeMs / 1000,
+               FAST_MODE_MOVEMENT_MS / 1000);
         }
       }
     }
     
+#if VIRTUAL_TAGS > 1
+    // Virtual tags are advertised on their own staggered schedule below.
+    (void)adv;
+#else
+#if DEEP_SLEEP_ENABLE
+    // Duty cycle: in SLOW mode on battery, one burst and deep sleep until
+    // the next interval instead of staying awake.
+    if (slow_mode && !usb && !dev_mode) {
+      advertiseBurstAndSleep(sample, false);
+    }
+#endif
     // Update advertising data and restart if needed
-    // Keep advertising running continuously - don't stop it!
-    startAdvertising(adv, sample, adv_interval_ms);
+    // Keep advertising running continuously - don't stop it! A stop the
+    // host did not report is caught here, once per interval; recovery owns
+    // advertising until it is back.
+    if (!gAdvSupervisor.recovering()) {
+      if (gAdvIntervalMs != 0 && !advertisingRunning(adv)) {
+        gAdvSupervisor.stopped(now_ms, kAdvStopSilent);
+      } else if (!startAdvertising(adv, sample, adv_interval_ms)) {
+        gAdvSupervisor.stopped(now_ms, kAdvStopStartFailed);
+      }
+    }
     
     if (DEBUG_SERIAL) {
-      Serial.printf("[ADV] Mode=%s interval=%lums tx=%ddBm uptime=%lus fast_until=%lus seq=%u batt=%umV\n",
-                    mode_label,
-                    adv_interval_ms,
-                    BLE_TX_POWER_DBM,
-                    gUptimeMs / 1000,
-                    gFastUntilMs / 1000,
-                    gMeasurementSeq - 1,
-                    batt_mv_raw);
+      DLOG("[ADV] Mode=%s interval=%lums tx=%ddBm uptime=%lus fast_until=%lus seq=%u batt=%umV upd=%lucyc\n",
+           mode_label,
+           adv_interval_ms,
+           BLE_TX_POWER_DBM,
+           gUptimeMs / 1000,
+           gFastUntilMs / 1000,
+           gMeasurementSeq - 1,
+           batt_mv_raw,
+           gAdvUpdateCycles);
+    }
+#endif
+  }
+
+#if VIRTUAL_TAGS > 1
+  serviceVirtualTags(NimBLEDevice::getAdvertising(), snap.samples, now_ms, adv_interval_ms);
+#endif
+
+  static bool first_adv_logged = false;
+  if (DEBUG_SERIAL && !first_adv_logged && gFirstAdvMs != 0) {
+    first_adv_logged = true;
+    Serial.printf("[BOOT] First advertisement at %lums after boot (sensor topology %s)\n",
+                  gFirstAdvMs,
+                  sensors_topology_cached() ? "cached" : "probed");
+    char timeline[224];
+    if (boot_timeline_format(timeline, sizeof(timeline))) {
+      Serial.printf("[BOOT] %s%s\n", FAST_BOOT ? "fast boot: " : "", timeline);
     }
-    
-    // Small delay to ensure advertising starts properly
-    delay(50);
   }
   
-  // NOTE: Light sleep is NOT compatible with BLE advertising on ESP32.
-  // According to ESP-IDF documentation:
-  // "In Deep-sleep and Light-sleep modes, the wireless peripherals are powered down."
-  // "Wi-Fi and Bluetooth connections are not maintained in Deep-sleep or Light-sleep mode."
-  //
-  // The ESP32 BLE stack automatically uses Modem-sleep mode, which:
-  // - Keeps the BLE radio active for advertising
-  // - Allows CPU to sleep between BLE events
-  // - Maintains BLE connections automatically
-  // - Provides significant power savings without breaking BLE
-  //
-  // We use a small delay here to prevent busy-waiting. The BLE stack handles
-  // actual power management automatically via Modem-sleep.
+  const uint32_t loop_us = micros() - loop_start_us;
+  if (loop_us > gLoopBusyMaxUs) {
+    gLoopBusyMaxUs = loop_us;
+  }
+  gLoopWakeups++;
+  load_task_pass(kLoadTaskLoop, loop_us);
+  prof_record(kProfLoop, prof_now() - prof_loop_start);
+  prof_dump_if_due(millis());  // After the loop stage, which it would skew
+
+#if LOOP_EVENT_DRIVEN
+  // Block until the next deadline: advertisement, advertising recovery
+  // step, virtual tag slot, status line or (without the sensor task) sensor
+  // work. Motion and advertising stopped by the host wake the loop early.
+  // While everything is blocked the BLE stack keeps advertising on its own,
+  // in Modem-sleep or automatic light sleep (power/power_mgmt.h).
+  const uint32_t end_ms = millis();
+  uint32_t wait_ms = force_immediate_adv ? 0 : msUntil(last_adv_ms + adv_interval_ms, end_ms);
+  wait_ms = min(wait_ms, gAdvSupervisor.msUntilNext(end_ms));
+#if VIRTUAL_TAGS > 1
+  if (!gAdvSupervisor.recovering()) {
+    wait_ms = min(wait_ms, msUntilVirtualTagWork(end_ms));
+  }
+#endif
+  if (DEBUG_SERIAL) {
+    wait_ms = min(wait_ms, msUntil(last_status_ms + 10000, end_ms));
+  }
+#if !SENSOR_TASK_ENABLE
+  wait_ms = min(wait_ms, msUntil(last_sensor_poll_ms + sensor_poll_interval_ms, end_ms));
+  if (sensor_pending) {
+    wait_ms = min(wait_ms, msUntil(sensor_collect_ms, end_ms));
+  }
+  wait_ms = min(wait_ms, sensorOwnerWaitMs(end_ms));
+#endif
+  xEventGroupWaitBits(gLoopEvents, kLoopEventAll, pdTRUE, pdFALSE, ticksFor(wait_ms));
+#else
+  // The BLE stack handles power management automatically via Modem-sleep.
   delay(10);
+#endif
 }
 
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <Arduino.h>
+#include <stdint.h>
+
+#include "config/board_config.h"
+#include "motion/motion_classifier.h"
+#include "motion/mpu6886.h"
+
+// Accelerometer FIFO batching on the M5StickC Plus2's MPU6886.
+//
+// The IMU samples the accelerometer at IMU_FIFO_ODR_HZ (behind its 10 Hz
+// low-pass, which also keeps vibration from aliasing in) and queues every
+// sample in its 1 KB FIFO. imu_fifo_drain() empties it with one burst I2C
+// read per sensor base tick and converts the records to mg in place, ready
+// for MotionClassifier. At 10 Hz the FIFO holds 17 s, more than the SLOW
+// advertising interval.
+//
+// The sample rate divider also paces the wake-on-motion comparator
+// (motion/imu_wom.h): it compares consecutive samples at this rate.
+
+#ifndef IMU_FIFO_ENABLE
+#if BOARD_PROFILE == BOARD_PROFILE_M5STICKCPLUS2
+#define IMU_FIFO_ENABLE 1
+#else
+#define IMU_FIFO_ENABLE 0
+#endif
+#endif
+// Accelerometer output rate into the FIFO (1 kHz / integer divider).
+#ifndef IMU_FIFO_ODR_HZ
+#define IMU_FIFO_ODR_HZ 10
+#endif
+
+static_assert(IMU_FIFO_ODR_HZ >= 4 && IMU_FIFO_ODR_HZ <= 1000,
+              "IMU_FIFO_ODR_HZ must be 4..1000 (SMPLRT_DIV is 8 bits)");
+
+constexpr uint16_t kImuFifoRecordBytes = sizeof(AccelMg);  // Accel X/Y/Z, big-endian
+constexpr uint16_t kImuFifoMaxSamples = kMpu6886FifoBytes / kImuFifoRecordBytes;
+static_assert(sizeof(AccelMg) == 6, "AccelMg must match the 6-byte FIFO record");
+
+constexpr int kImuFifoOverflow = -1;  // FIFO was full: samples were lost, FIFO reset
+constexpr int kImuFifoError = -2;     // I2C failure
+
+static bool gImuFifoActive = false;
+static uint8_t gImuFifoFsShift = 0;                // ACCEL_FS_SEL: 16384 >> shift LSB/g
+static AccelMg gImuFifoBatch[kImuFifoMaxSamples];  // Raw records, converted in place
+
+#if IMU_FIFO_ENABLE && BOARD_PROFILE == BOARD_PROFILE_M5STICKCPLUS2
+inline bool imu_fifo_reset() {
+  const uint8_t user = mpu6886_read(kMpu6886UserCtrl);
+  return mpu6886_write(kMpu6886UserCtrl, user | kMpu6886UserFifoEn | kMpu6886UserFifoRst);
+}
+#endif
+
+// Switch the accelerometer to IMU_FIFO_ODR_HZ into the FIFO, after
+// M5.begin(). Returns false if the board has no supported IMU; callers
+// then read the accelerometer directly.
+inline bool imu_fifo_begin() {
+#if IMU_FIFO_ENABLE && BOARD_PROFILE == BOARD_PROFILE_M5STICKCPLUS2
+  if (!mpu6886_present()) {
+    return false;
+  }
+  gImuFifoFsShift = (mpu6886_read(kMpu6886AccelConfig) & kMpu6886AccelFsMask) >> 3;
+  const bool ok = mpu6886_write(kMpu6886SmplrtDiv, 1000 / IMU_FIFO_ODR_HZ - 1) &&
+                  mpu6886_write(kMpu6886AccelConfig2, kMpu6886AccelDlpf10Hz) &&
+                  mpu6886_write(kMpu6886FifoEn, kMpu6886AccelFifo) && imu_fifo_reset();
+  gImuFifoActive = ok;
+  return ok;
+#else
+  return false;
+#endif
+}
+
+inline bool imu_fifo_active() {
+  return gImuFifoActive;
+}
+
+// Drain the FIFO into gImuFifoBatch (mg). Returns the number of samples,
+// or kImuFifoOverflow / kImuFifoError.
+inline int imu_fifo_drain() {
+#if IMU_FIFO_ENABLE && BOARD_PROFILE == BOARD_PROFILE_M5STICKCPLUS2
+  if (!gImuFifoActive) {
+    return 0;
+  }
+  uint8_t count_be[2];
+  if (!mpu6886_read_burst(kMpu6886FifoCountH, count_be, sizeof(count_be))) {
+    return kImuFifoError;
+  }
+  const uint16_t count = ((uint16_t(count_be[0]) << 8) | count_be[1]) & 0x1FFF;
+  if (count > kMpu6886FifoBytes - kImuFifoRecordBytes) {
+    imu_fifo_reset();  // Full: the oldest records were overwritten
+    return kImuFifoOverflow;
+  }
+  const uint16_t n = count / kImuFifoRecordBytes;  // Whole records; the rest stays queued
+  if (n == 0) {
+    return 0;
+  }
+  uint8_t *raw = reinterpret_cast<uint8_t *>(gImuFifoBatch);
+  if (!mpu6886_read_burst(kMpu6886FifoRw, raw, n * kImuFifoRecordBytes)) {
+    return kImuFifoError;
+  }
+  // mg = raw * 1000 / (16384 >> fs). Each record is read before it is
+  // overwritten, so the conversion works in place.
+  const int32_t scale = int32_t(1000) << gImuFifoFsShift;
+  for (uint16_t i = 0; i < n; ++i) {
+    const uint8_t *r = raw + i * kImuFifoRecordBytes;
+    const int16_t x = int16_t((uint16_t(r[0]) << 8) | r[1]);
+    const int16_t y = int16_t((uint16_t(r[2]) << 8) | r[3]);
+    const int16_t z = int16_t((uint16_t(r[4]) << 8) | r[5]);
+    gImuFifoBatch[i] = {int16_t((x * scale) >> 14), int16_t((y * scale) >> 14),
+                        int16_t((z * scale) >> 14)};
+  }
+  return n;
+#else
+  return 0;
+#endif
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <Arduino.h>
+#include <stdint.h>
+
+#include "config/board_config.h"
+#include "motion/mpu6886.h"
+#include "power/power_mgmt.h"
+
+// Hardware wake-on-motion on the M5StickC Plus2's MPU6886.
+//
+// The IMU compares every accelerometer sample with the previous one and
+// latches a WOM interrupt when any axis moves by more than
+// IMU_WOM_THRESHOLD_MG, so a bump is caught even when nobody is reading
+// the accelerometer. With IMU_WOM_INT_PIN wired, the INT line raises a
+// GPIO interrupt and the callback passed to imu_wom_begin() runs in the
+// ISR; the latch is then cleared with imu_wom_take() from task context.
+// Without a pin, imu_wom_take() polls the latched INT_STATUS register
+// (one byte instead of a six-byte accelerometer read).
+
+#ifndef IMU_WOM_ENABLE
+#if BOARD_PROFILE == BOARD_PROFILE_M5STICKCPLUS2
+#define IMU_WOM_ENABLE 1
+#else
+#define IMU_WOM_ENABLE 0
+#endif
+#endif
+// Per-axis change that counts as motion (4 mg steps, up to 1020 mg).
+#ifndef IMU_WOM_THRESHOLD_MG
+#define IMU_WOM_THRESHOLD_MG 120
+#endif
+// GPIO the IMU INT line is wired to; -1 polls INT_STATUS instead.
+#ifndef IMU_WOM_INT_PIN
+#define IMU_WOM_INT_PIN -1
+#endif
+// INT_STATUS polling period without an interrupt pin.
+#ifndef IMU_WOM_POLL_MS
+#define IMU_WOM_POLL_MS 500
+#endif
+
+static bool gImuWomActive = false;
+static uint32_t gImuWomLastPollMs = 0;
+
+// Arm wake-on-motion after M5.begin(). `on_motion_isr` (IRAM, ISR-safe)
+// runs from the GPIO interrupt when IMU_WOM_INT_PIN is set. Returns false
+// if the board has no supported IMU; callers then compare accelerometer
+// reads as before.
+inline bool imu_wom_begin(void (*on_motion_isr)()) {
+#if IMU_WOM_ENABLE && BOARD_PROFILE == BOARD_PROFILE_M5STICKCPLUS2
+  if (!mpu6886_present()) {
+    return false;
+  }
+  const uint8_t thr = IMU_WOM_THRESHOLD_MG / 4 > 255 ? 255 : IMU_WOM_THRESHOLD_MG / 4;
+  bool ok = mpu6886_write(kMpu6886WomThrX, thr) && mpu6886_write(kMpu6886WomThrY, thr) &&
+            mpu6886_write(kMpu6886WomThrZ, thr) &&
+            mpu6886_write(kMpu6886AccelIntelCtrl, kMpu6886IntelCompareLast) &&
+            mpu6886_write(kMpu6886IntPinCfg, kMpu6886IntLatch) &&
+            mpu6886_write(kMpu6886IntEnable, kMpu6886WomBits);
+  if (!ok) {
+    return false;
+  }
+  mpu6886_read(kMpu6886IntStatus);  // Drop anything latched during setup
+#if IMU_WOM_INT_PIN >= 0
+  pinMode(IMU_WOM_INT_PIN, INPUT);
+  attachInterrupt(digitalPinToInterrupt(IMU_WOM_INT_PIN), on_motion_isr, RISING);
+  power_mgmt_wake_on_gpio(IMU_WOM_INT_PIN, true);  // INT stays high until serviced
+#else
+  (void)on_motion_isr;
+#endif
+  gImuWomActive = true;
+  return true;
+#else
+  (void)on_motion_isr;
+  return false;
+#endif
+}
+
+inline bool imu_wom_active() {
+  return gImuWomActive;
+}
+
+// True if the IMU latched motion since the last call; clears the latch
+// (which also releases the INT line). With an interrupt pin, call it after
+// the ISR fired; without one, call it often and it reads INT_STATUS once
+// per IMU_WOM_POLL_MS.
+inline bool imu_wom_take(uint32_t now_ms, bool isr_fired) {
+#if IMU_WOM_ENABLE && BOARD_PROFILE == BOARD_PROFILE_M5STICKCPLUS2
+  if (!gImuWomActive) {
+    return false;
+  }
+  if (IMU_WOM_INT_PIN >= 0 && !isr_fired) {
+    return false;
+  }
+  if (IMU_WOM_INT_PIN < 0) {
+    if (now_ms - gImuWomLastPollMs < IMU_WOM_POLL_MS) {
+      return false;
+    }
+    gImuWomLastPollMs = now_ms;
+  }
+  return (mpu6886_read(kMpu6886IntStatus) & kMpu6886WomBits) != 0;
+#else
+  (void)now_ms;
+  (void)isr_fired;
+  return false;
+#endif
+}
+
+// Milliseconds until imu_wom_take() next reads INT_STATUS without an
+// interrupt pin; UINT32_MAX when it never polls.
+inline uint32_t imu_wom_ms_until_poll(uint32_t now_ms) {
+  if (!gImuWomActive || IMU_WOM_INT_PIN >= 0) {
+    return UINT32_MAX;
+  }
+  const uint32_t elapsed = now_ms - gImuWomLastPollMs;
+  return elapsed >= IMU_WOM_POLL_MS ? 0 : IMU_WOM_POLL_MS - elapsed;
+}
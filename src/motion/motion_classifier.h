@@ -0,0 +1,192 @@
+#pragma once
+
+#include <stdint.h>
+
+// Windowed motion classifier for batches of accelerometer samples.
+//
+// Samples (one per IMU output period, drained from the FIFO in batches)
+// are cut into windows of IMU_MOTION_WINDOW samples. Each window yields:
+//
+//   * variance: sum over the axes of the sample variance (mg^2), sustained
+//     handling;
+//   * energy: mean squared sample-to-sample difference (mg^2), knocks and
+//     shakes;
+//   * tilt: largest axis change of the window mean against the orientation
+//     the device last came to rest in (mg), slow tilts that never move fast
+//     enough for the other two.
+//
+// A still device turns "moving" when any of the three crosses its enter
+// threshold. It turns "still" again only after IMU_MOTION_EXIT_WINDOWS
+// consecutive quiet windows: variance and energy below their (lower) exit
+// thresholds and the mean no longer drifting. Each still -> moving
+// transition is one movement event, so vibration below the enter
+// thresholds is never counted and a long handling session counts once.
+//
+// Integer only: deviations are taken from the window's first sample and
+// clamped to +-2047 mg, which keeps every sum in int32_t for windows of up
+// to 64 samples. scripts/motion_classifier_bench.py compiles this header on
+// the host, times it per batch and scores it on labelled traces.
+
+#ifndef IMU_MOTION_WINDOW
+#define IMU_MOTION_WINDOW 10  // Samples per window (1 s at 10 Hz)
+#endif
+// Enter / exit thresholds. The exit thresholds are lower (hysteresis).
+#ifndef IMU_MOTION_VAR_ENTER_MG2
+#define IMU_MOTION_VAR_ENTER_MG2 1600  // ~40 mg RMS
+#endif
+#ifndef IMU_MOTION_VAR_EXIT_MG2
+#define IMU_MOTION_VAR_EXIT_MG2 800
+#endif
+#ifndef IMU_MOTION_ENERGY_ENTER_MG2
+#define IMU_MOTION_ENERGY_ENTER_MG2 6400
+#endif
+#ifndef IMU_MOTION_ENERGY_EXIT_MG2
+#define IMU_MOTION_ENERGY_EXIT_MG2 3200
+#endif
+// Orientation change that counts as motion on its own (~6 degrees).
+#ifndef IMU_MOTION_TILT_MG
+#define IMU_MOTION_TILT_MG 100
+#endif
+// Quiet windows before the device counts as still again.
+#ifndef IMU_MOTION_EXIT_WINDOWS
+#define IMU_MOTION_EXIT_WINDOWS 3
+#endif
+
+static_assert(IMU_MOTION_WINDOW >= 2 && IMU_MOTION_WINDOW <= 64,
+              "IMU_MOTION_WINDOW must be 2..64 samples");
+
+struct AccelMg {
+  int16_t x;
+  int16_t y;
+  int16_t z;
+};
+
+class MotionClassifier {
+ public:
+  // Feed one sample. True if it completed a window that started a
+  // movement (still -> moving).
+  bool push(const AccelMg &a) {
+    const int16_t v[3] = {a.x, a.y, a.z};
+    if (n_ == 0) {
+      for (int i = 0; i < 3; ++i) {
+        origin_[i] = v[i];
+      }
+    }
+    for (int i = 0; i < 3; ++i) {
+      const int32_t d = clamp(int32_t(v[i]) - origin_[i]);
+      sum_[i] += d;
+      sq_[i] += d * d;
+      if (have_prev_) {
+        const int32_t dd = clamp(int32_t(v[i]) - prev_[i]);
+        diff_sq_ += dd * dd;
+      }
+      prev_[i] = v[i];
+    }
+    if (have_prev_) {
+      ++diffs_;
+    }
+    have_prev_ = true;
+    return ++n_ == IMU_MOTION_WINDOW && close_window();
+  }
+
+  // Feed a batch; returns the number of movements it started.
+  uint16_t push_batch(const AccelMg *samples, uint16_t count) {
+    uint16_t started = 0;
+    for (uint16_t i = 0; i < count; ++i) {
+      started += push(samples[i]) ? 1 : 0;
+    }
+    return started;
+  }
+
+  bool moving() const { return moving_; }
+  // Mean of the last complete window (valid once windows() > 0).
+  AccelMg mean() const { return {int16_t(mean_[0]), int16_t(mean_[1]), int16_t(mean_[2])}; }
+  uint32_t windows() const { return windows_; }
+  // Features of the last complete window, for diagnostics and tuning.
+  uint32_t variance() const { return variance_; }
+  uint32_t energy() const { return energy_; }
+  uint16_t tilt() const { return tilt_; }
+
+ private:
+  static constexpr int32_t kClampMg = 2047;
+
+  static int32_t clamp(int32_t d) { return d > kClampMg ? kClampMg : (d < -kClampMg ? -kClampMg : d); }
+  static int32_t abs32(int32_t v) { return v < 0 ? -v : v; }
+
+  bool close_window() {
+    int32_t var = 0;
+    int32_t mean[3];
+    for (int i = 0; i < 3; ++i) {
+      const int32_t m = sum_[i] / IMU_MOTION_WINDOW;
+      const int32_t v = sq_[i] / IMU_MOTION_WINDOW - m * m;
+      var += v > 0 ? v : 0;
+      mean[i] = origin_[i] + m;
+    }
+    variance_ = uint32_t(var);
+    energy_ = diffs_ ? uint32_t(diff_sq_ / diffs_) : 0;
+
+    if (windows_ == 0) {
+      for (int i = 0; i < 3; ++i) {
+        rest_[i] = mean[i];
+        mean_[i] = mean[i];
+      }
+    }
+    int32_t tilt = 0;
+    int32_t drift = 0;
+    for (int i = 0; i < 3; ++i) {
+      const int32_t t = abs32(mean[i] - rest_[i]);
+      const int32_t d = abs32(mean[i] - mean_[i]);
+      tilt = t > tilt ? t : tilt;
+      drift = d > drift ? d : drift;
+      mean_[i] = mean[i];
+    }
+    tilt_ = uint16_t(tilt > 0xFFFF ? 0xFFFF : tilt);
+    ++windows_;
+
+    bool started = false;
+    if (!moving_) {
+      if (variance_ >= IMU_MOTION_VAR_ENTER_MG2 || energy_ >= IMU_MOTION_ENERGY_ENTER_MG2 ||
+          tilt >= IMU_MOTION_TILT_MG) {
+        moving_ = true;
+        started = true;
+        quiet_ = 0;
+      }
+    } else if (variance_ < IMU_MOTION_VAR_EXIT_MG2 && energy_ < IMU_MOTION_ENERGY_EXIT_MG2 &&
+               drift < IMU_MOTION_TILT_MG / 4) {
+      if (++quiet_ >= IMU_MOTION_EXIT_WINDOWS) {
+        moving_ = false;
+        for (int i = 0; i < 3; ++i) {
+          rest_[i] = mean[i];  // New resting orientation
+        }
+      }
+    } else {
+      quiet_ = 0;
+    }
+
+    n_ = 0;
+    diffs_ = 0;
+    diff_sq_ = 0;
+    for (int i = 0; i < 3; ++i) {
+      sum_[i] = 0;
+      sq_[i] = 0;
+    }
+    return started;
+  }
+
+  int32_t origin_[3] = {0, 0, 0};  // First sample of the window
+  int32_t sum_[3] = {0, 0, 0};     // Sum of deviations from origin_
+  int32_t sq_[3] = {0, 0, 0};      // Sum of squared deviations
+  int32_t diff_sq_ = 0;            // Sum of squared sample-to-sample differences (all axes)
+  int16_t prev_[3] = {0, 0, 0};
+  int32_t mean_[3] = {0, 0, 0};    // Last window mean
+  int32_t rest_[3] = {0, 0, 0};    // Mean when the device last came to rest
+  uint32_t variance_ = 0;
+  uint32_t energy_ = 0;
+  uint32_t windows_ = 0;
+  uint16_t tilt_ = 0;
+  uint8_t n_ = 0;
+  uint8_t diffs_ = 0;
+  uint8_t quiet_ = 0;
+  bool have_prev_ = false;
+  bool moving_ = false;
+};
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <Arduino.h>
+#include <stdint.h>
+
+#include "config/board_config.h"
+
+// MPU6886 (M5StickC Plus2 IMU) registers shared by the wake-on-motion and
+// FIFO code. M5Unified owns the chip's setup; these helpers only adjust
+// the registers the motion code needs, on M5Unified's internal I2C bus.
+
+constexpr uint8_t kMpu6886Addr = 0x68;
+constexpr uint8_t kMpu6886SmplrtDiv = 0x19;
+constexpr uint8_t kMpu6886AccelConfig = 0x1C;
+constexpr uint8_t kMpu6886AccelConfig2 = 0x1D;
+constexpr uint8_t kMpu6886WomThrX = 0x20;
+constexpr uint8_t kMpu6886WomThrY = 0x21;
+constexpr uint8_t kMpu6886WomThrZ = 0x22;
+constexpr uint8_t kMpu6886FifoEn = 0x23;
+constexpr uint8_t kMpu6886IntPinCfg = 0x37;
+constexpr uint8_t kMpu6886IntEnable = 0x38;
+constexpr uint8_t kMpu6886IntStatus = 0x3A;
+constexpr uint8_t kMpu6886AccelIntelCtrl = 0x69;
+constexpr uint8_t kMpu6886UserCtrl = 0x6A;
+constexpr uint8_t kMpu6886FifoCountH = 0x72;
+constexpr uint8_t kMpu6886FifoRw = 0x74;
+constexpr uint8_t kMpu6886WhoAmI = 0x75;
+constexpr uint8_t kMpu6886WhoAmIValue = 0x19;
+constexpr uint8_t kMpu6886WomBits = 0xE0;           // WOM X/Y/Z (INT_ENABLE, INT_STATUS)
+constexpr uint8_t kMpu6886IntLatch = 0x20;          // INT_PIN_CFG: hold INT until INT_STATUS is read
+constexpr uint8_t kMpu6886IntelCompareLast = 0xC0;  // ACCEL_INTEL_EN | compare with previous sample
+constexpr uint8_t kMpu6886AccelFsMask = 0x18;       // ACCEL_CONFIG: ACCEL_FS_SEL
+constexpr uint8_t kMpu6886AccelDlpf10Hz = 0x05;     // ACCEL_CONFIG2: A_DLPF_CFG 5 (10.2 Hz, 1 kHz rate)
+constexpr uint8_t kMpu6886AccelFifo = 0x08;         // FIFO_EN: ACCEL_FIFO_EN (6-byte records)
+constexpr uint8_t kMpu6886UserFifoEn = 0x40;        // USER_CTRL: FIFO_EN
+constexpr uint8_t kMpu6886UserFifoRst = 0x04;       // USER_CTRL: FIFO_RST
+constexpr uint16_t kMpu6886FifoBytes = 1024;
+constexpr uint32_t kMpu6886I2cHz = 400000;
+
+#if BOARD_PROFILE == BOARD_PROFILE_M5STICKCPLUS2
+// Each helper holds the bus PM lock for its transaction (power/pm_lock.h).
+inline bool mpu6886_write(uint8_t reg, uint8_t value) {
+  PmLock bus(kPmLockBus);
+  return M5.In_I2C.writeRegister8(kMpu6886Addr, reg, value, kMpu6886I2cHz);
+}
+
+inline uint8_t mpu6886_read(uint8_t reg) {
+  PmLock bus(kPmLockBus);
+  return M5.In_I2C.readRegister8(kMpu6886Addr, reg, kMpu6886I2cHz);
+}
+
+// Burst read of `len` bytes starting at `reg` (FIFO_R_W does not
+// auto-increment, so this drains the FIFO).
+inline bool mpu6886_read_burst(uint8_t reg, uint8_t *buf, size_t len) {
+  PmLock bus(kPmLockBus);
+  return M5.In_I2C.readRegister(kMpu6886Addr, reg, buf, len, kMpu6886I2cHz);
+}
+
+inline bool mpu6886_present() {
+  return mpu6886_read(kMpu6886WhoAmI) == kMpu6886WhoAmIValue;
+}
+#endif
@@ -5,6 +5,9 @@
 // firmware size low. For best accuracy, use a full 4096-point table generated
 // per-board (see ntc_lut_full.h and the e-tinkers reference).
 //
+// scripts/gen_ntc_table.py folds these tables into src/ntc_table.h; they
+// are only compiled in with NTC_TABLE=0.
+//
 // Reference LUT source and discussion:
 // https://raw.githubusercontent.com/e-tinkers/ntc-thermistor-with-arduino-and-esp32/refs/heads/master/ntc_3950.ino
 
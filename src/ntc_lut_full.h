@@ -1,5 +1,6 @@
 // Optional full-resolution ADC LUT (4096 entries) for NTC mode.
-// Paste your generated table here and compile with -DUSE_FULL_NTC_LUT.
+// Paste your generated table here, rerun scripts/gen_ntc_table.py and compile
+// with -DUSE_FULL_NTC_LUT.
 // Example source (10k/3950) from e-tinkers:
 // https://raw.githubusercontent.com/e-tinkers/ntc-thermistor-with-arduino-and-esp32/refs/heads/master/ntc_3950.ino
 //
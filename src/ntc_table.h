@@ -0,0 +1,506 @@
+// Generated by scripts/gen_ntc_table.py -- do not edit.
+#pragma once
+
+#include <stdint.h>
+
+// Raw ADC -> centi-degrees C for the NTC, with the ADC linearization
+// and the Beta / series-resistor model folded in. Evenly spaced knots,
+// linear interpolation in between (see ntc_table_lookup()). The float
+// path truncates its LUT interpolation to whole counts, so it steps by up
+// to ~0.2 C at the hot end; the tables interpolate instead.
+// Regenerate after changing the NTC_* parameters or either LUT.
+//
+// Generated for NTC_SERIES_OHMS=10000, NTC_NOMINAL_OHMS=10000,
+// NTC_NOMINAL_TEMP_C=25, NTC_BETA=3950. Knots are clamped
+// to +/-300 C, so an open or shorted NTC still reads far out of range.
+#define NTC_TABLE_SERIES_OHMS 10000.0f
+#define NTC_TABLE_NOMINAL_OHMS 10000.0f
+#define NTC_TABLE_NOMINAL_TEMP_C 25.0f
+#define NTC_TABLE_BETA 3950.0f
+
+#if defined(USE_FULL_NTC_LUT)  // ntc_lut_full.h
+// Step 1 counts, 4097 knots, 8194 bytes. Max error over
+// -40..125 C (ADC 110..4080): 0.005 C vs. the model,
+// 0.223 C vs. the float path (NTC_TABLE=0).
+constexpr uint8_t kNtcTableStepBits = 0;
+static const int16_t kNtcTable[4097] = {
+    -27315,  29650,  23533,  22880,  22240,  21673,  21165,  20749,  20326,  19975,
+     19649,  19411,  19216,  19029,  18850,  18650,  18485,  18326,  18173,  17977,
+     17859,  17721,  17588,  17437,  17333,  17231,  17132,  17054,  16959,  16866,
+     16775,  16685,  16616,  16530,  16446,  16364,  16283,  16204,  16142,  16065,
+     15976,  15874,  15788,  15718,  15649,  15568,  15502,  15437,  15361,  15285,
+     15212,  15139,  15080,  15010,  14952,  14873,  14796,  14731,  14667,  14594,
+     14532,  14471,  14402,  14333,  14276,  14228,  14163,  14126,  14089,  14044,
+     14009,  13965,  13921,  13886,  13852,  13827,  13785,  13743,  13710,  13669,
+     13629,  13597,  13566,  13542,  13503,  13449,  13396,  13351,  13307,  13249,
+     13206,  13163,  13107,  13066,  13025,  12971,  12931,  12898,  12866,  12833,
+     12801,  12763,  12725,  12694,  12657,  12621,  12591,  12561,  12531,  12502,
+     12467,  12438,  12409,  12364,  12330,  12296,  12253,  12220,  12188,  12150,
+     12113,  12082,  12051,  12010,  11984,  11969,  11954,  11929,  11909,  11889,
+     11880,  11855,  11836,  11816,  11802,  11783,  11764,  11740,  11731,  11712,
+     11693,  11670,  11656,  11642,  11624,  11597,  11574,  11547,  11516,  11490,
+     11468,  11442,  11420,  11390,  11361,  11340,  11314,  11294,  11269,  11248,
+     11228,  11204,  11183,  11163,  11144,  11124,  11100,  11081,  11061,  11042,
+     11019,  11000,  10981,  10962,  10943,  10925,  10906,  10888,  10869,  10847,
+     10829,  10811,  10793,  10775,  10758,  10740,  10719,  10702,  10681,  10663,
+     10639,  10622,  10602,  10585,  10565,  10545,  10522,  10505,  10486,  10469,
+     10450,  10427,  10408,  10389,  10364,  10342,  10314,  10295,  10268,  10246,
+     10222,  10201,  10177,  10156,  10142,  10127,  10115,  10101,  10086,  10072,
+     10057,  10043,  10029,  10014,  10000,   9989,   9975,   9961,   9947,   9933,
+      9922,   9916,   9905,   9894,   9889,   9878,   9867,   9862,   9851,   9843,
+      9835,   9824,   9816,   9808,   9797,   9792,   9782,   9771,   9766,   9755,
+      9745,   9739,   9729,   9719,   9716,   9677,   9642,   9609,   9576,   9542,
+      9512,   9500,   9488,   9476,   9464,   9452,   9442,   9430,   9419,   9407,
+      9395,   9383,   9372,   9360,   9348,   9337,   9325,   9314,   9300,   9284,
+      9270,   9259,   9248,   9234,   9223,   9212,   9196,   9183,   9170,   9159,
+      9148,   9137,   9126,   9115,   9105,   9096,   9087,   9079,   9068,   9060,
+      9049,   9038,   9028,   9019,   9009,   8999,   8988,   8980,   8971,   8963,
+      8955,   8945,   8934,   8924,   8916,   8906,   8896,   8886,   8878,   8870,
+      8862,   8854,   8844,   8834,   8824,   8816,   8804,   8790,   8777,   8765,
+      8747,   8736,   8722,   8709,   8698,   8680,   8669,   8656,   8641,   8624,
+      8613,   8596,   8583,   8569,   8554,   8539,   8523,   8512,   8498,   8487,
+      8477,   8464,   8452,   8441,   8431,   8417,   8408,   8397,   8383,   8373,
+      8363,   8354,   8346,   8335,   8325,   8315,   8305,   8296,   8288,   8278,
+      8269,   8261,   8251,   8241,   8233,   8228,   8220,   8213,   8206,   8202,
+      8195,   8188,   8180,   8175,   8171,   8162,   8156,   8150,   8145,   8138,
+      8132,   8124,   8119,   8114,   8106,   8100,   8092,   8084,   8078,   8071,
+      8065,   8059,   8051,   8043,   8037,   8029,   8021,   8014,   8007,   8001,
+      7995,   7989,   7981,   7969,   7958,   7945,   7934,   7921,   7908,   7898,
+      7885,   7874,   7862,   7855,   7848,   7842,   7837,   7831,   7824,   7818,
+      7811,   7807,   7802,   7795,   7789,   7782,   7776,   7770,   7766,   7759,
+      7753,   7746,   7739,   7729,   7718,   7706,   7695,   7682,   7674,   7661,
+      7650,   7639,   7630,   7620,   7613,   7605,   7598,   7591,   7582,   7573,
+      7565,   7559,   7550,   7544,   7536,   7526,   7520,   7514,   7509,   7504,
+      7497,   7490,   7484,   7479,   7472,   7465,   7459,   7454,   7448,   7443,
+      7438,   7431,   7425,   7418,   7409,   7399,   7387,   7376,   7366,   7354,
+      7343,   7332,   7323,   7311,   7305,   7299,   7294,   7288,   7281,   7275,
+      7270,   7264,   7258,   7252,   7247,   7241,   7235,   7228,   7223,   7217,
+      7213,   7209,   7205,   7202,   7199,   7194,   7192,   7188,   7185,   7181,
+      7176,   7175,   7170,   7168,   7163,   7159,   7157,   7152,   7150,   7146,
+      7143,   7139,   7134,   7133,   7128,   7126,   7121,   7115,   7105,   7094,
+      7086,   7075,   7064,   7055,   7045,   7035,   7026,   7021,   7016,   7010,
+      7005,   6999,   6993,   6987,   6983,   6977,   6972,   6966,   6960,   6956,
+      6950,   6946,   6940,   6935,   6930,   6924,   6918,   6912,   6906,   6901,
+      6894,   6889,   6883,   6878,   6871,   6865,   6860,   6854,   6849,   6844,
+      6838,   6833,   6827,   6822,   6816,   6811,   6805,   6800,   6795,   6789,
+      6784,   6779,   6773,   6768,   6763,   6756,   6747,   6739,   6730,   6720,
+      6713,   6703,   6695,   6688,   6678,   6672,   6667,   6659,   6653,   6647,
+      6642,   6636,   6631,   6625,   6619,   6612,   6606,   6601,   6595,   6590,
+      6584,   6576,   6570,   6565,   6559,   6553,   6546,   6540,   6534,   6529,
+      6523,   6516,   6510,   6505,   6500,   6495,   6491,   6486,   6481,   6475,
+      6470,   6465,   6460,   6455,   6450,   6445,   6441,   6436,   6430,   6425,
+      6419,   6414,   6409,   6404,   6398,   6393,   6388,   6384,   6379,   6374,
+      6369,   6364,   6359,   6354,   6349,   6344,   6338,   6331,   6327,   6322,
+      6316,   6312,   6307,   6301,   6296,   6290,   6284,   6280,   6277,   6274,
+      6270,   6266,   6262,   6259,   6256,   6252,   6247,   6245,   6242,   6237,
+      6234,   6230,   6227,   6223,   6220,   6215,   6213,   6210,   6183,   6152,
+      6134,   6130,   6126,   6122,   6118,   6114,   6110,   6106,   6102,   6098,
+      6093,   6089,   6085,   6081,   6076,   6072,   6068,   6063,   6060,   6056,
+      6053,   6049,   6045,   6041,   6037,   6033,   6028,   6025,   6021,   6018,
+      6015,   6010,   6006,   6002,   5998,   5994,   5989,   5984,   5978,   5972,
+      5968,   5963,   5958,   5952,   5947,   5942,   5938,   5933,   5927,   5925,
+      5921,   5917,   5913,   5911,   5908,   5904,   5901,   5896,   5894,   5891,
+      5887,   5884,   5880,   5877,   5875,   5871,   5867,   5864,   5861,   5855,
+      5851,   5846,   5841,   5834,   5830,   5825,   5820,   5814,   5810,   5805,
+      5801,   5795,   5791,   5787,   5783,   5779,   5775,   5771,   5766,   5763,
+      5759,   5755,   5751,   5747,   5743,   5739,   5735,   5731,   5725,   5721,
+      5716,   5711,   5706,   5701,   5696,   5692,   5687,   5681,   5677,   5672,
+      5668,   5664,   5660,   5656,   5652,   5648,   5645,   5641,   5637,   5633,
+      5629,   5625,   5622,   5618,   5614,   5610,   5606,   5601,   5595,   5591,
+      5587,   5581,   5576,   5571,   5567,   5561,   5557,   5552,   5546,   5542,
+      5539,   5537,   5533,   5530,   5526,   5523,   5521,   5518,   5514,   5511,
+      5507,   5504,   5502,   5499,   5495,   5492,   5489,   5486,   5483,   5479,
+      5474,   5470,   5466,   5462,   5459,   5454,   5450,   5447,   5442,   5438,
+      5433,   5429,   5425,   5422,   5417,   5414,   5409,   5404,   5400,   5396,
+      5391,   5388,   5383,   5378,   5374,   5370,   5366,   5362,   5357,   5352,
+      5349,   5344,   5341,   5336,   5331,   5327,   5323,   5319,   5315,   5311,
+      5307,   5305,   5302,   5299,   5297,   5295,   5291,   5290,   5287,   5284,
+      5282,   5280,   5277,   5274,   5272,   5269,   5266,   5265,   5262,   5259,
+      5257,   5255,   5252,   5248,   5244,   5240,   5234,   5231,   5227,   5222,
+      5217,   5213,   5209,   5205,   5199,   5196,   5192,   5188,   5185,   5181,
+      5178,   5174,   5169,   5166,   5162,   5158,   5154,   5151,   5147,   5144,
+      5140,   5136,   5130,   5126,   5120,   5116,   5110,   5105,   5100,   5095,
+      5090,   5085,   5082,   5079,   5076,   5073,   5070,   5067,   5065,   5061,
+      5058,   5055,   5052,   5049,   5047,   5044,   5041,   5038,   5035,   5032,
+      5029,   5025,   5022,   5019,   5016,   5013,   5010,   5007,   5004,   5001,
+      4998,   4995,   4991,   4988,   4985,   4982,   4979,   4975,   4971,   4968,
+      4965,   4961,   4957,   4953,   4949,   4946,   4942,   4939,   4935,   4932,
+      4929,   4925,   4922,   4920,   4916,   4914,   4912,   4909,   4907,   4903,
+      4901,   4899,   4896,   4893,   4890,   4887,   4885,   4883,   4880,   4877,
+      4874,   4872,   4868,   4865,   4861,   4858,   4855,   4852,   4848,   4845,
+      4842,   4839,   4836,   4832,   4829,   4825,   4822,   4819,   4816,   4813,
+      4810,   4806,   4803,   4800,   4797,   4794,   4791,   4788,   4785,   4782,
+      4779,   4775,   4772,   4768,   4764,   4760,   4756,   4750,   4746,   4743,
+      4738,   4734,   4730,   4725,   4722,   4718,   4716,   4713,   4712,   4709,
+      4707,   4704,   4701,   4699,   4697,   4694,   4691,   4689,   4687,   4684,
+      4682,   4679,   4677,   4675,   4672,   4667,   4662,   4657,   4651,   4645,
+      4639,   4633,   4628,   4623,   4619,   4616,   4613,   4610,   4606,   4603,
+      4599,   4596,   4593,   4590,   4587,   4584,   4581,   4578,   4575,   4572,
+      4569,   4566,   4563,   4560,   4557,   4554,   4551,   4548,   4545,   4542,
+      4540,   4537,   4534,   4531,   4528,   4526,   4524,   4521,   4518,   4516,
+      4514,   4512,   4509,   4506,   4505,   4503,   4500,   4498,   4495,   4493,
+      4491,   4488,   4486,   4483,   4481,   4479,   4474,   4468,   4464,   4459,
+      4453,   4447,   4443,   4438,   4433,   4429,   4426,   4423,   4420,   4417,
+      4413,   4410,   4407,   4404,   4400,   4397,   4394,   4392,   4388,   4385,
+      4383,   4380,   4377,   4374,   4372,   4369,   4366,   4363,   4361,   4359,
+      4356,   4354,   4351,   4348,   4345,   4343,   4340,   4337,   4335,   4332,
+      4329,   4327,   4325,   4323,   4320,   4317,   4314,   4311,   4309,   4306,
+      4303,   4300,   4298,   4295,   4292,   4286,   4281,   4275,   4270,   4264,
+      4259,   4253,   4248,   4244,   4241,   4237,   4233,   4229,   4226,   4221,
+      4218,   4215,   4210,   4207,   4204,   4201,   4199,   4196,   4193,   4190,
+      4188,   4185,   4183,   4180,   4177,   4175,   4173,   4170,   4168,   4165,
+      4163,   4160,   4158,   4155,   4153,   4152,   4149,   4147,   4145,   4143,
+      4141,   4138,   4137,   4135,   4132,   4130,   4128,   4127,   4124,   4122,
+      4120,   4119,   4116,   4113,   4109,   4105,   4102,   4099,   4095,   4091,
+      4089,   4084,   4081,   4078,   4074,   4070,   4068,   4066,   4064,   4061,
+      4059,   4056,   4053,   4051,   4048,   4046,   4043,   4040,   4038,   4035,
+      4033,   4031,   4027,   4021,   4013,   4006,   3999,   3992,   3986,   3984,
+      3982,   3981,   3979,   3977,   3975,   3973,   3972,   3970,   3968,   3967,
+      3965,   3963,   3962,   3960,   3958,   3957,   3955,   3954,   3952,   3950,
+      3949,   3947,   3945,   3944,   3940,   3936,   3933,   3928,   3925,   3921,
+      3917,   3913,   3910,   3906,   3902,   3899,   3897,   3894,   3891,   3889,
+      3887,   3885,   3883,   3880,   3878,   3875,   3873,   3870,   3868,   3865,
+      3863,   3861,   3858,   3855,   3852,   3847,   3844,   3841,   3836,   3833,
+      3830,   3826,   3823,   3819,   3816,   3813,   3811,   3808,   3805,   3803,
+      3800,   3798,   3795,   3792,   3790,   3787,   3785,   3782,   3780,   3777,
+      3774,   3772,   3770,   3768,   3766,   3764,   3761,   3759,   3756,   3754,
+      3752,   3750,   3748,   3746,   3743,   3741,   3739,   3736,   3733,   3729,
+      3725,   3721,   3716,   3712,   3707,   3703,   3698,   3695,   3692,   3690,
+      3687,   3685,   3683,   3680,   3678,   3675,   3672,   3670,   3668,   3666,
+      3663,   3661,   3659,   3657,   3654,   3650,   3647,   3643,   3640,   3636,
+      3632,   3629,   3625,   3622,   3617,   3614,   3612,   3610,   3607,   3606,
+      3604,   3602,   3600,   3597,   3595,   3594,   3592,   3589,   3587,   3585,
+      3583,   3582,   3579,   3577,   3575,   3572,   3570,   3567,   3565,   3562,
+      3560,   3557,   3555,   3552,   3550,   3547,   3545,   3542,   3540,   3538,
+      3535,   3533,   3530,   3529,   3527,   3525,   3522,   3520,   3518,   3516,
+      3514,   3512,   3510,   3508,   3505,   3503,   3502,   3500,   3498,   3496,
+      3493,   3490,   3486,   3483,   3479,   3476,   3473,   3469,   3466,   3463,
+      3459,   3456,   3453,   3451,   3447,   3444,   3441,   3439,   3436,   3433,
+      3430,   3427,   3424,   3421,   3418,   3415,   3413,   3411,   3409,   3407,
+      3405,   3402,   3400,   3398,   3396,   3394,   3392,   3390,   3388,   3385,
+      3383,   3381,   3379,   3376,   3374,   3371,   3369,   3366,   3364,   3361,
+      3359,   3357,   3354,   3351,   3348,   3345,   3343,   3340,   3338,   3336,
+      3334,   3333,   3330,   3328,   3326,   3323,   3322,   3320,   3318,   3316,
+      3314,   3311,   3310,   3308,   3306,   3304,   3301,   3298,   3294,   3290,
+      3285,   3282,   3278,   3273,   3269,   3265,   3261,   3260,   3259,   3256,
+      3254,   3252,   3251,   3249,   3247,   3245,   3243,   3242,   3240,   3238,
+      3235,   3234,   3232,   3230,   3228,   3226,   3224,   3222,   3219,   3216,
+      3214,   3212,   3209,   3206,   3204,   3202,   3199,   3197,   3194,   3191,
+      3188,   3186,   3183,   3181,   3178,   3176,   3174,   3171,   3168,   3166,
+      3163,   3160,   3158,   3155,   3153,   3150,   3148,   3145,   3143,   3141,
+      3138,   3136,   3134,   3131,   3129,   3127,   3124,   3122,   3119,   3117,
+      3114,   3112,   3109,   3106,   3102,   3099,   3096,   3093,   3090,   3087,
+      3084,   3081,   3078,   3075,   3071,   3069,   3065,   3062,   3059,   3056,
+      3053,   3050,   3046,   3044,   3041,   3038,   3035,   3033,   3031,   3029,
+      3027,   3025,   3022,   3020,   3018,   3015,   3013,   3011,   3009,   3007,
+      3004,   3002,   3000,   2998,   2996,   2994,   2992,   2990,   2988,   2985,
+      2984,   2981,   2979,   2977,   2975,   2974,   2972,   2969,   2967,   2965,
+      2963,   2960,   2956,   2954,   2951,   2948,   2945,   2942,   2940,   2936,
+      2933,   2931,   2928,   2926,   2924,   2922,   2920,   2917,   2915,   2914,
+      2912,   2910,   2908,   2905,   2904,   2901,   2899,   2897,   2895,   2894,
+      2892,   2888,   2885,   2883,   2880,   2876,   2874,   2871,   2868,   2865,
+      2862,   2860,   2856,   2854,   2851,   2848,   2845,   2842,   2839,   2836,
+      2833,   2830,   2827,   2824,   2821,   2818,   2815,   2813,   2811,   2808,
+      2806,   2804,   2801,   2799,   2796,   2793,   2791,   2788,   2786,   2784,
+      2782,   2780,   2779,   2777,   2775,   2773,   2772,   2770,   2768,   2767,
+      2765,   2763,   2761,   2760,   2759,   2756,   2755,   2753,   2752,   2750,
+      2748,   2746,   2743,   2741,   2739,   2736,   2734,   2732,   2729,   2726,
+      2724,   2721,   2719,   2716,   2714,   2712,   2709,   2706,   2703,   2701,
+      2698,   2696,   2693,   2690,   2687,   2685,   2683,   2680,   2677,   2674,
+      2671,   2667,   2664,   2660,   2657,   2654,   2650,   2647,   2643,   2640,
+      2638,   2636,   2634,   2632,   2631,   2629,   2627,   2625,   2623,   2622,
+      2620,   2618,   2616,   2614,   2613,   2611,   2609,   2607,   2605,   2603,
+      2601,   2599,   2596,   2594,   2592,   2590,   2588,   2585,   2583,   2581,
+      2579,   2576,   2574,   2572,   2570,   2567,   2564,   2561,   2558,   2555,
+      2552,   2550,   2546,   2543,   2541,   2537,   2535,   2533,   2532,   2531,
+      2530,   2529,   2528,   2528,   2526,   2525,   2524,   2523,   2522,   2521,
+      2520,   2519,   2519,   2517,   2517,   2515,   2514,   2513,   2513,   2512,
+      2510,   2510,   2508,   2508,   2507,   2506,   2505,   2504,   2503,   2502,
+      2501,   2500,   2499,   2497,   2495,   2492,   2489,   2486,   2484,   2481,
+      2478,   2475,   2473,   2470,   2467,   2464,   2462,   2460,   2458,   2455,
+      2453,   2451,   2449,   2447,   2444,   2442,   2440,   2438,   2436,   2434,
+      2432,   2430,   2427,   2425,   2422,   2420,   2416,   2414,   2411,   2409,
+      2406,   2403,   2401,   2398,   2395,   2393,   2392,   2389,   2388,   2386,
+      2385,   2383,   2381,   2379,   2378,   2376,   2374,   2372,   2371,   2369,
+      2368,   2366,   2364,   2362,   2361,   2359,   2357,   2354,   2351,   2348,
+      2345,   2342,   2339,   2336,   2333,   2331,   2327,   2324,   2322,   2318,
+      2315,   2311,   2308,   2305,   2302,   2298,   2295,   2292,   2289,   2286,
+      2284,   2281,   2279,   2277,   2274,   2272,   2270,   2267,   2264,   2262,
+      2259,   2257,   2255,   2253,   2251,   2250,   2248,   2246,   2244,   2242,
+      2241,   2239,   2237,   2235,   2233,   2232,   2231,   2228,   2227,   2225,
+      2223,   2222,   2220,   2218,   2215,   2213,   2212,   2209,   2207,   2205,
+      2203,   2201,   2199,   2196,   2194,   2192,   2190,   2188,   2186,   2183,
+      2181,   2179,   2177,   2175,   2173,   2170,   2168,   2166,   2164,   2161,
+      2159,   2157,   2155,   2153,   2151,   2148,   2147,   2145,   2142,   2140,
+      2139,   2137,   2135,   2133,   2131,   2129,   2127,   2125,   2123,   2121,
+      2119,   2117,   2115,   2113,   2111,   2108,   2106,   2104,   2101,   2099,
+      2097,   2095,   2093,   2091,   2088,   2086,   2084,   2082,   2078,   2074,
+      2069,   2066,   2062,   2057,   2054,   2049,   2045,   2044,   2043,   2041,
+      2039,   2037,   2036,   2034,   2032,   2030,   2029,   2027,   2026,   2024,
+      2022,   2020,   2019,   2017,   2015,   2013,   2012,   2010,   2008,   2006,
+      2004,   2002,   2000,   1998,   1996,   1994,   1992,   1990,   1988,   1987,
+      1985,   1982,   1980,   1979,   1976,   1973,   1970,   1967,   1964,   1961,
+      1959,   1955,   1952,   1949,   1946,   1944,   1941,   1938,   1935,   1933,
+      1930,   1927,   1924,   1922,   1918,   1916,   1914,   1911,   1908,   1905,
+      1903,   1901,   1899,   1897,   1895,   1893,   1890,   1888,   1886,   1884,
+      1881,   1879,   1877,   1875,   1872,   1869,   1867,   1864,   1862,   1859,
+      1856,   1853,   1851,   1848,   1845,   1843,   1841,   1838,   1835,   1832,
+      1829,   1826,   1823,   1821,   1817,   1815,   1812,   1809,   1806,   1804,
+      1802,   1801,   1800,   1798,   1796,   1794,   1793,   1791,   1789,   1787,
+      1786,   1784,   1783,   1781,   1779,   1777,   1776,   1774,   1772,   1770,
+      1765,   1761,   1757,   1752,   1748,   1744,   1739,   1736,   1735,   1733,
+      1731,   1729,   1728,   1727,   1724,   1723,   1721,   1720,   1718,   1716,
+      1714,   1713,   1712,   1710,   1708,   1706,   1705,   1703,   1701,   1698,
+      1695,   1692,   1690,   1686,   1684,   1681,   1678,   1675,   1673,   1669,
+      1667,   1665,   1663,   1662,   1660,   1658,   1656,   1653,   1652,   1650,
+      1647,   1645,   1643,   1642,   1640,   1638,   1636,   1634,   1632,   1629,
+      1626,   1624,   1622,   1619,   1616,   1614,   1611,   1609,   1606,   1604,
+      1601,   1598,   1597,   1595,   1593,   1591,   1589,   1587,   1585,   1583,
+      1581,   1580,   1578,   1576,   1574,   1572,   1570,   1568,   1566,   1564,
+      1561,   1559,   1556,   1554,   1551,   1548,   1546,   1543,   1541,   1538,
+      1535,   1533,   1530,   1528,   1526,   1524,   1521,   1519,   1516,   1514,
+      1511,   1509,   1507,   1505,   1503,   1501,   1498,   1496,   1494,   1491,
+      1488,   1485,   1483,   1481,   1479,   1476,   1474,   1471,   1468,   1466,
+      1463,   1461,   1458,   1455,   1451,   1448,   1445,   1442,   1438,   1435,
+      1432,   1429,   1425,   1422,   1418,   1416,   1412,   1409,   1405,   1402,
+      1398,   1394,   1392,   1390,   1388,   1386,   1385,   1383,   1381,   1379,
+      1378,   1377,   1375,   1373,   1371,   1370,   1368,   1366,   1364,   1363,
+      1361,   1360,   1357,   1356,   1353,   1351,   1349,   1346,   1344,   1341,
+      1338,   1336,   1333,   1331,   1329,   1326,   1323,   1321,   1319,   1317,
+      1315,   1313,   1311,   1309,   1307,   1305,   1302,   1301,   1298,   1296,
+      1294,   1292,   1290,   1288,   1286,   1283,   1281,   1278,   1275,   1272,
+      1270,   1267,   1264,   1261,   1259,   1256,   1254,   1251,   1249,   1247,
+      1245,   1243,   1241,   1239,   1237,   1235,   1232,   1231,   1228,   1226,
+      1224,   1222,   1220,   1218,   1216,   1213,   1211,   1209,   1206,   1204,
+      1202,   1200,   1198,   1195,   1193,   1191,   1188,   1186,   1184,   1182,
+      1179,   1176,   1174,   1171,   1169,   1166,   1164,   1162,   1159,   1157,
+      1154,   1151,   1149,   1146,   1144,   1142,   1140,   1138,   1135,   1133,
+      1131,   1129,   1127,   1124,   1122,   1120,   1118,   1115,   1113,   1111,
+      1109,   1107,   1104,   1101,   1098,   1096,   1094,   1091,   1089,   1087,
+      1084,   1081,   1079,   1076,   1074,   1072,   1069,   1067,   1065,   1063,
+      1061,   1059,   1056,   1054,   1052,   1050,   1048,   1046,   1044,   1041,
+      1038,   1034,   1029,   1024,   1019,   1014,   1009,   1004,   1002,   1000,
+       998,    996,    994,    993,    991,    989,    987,    985,    983,    981,
+       980,    977,    976,    973,    971,    969,    968,    966,    964,    964,
+       962,    960,    959,    958,    956,    955,    953,    952,    950,    949,
+       948,    946,    944,    944,    942,    940,    939,    937,    936,    935,
+       933,    931,    928,    926,    923,    920,    917,    915,    912,    909,
+       906,    904,    901,    899,    896,    894,    892,    890,    888,    885,
+       883,    881,    880,    878,    876,    874,    872,    870,    867,    866,
+       864,    862,    860,    856,    853,    850,    847,    844,    840,    837,
+       833,    831,    827,    824,    821,    817,    813,    810,    806,    803,
+       799,    795,    792,    788,    785,    783,    781,    780,    778,    776,
+       773,    772,    769,    767,    765,    763,    761,    760,    757,    756,
+       753,    751,    749,    746,    744,    741,    737,    735,    732,    730,
+       726,    723,    721,    718,    715,    712,    711,    709,    707,    705,
+       702,    701,    699,    697,    695,    693,    691,    689,    687,    685,
+       683,    681,    679,    677,    675,    673,    670,    668,    666,    664,
+       662,    659,    657,    655,    653,    650,    648,    646,    644,    642,
+       639,    635,    630,    625,    621,    616,    611,    607,    602,    600,
+       597,    595,    592,    590,    588,    585,    583,    581,    578,    576,
+       574,    571,    569,    567,    564,    562,    560,    558,    556,    554,
+       552,    550,    548,    546,    543,    541,    540,    538,    536,    534,
+       531,    529,    527,    525,    523,    521,    519,    517,    515,    512,
+       510,    508,    506,    504,    502,    500,    498,    496,    493,    491,
+       489,    486,    484,    482,    480,    477,    475,    473,    471,    469,
+       467,    464,    462,    460,    457,    455,    453,    451,    448,    443,
+       440,    436,    433,    429,    426,    422,    419,    415,    412,    409,
+       407,    404,    402,    399,    397,    395,    392,    390,    387,    385,
+       383,    380,    378,    375,    373,    370,    366,    363,    359,    356,
+       352,    349,    346,    342,    339,    334,    332,    329,    327,    325,
+       323,    322,    319,    317,    314,    312,    310,    307,    305,    303,
+       301,    299,    297,    294,    293,    291,    289,    287,    285,    284,
+       282,    280,    278,    276,    275,    273,    270,    269,    267,    265,
+       263,    262,    260,    258,    256,    255,    252,    250,    247,    245,
+       242,    240,    238,    235,    233,    230,    228,    226,    223,    221,
+       218,    216,    213,    209,    206,    203,    198,    195,    192,    188,
+       185,    181,    177,    174,    172,    170,    168,    166,    164,    162,
+       160,    158,    156,    154,    152,    150,    148,    145,    144,    142,
+       140,    137,    135,    133,    130,    127,    125,    122,    119,    117,
+       114,    112,    108,    106,    103,    100,     97,     94,     92,     89,
+        85,     82,     79,     76,     73,     70,     66,     63,     60,     57,
+        53,     50,     47,     44,     41,     38,     34,     32,     28,     25,
+        21,     19,     15,     12,      9,      6,      4,      1,     -1,     -4,
+        -7,     -9,    -12,    -15,    -17,    -20,    -22,    -25,    -28,    -31,
+       -33,    -36,    -37,    -39,    -41,    -43,    -46,    -48,    -50,    -52,
+       -54,    -57,    -59,    -60,    -62,    -65,    -67,    -70,    -71,    -73,
+       -76,    -78,    -81,    -83,    -85,    -86,    -89,    -91,    -94,    -96,
+       -98,   -100,   -102,   -105,   -107,   -110,   -111,   -114,   -116,   -121,
+      -126,   -130,   -135,   -140,   -145,   -150,   -154,   -159,   -161,   -164,
+      -166,   -168,   -170,   -172,   -174,   -177,   -179,   -180,   -183,   -185,
+      -188,   -190,   -191,   -194,   -196,   -199,   -201,   -203,   -206,   -210,
+      -213,   -216,   -219,   -222,   -225,   -229,   -232,   -235,   -238,   -241,
+      -245,   -248,   -251,   -255,   -257,   -262,   -265,   -268,   -271,   -275,
+      -279,   -282,   -285,   -288,   -291,   -293,   -294,   -296,   -296,   -298,
+      -299,   -301,   -302,   -304,   -305,   -307,   -307,   -310,   -310,   -312,
+      -313,   -315,   -316,   -318,   -319,   -320,   -321,   -323,   -324,   -325,
+      -327,   -328,   -329,   -331,   -332,   -333,   -335,   -338,   -341,   -346,
+      -350,   -354,   -358,   -362,   -366,   -370,   -375,   -378,   -383,   -386,
+      -388,   -391,   -394,   -398,   -400,   -403,   -406,   -409,   -412,   -415,
+      -418,   -421,   -423,   -426,   -429,   -432,   -435,   -438,   -441,   -444,
+      -447,   -450,   -453,   -456,   -459,   -462,   -465,   -468,   -471,   -474,
+      -476,   -479,   -480,   -482,   -485,   -487,   -488,   -491,   -493,   -495,
+      -497,   -499,   -502,   -503,   -505,   -508,   -509,   -512,   -514,   -516,
+      -518,   -520,   -522,   -524,   -527,   -529,   -532,   -535,   -537,   -538,
+      -541,   -544,   -547,   -549,   -550,   -553,   -556,   -559,   -561,   -563,
+      -565,   -568,   -571,   -577,   -580,   -586,   -589,   -595,   -598,   -604,
+      -608,   -613,   -617,   -620,   -622,   -623,   -626,   -628,   -630,   -632,
+      -634,   -637,   -638,   -641,   -644,   -645,   -647,   -650,   -652,   -653,
+      -656,   -658,   -660,   -663,   -665,   -667,   -669,   -673,   -675,   -678,
+      -681,   -684,   -687,   -691,   -694,   -696,   -699,   -702,   -705,   -709,
+      -712,   -714,   -717,   -719,   -722,   -725,   -727,   -731,   -733,   -736,
+      -738,   -741,   -744,   -746,   -750,   -752,   -754,   -756,   -760,   -762,
+      -765,   -769,   -772,   -777,   -781,   -785,   -790,   -795,   -799,   -804,
+      -808,   -812,   -817,   -820,   -822,   -824,   -827,   -830,   -832,   -834,
+      -837,   -839,   -843,   -844,   -846,   -849,   -852,   -854,   -856,   -860,
+      -862,   -865,   -866,   -869,   -872,   -875,   -877,   -879,   -883,   -885,
+      -888,   -890,   -892,   -896,   -898,   -901,   -903,   -906,   -909,   -912,
+      -914,   -916,   -919,   -922,   -925,   -928,   -932,   -935,   -938,   -942,
+      -945,   -949,   -952,   -955,   -959,   -962,   -965,   -969,   -972,   -976,
+      -979,   -982,   -984,   -986,   -990,   -993,   -996,   -999,  -1003,  -1006,
+     -1008,  -1010,  -1014,  -1017,  -1020,  -1023,  -1027,  -1029,  -1032,  -1035,
+     -1037,  -1038,  -1041,  -1044,  -1045,  -1048,  -1051,  -1052,  -1055,  -1057,
+     -1059,  -1062,  -1064,  -1066,  -1069,  -1070,  -1073,  -1076,  -1077,  -1080,
+     -1083,  -1083,  -1086,  -1090,  -1091,  -1094,  -1097,  -1100,  -1102,  -1105,
+     -1107,  -1111,  -1112,  -1115,  -1118,  -1122,  -1123,  -1126,  -1129,  -1132,
+     -1134,  -1137,  -1140,  -1142,  -1145,  -1148,  -1152,  -1156,  -1160,  -1164,
+     -1168,  -1172,  -1176,  -1179,  -1183,  -1187,  -1190,  -1194,  -1198,  -1202,
+     -1205,  -1209,  -1210,  -1213,  -1217,  -1220,  -1223,  -1224,  -1228,  -1231,
+     -1234,  -1237,  -1239,  -1243,  -1245,  -1248,  -1251,  -1254,  -1257,  -1260,
+     -1263,  -1266,  -1270,  -1273,  -1277,  -1281,  -1284,  -1287,  -1291,  -1295,
+     -1299,  -1303,  -1306,  -1310,  -1314,  -1318,  -1322,  -1325,  -1326,  -1329,
+     -1332,  -1334,  -1337,  -1340,  -1341,  -1344,  -1347,  -1349,  -1352,  -1355,
+     -1356,  -1359,  -1362,  -1364,  -1367,  -1369,  -1372,  -1375,  -1377,  -1380,
+     -1383,  -1384,  -1387,  -1391,  -1395,  -1398,  -1402,  -1406,  -1410,  -1413,
+     -1417,  -1420,  -1423,  -1427,  -1431,  -1434,  -1438,  -1442,  -1446,  -1449,
+     -1451,  -1454,  -1456,  -1459,  -1462,  -1463,  -1466,  -1469,  -1471,  -1474,
+     -1477,  -1479,  -1482,  -1484,  -1486,  -1490,  -1491,  -1495,  -1497,  -1499,
+     -1503,  -1504,  -1508,  -1511,  -1512,  -1516,  -1519,  -1521,  -1524,  -1527,
+     -1529,  -1532,  -1536,  -1537,  -1541,  -1544,  -1546,  -1549,  -1552,  -1555,
+     -1557,  -1561,  -1563,  -1566,  -1569,  -1572,  -1574,  -1577,  -1582,  -1585,
+     -1588,  -1592,  -1595,  -1599,  -1604,  -1607,  -1611,  -1616,  -1619,  -1622,
+     -1625,  -1629,  -1634,  -1638,  -1641,  -1646,  -1648,  -1651,  -1654,  -1655,
+     -1659,  -1660,  -1663,  -1665,  -1667,  -1670,  -1673,  -1675,  -1677,  -1681,
+     -1681,  -1685,  -1686,  -1689,  -1691,  -1694,  -1696,  -1699,  -1702,  -1703,
+     -1707,  -1708,  -1711,  -1713,  -1716,  -1719,  -1724,  -1727,  -1732,  -1736,
+     -1739,  -1744,  -1748,  -1753,  -1757,  -1762,  -1765,  -1770,  -1774,  -1779,
+     -1783,  -1788,  -1791,  -1793,  -1794,  -1797,  -1798,  -1802,  -1803,  -1806,
+     -1807,  -1811,  -1812,  -1815,  -1817,  -1818,  -1820,  -1823,  -1825,  -1827,
+     -1830,  -1831,  -1834,  -1835,  -1839,  -1840,  -1844,  -1845,  -1847,  -1849,
+     -1851,  -1854,  -1856,  -1858,  -1860,  -1862,  -1864,  -1870,  -1876,  -1881,
+     -1886,  -1892,  -1897,  -1901,  -1907,  -1913,  -1919,  -1925,  -1929,  -1934,
+     -1940,  -1943,  -1945,  -1946,  -1949,  -1950,  -1953,  -1954,  -1956,  -1959,
+     -1960,  -1963,  -1964,  -1965,  -1969,  -1970,  -1972,  -1974,  -1975,  -1979,
+     -1980,  -1982,  -1984,  -1985,  -1988,  -1989,  -1991,  -1993,  -1994,  -1998,
+     -1999,  -2000,  -2003,  -2004,  -2008,  -2010,  -2011,  -2014,  -2015,  -2018,
+     -2020,  -2024,  -2030,  -2039,  -2046,  -2055,  -2063,  -2071,  -2080,  -2086,
+     -2096,  -2103,  -2107,  -2111,  -2115,  -2119,  -2123,  -2127,  -2131,  -2134,
+     -2139,  -2143,  -2147,  -2149,  -2155,  -2159,  -2163,  -2165,  -2171,  -2175,
+     -2180,  -2182,  -2187,  -2191,  -2193,  -2197,  -2199,  -2202,  -2206,  -2209,
+     -2212,  -2214,  -2219,  -2220,  -2224,  -2227,  -2230,  -2234,  -2237,  -2241,
+     -2242,  -2247,  -2249,  -2252,  -2256,  -2259,  -2262,  -2265,  -2269,  -2270,
+     -2275,  -2277,  -2280,  -2284,  -2287,  -2291,  -2293,  -2296,  -2299,  -2303,
+     -2304,  -2309,  -2310,  -2315,  -2317,  -2320,  -2323,  -2326,  -2330,  -2333,
+     -2337,  -2339,  -2344,  -2345,  -2349,  -2351,  -2355,  -2356,  -2361,  -2364,
+     -2367,  -2371,  -2374,  -2379,  -2381,  -2385,  -2390,  -2392,  -2397,  -2400,
+     -2404,  -2409,  -2410,  -2415,  -2420,  -2422,  -2427,  -2431,  -2434,  -2439,
+     -2440,  -2445,  -2450,  -2453,  -2457,  -2460,  -2465,  -2471,  -2482,  -2490,
+     -2500,  -2509,  -2519,  -2528,  -2536,  -2545,  -2556,  -2565,  -2571,  -2573,
+     -2578,  -2579,  -2584,  -2586,  -2591,  -2592,  -2597,  -2600,  -2604,  -2607,
+     -2611,  -2615,  -2617,  -2621,  -2625,  -2628,  -2632,  -2636,  -2639,  -2643,
+     -2645,  -2651,  -2652,  -2658,  -2659,  -2664,  -2666,  -2671,  -2673,  -2678,
+     -2679,  -2685,  -2686,  -2692,  -2693,  -2697,  -2700,  -2704,  -2707,  -2710,
+     -2714,  -2717,  -2720,  -2722,  -2727,  -2729,  -2734,  -2736,  -2741,  -2742,
+     -2748,  -2749,  -2755,  -2756,  -2762,  -2763,  -2768,  -2771,  -2775,  -2778,
+     -2781,  -2785,  -2789,  -2792,  -2798,  -2804,  -2807,  -2813,  -2818,  -2821,
+     -2827,  -2833,  -2836,  -2842,  -2848,  -2851,  -2857,  -2863,  -2866,  -2872,
+     -2878,  -2881,  -2887,  -2893,  -2896,  -2903,  -2909,  -2912,  -2918,  -2921,
+     -2926,  -2930,  -2935,  -2941,  -2943,  -2949,  -2954,  -2959,  -2965,  -2966,
+     -2973,  -2978,  -2982,  -2989,  -2990,  -2997,  -3002,  -3007,  -3011,  -3015,
+     -3021,  -3024,  -3031,  -3036,  -3039,  -3046,  -3047,  -3054,  -3057,  -3064,
+     -3069,  -3072,  -3079,  -3081,  -3088,  -3091,  -3098,  -3103,  -3106,  -3113,
+     -3115,  -3122,  -3125,  -3130,  -3137,  -3141,  -3148,  -3149,  -3156,  -3160,
+     -3165,  -3172,  -3176,  -3181,  -3185,  -3192,  -3194,  -3201,  -3204,  -3210,
+     -3215,  -3221,  -3226,  -3230,  -3237,  -3239,  -3246,  -3248,  -3255,  -3259,
+     -3265,  -3270,  -3276,  -3281,  -3285,  -3293,  -3295,  -3302,  -3304,  -3312,
+     -3315,  -3323,  -3331,  -3335,  -3342,  -3350,  -3352,  -3360,  -3368,  -3372,
+     -3380,  -3388,  -3392,  -3400,  -3406,  -3412,  -3420,  -3426,  -3432,  -3440,
+     -3446,  -3452,  -3461,  -3465,  -3473,  -3481,  -3486,  -3494,  -3503,  -3507,
+     -3515,  -3524,  -3528,  -3537,  -3545,  -3550,  -3559,  -3567,  -3572,  -3581,
+     -3589,  -3596,  -3603,  -3612,  -3619,  -3625,  -3635,  -3641,  -3648,  -3658,
+     -3662,  -3669,  -3679,  -3683,  -3693,  -3697,  -3707,  -3714,  -3719,  -3729,
+     -3736,  -3743,  -3753,  -3755,  -3765,  -3773,  -3780,  -3790,  -3793,  -3803,
+     -3810,  -3818,  -3828,  -3833,  -3841,  -3851,  -3856,  -3869,  -3880,  -3888,
+     -3896,  -3907,  -3917,  -3923,  -3936,  -3947,  -3956,  -3964,  -3975,  -3986,
+     -3992,  -4006,  -4017,  -4026,  -4035,  -4046,  -4058,  -4064,  -4103,  -4136,
+     -4171,  -4209,  -4248,  -4285,  -4322,  -4518,  -4741,
+};
+
+#else  // ntc_lut.h coarse LUT
+// Step 16 counts, 257 knots, 514 bytes. Max error over
+// -40..125 C (ADC 152..4095): 0.072 C vs. the model,
+// 0.239 C vs. the float path (NTC_TABLE=0).
+constexpr uint8_t kNtcTableStepBits = 4;
+static const int16_t kNtcTable[257] = {
+    -27315,  24369,  20051,  17835,  16380,  15310,  14471,  13785,  13206,  12707,
+     12269,  11880,  11529,  11212,  10921,  10653,  10405,  10174,   9958,   9755,
+      9564,   9383,   9212,   9049,   8894,   8746,   8604,   8468,   8337,   8211,
+      8090,   7974,   7861,   7752,   7646,   7544,   7444,   7348,   7254,   7163,
+      7074,   6987,   6903,   6821,   6740,   6662,   6585,   6509,   6436,   6364,
+      6293,   6223,   6155,   6089,   6023,   5959,   5896,   5833,   5772,   5712,
+      5653,   5594,   5537,   5480,   5425,   5370,   5315,   5262,   5209,   5157,
+      5105,   5055,   5004,   4955,   4906,   4857,   4810,   4762,   4715,   4669,
+      4623,   4578,   4533,   4488,   4444,   4400,   4357,   4314,   4271,   4229,
+      4188,   4146,   4105,   4064,   4024,   3983,   3944,   3904,   3865,   3826,
+      3787,   3748,   3710,   3672,   3634,   3597,   3559,   3522,   3485,   3449,
+      3412,   3376,   3340,   3304,   3268,   3232,   3197,   3162,   3127,   3092,
+      3057,   3022,   2988,   2953,   2919,   2885,   2851,   2817,   2783,   2750,
+      2716,   2683,   2649,   2616,   2583,   2550,   2517,   2484,   2451,   2418,
+      2385,   2352,   2320,   2287,   2254,   2222,   2190,   2157,   2125,   2092,
+      2060,   2028,   1995,   1963,   1931,   1899,   1866,   1834,   1802,   1770,
+      1737,   1705,   1673,   1640,   1608,   1576,   1543,   1511,   1479,   1446,
+      1413,   1381,   1348,   1315,   1283,   1250,   1217,   1184,   1151,   1118,
+      1084,   1051,   1018,    984,    950,    917,    883,    849,    815,    780,
+       746,    711,    677,    642,    607,    571,    536,    500,    464,    428,
+       392,    356,    319,    282,    245,    208,    170,    132,     94,     55,
+        16,    -23,    -62,   -102,   -143,   -183,   -224,   -266,   -307,   -350,
+      -392,   -436,   -479,   -524,   -568,   -614,   -660,   -706,   -753,   -801,
+      -850,   -899,   -949,  -1000,  -1052,  -1105,  -1158,  -1213,  -1269,  -1326,
+     -1384,  -1443,  -1504,  -1566,  -1629,  -1695,  -1762,  -1831,  -1901,  -1975,
+     -2050,  -2128,  -2209,  -2293,  -2380,  -2471,  -2566,
+};
+#endif
+
+// No linearization: for eFuse-calibrated input (NTC_ADC_CAL)
+// Step 16 counts, 257 knots, 514 bytes. Max error over
+// -40..125 C (ADC 142..3995): 0.075 C vs. the model,
+// 0.075 C vs. the float path (NTC_TABLE=0).
+constexpr uint8_t kNtcTableCalStepBits = 4;
+static const int16_t kNtcTableCal[257] = {
+    -27315,  23935,  19684,  17501,  16065,  15010,  14181,  13503,  12931,  12438,
+     12005,  11619,  11273,  10958,  10670,  10405,  10159,   9930,   9716,   9515,
+      9325,   9146,   8976,   8814,   8660,   8512,   8371,   8236,   8106,   7981,
+      7861,   7745,   7632,   7524,   7418,   7316,   7217,   7121,   7028,   6937,
+      6848,   6761,   6677,   6595,   6514,   6436,   6359,   6284,   6210,   6138,
+      6067,   5997,   5929,   5862,   5797,   5732,   5668,   5606,   5545,   5484,
+      5425,   5366,   5308,   5251,   5195,   5140,   5085,   5031,   4978,   4925,
+      4874,   4822,   4772,   4722,   4672,   4623,   4575,   4527,   4479,   4432,
+      4386,   4340,   4294,   4249,   4204,   4160,   4116,   4072,   4029,   3986,
+      3944,   3901,   3859,   3818,   3776,   3735,   3695,   3654,   3614,   3574,
+      3535,   3495,   3456,   3417,   3378,   3340,   3301,   3263,   3225,   3188,
+      3150,   3113,   3075,   3038,   3002,   2965,   2928,   2892,   2856,   2819,
+      2783,   2747,   2712,   2676,   2640,   2605,   2569,   2534,   2499,   2464,
+      2429,   2394,   2359,   2324,   2289,   2254,   2220,   2185,   2151,   2116,
+      2082,   2047,   2013,   1978,   1944,   1909,   1875,   1841,   1806,   1772,
+      1737,   1703,   1668,   1634,   1600,   1565,   1530,   1496,   1461,   1426,
+      1392,   1357,   1322,   1287,   1252,   1217,   1182,   1146,   1111,   1076,
+      1040,   1004,    968,    932,    896,    860,    824,    787,    750,    714,
+       677,    639,    602,    564,    526,    488,    450,    412,    373,    334,
+       294,    255,    215,    175,    134,     94,     53,     11,    -31,    -73,
+      -116,   -159,   -202,   -246,   -291,   -336,   -381,   -427,   -473,   -521,
+      -568,   -617,   -666,   -716,   -766,   -817,   -869,   -922,   -976,  -1031,
+     -1087,  -1144,  -1202,  -1261,  -1322,  -1384,  -1447,  -1512,  -1578,  -1647,
+     -1717,  -1789,  -1863,  -1940,  -2020,  -2102,  -2187,  -2276,  -2368,  -2465,
+     -2566,  -2673,  -2785,  -2904,  -3031,  -3167,  -3314,  -3473,  -3648,  -3843,
+     -4064,  -4319,  -4623,  -5004,  -5521,  -6364, -27315,
+};
@@ -0,0 +1,175 @@
+#pragma once
+
+#include <stdint.h>
+
+// Battery sampling cadence and USB detection from the battery voltage trend.
+//
+// The battery is read on its own fixed cadence (BATTERY_SAMPLE_MS) instead
+// of on every loop or task tick; on the M5StickC each read is a PMIC
+// query. UsbTrendDetector works from the real time between samples, so its
+// time constants and thresholds mean the same thing at any cadence:
+//
+//   * the voltage is smoothed with time constant VBAT_TAU_MS;
+//   * its slope (mV/min, from the actual dt) is smoothed with
+//     VBAT_SLOPE_TAU_MS;
+//   * a slope above VBAT_T_CHARGE adds evidence for "charging" at twice
+//     the rate a slope below -VBAT_T_DISCHARGE adds evidence for
+//     "discharging"; no clear trend decays the evidence. The state changes
+//     once VBAT_SCORE_MAX seconds of evidence have accumulated.
+//
+// Voltages are kept in mV * 65536 and slopes in mV/min * 65536, so even
+// 10 ms steps of a 20 s low-pass do not stall in integer truncation.
+// scripts/usb_detect_replay.py compiles this header on the host and
+// replays charge/discharge traces through it.
+
+#ifndef BATTERY_SAMPLE_MS
+#define BATTERY_SAMPLE_MS 1000
+#endif
+// Voltage and slope smoothing time constants.
+#ifndef VBAT_TAU_MS
+#define VBAT_TAU_MS 20000
+#endif
+#ifndef VBAT_SLOPE_TAU_MS
+#define VBAT_SLOPE_TAU_MS 25000
+#endif
+// Samples further than this from the smoothed voltage add no evidence.
+#ifndef VBAT_SPIKE_MV
+#define VBAT_SPIKE_MV 30
+#endif
+// Slope thresholds (mV/min).
+#ifndef VBAT_T_CHARGE
+#define VBAT_T_CHARGE 8.0f
+#endif
+#ifndef VBAT_T_DISCHARGE
+#define VBAT_T_DISCHARGE 3.0f
+#endif
+// Seconds of consistent evidence needed to switch state.
+#ifndef VBAT_SCORE_MAX
+#define VBAT_SCORE_MAX 12
+#endif
+// Above this voltage a flat or rising trend keeps "charging" (the charger's
+// constant-voltage phase).
+#ifndef VBAT_FULL_MV
+#define VBAT_FULL_MV 4150
+#endif
+
+// Fixed cadence gate: due() is true once per BATTERY_SAMPLE_MS.
+class BatterySampler {
+ public:
+  bool due(uint32_t now_ms) {
+    if (primed_ && now_ms - next_ms_ >= 0x80000000u) {
+      return false;  // now_ms is before next_ms_
+    }
+    // Keep the cadence; after a stall (or the first call) restart from now.
+    next_ms_ = primed_ && now_ms - next_ms_ < BATTERY_SAMPLE_MS ? next_ms_ + BATTERY_SAMPLE_MS
+                                                                 : now_ms + BATTERY_SAMPLE_MS;
+    primed_ = true;
+    return true;
+  }
+
+  // Milliseconds until due() turns true (0 if it already is).
+  uint32_t ms_until_due(uint32_t now_ms) const {
+    const int32_t d = static_cast<int32_t>(next_ms_ - now_ms);
+    return primed_ && d > 0 ? static_cast<uint32_t>(d) : 0;
+  }
+
+ private:
+  uint32_t next_ms_ = 0;
+  bool primed_ = false;
+};
+
+class UsbTrendDetector {
+ public:
+  enum State : uint8_t { kUnknown = 0, kCharging = 1, kDischarging = 2 };
+
+  // Feed one battery reading; returns the current state.
+  State update(uint32_t now_ms, uint16_t batt_mv) {
+    const int32_t mv_q16 = int32_t(batt_mv) * kOne;
+    if (!primed_) {
+      primed_ = true;
+      vf_ = mv_q16;
+      last_ms_ = now_ms;
+      return state_;
+    }
+    uint32_t dt = now_ms - last_ms_;
+    last_ms_ = now_ms;
+    if (dt == 0) {
+      return state_;
+    }
+    if (dt > kMaxDtMs) {
+      dt = kMaxDtMs;  // After a long gap, one sample's worth of evidence at most
+    }
+
+    const int32_t dev = mv_q16 - vf_;
+    const bool spike = dev > VBAT_SPIKE_MV * kOne || dev < -VBAT_SPIKE_MV * kOne;
+
+    const int32_t vf_prev = vf_;
+    vf_ += ewma_step(dev, dt, VBAT_TAU_MS);
+    const int32_t slope = static_cast<int32_t>(int64_t(vf_ - vf_prev) * 60000 / int32_t(dt));
+    sf_ += ewma_step(slope - sf_, dt, VBAT_SLOPE_TAU_MS);
+
+    if (!spike) {
+      if (sf_ > kChargeQ16) {
+        score_ms_ += 2 * int32_t(dt);
+      } else if (sf_ < -kDischargeQ16) {
+        score_ms_ -= int32_t(dt);
+      } else if (score_ms_ > 0) {
+        score_ms_ = score_ms_ > int32_t(dt) ? score_ms_ - int32_t(dt) : 0;
+      } else if (score_ms_ < 0) {
+        score_ms_ = score_ms_ < -int32_t(dt) ? score_ms_ + int32_t(dt) : 0;
+      }
+      if (score_ms_ > kScoreMaxMs) {
+        score_ms_ = kScoreMaxMs;
+      } else if (score_ms_ < -kScoreMaxMs) {
+        score_ms_ = -kScoreMaxMs;
+      }
+    }
+
+    if (score_ms_ >= kScoreMaxMs) {
+      state_ = kCharging;
+    } else if (score_ms_ <= -kScoreMaxMs) {
+      state_ = kDischarging;
+    }
+    // A full battery on the charger is flat, which gives no trend evidence.
+    // This only keeps (or, from boot, decides) "charging": after an unplug
+    // at full charge the discharge is just as flat, and once the trend has
+    // decided "discharging" only new charge evidence may undo it.
+    if (state_ != kDischarging && vf_ > VBAT_FULL_MV * kOne && sf_ > -2 * kOne) {
+      state_ = kCharging;
+    }
+    return state_;
+  }
+
+  State state() const { return state_; }
+
+  // Carry the state into a new millis() time base (deep sleep restarts
+  // it): `old_now_ms` is the current time in the old base, `new_now_ms` in
+  // the new one.
+  void rebase(uint32_t old_now_ms, uint32_t new_now_ms) {
+    last_ms_ = new_now_ms - (old_now_ms - last_ms_);
+  }
+
+  // Smoothed voltage (mV) and slope (mV/min), for diagnostics.
+  int32_t filtered_mv() const { return (vf_ + kOne / 2) / kOne; }
+  int32_t slope_mv_per_min() const { return sf_ / kOne; }
+
+ private:
+  static constexpr int32_t kOne = 65536;  // 4200 mV still fits int32_t
+  static constexpr uint32_t kMaxDtMs = 60000;
+  static constexpr int32_t kChargeQ16 = static_cast<int32_t>(VBAT_T_CHARGE * 65536);
+  static constexpr int32_t kDischargeQ16 = static_cast<int32_t>(VBAT_T_DISCHARGE * 65536);
+  static constexpr int32_t kScoreMaxMs = int32_t(VBAT_SCORE_MAX) * 1000;
+
+  // First-order low-pass step towards an input `diff` away from the state:
+  // diff * dt / (tau + dt) (backward Euler, stable for any dt).
+  static int32_t ewma_step(int32_t diff, uint32_t dt, uint32_t tau) {
+    return static_cast<int32_t>(int64_t(diff) * int64_t(dt) / int64_t(tau + dt));
+  }
+
+  int32_t vf_ = 0;        // Smoothed voltage, mV * 65536
+  int32_t sf_ = 0;        // Smoothed slope, mV/min * 65536
+  int32_t score_ms_ = 0;  // + charging / - discharging evidence
+  uint32_t last_ms_ = 0;
+  State state_ = kUnknown;
+  bool primed_ = false;
+};
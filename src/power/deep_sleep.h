@@ -0,0 +1,146 @@
+#pragma once
+
+#include <Arduino.h>
+#include <stdint.h>
+#include <sys/time.h>
+#include <type_traits>
+#include <esp_attr.h>
+#include <esp_sleep.h>
+#include <esp_system.h>
+#include <driver/gpio.h>
+#include <driver/rtc_io.h>
+
+#include "power/battery_monitor.h"
+
+// Deep-sleep duty cycle (opt-in, DEEP_SLEEP_ENABLE=1).
+//
+// Instead of staying awake between SLOW advertisements, the device
+// advertises for ADV_BURST_MS at DEEP_SLEEP_ADV_MS and then deep sleeps until
+// the next SLOW interval. Each timer wake takes a short path through setup()
+// that skips the rest of the boot: read the sensors, send one burst, sleep
+// again. The state that has to outlive the reset (counters, USB detector,
+// FAST window) is kept in RTC slow memory, and wakes are scheduled on the
+// RTC-backed system clock so the cadence does not drift with boot time.
+//
+// Power-on, FAST windows, USB power and DEV mode keep the normal continuous
+// mode; the duty cycle resumes once the device is back in SLOW mode on
+// battery. With an RTC-capable IMU_WOM_INT_PIN, motion wakes the chip (ext0)
+// into continuous FAST mode.
+//
+// The M5StickC Plus2 wakes unreliably from deep sleep
+// (docs/power-management-implementation.md), so this is meant for boards
+// where it works, such as the esp32s3 environment.
+
+#ifndef DEEP_SLEEP_ENABLE
+#define DEEP_SLEEP_ENABLE 0
+#endif
+// Advertising interval inside a wake burst: a few PDUs per ADV_BURST_MS.
+#ifndef DEEP_SLEEP_ADV_MS
+#define DEEP_SLEEP_ADV_MS 100
+#endif
+// Shortest sleep worth the reboot; a late cycle sleeps at least this long.
+#ifndef DEEP_SLEEP_MIN_MS
+#define DEEP_SLEEP_MIN_MS 1000
+#endif
+
+enum DeepSleepWake : uint8_t {
+  kDeepSleepWakeNone = 0,  // Power-on or reset: nothing retained
+  kDeepSleepWakeTimer = 1,
+  kDeepSleepWakeMotion = 2,
+};
+
+// Wake-to-first-advertisement latency: from the moment the wake timer
+// fired (ROM boot and bootloader included) to the first burst advertisement.
+struct DeepSleepLatency {
+  uint32_t last_us;
+  uint32_t min_us;
+  uint32_t max_us;
+  uint32_t app_ms;  // Part of last_us spent after the app started (millis())
+  uint64_t sum_us;
+  uint32_t count;
+};
+
+struct RtcRetained {
+  uint32_t magic;
+  uint32_t wakes;              // Timer and motion wakes since power-on
+  uint16_t seq;                // gMeasurementSeq
+  uint8_t movement;            // gMovementCounter
+  bool usb_state;
+  uint32_t fast_remaining_ms;  // Rest of the FAST window when going to sleep
+  uint32_t saved_ms;           // millis() when saved
+  int64_t saved_us;            // deep_sleep_clock_us() when saved
+  int64_t wake_due_us;         // When the wake timer was set to fire
+  UsbTrendDetector usb;
+  DeepSleepLatency latency;
+};
+
+static_assert(std::is_trivially_copyable<UsbTrendDetector>::value,
+              "UsbTrendDetector is kept in RTC memory by plain copy");
+
+constexpr uint32_t kRtcRetainedMagic = 0x52545631;  // "RTV1"
+
+// Loaded on power-on only; a deep-sleep wake keeps the contents.
+static RTC_DATA_ATTR RtcRetained gRtcRetained;
+
+// System time in microseconds. Backed by the RTC timer, so it keeps
+// counting through deep sleep (unlike millis() and esp_timer).
+inline int64_t deep_sleep_clock_us() {
+  struct timeval tv;
+  gettimeofday(&tv, nullptr);
+  return int64_t(tv.tv_sec) * 1000000 + tv.tv_usec;
+}
+
+// Why this boot happened. Retained state is only trusted after a
+// deep-sleep reset with the magic intact.
+inline DeepSleepWake deep_sleep_wake_cause() {
+#if DEEP_SLEEP_ENABLE
+  if (esp_reset_reason() != ESP_RST_DEEPSLEEP || gRtcRetained.magic != kRtcRetainedMagic) {
+    return kDeepSleepWakeNone;
+  }
+  return esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_EXT0 ? kDeepSleepWakeMotion
+                                                                : kDeepSleepWakeTimer;
+#else
+  return kDeepSleepWakeNone;
+#endif
+}
+
+// Call when the first burst advertisement has started.
+inline void deep_sleep_note_first_adv() {
+  DeepSleepLatency &l = gRtcRetained.latency;
+  const int64_t d = deep_sleep_clock_us() - gRtcRetained.wake_due_us;
+  l.last_us = d > 0 ? static_cast<uint32_t>(d) : 0;
+  l.app_ms = millis();
+  l.min_us = l.count == 0 || l.last_us < l.min_us ? l.last_us : l.min_us;
+  l.max_us = l.last_us > l.max_us ? l.last_us : l.max_us;
+  l.sum_us += l.last_us;
+  ++l.count;
+}
+
+// Next wake on the cycle grid: one period after the last scheduled wake,
+// or a period from now when coming from continuous mode or running late.
+inline int64_t deep_sleep_next_wake_us(bool timer_wake, uint32_t period_ms) {
+  const int64_t now_us = deep_sleep_clock_us();
+  const int64_t period_us = int64_t(period_ms) * 1000;
+  int64_t next_us = timer_wake ? gRtcRetained.wake_due_us + period_us : now_us + period_us;
+  if (next_us - now_us < int64_t(DEEP_SLEEP_MIN_MS) * 1000) {
+    next_us = now_us + period_us;
+  }
+  return next_us;
+}
+
+// Sleep until `wake_at_us` (deep_sleep_clock_us() time), or until the IMU
+// raises `wake_pin` (active high; -1 or a non-RTC pin for none). Does not
+// return.
+inline void deep_sleep_start(int64_t wake_at_us, int wake_pin) {
+  int64_t sleep_us = wake_at_us - deep_sleep_clock_us();
+  if (sleep_us < int64_t(DEEP_SLEEP_MIN_MS) * 1000) {
+    sleep_us = int64_t(DEEP_SLEEP_MIN_MS) * 1000;
+  }
+  gRtcRetained.wake_due_us = deep_sleep_clock_us() + sleep_us;
+  gRtcRetained.magic = kRtcRetainedMagic;
+  esp_sleep_enable_timer_wakeup(static_cast<uint64_t>(sleep_us));
+  if (wake_pin >= 0 && rtc_gpio_is_valid_gpio(static_cast<gpio_num_t>(wake_pin))) {
+    esp_sleep_enable_ext0_wakeup(static_cast<gpio_num_t>(wake_pin), 1);
+  }
+  esp_deep_sleep_start();
+}
@@ -0,0 +1,362 @@
+#pragma once
+
+#include <Arduino.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <esp_freertos_hooks.h>
+#include <esp_idf_version.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <sdkconfig.h>
+
+// CPU load and wakeup monitor, per status window and per operating mode.
+//
+// Three sources:
+//
+//   * core wakeups: an idle hook on each core counts how often the idle
+//     task gets back to WAITI, i.e. once after every interrupt or task run
+//     that woke the core. Without tickless idle the FreeRTOS tick alone
+//     gives CONFIG_FREERTOS_HZ per core; light sleep and tickless idle are
+//     what bring it down;
+//   * loop() and the sensor task report each pass and its busy time (wall
+//     time from wake to block, preemption included);
+//   * with CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS and the trace facility,
+//     the FreeRTOS run-time counters: load per core (everything but the
+//     idle task) and the busiest tasks, BLE host and controller included.
+//     The prebuilt Arduino core has them off; the report then has only our
+//     two tasks' busy time, a lower bound for the load.
+//
+// load_monitor_mode() closes the period so far into the mode it ran in
+// when the mode changes; load_monitor_take_window() closes it at a status
+// line. The counters are 32-bit and compared as differences, so some
+// period must be closed at least every 71 minutes (microsecond busy time
+// and run-time counters wrap).
+
+#ifndef LOAD_MONITOR
+#define LOAD_MONITOR 1
+#endif
+// Add CPU load and core wakeups as a line on the debug LCD.
+#ifndef LOAD_MONITOR_LCD
+#define LOAD_MONITOR_LCD 0
+#endif
+
+#if defined(CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS) && defined(CONFIG_FREERTOS_USE_TRACE_FACILITY)
+#define LOAD_RUNTIME_STATS 1
+#else
+#define LOAD_RUNTIME_STATS 0
+#endif
+
+enum LoadTask : uint8_t {
+  kLoadTaskLoop = 0,
+  kLoadTaskSensors = 1,
+  kLoadTasks = 2,
+};
+
+enum LoadMode : uint8_t {
+  kLoadModeDev = 0,
+  kLoadModeFast = 1,
+  kLoadModeSlow = 2,
+  kLoadModes = 3,
+};
+
+constexpr uint8_t kLoadCores = portNUM_PROCESSORS;
+constexpr uint8_t kLoadTopTasks = 3;  // Busiest tasks listed per window
+
+struct LoadTotals {
+  uint64_t us;  // Wall time
+  uint64_t core_wakes[kLoadCores];
+  uint64_t task_passes[kLoadTasks];
+  uint64_t task_busy_us[kLoadTasks];
+  uint64_t idle_rt[kLoadCores];  // Idle task run time (run-time stats only)
+  uint64_t total_rt;             // Run-time counter span (0 without)
+};
+
+struct LoadTop {
+  char name[configMAX_TASK_NAME_LEN];
+  uint32_t rt;
+};
+
+static volatile uint32_t gLoadIdleHooks[kLoadCores] = {};
+static portMUX_TYPE gLoadMux = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t gLoadPasses[kLoadTasks] = {};
+static uint32_t gLoadBusyUs[kLoadTasks] = {};
+
+// Values at the end of the last closed period.
+static uint32_t gLoadLastUs = 0;
+static uint32_t gLoadLastHooks[kLoadCores] = {};
+static uint32_t gLoadLastPasses[kLoadTasks] = {};
+static uint32_t gLoadLastBusyUs[kLoadTasks] = {};
+
+static uint8_t gLoadMode = kLoadModes;  // None yet
+static LoadTotals gLoadWindow = {};
+static LoadTotals gLoadModeTotals[kLoadModes] = {};
+static LoadTop gLoadTop[kLoadTopTasks] = {};  // Busiest tasks of the last closed window
+
+#if LOAD_RUNTIME_STATS
+constexpr UBaseType_t kLoadMaxTasks = 24;
+struct LoadTaskRt {
+  TaskHandle_t handle;
+  uint32_t rt;
+};
+static TaskStatus_t gLoadStatus[kLoadMaxTasks];
+static LoadTaskRt gLoadLastRt[kLoadMaxTasks] = {};
+static UBaseType_t gLoadLastRtCount = 0;
+static uint32_t gLoadLastTotalRt = 0;
+static LoadTaskRt gLoadWindowRt[kLoadMaxTasks] = {};  // Counters at the start of the window
+static UBaseType_t gLoadWindowRtCount = 0;
+#endif
+
+template <uint8_t kCore>
+bool load_idle_hook() {
+  gLoadIdleHooks[kCore] = gLoadIdleHooks[kCore] + 1;  // Only this core writes it
+  return true;                                         // WAITI as usual
+}
+
+// Register the idle hooks; call once from setup().
+inline bool load_monitor_begin() {
+#if LOAD_MONITOR
+  gLoadLastUs = static_cast<uint32_t>(esp_timer_get_time());
+  bool ok = esp_register_freertos_idle_hook_for_cpu(load_idle_hook<0>, 0) == ESP_OK;
+#if portNUM_PROCESSORS > 1
+  ok = esp_register_freertos_idle_hook_for_cpu(load_idle_hook<1>, 1) == ESP_OK && ok;
+#endif
+  return ok;
+#else
+  return false;
+#endif
+}
+
+// From loop() and the sensor task, once per pass.
+inline void load_task_pass(LoadTask task, uint32_t busy_us) {
+#if LOAD_MONITOR
+  portENTER_CRITICAL(&gLoadMux);
+  ++gLoadPasses[task];
+  gLoadBusyUs[task] += busy_us;
+  portEXIT_CRITICAL(&gLoadMux);
+#else
+  (void)task;
+  (void)busy_us;
+#endif
+}
+
+#if LOAD_RUNTIME_STATS
+inline TaskHandle_t load_idle_task(uint8_t core) {
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 1, 0)
+  return xTaskGetIdleTaskHandleForCore(core);
+#else
+  return xTaskGetIdleTaskHandleForCPU(core);
+#endif
+}
+
+inline bool load_is_idle_task(TaskHandle_t handle) {
+  for (uint8_t c = 0; c < kLoadCores; ++c) {
+    if (handle == load_idle_task(c)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Run-time counter differences since the last period: idle time per core
+// into `t`.
+inline void load_sample_runtime(LoadTotals &t) {
+  uint32_t total_rt = 0;
+  const UBaseType_t n = uxTaskGetSystemState(gLoadStatus, kLoadMaxTasks, &total_rt);
+  if (n == 0) {
+    return;  // More tasks than kLoadMaxTasks
+  }
+  t.total_rt += total_rt - gLoadLastTotalRt;
+  for (UBaseType_t i = 0; i < n; ++i) {
+    const TaskStatus_t &s = gLoadStatus[i];
+    uint32_t rt = s.ulRunTimeCounter;
+    for (UBaseType_t j = 0; j < gLoadLastRtCount; ++j) {
+      if (gLoadLastRt[j].handle == s.xHandle) {
+        rt -= gLoadLastRt[j].rt;
+        break;
+      }
+    }
+    for (uint8_t c = 0; c < kLoadCores; ++c) {
+      if (s.xHandle == load_idle_task(c)) {
+        t.idle_rt[c] += rt;
+      }
+    }
+  }
+  for (UBaseType_t i = 0; i < n; ++i) {
+    gLoadLastRt[i].handle = gLoadStatus[i].xHandle;
+    gLoadLastRt[i].rt = gLoadStatus[i].ulRunTimeCounter;
+  }
+  gLoadLastRtCount = n;
+  gLoadLastTotalRt = total_rt;
+}
+
+// Rank the busiest non-idle tasks over the whole window into gLoadTop,
+// from the counters load_sample_runtime() read last, so mode changes
+// inside the window do not split a task's run time. Starts the next
+// window from the same counters.
+inline void load_rank_window() {
+  for (uint8_t k = 0; k < kLoadTopTasks; ++k) {
+    gLoadTop[k] = LoadTop();
+  }
+  for (UBaseType_t i = 0; i < gLoadLastRtCount; ++i) {
+    const TaskStatus_t &s = gLoadStatus[i];
+    if (load_is_idle_task(s.xHandle)) {
+      continue;
+    }
+    uint32_t rt = s.ulRunTimeCounter;
+    for (UBaseType_t j = 0; j < gLoadWindowRtCount; ++j) {
+      if (gLoadWindowRt[j].handle == s.xHandle) {
+        rt -= gLoadWindowRt[j].rt;
+        break;
+      }
+    }
+    for (uint8_t k = 0; k < kLoadTopTasks; ++k) {
+      if (rt > gLoadTop[k].rt) {
+        for (uint8_t m = kLoadTopTasks - 1; m > k; --m) {
+          gLoadTop[m] = gLoadTop[m - 1];
+        }
+        gLoadTop[k].rt = rt;
+        strncpy(gLoadTop[k].name, s.pcTaskName, sizeof(gLoadTop[k].name) - 1);
+        gLoadTop[k].name[sizeof(gLoadTop[k].name) - 1] = '\0';
+        break;
+      }
+    }
+  }
+  memcpy(gLoadWindowRt, gLoadLastRt, sizeof(gLoadWindowRt));
+  gLoadWindowRtCount = gLoadLastRtCount;
+}
+#endif
+
+inline void load_add(LoadTotals &to, const LoadTotals &d) {
+  to.us += d.us;
+  for (uint8_t c = 0; c < kLoadCores; ++c) {
+    to.core_wakes[c] += d.core_wakes[c];
+    to.idle_rt[c] += d.idle_rt[c];
+  }
+  for (uint8_t i = 0; i < kLoadTasks; ++i) {
+    to.task_passes[i] += d.task_passes[i];
+    to.task_busy_us[i] += d.task_busy_us[i];
+  }
+  to.total_rt += d.total_rt;
+}
+
+// Close the period since the last call into the current mode and window.
+inline void load_monitor_close() {
+#if LOAD_MONITOR
+  LoadTotals d = {};
+  const uint32_t now_us = static_cast<uint32_t>(esp_timer_get_time());
+  d.us = now_us - gLoadLastUs;
+  gLoadLastUs = now_us;
+  for (uint8_t c = 0; c < kLoadCores; ++c) {
+    const uint32_t hooks = gLoadIdleHooks[c];
+    d.core_wakes[c] = hooks - gLoadLastHooks[c];
+    gLoadLastHooks[c] = hooks;
+  }
+  portENTER_CRITICAL(&gLoadMux);
+  for (uint8_t i = 0; i < kLoadTasks; ++i) {
+    d.task_passes[i] = gLoadPasses[i] - gLoadLastPasses[i];
+    d.task_busy_us[i] = gLoadBusyUs[i] - gLoadLastBusyUs[i];
+    gLoadLastPasses[i] = gLoadPasses[i];
+    gLoadLastBusyUs[i] = gLoadBusyUs[i];
+  }
+  portEXIT_CRITICAL(&gLoadMux);
+#if LOAD_RUNTIME_STATS
+  load_sample_runtime(d);
+#endif
+  load_add(gLoadWindow, d);
+  if (gLoadMode < kLoadModes) {
+    load_add(gLoadModeTotals[gLoadMode], d);
+  }
+#endif
+}
+
+// Call on every loop() pass with the mode it runs in.
+inline void load_monitor_mode(LoadMode mode) {
+#if LOAD_MONITOR
+  if (mode != gLoadMode) {
+    load_monitor_close();
+    gLoadMode = mode;
+  }
+#else
+  (void)mode;
+#endif
+}
+
+// Totals since the last call (the status window); starts the next window.
+inline LoadTotals load_monitor_take_window() {
+  load_monitor_close();
+#if LOAD_MONITOR && LOAD_RUNTIME_STATS
+  load_rank_window();
+#endif
+  const LoadTotals w = gLoadWindow;
+  gLoadWindow = LoadTotals();
+  return w;
+}
+
+inline const LoadTotals &load_monitor_mode_totals(LoadMode mode) {
+  return gLoadModeTotals[mode];
+}
+
+// Core load in permille, or -1 without run-time stats.
+inline int32_t load_core_permille(const LoadTotals &t, uint8_t core) {
+  if (t.total_rt == 0) {
+    return -1;
+  }
+  const uint64_t idle = t.idle_rt[core] < t.total_rt ? t.idle_rt[core] : t.total_rt;
+  return static_cast<int32_t>(1000 - idle * 1000 / t.total_rt);
+}
+
+inline uint32_t load_busy_permille(const LoadTotals &t, LoadTask task) {
+  return t.us ? static_cast<uint32_t>(t.task_busy_us[task] * 1000 / t.us) : 0;
+}
+
+// Core wakeups per second, all cores.
+inline uint32_t load_core_wakes_per_s(const LoadTotals &t) {
+  uint64_t wakes = 0;
+  for (uint8_t c = 0; c < kLoadCores; ++c) {
+    wakes += t.core_wakes[c];
+  }
+  return t.us ? static_cast<uint32_t>(wakes * 1000000 / t.us) : 0;
+}
+
+// "core0=3.1% core1=0.8% wake/s=1003+1001 loop=0.4%/1.0/s sensors=0.9%/2.0/s"
+inline int load_format(char *buf, size_t len, const LoadTotals &t) {
+  int n = 0;
+  for (uint8_t c = 0; c < kLoadCores && n >= 0 && size_t(n) < len; ++c) {
+    const int32_t pm = load_core_permille(t, c);
+    n += pm < 0 ? snprintf(buf + n, len - n, "core%u=n/a ", c)
+                : snprintf(buf + n, len - n, "core%u=%ld.%ld%% ", c, static_cast<long>(pm / 10),
+                           static_cast<long>(pm % 10));
+  }
+  for (uint8_t c = 0; c < kLoadCores && n >= 0 && size_t(n) < len; ++c) {
+    n += snprintf(buf + n, len - n, c == 0 ? "wake/s=%lu" : "+%lu",
+                  static_cast<unsigned long>(t.us ? t.core_wakes[c] * 1000000 / t.us : 0));
+  }
+  static const char *const kNames[kLoadTasks] = {"loop", "sensors"};
+  for (uint8_t i = 0; i < kLoadTasks && n >= 0 && size_t(n) < len; ++i) {
+    const uint32_t pm = load_busy_permille(t, static_cast<LoadTask>(i));
+    const uint32_t passes_10 = t.us ? static_cast<uint32_t>(t.task_passes[i] * 10000000 / t.us) : 0;
+    n += snprintf(buf + n, len - n, " %s=%lu.%lu%%/%lu.%lu/s", kNames[i],
+                  static_cast<unsigned long>(pm / 10), static_cast<unsigned long>(pm % 10),
+                  static_cast<unsigned long>(passes_10 / 10), static_cast<unsigned long>(passes_10 % 10));
+  }
+  return n;
+}
+
+// Busiest non-idle tasks of the window that load_monitor_take_window()
+// just closed, as "name:pct ..." of the window's run time (empty without
+// run-time stats).
+inline int load_format_top(char *buf, size_t len, const LoadTotals &t) {
+  int n = 0;
+  buf[0] = '\0';
+  for (uint8_t k = 0; k < kLoadTopTasks && t.total_rt > 0 && n >= 0 && size_t(n) < len; ++k) {
+    if (gLoadTop[k].rt == 0) {
+      break;
+    }
+    const uint32_t pm = static_cast<uint32_t>(uint64_t(gLoadTop[k].rt) * 1000 / t.total_rt);
+    n += snprintf(buf + n, len - n, "%s%s:%lu.%lu%%", k ? " " : "", gLoadTop[k].name,
+                  static_cast<unsigned long>(pm / 10), static_cast<unsigned long>(pm % 10));
+  }
+  return n;
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <Arduino.h>
+#include <stdint.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <sdkconfig.h>
+
+#if defined(CONFIG_PM_ENABLE)
+#include <esp_pm.h>
+#endif
+
+// Power management locks for dynamic frequency scaling.
+//
+// With DFS on (power/power_mgmt.h) the CPU idles at PM_MIN_FREQ_MHZ and
+// only runs faster while something holds a lock:
+//
+//   * kPmLockBus (ESP_PM_APB_FREQ_MAX): APB at 80 MHz, for peripheral work
+//     whose clock comes from APB: I2C transactions, ADC reads, LCD SPI;
+//   * kPmLockCpu (ESP_PM_CPU_FREQ_MAX): CPU at PM_MAX_FREQ_MHZ, for short
+//     CPU-bound bursts (advertising update, LCD rendering).
+//
+// Drivers take them through the PmLock scope guard:
+//
+//   { PmLock bus(kPmLockBus); ...I2C transaction... }
+//
+// Locks nest and may be held from any task. Without CONFIG_PM_ENABLE (or
+// before power_mgmt_begin()) PmLock only does the residency accounting.
+//
+// Residency: time is split by the level our own locks ask for (CPU lock ->
+// max, bus lock -> APB max, none -> min). Locks held inside the BLE
+// controller, Wi-Fi or the continuous ADC driver are not visible here, so
+// the max/APB figures are a lower bound and "min" includes light sleep. For
+// exact per-mode figures build with CONFIG_PM_PROFILING; the status line
+// then also prints esp_pm_dump_locks().
+
+enum PmLockKind : uint8_t {
+  kPmLockBus = 0,
+  kPmLockCpu = 1,
+  kPmLockKinds = 2,
+};
+
+// Frequency levels for the residency report, slowest first.
+enum PmLevel : uint8_t {
+  kPmLevelMin = 0,
+  kPmLevelApb = 1,
+  kPmLevelMax = 2,
+  kPmLevels = 3,
+};
+
+struct PmResidency {
+  uint64_t us[kPmLevels];  // Time at each level since the last report
+  uint32_t acquires;       // Outermost lock acquisitions
+};
+
+static portMUX_TYPE gPmLockMux = portMUX_INITIALIZER_UNLOCKED;
+#if defined(CONFIG_PM_ENABLE)
+static esp_pm_lock_handle_t gPmLocks[kPmLockKinds] = {};
+#endif
+static uint16_t gPmLockDepth[kPmLockKinds] = {};
+static uint8_t gPmLevel = kPmLevelMin;
+static int64_t gPmLevelSinceUs = 0;
+static uint64_t gPmLevelUs[kPmLevels] = {};
+static uint32_t gPmLockAcquires = 0;
+
+// Create the IDF lock handles; called by power_mgmt_begin() once DFS is on.
+inline bool pm_lock_init() {
+#if defined(CONFIG_PM_ENABLE)
+  return esp_pm_lock_create(ESP_PM_APB_FREQ_MAX, 0, "bus", &gPmLocks[kPmLockBus]) == ESP_OK &&
+         esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "cpu", &gPmLocks[kPmLockCpu]) == ESP_OK;
+#else
+  return false;
+#endif
+}
+
+// Close the current level's time and switch to the one the depths ask for.
+// Called with gPmLockMux held.
+inline void pm_level_update_locked(int64_t now_us) {
+  if (gPmLevelSinceUs != 0) {
+    gPmLevelUs[gPmLevel] += static_cast<uint64_t>(now_us - gPmLevelSinceUs);
+  }
+  gPmLevelSinceUs = now_us;
+  gPmLevel = gPmLockDepth[kPmLockCpu] ? kPmLevelMax : (gPmLockDepth[kPmLockBus] ? kPmLevelApb : kPmLevelMin);
+}
+
+inline void pm_lock_acquire(PmLockKind kind) {
+  portENTER_CRITICAL(&gPmLockMux);
+  if (gPmLockDepth[kind]++ == 0) {
+    ++gPmLockAcquires;
+    pm_level_update_locked(esp_timer_get_time());
+  }
+  portEXIT_CRITICAL(&gPmLockMux);
+#if defined(CONFIG_PM_ENABLE)
+  if (gPmLocks[kind] != nullptr) {
+    esp_pm_lock_acquire(gPmLocks[kind]);
+  }
+#endif
+}
+
+inline void pm_lock_release(PmLockKind kind) {
+#if defined(CONFIG_PM_ENABLE)
+  if (gPmLocks[kind] != nullptr) {
+    esp_pm_lock_release(gPmLocks[kind]);
+  }
+#endif
+  portENTER_CRITICAL(&gPmLockMux);
+  if (gPmLockDepth[kind] > 0 && --gPmLockDepth[kind] == 0) {
+    pm_level_update_locked(esp_timer_get_time());
+  }
+  portEXIT_CRITICAL(&gPmLockMux);
+}
+
+// Residency since the previous call; restarts the accounting window.
+inline PmResidency pm_residency_take() {
+  PmResidency r;
+  portENTER_CRITICAL(&gPmLockMux);
+  pm_level_update_locked(esp_timer_get_time());
+  for (uint8_t i = 0; i < kPmLevels; ++i) {
+    r.us[i] = gPmLevelUs[i];
+    gPmLevelUs[i] = 0;
+  }
+  r.acquires = gPmLockAcquires;
+  gPmLockAcquires = 0;
+  portEXIT_CRITICAL(&gPmLockMux);
+  return r;
+}
+
+class PmLock {
+ public:
+  explicit PmLock(PmLockKind kind) : kind_(kind) { pm_lock_acquire(kind_); }
+  ~PmLock() { pm_lock_release(kind_); }
+  PmLock(const PmLock &) = delete;
+  PmLock &operator=(const PmLock &) = delete;
+
+ private:
+  PmLockKind kind_;
+};
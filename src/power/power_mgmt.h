@@ -0,0 +1,160 @@
+#pragma once
+
+#include <Arduino.h>
+#include <stdint.h>
+#include <esp_idf_version.h>
+#include <esp_sleep.h>
+#include <driver/gpio.h>
+#include <sdkconfig.h>
+
+#include "power/pm_lock.h"
+
+// Dynamic frequency scaling and automatic light sleep through the ESP-IDF
+// power management framework.
+//
+// DFS (needs CONFIG_PM_ENABLE): the CPU runs at PM_MIN_FREQ_MHZ whenever no
+// PM lock is held and at up to PM_MAX_FREQ_MHZ while one is (see
+// power/pm_lock.h for which work takes which lock). The BLE controller
+// holds its own lock while the radio is active.
+//
+// Light sleep: with every task blocked until its next deadline (see loop() and the
+// sensor task), FreeRTOS tickless idle stops the tick and esp_pm puts the
+// chip in light sleep until the next timer or interrupt. That needs a
+// build with CONFIG_PM_ENABLE and CONFIG_FREERTOS_USE_TICKLESS_IDLE, and a
+// BLE controller that keeps its timing on a low-power clock while the chip
+// sleeps:
+//
+//   * ESP32-S3/C3: modem sleep with the main crystal powered in light
+//     sleep, or an external 32 kHz crystal;
+//   * classic ESP32 (M5StickC Plus2): only with an external 32 kHz crystal.
+//
+// Otherwise light sleep would stall advertising, so it stays off and the
+// blocked tasks just let the idle task halt the CPU between ticks.
+
+#ifndef ENABLE_LIGHT_SLEEP
+#define ENABLE_LIGHT_SLEEP 1  // Used only when the build supports it (below)
+#endif
+#ifndef ENABLE_DFS
+#define ENABLE_DFS 1  // Used only with CONFIG_PM_ENABLE
+#endif
+// CPU frequency while PM locks are held (and the fixed frequency without DFS).
+#ifndef PM_MAX_FREQ_MHZ
+#define PM_MAX_FREQ_MHZ 80
+#endif
+// Idle CPU frequency: the crystal (40 MHz) or an integer fraction of it.
+// Below 40 MHz the APB clock drops too and the serial console garbles.
+#ifndef PM_MIN_FREQ_MHZ
+#define PM_MIN_FREQ_MHZ 40
+#endif
+
+static_assert(PM_MIN_FREQ_MHZ <= PM_MAX_FREQ_MHZ, "PM_MIN_FREQ_MHZ must not exceed PM_MAX_FREQ_MHZ");
+
+#if defined(CONFIG_PM_ENABLE) && defined(CONFIG_FREERTOS_USE_TICKLESS_IDLE)
+#define PM_TICKLESS_SUPPORTED 1
+#else
+#define PM_TICKLESS_SUPPORTED 0
+#endif
+
+#if defined(CONFIG_BT_CTRL_MODEM_SLEEP_MODE_1) && \
+    (defined(CONFIG_BT_CTRL_MAIN_XTAL_PU_DURING_LIGHT_SLEEP) || defined(CONFIG_BT_CTRL_LPCLK_SEL_EXT_32K_XTAL))
+#define PM_BLE_LOW_POWER_CLOCK 1
+#elif defined(CONFIG_BTDM_CTRL_MODEM_SLEEP_MODE_ORIG) && defined(CONFIG_BTDM_CTRL_LPCLK_SEL_EXT_32K_XTAL)
+#define PM_BLE_LOW_POWER_CLOCK 1
+#else
+#define PM_BLE_LOW_POWER_CLOCK 0
+#endif
+
+#define PM_LIGHT_SLEEP (ENABLE_LIGHT_SLEEP && PM_TICKLESS_SUPPORTED && PM_BLE_LOW_POWER_CLOCK)
+
+#if defined(CONFIG_PM_ENABLE)
+#define PM_DFS (ENABLE_DFS && PM_MIN_FREQ_MHZ < PM_MAX_FREQ_MHZ)
+#else
+#define PM_DFS 0
+#endif
+
+static bool gPmLightSleep = false;
+static bool gPmDfs = false;
+static char gPmStatus[96] = "off";
+
+// Enable DFS and automatic light sleep as far as the build allows; call
+// once after the BLE stack is up (board_init() has set PM_MAX_FREQ_MHZ).
+inline bool power_mgmt_begin() {
+  pm_residency_take();  // Start the first residency window
+#if PM_DFS || PM_LIGHT_SLEEP
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+  esp_pm_config_t cfg = {};
+#elif defined(CONFIG_IDF_TARGET_ESP32S3)
+  esp_pm_config_esp32s3_t cfg = {};
+#elif defined(CONFIG_IDF_TARGET_ESP32C3)
+  esp_pm_config_esp32c3_t cfg = {};
+#else
+  esp_pm_config_esp32_t cfg = {};
+#endif
+  // The locks must exist before the frequency may drop: drivers rely on
+  // them to keep APB at 80 MHz during transfers.
+  const bool dfs = PM_DFS && pm_lock_init();
+  cfg.max_freq_mhz = PM_MAX_FREQ_MHZ;
+  cfg.min_freq_mhz = dfs ? PM_MIN_FREQ_MHZ : PM_MAX_FREQ_MHZ;
+  cfg.light_sleep_enable = PM_LIGHT_SLEEP;
+  if (esp_pm_configure(&cfg) != ESP_OK) {
+    snprintf(gPmStatus, sizeof(gPmStatus), "esp_pm_configure failed, fixed %d MHz", getCpuFrequencyMhz());
+    return false;
+  }
+  gPmDfs = dfs;
+  gPmLightSleep = PM_LIGHT_SLEEP;
+#endif
+  const char *sleep = "automatic light sleep";
+  if (!gPmLightSleep) {
+    if (!ENABLE_LIGHT_SLEEP) {
+      sleep = "light sleep disabled";
+    } else if (!PM_TICKLESS_SUPPORTED) {
+      sleep = "no light sleep (needs CONFIG_PM_ENABLE + tickless idle)";
+    } else {
+      sleep = "no light sleep (BLE controller has no low-power clock)";
+    }
+  }
+  if (gPmDfs) {
+    snprintf(gPmStatus, sizeof(gPmStatus), "DFS %d-%d MHz, %s", PM_MIN_FREQ_MHZ, PM_MAX_FREQ_MHZ, sleep);
+  } else {
+    const char *why = "";
+    if (PM_DFS) {
+      why = " (PM lock creation failed)";
+    } else if (ENABLE_DFS && PM_MIN_FREQ_MHZ < PM_MAX_FREQ_MHZ) {
+      why = " (DFS needs CONFIG_PM_ENABLE)";
+    }
+    snprintf(gPmStatus, sizeof(gPmStatus), "fixed %d MHz%s, %s", getCpuFrequencyMhz(), why, sleep);
+  }
+  return gPmDfs || gPmLightSleep;
+}
+
+inline bool power_mgmt_dfs() {
+  return gPmDfs;
+}
+
+inline bool power_mgmt_light_sleep() {
+  return gPmLightSleep;
+}
+
+inline const char *power_mgmt_status() {
+  return gPmStatus;
+}
+
+// GPIO interrupts do not wake the chip from light sleep by themselves; a
+// level-triggered wakeup does. For latched lines (held until serviced).
+inline void power_mgmt_wake_on_gpio(int pin, bool active_high) {
+#if PM_LIGHT_SLEEP
+  gpio_wakeup_enable(static_cast<gpio_num_t>(pin), active_high ? GPIO_INTR_HIGH_LEVEL : GPIO_INTR_LOW_LEVEL);
+  esp_sleep_enable_gpio_wakeup();
+#else
+  (void)pin;
+  (void)active_high;
+#endif
+}
+
+// Per-mode residency and lock statistics from the IDF (CONFIG_PM_PROFILING
+// builds only; a no-op otherwise).
+inline void power_mgmt_dump_profile() {
+#if defined(CONFIG_PM_PROFILING)
+  esp_pm_dump_locks(stdout);
+#endif
+}
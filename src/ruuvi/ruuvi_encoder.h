@@ -0,0 +1,212 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#include "sensors/sensor_interface.h"
+
+// Ruuvi payload encoders.
+//
+// Each data format is a policy struct with a fixed size and a straight-line
+// write() that fills every byte at a constant offset. The active format is
+// picked at compile time (RUUVI_DATA_FORMAT), so there is no runtime format
+// dispatch on the advertising path:
+//
+//   0x03  DF3 / RAWv1     14 bytes, legacy gateways (no sequence, no MAC)
+//   0x05  DF5 / RAWv2     24 bytes, default
+//   0xC5  Cut-RAWv2       12 bytes, DF5 without acceleration and MAC
+//   0xE1  Extended v1     40 bytes, needs BLE 5 extended advertising
+//
+// MAC bytes (where the format has them) never change, so they are written
+// once via ruuvi_write_mac() instead of on every frame.
+
+#define RUUVI_FORMAT_DF3 0x03
+#define RUUVI_FORMAT_DF5 0x05
+#define RUUVI_FORMAT_C5 0xC5
+#define RUUVI_FORMAT_E1 0xE1
+
+#ifndef RUUVI_DATA_FORMAT
+#define RUUVI_DATA_FORMAT RUUVI_FORMAT_DF5
+#endif
+
+// Per-frame values that are not part of SensorSample.
+struct RuuviCounters {
+  uint8_t movement;
+  uint32_t sequence;
+};
+
+// Saturating clamp written as min/max so it compiles to MIN/MAX on Xtensa.
+inline int32_t ruuvi_clamp(int32_t v, int32_t lo, int32_t hi) {
+  return v < lo ? lo : (v > hi ? hi : v);
+}
+
+inline void ruuvi_be16(uint8_t *buf, size_t offset, int32_t val) {
+  buf[offset] = (val >> 8) & 0xFF;
+  buf[offset + 1] = val & 0xFF;
+}
+
+inline void ruuvi_be24(uint8_t *buf, size_t offset, uint32_t val) {
+  buf[offset] = (val >> 16) & 0xFF;
+  buf[offset + 1] = (val >> 8) & 0xFF;
+  buf[offset + 2] = val & 0xFF;
+}
+
+// Sample fields are already DF5-native (humidity) or an exact multiple of the
+// DF5 step (temperature, pressure), so encoding is integer-only.
+inline uint16_t ruuvi_encode_humidity(uint16_t humidity_df5) {
+  return humidity_df5;
+}
+
+inline int16_t ruuvi_encode_temperature(int16_t cdeg) {
+  // 0.01 C -> 0.005 C steps; INT16_MIN is reserved for "not available".
+  return static_cast<int16_t>(ruuvi_clamp(int32_t(cdeg) * 2, INT16_MIN + 1, INT16_MAX));
+}
+
+inline uint16_t ruuvi_encode_pressure(uint32_t pa) {
+  const int32_t raw = static_cast<int32_t>(pa > 0x7FFFFFFF ? 0x7FFFFFFF : pa) - 50000;
+  // 0xFFFF is reserved for "not available".
+  return static_cast<uint16_t>(ruuvi_clamp(raw, 0, 0xFFFE));
+}
+
+// DF5/C5/E1 "not available" values, sent for fields whose kSensorCap bit is
+// not set in the sample. DF3 has no such values and sends the raw fields.
+constexpr int16_t kRuuviNaTemperature = INT16_MIN;  // 0x8000
+constexpr uint16_t kRuuviNaHumidity = 0xFFFF;
+constexpr uint16_t kRuuviNaPressure = 0xFFFF;
+constexpr int16_t kRuuviNaAccel = INT16_MIN;  // 0x8000
+
+inline int16_t ruuvi_field_temperature(const SensorSample &s) {
+  return (s.caps & kSensorCapTemperature) ? ruuvi_encode_temperature(s.temperature_cdeg)
+                                          : kRuuviNaTemperature;
+}
+
+inline uint16_t ruuvi_field_humidity(const SensorSample &s) {
+  return (s.caps & kSensorCapHumidity) ? ruuvi_encode_humidity(s.humidity_df5) : kRuuviNaHumidity;
+}
+
+inline uint16_t ruuvi_field_pressure(const SensorSample &s) {
+  return (s.caps & kSensorCapPressure) ? ruuvi_encode_pressure(s.pressure_pa) : kRuuviNaPressure;
+}
+
+inline int16_t ruuvi_field_accel(const SensorSample &s, int16_t mg) {
+  return (s.caps & kSensorCapAccel) ? static_cast<int16_t>(ruuvi_clamp(mg, INT16_MIN + 1, INT16_MAX))
+                                    : kRuuviNaAccel;
+}
+
+// DF5 power info: 11 bits battery (mV - 1600), 5 bits TX power ((dBm + 40) / 2).
+// All ones in either field is "not available", so both clamp one below.
+inline uint16_t ruuvi_encode_power(uint16_t battery_mv, int8_t tx_dbm) {
+  const int32_t batt_bits = ruuvi_clamp(int32_t(battery_mv) - 1600, 0, 0x7FE);
+  const int32_t tx_bits = ruuvi_clamp((tx_dbm + 40) / 2, 0, 0x1E);
+  return static_cast<uint16_t>((batt_bits << 5) | tx_bits);
+}
+
+struct RuuviFormatDf3 {
+  static constexpr uint8_t kId = RUUVI_FORMAT_DF3;
+  static constexpr uint8_t kLen = 14;
+  static constexpr bool kHasMac = false;
+  static constexpr uint8_t kMacOffset = 0;
+
+  static void write(uint8_t *out, const SensorSample &s, const RuuviCounters &) {
+    out[0] = kId;
+    // Humidity in 0.5 %RH steps.
+    out[1] = static_cast<uint8_t>(ruuvi_clamp((int32_t(s.humidity_df5) + 100) / 200, 0, 0xFF));
+    // Temperature as sign + magnitude: integer degrees (bit 7 = sign), then hundredths.
+    const int32_t t = s.temperature_cdeg;
+    const int32_t mag = ruuvi_clamp(t < 0 ? -t : t, 0, 12799);
+    out[2] = static_cast<uint8_t>((mag / 100) | (t < 0 ? 0x80 : 0x00));
+    out[3] = static_cast<uint8_t>(mag % 100);
+    ruuvi_be16(out, 4, ruuvi_encode_pressure(s.pressure_pa));
+    ruuvi_be16(out, 6, s.accel_x_mg);
+    ruuvi_be16(out, 8, s.accel_y_mg);
+    ruuvi_be16(out, 10, s.accel_z_mg);
+    ruuvi_be16(out, 12, s.battery_mv);
+  }
+};
+
+struct RuuviFormatDf5 {
+  static constexpr uint8_t kId = RUUVI_FORMAT_DF5;
+  static constexpr uint8_t kLen = 24;
+  static constexpr bool kHasMac = true;
+  static constexpr uint8_t kMacOffset = 18;
+
+  static void write(uint8_t *out, const SensorSample &s, const RuuviCounters &c) {
+    out[0] = kId;
+    ruuvi_be16(out, 1, ruuvi_field_temperature(s));
+    ruuvi_be16(out, 3, ruuvi_field_humidity(s));
+    ruuvi_be16(out, 5, ruuvi_field_pressure(s));
+    // Accel X/Y/Z in milli-g.
+    ruuvi_be16(out, 7, ruuvi_field_accel(s, s.accel_x_mg));
+    ruuvi_be16(out, 9, ruuvi_field_accel(s, s.accel_y_mg));
+    ruuvi_be16(out, 11, ruuvi_field_accel(s, s.accel_z_mg));
+    ruuvi_be16(out, 13, ruuvi_encode_power(s.battery_mv, s.tx_power_dbm));
+    out[15] = c.movement;
+    ruuvi_be16(out, 16, c.sequence & 0xFFFF);
+  }
+};
+
+struct RuuviFormatC5 {
+  static constexpr uint8_t kId = RUUVI_FORMAT_C5;
+  static constexpr uint8_t kLen = 12;
+  static constexpr bool kHasMac = false;
+  static constexpr uint8_t kMacOffset = 0;
+
+  static void write(uint8_t *out, const SensorSample &s, const RuuviCounters &c) {
+    out[0] = kId;
+    ruuvi_be16(out, 1, ruuvi_field_temperature(s));
+    ruuvi_be16(out, 3, ruuvi_field_humidity(s));
+    ruuvi_be16(out, 5, ruuvi_field_pressure(s));
+    ruuvi_be16(out, 7, ruuvi_encode_power(s.battery_mv, s.tx_power_dbm));
+    out[9] = c.movement;
+    ruuvi_be16(out, 10, c.sequence & 0xFFFF);
+  }
+};
+
+struct RuuviFormatE1 {
+  static constexpr uint8_t kId = RUUVI_FORMAT_E1;
+  static constexpr uint8_t kLen = 40;
+  static constexpr bool kHasMac = true;
+  static constexpr uint8_t kMacOffset = 34;
+
+  static void write(uint8_t *out, const SensorSample &s, const RuuviCounters &c) {
+    out[0] = kId;
+    ruuvi_be16(out, 1, ruuvi_field_temperature(s));
+    ruuvi_be16(out, 3, ruuvi_field_humidity(s));
+    ruuvi_be16(out, 5, ruuvi_field_pressure(s));
+    // PM1.0/2.5/4.0/10, CO2, VOC/NOx index and luminosity: no such sensors,
+    // so every byte carries the "not available" value.
+    memset(out + 7, 0xFF, 15);
+    // 22-24 reserved.
+    memset(out + 22, 0xFF, 3);
+    ruuvi_be24(out, 25, c.sequence & 0xFFFFFF);
+    // Flags: bit 7/6 are the NOx/VOC index LSBs (all ones = not available).
+    out[28] = 0xC0;
+    // 29-33 reserved.
+    memset(out + 29, 0xFF, 5);
+  }
+};
+
+#if RUUVI_DATA_FORMAT == RUUVI_FORMAT_DF3
+using RuuviFormat = RuuviFormatDf3;
+#elif RUUVI_DATA_FORMAT == RUUVI_FORMAT_DF5
+using RuuviFormat = RuuviFormatDf5;
+#elif RUUVI_DATA_FORMAT == RUUVI_FORMAT_C5
+using RuuviFormat = RuuviFormatC5;
+#elif RUUVI_DATA_FORMAT == RUUVI_FORMAT_E1
+using RuuviFormat = RuuviFormatE1;
+#else
+#error "Unsupported RUUVI_DATA_FORMAT (use 0x03, 0x05, 0xC5 or 0xE1)"
+#endif
+
+template <typename Format>
+inline void ruuvi_encode(uint8_t *out, const SensorSample &s, const RuuviCounters &c) {
+  Format::write(out, s, c);
+}
+
+// mac is big-endian (as printed, as seen over the air).
+template <typename Format>
+inline void ruuvi_write_mac(uint8_t *out, const uint8_t *mac) {
+  if (Format::kHasMac) {
+    memcpy(out + Format::kMacOffset, mac, 6);
+  }
+}
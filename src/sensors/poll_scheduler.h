@@ -0,0 +1,153 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "sensor_interface.h"
+
+// Change-driven environmental polling.
+//
+// While readings are stable the poll interval doubles after every poll, up
+// to SENSOR_POLL_MAX_INTERVAL_MS. It is also capped at the time the latest
+// rate of change needs to move any field by its budget, so a slow drift
+// keeps the interval short enough that the drift stays within one budget.
+// The interval snaps back to the base interval (the mode's normal poll
+// interval) as soon as a field changed by more than its budget since the
+// last poll, or deviates by more than its budget from where the previous
+// rate of change predicted it (noise, or a change in trend), and when the
+// base interval shrinks (mode switch, setBase()).
+//
+// due() is only asked on base ticks (sensorTask(), or loop() without the
+// task), so the interval is always a whole number of base intervals, rounded
+// down: neither the cap nor a drift limit is overshot by a partial tick.
+//
+// The budgets bound slow drift, not steps: a step that lands inside a
+// stretched interval (a door opening) is reported only at the next poll,
+// up to SENSOR_POLL_MAX_INTERVAL_MS late (rounded down to whole base
+// intervals, never below one), with its full size as the error.
+//
+// scripts/poll_trace_replay.py compiles this header, replays recorded or
+// synthetic traces through it on the sensor task's base ticks and compares
+// it with fixed polling.
+
+// 0 = poll at the base interval (fixed schedule)
+#ifndef SENSOR_POLL_ADAPTIVE
+#define SENSOR_POLL_ADAPTIVE 1
+#endif
+// Longest stretch between polls, rounded down to whole base intervals;
+// bounds how late a step change is seen.
+#ifndef SENSOR_POLL_MAX_INTERVAL_MS
+#define SENSOR_POLL_MAX_INTERVAL_MS 20000
+#endif
+// Per-field change budgets (SensorSample units).
+#ifndef SENSOR_POLL_BUDGET_CDEG
+#define SENSOR_POLL_BUDGET_CDEG 10  // 0.10 °C
+#endif
+#ifndef SENSOR_POLL_BUDGET_HUMIDITY
+#define SENSOR_POLL_BUDGET_HUMIDITY 200  // 0.5 %RH
+#endif
+#ifndef SENSOR_POLL_BUDGET_PA
+#define SENSOR_POLL_BUDGET_PA 20  // 0.2 hPa
+#endif
+
+template <uint8_t N>
+class AdaptivePollScheduler {
+ public:
+  // The mode's base interval, on every pass before due(). A shorter base
+  // than before drops the stretched interval, so the next poll is at most
+  // one new base interval after the last; a longer one keeps it, in whole
+  // ticks of the new base.
+  void setBase(uint32_t base_ms) {
+    if (base_ms < base_ms_) {
+      interval_ = base_ms;
+    } else if (base_ms > base_ms_) {
+      interval_ = whole_ticks(interval_, base_ms);
+    }
+    base_ms_ = base_ms;
+  }
+
+  // True when the environmental sensors should be polled again. Asked on
+  // base ticks: rounds to the nearest tick, so loop jitter or a split-phase
+  // collect that lands after its tick does not cost one more tick.
+  bool due(uint32_t now_ms, uint32_t base_ms) const {
+    const uint32_t wait_ms = interval_ > base_ms ? interval_ : base_ms;
+    return !primed_ || now_ms - last_ms_ + base_ms / 2 >= wait_ms;
+  }
+
+  // Feed the samples of one poll (channels 0..N-1); returns the interval
+  // until the next one.
+  uint32_t update(const SensorSample *samples, uint32_t now_ms, uint32_t base_ms) {
+    const uint32_t dt = now_ms - last_ms_;
+    uint32_t worst = 0;     // Largest change, 256 = one budget
+    uint32_t residual = 0;  // Largest deviation from the predicted change
+    for (uint8_t ch = 0; ch < N; ++ch) {
+      const SensorSample &s = samples[ch];
+      const int32_t value[kFields] = {s.temperature_cdeg, s.humidity_df5,
+                                      static_cast<int32_t>(s.pressure_pa)};
+      const uint8_t caps[kFields] = {kSensorCapTemperature, kSensorCapHumidity,
+                                     kSensorCapPressure};
+      for (uint8_t f = 0; f < kFields; ++f) {
+        if (!(s.caps & caps[f])) {
+          continue;
+        }
+        const int32_t delta = value[f] - last_[ch][f];
+        const int32_t predicted =
+            last_dt_ ? static_cast<int32_t>(int64_t(last_delta_[ch][f]) * dt / last_dt_) : 0;
+        worst = max_u32(worst, scaled(delta, kBudget[f]));
+        residual = max_u32(residual, scaled(delta - predicted, kBudget[f]));
+        last_[ch][f] = value[f];
+        last_delta_[ch][f] = delta;
+      }
+    }
+
+    if (!SENSOR_POLL_ADAPTIVE || !primed_ || worst > 256 || residual > 256) {
+      interval_ = base_ms;
+      last_dt_ = primed_ ? dt : 0;
+    } else {
+      uint32_t next = (interval_ > base_ms ? interval_ : base_ms) * 2;
+      if (worst > 0) {
+        // Time until the current rate of change uses up one budget.
+        const uint64_t limit = uint64_t(dt) * 256 / worst;
+        if (limit < next) {
+          next = static_cast<uint32_t>(limit);
+        }
+      }
+      if (next > SENSOR_POLL_MAX_INTERVAL_MS) {
+        next = SENSOR_POLL_MAX_INTERVAL_MS;
+      }
+      next = whole_ticks(next, base_ms);
+      interval_ = next > base_ms ? next : base_ms;
+      last_dt_ = dt;
+    }
+    primed_ = true;
+    last_ms_ = now_ms;
+    return interval_;
+  }
+
+  uint32_t interval() const { return interval_; }
+
+ private:
+  static constexpr uint8_t kFields = 3;  // Temperature, humidity, pressure
+  static constexpr int32_t kBudget[kFields] = {
+      SENSOR_POLL_BUDGET_CDEG, SENSOR_POLL_BUDGET_HUMIDITY, SENSOR_POLL_BUDGET_PA};
+
+  static uint32_t scaled(int32_t delta, int32_t budget) {
+    const uint32_t mag = static_cast<uint32_t>(delta < 0 ? -delta : delta);
+    return static_cast<uint32_t>(uint64_t(mag) * 256 / budget);
+  }
+  static uint32_t max_u32(uint32_t a, uint32_t b) { return a > b ? a : b; }
+  // ms rounded down to whole base intervals (0 if shorter than one).
+  static uint32_t whole_ticks(uint32_t ms, uint32_t base_ms) {
+    return base_ms ? ms / base_ms * base_ms : ms;
+  }
+
+  int32_t last_[N][kFields] = {};
+  int32_t last_delta_[N][kFields] = {};
+  uint32_t last_ms_ = 0;
+  uint32_t last_dt_ = 0;  // Interval of last_delta_ (0 = no trend yet)
+  uint32_t interval_ = 0;
+  uint32_t base_ms_ = 0;
+  bool primed_ = false;
+};
+
+template <uint8_t N>
+constexpr int32_t AdaptivePollScheduler<N>::kBudget[];
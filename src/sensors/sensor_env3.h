@@ -1,12 +1,10 @@
 #pragma once
 
 #include "sensor_interface.h"
+#include <Arduino.h>
 #include <Wire.h>
 #include "M5UnitENV.h"
-
-static SHT3X gSht3x;
-static QMP6988 gQmp6988;
-static bool gEnv3Ready = false;
+#include "power/pm_lock.h"
 
 #ifndef I2C_SDA_PIN
 #define I2C_SDA_PIN 32
@@ -15,38 +13,228 @@ static bool gEnv3Ready = false;
 #define I2C_SCL_PIN 33
 #endif
 
-inline bool sensor_init() {
+// Maximum number of ENV III units on the bus (one channel each). The SHT30
+// and QMP6988 each have two addresses, so at most two units can share a bus;
+// units are paired in address order (QMP6988 0x70/0x56, SHT30 0x44/0x45).
+#ifndef ENV3_UNITS
+#define ENV3_UNITS 2
+#endif
+static_assert(ENV3_UNITS >= 1 && ENV3_UNITS <= 2, "ENV3_UNITS must be 1 or 2");
+
+constexpr uint8_t kEnv3SensorId = 2;
+constexpr uint8_t kEnv3ChannelCount = ENV3_UNITS;
+constexpr uint8_t kSht30AddrAlt = 0x45;
+
+static SHT3X gSht3x[ENV3_UNITS];
+static QMP6988 gQmp6988[ENV3_UNITS];
+static bool gEnv3Ready[ENV3_UNITS] = {};
+static uint8_t gEnv3ShtAddr[ENV3_UNITS] = {};
+static bool gEnv3Pending[ENV3_UNITS] = {};        // SHT30 conversion started by env3_sensor_trigger()
+static uint32_t gEnv3TriggerMs[ENV3_UNITS] = {};
+static uint8_t gEnv3Topo[1 + ENV3_UNITS] = {};     // Topology of a deferred begin
+static uint8_t gEnv3Begun = 0;                     // Units brought up so far
+
+// Split-phase SHT30 access. The library's update() sends a clock-stretching
+// measurement and then waits for the result, stalling the caller. Here the
+// single-shot command (high repeatability, no clock stretching) is sent by
+// env3_sensor_trigger() and the result read by env3_sensor_read() once the conversion
+// time has passed. The QMP6988 runs in normal mode (continuous conversion),
+// so its latest result is simply read at collect time.
+constexpr uint8_t kSht30CmdSingleShotHighMsb = 0x24;
+constexpr uint8_t kSht30CmdSingleShotHighLsb = 0x00;
+constexpr uint32_t kSht30ConversionMs = 16;  // Datasheet max 15.5 ms at high repeatability
+
+// Every bus access below runs under the bus PM lock (power/pm_lock.h); the
+// SHT30 conversion wait in between runs without it.
+
+inline uint8_t sht30_crc8(const uint8_t *data, size_t len) {
+  uint8_t crc = 0xFF;
+  for (size_t i = 0; i < len; ++i) {
+    crc ^= data[i];
+    for (uint8_t bit = 0; bit < 8; ++bit) {
+      crc = (crc & 0x80) ? static_cast<uint8_t>((crc << 1) ^ 0x31) : static_cast<uint8_t>(crc << 1);
+    }
+  }
+  return crc;
+}
+
+inline bool sht30_start(uint8_t addr) {
+  Wire.beginTransmission(addr);
+  Wire.write(kSht30CmdSingleShotHighMsb);
+  Wire.write(kSht30CmdSingleShotHighLsb);
+  return Wire.endTransmission() == 0;
+}
+
+// Read a finished single-shot result; integer conversion straight to
+// SensorSample units.
+inline bool sht30_fetch(uint8_t addr, int16_t &cdeg, uint16_t &humidity_df5) {
+  uint8_t d[6];
+  if (Wire.requestFrom(addr, static_cast<uint8_t>(6)) != 6) {
+    return false;
+  }
+  for (size_t i = 0; i < 6; ++i) {
+    d[i] = static_cast<uint8_t>(Wire.read());
+  }
+  if (sht30_crc8(d, 2) != d[2] || sht30_crc8(d + 3, 2) != d[5]) {
+    return false;
+  }
+  const uint32_t raw_t = (uint32_t(d[0]) << 8) | d[1];
+  const uint32_t raw_h = (uint32_t(d[3]) << 8) | d[4];
+  // T = -45 + 175 * raw / 65535 [C], RH = 100 * raw / 65535 [%].
+  cdeg = static_cast<int16_t>(-4500 + static_cast<int32_t>((17500u * raw_t + 32767u) / 65535u));
+  humidity_df5 = static_cast<uint16_t>((uint32_t(kHumidityDf5Full) * raw_h + 32767u) / 65535u);
+  return true;
+}
+
+inline bool env3_begin_unit(uint8_t unit, uint8_t qmp_addr, uint8_t sht_addr) {
+  const bool qmp_ok = gQmp6988[unit].begin(&Wire, qmp_addr, I2C_SDA_PIN, I2C_SCL_PIN, 400000U);
+  const bool sht_ok = gSht3x[unit].begin(&Wire, sht_addr, I2C_SDA_PIN, I2C_SCL_PIN, 400000U);
+  gEnv3ShtAddr[unit] = sht_addr;
+  gEnv3Ready[unit] = qmp_ok && sht_ok;
+  return gEnv3Ready[unit];
+}
+
+inline void env3_bus_begin() {
   Wire.begin(I2C_SDA_PIN, I2C_SCL_PIN);
   Wire.setClock(400000);
+}
 
-  bool qmp_ok = gQmp6988.begin(&Wire, QMP6988_SLAVE_ADDRESS_L, I2C_SDA_PIN, I2C_SCL_PIN, 400000U);
-  if (!qmp_ok) {
-    qmp_ok = gQmp6988.begin(&Wire, QMP6988_SLAVE_ADDRESS_H, I2C_SDA_PIN, I2C_SCL_PIN, 400000U);
+inline bool env3_ack(uint8_t addr) {
+  Wire.beginTransmission(addr);
+  return Wire.endTransmission() == 0;
+}
+
+// Topology: topo[0] = unit count, topo[1 + unit] = bit 0 QMP6988 at the
+// high address, bit 1 SHT30 at the alternate address.
+inline bool env3_begin_units(const uint8_t *topo, uint8_t from, uint8_t to) {
+  for (uint8_t i = from; i < to; ++i) {
+    const uint8_t qmp = (topo[1 + i] & 0x01) ? QMP6988_SLAVE_ADDRESS_H : QMP6988_SLAVE_ADDRESS_L;
+    const uint8_t sht = (topo[1 + i] & 0x02) ? kSht30AddrAlt : SHT3X_I2C_ADDR;
+    if (!env3_begin_unit(i, qmp, sht)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// With `defer` only the first unit is brought up; env3_sensor_finish()
+// does the others (their channels read as "not available" until then).
+inline uint8_t env3_sensor_begin(const uint8_t *topo, bool defer) {
+  const uint8_t units = topo[0];
+  if (units == 0 || units > ENV3_UNITS) {
+    return 0;
+  }
+  PmLock bus(kPmLockBus);
+  env3_bus_begin();
+  const uint8_t now = defer ? 1 : units;
+  if (!env3_begin_units(topo, 0, now)) {
+    return 0;
+  }
+  memcpy(gEnv3Topo, topo, 1 + units);
+  gEnv3Begun = now;
+  return units;
+}
+
+inline bool env3_sensor_finish() {
+  PmLock bus(kPmLockBus);
+  if (!env3_begin_units(gEnv3Topo, gEnv3Begun, gEnv3Topo[0])) {
+    return false;
+  }
+  gEnv3Begun = gEnv3Topo[0];
+  return true;
+}
+
+// Address-only scan of both chips' addresses; units are formed from the
+// QMP6988s and SHT30s found, in address order.
+inline uint8_t env3_sensor_probe(uint8_t *topo) {
+  PmLock bus(kPmLockBus);
+  env3_bus_begin();
+  uint8_t qmp_bits[2];
+  uint8_t sht_bits[2];
+  uint8_t n_qmp = 0;
+  uint8_t n_sht = 0;
+  if (env3_ack(QMP6988_SLAVE_ADDRESS_L)) {
+    qmp_bits[n_qmp++] = 0x00;
+  }
+  if (env3_ack(QMP6988_SLAVE_ADDRESS_H)) {
+    qmp_bits[n_qmp++] = 0x01;
+  }
+  if (env3_ack(SHT3X_I2C_ADDR)) {
+    sht_bits[n_sht++] = 0x00;
+  }
+  if (env3_ack(kSht30AddrAlt)) {
+    sht_bits[n_sht++] = 0x02;
+  }
+  uint8_t units = n_qmp < n_sht ? n_qmp : n_sht;
+  if (units > ENV3_UNITS) {
+    units = ENV3_UNITS;
   }
-  bool sht_ok = gSht3x.begin(&Wire, SHT3X_I2C_ADDR, I2C_SDA_PIN, I2C_SCL_PIN, 400000U);
-  if (!sht_ok) {
-    sht_ok = gSht3x.begin(&Wire, 0x45, I2C_SDA_PIN, I2C_SCL_PIN, 400000U);
+  topo[0] = units;
+  for (uint8_t i = 0; i < units; ++i) {
+    topo[1 + i] = qmp_bits[i] | sht_bits[i];
   }
-  gEnv3Ready = qmp_ok && sht_ok;
-  return gEnv3Ready;
+  return units == 0 ? 0 : env3_sensor_begin(topo, false);
 }
 
-inline SensorSample sensor_read() {
+// Start a measurement on `channel`; returns the ms until env3_sensor_read() can
+// collect it without waiting.
+inline uint32_t env3_sensor_trigger(uint8_t channel) {
+  PmLock bus(kPmLockBus);
+  gEnv3Pending[channel] = gEnv3Ready[channel] && sht30_start(gEnv3ShtAddr[channel]);
+  gEnv3TriggerMs[channel] = millis();
+  return gEnv3Pending[channel] ? kSht30ConversionMs : 0;
+}
+
+// Collects a triggered measurement, or measures synchronously through the
+// library when nothing was triggered. caps stays 0 if the unit did not answer.
+inline SensorSample env3_sensor_read(uint8_t channel) {
   SensorSample s{
-      .temperature_c = 0.0f,
-      .humidity_rh = 0.0f,
-      .pressure_hpa = 1013.25f,
+      .temperature_cdeg = 0,
+      .humidity_df5 = 0,
+      .pressure_pa = kPressurePaStandard,
       .battery_mv = 0,
       .tx_power_dbm = 0,
       .accel_x_mg = 0,
       .accel_y_mg = 0,
       .accel_z_mg = 0,
+      .caps = 0,
   };
 
-  if (gEnv3Ready && gSht3x.update() && gQmp6988.update()) {
-    s.temperature_c = gSht3x.cTemp;
-    s.humidity_rh = gSht3x.humidity;
-    s.pressure_hpa = gQmp6988.pressure / 100.0f; // Pa -> hPa
+  if (gEnv3Pending[channel]) {
+    gEnv3Pending[channel] = false;
+    const uint32_t elapsed = millis() - gEnv3TriggerMs[channel];
+    if (elapsed < kSht30ConversionMs) {
+      delay(kSht30ConversionMs - elapsed);  // Collected early; only the remainder blocks.
+    }
+    PmLock bus(kPmLockBus);
+    int16_t cdeg = 0;
+    uint16_t humidity = 0;
+    if (sht30_fetch(gEnv3ShtAddr[channel], cdeg, humidity) && gQmp6988[channel].update()) {
+      s.temperature_cdeg = cdeg;
+      s.humidity_df5 = humidity;
+      s.pressure_pa = sensor_pressure_pa_from_pa(gQmp6988[channel].pressure);
+      s.caps = kSensorCapEnvironment;
+    }
+    return s;
+  }
+
+  PmLock bus(kPmLockBus);  // The library's update() also waits for the conversion
+  if (gEnv3Ready[channel] && gSht3x[channel].update() && gQmp6988[channel].update()) {
+    s.temperature_cdeg = sensor_cdeg_from_c(gSht3x[channel].cTemp);
+    s.humidity_df5 = sensor_humidity_df5_from_rh(gSht3x[channel].humidity);
+    s.pressure_pa = sensor_pressure_pa_from_pa(gQmp6988[channel].pressure);
+    s.caps = kSensorCapEnvironment;
   }
   return s;
 }
+
+constexpr SensorDriver kEnv3SensorDriver = {
+    kEnv3SensorId,
+    "env3",
+    kSensorCapEnvironment,
+    env3_sensor_probe,
+    env3_sensor_begin,
+    env3_sensor_finish,
+    env3_sensor_trigger,
+    env3_sensor_read,
+};
@@ -3,22 +3,52 @@
 #include "sensor_interface.h"
 #include <Arduino.h>
 
-inline bool sensor_init() {
-  return true;
+// Number of fake channels (one per virtual tag); each channel is offset by
+// +1 C / +1 %RH so the streams are distinguishable.
+#ifndef FAKE_SENSOR_CHANNELS
+#define FAKE_SENSOR_CHANNELS 1
+#endif
+
+constexpr uint8_t kFakeSensorId = 0;
+constexpr uint8_t kFakeChannelCount = FAKE_SENSOR_CHANNELS;
+
+inline uint8_t fake_sensor_begin(const uint8_t *, bool) {
+  return kFakeChannelCount;
+}
+
+inline uint8_t fake_sensor_probe(uint8_t *topo) {
+  topo[0] = kFakeChannelCount;
+  return kFakeChannelCount;
 }
 
-inline SensorSample sensor_read() {
-  const float base = 22.0f;
-  float delta = (millis() / 1000 % 6) * 0.5f; // 0..2.5
+// Synchronous driver: nothing to start ahead of fake_sensor_read().
+inline uint32_t fake_sensor_trigger(uint8_t) {
+  return 0;
+}
+
+inline SensorSample fake_sensor_read(uint8_t channel) {
+  const uint16_t step = millis() / 1000 % 6; // 0..5 -> +0..2.5
   SensorSample s{
-      .temperature_c = base + delta,
-      .humidity_rh = 45.0f + delta,
-      .pressure_hpa = 1013.25f,
+      .temperature_cdeg = static_cast<int16_t>(2200 + step * 50 + channel * 100),
+      .humidity_df5 = static_cast<uint16_t>(18000 + step * 200 + channel * 400),
+      .pressure_pa = kPressurePaStandard,
       .battery_mv = 0,
       .tx_power_dbm = 0,
       .accel_x_mg = 0,
       .accel_y_mg = 0,
       .accel_z_mg = 0,
+      .caps = kSensorCapEnvironment,
   };
   return s;
 }
+
+constexpr SensorDriver kFakeSensorDriver = {
+    kFakeSensorId,
+    "fake",
+    kSensorCapEnvironment,
+    fake_sensor_probe,
+    fake_sensor_begin,
+    nullptr,
+    fake_sensor_trigger,
+    fake_sensor_read,
+};
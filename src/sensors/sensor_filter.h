@@ -0,0 +1,133 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "sensor_interface.h"
+
+// Streaming filter for environmental sensor samples.
+//
+// Every field of every channel passes a short running median, which drops
+// single-poll spikes inside the valid range (NTC ADC noise, SHT30
+// transients), then a first-order IIR smoother. Both run in integers on a
+// fixed ring buffer; nothing is allocated. A change that survives the
+// median and exceeds the field's step threshold restarts the smoother at
+// the new value, so a real step (a door opening) reaches the air one poll
+// later instead of trailing the IIR for several polls.
+//
+// scripts/sensor_filter_bench.py compiles this header on the host, times
+// it and compares noise rejection on recorded or synthetic traces.
+
+// 0 = send readings unfiltered
+#ifndef SENSOR_FILTER_ENABLE
+#define SENSOR_FILTER_ENABLE 1
+#endif
+// Median window in polls (odd, 1..7; 1 = no median).
+#ifndef SENSOR_FILTER_MEDIAN
+#define SENSOR_FILTER_MEDIAN 3
+#endif
+// IIR weight of a new sample: 1 / 2^shift (0 = no smoothing).
+#ifndef SENSOR_FILTER_IIR_SHIFT
+#define SENSOR_FILTER_IIR_SHIFT 1
+#endif
+// Step thresholds (SensorSample units) above which the smoother restarts.
+#ifndef SENSOR_FILTER_STEP_CDEG
+#define SENSOR_FILTER_STEP_CDEG 50  // 0.50 °C
+#endif
+#ifndef SENSOR_FILTER_STEP_HUMIDITY
+#define SENSOR_FILTER_STEP_HUMIDITY 800  // 2 %RH
+#endif
+#ifndef SENSOR_FILTER_STEP_PA
+#define SENSOR_FILTER_STEP_PA 100  // 1 hPa
+#endif
+
+// Median of the last W inputs followed by an IIR with weight 1 / 2^Shift.
+template <uint8_t W, uint8_t Shift>
+class StreamFilter {
+ public:
+  static_assert(W >= 1 && W <= 7 && (W & 1), "median window must be odd, 1..7");
+  static_assert(Shift <= 8, "IIR shift out of range");
+
+  int32_t push(int32_t x, int32_t step) {
+    ring_[head_] = x;
+    head_ = head_ + 1 < W ? head_ + 1 : 0;
+    if (count_ < W) {
+      ++count_;
+    }
+    const int32_t m = median();
+    const int32_t diff = m - value();
+    if (!primed_ || Shift == 0 || diff > step || diff < -step) {
+      state_ = m * kOne;
+      primed_ = true;
+    } else {
+      state_ += (m * kOne - state_) / (1 << Shift);
+    }
+    return value();
+  }
+
+  // Latest output (0 before the first push).
+  int32_t value() const {
+    return state_ >= 0 ? (state_ + kOne / 2) / kOne : -((kOne / 2 - state_) / kOne);
+  }
+
+ private:
+  // Fractional bits of the IIR state, so small steps do not stall in the
+  // truncation dead band. Pressure (~100000 Pa) * 256 still fits int32_t.
+  static constexpr int32_t kOne = 256;
+
+  // Insertion sort of at most 7 values: cheaper than anything clever.
+  int32_t median() const {
+    int32_t tmp[W];
+    for (uint8_t i = 0; i < count_; ++i) {
+      const int32_t v = ring_[i];
+      uint8_t j = i;
+      while (j > 0 && tmp[j - 1] > v) {
+        tmp[j] = tmp[j - 1];
+        --j;
+      }
+      tmp[j] = v;
+    }
+    return tmp[count_ / 2];
+  }
+
+  int32_t ring_[W] = {};
+  int32_t state_ = 0;
+  uint8_t head_ = 0;
+  uint8_t count_ = 0;
+  bool primed_ = false;
+};
+
+// Filters the environmental fields of N channels in place.
+template <uint8_t N>
+class SensorSampleFilter {
+ public:
+  void apply(SensorSample *samples) {
+    if (!SENSOR_FILTER_ENABLE) {
+      return;
+    }
+    for (uint8_t ch = 0; ch < N; ++ch) {
+      SensorSample &s = samples[ch];
+      Channel &f = channels_[ch];
+      if (s.caps & kSensorCapTemperature) {
+        s.temperature_cdeg =
+            static_cast<int16_t>(f.temperature.push(s.temperature_cdeg, SENSOR_FILTER_STEP_CDEG));
+      }
+      if (s.caps & kSensorCapHumidity) {
+        s.humidity_df5 =
+            static_cast<uint16_t>(f.humidity.push(s.humidity_df5, SENSOR_FILTER_STEP_HUMIDITY));
+      }
+      if (s.caps & kSensorCapPressure) {
+        s.pressure_pa = static_cast<uint32_t>(
+            f.pressure.push(static_cast<int32_t>(s.pressure_pa), SENSOR_FILTER_STEP_PA));
+      }
+    }
+  }
+
+ private:
+  typedef StreamFilter<SENSOR_FILTER_MEDIAN, SENSOR_FILTER_IIR_SHIFT> Field;
+  struct Channel {
+    Field temperature;
+    Field humidity;
+    Field pressure;
+  };
+  Channel channels_[N];
+};
@@ -1,14 +1,96 @@
 #pragma once
 
 #include <stdint.h>
+#include <math.h>
 
+// Fixed-point sample in DF5-friendly units so the advertising path never
+// touches floats:
+//   temperature_cdeg: 0.01 °C
+//   humidity_df5:     0.0025 %RH (DF5 native, 40000 = 100 %RH)
+//   pressure_pa:      1 Pa (DF5 encodes pressure_pa - 50000)
+// caps marks which measurement fields are real (kSensorCap* bits); the
+// encoders send the format's "not available" value for the others.
 struct SensorSample {
-  float temperature_c;
-  float humidity_rh;
-  float pressure_hpa;
+  int16_t temperature_cdeg;
+  uint16_t humidity_df5;
+  uint32_t pressure_pa;
   uint16_t battery_mv;
   int8_t tx_power_dbm;
   int16_t accel_x_mg;
   int16_t accel_y_mg;
   int16_t accel_z_mg;
+  uint8_t caps;
 };
+
+constexpr uint8_t kSensorCapTemperature = 0x01;
+constexpr uint8_t kSensorCapHumidity = 0x02;
+constexpr uint8_t kSensorCapPressure = 0x04;
+constexpr uint8_t kSensorCapAccel = 0x08;
+constexpr uint8_t kSensorCapEnvironment = kSensorCapTemperature | kSensorCapHumidity | kSensorCapPressure;
+
+// Driver-specific topology (addresses, pin masks) as stored in the NVS cache.
+constexpr uint8_t kSensorTopoLen = 4;
+
+// A sensor driver as seen by the registry (sensor_registry.h). Drivers are
+// header-only; each exposes one constant SensorDriver.
+struct SensorDriver {
+  uint8_t id;    // Stable id, stored in the topology cache
+  const char *name;
+  uint8_t caps;  // kSensorCap* bits this driver measures
+  // Look for the hardware. Fills topo and returns the channel count
+  // (0 = not present).
+  uint8_t (*probe)(uint8_t *topo);
+  // Bring the driver up from a known (cached) topology without probing.
+  // Returns the channel count, 0 if the hardware no longer answers. With
+  // `defer` only channel 0 has to be usable on return; finish() brings up
+  // the rest.
+  uint8_t (*begin)(const uint8_t *topo, bool defer);
+  // Complete a deferred begin(); false if deferred hardware did not answer.
+  // nullptr for drivers that never defer anything.
+  bool (*finish)();
+  // Start a measurement; returns the ms until read() can collect it.
+  uint32_t (*trigger)(uint8_t channel);
+  SensorSample (*read)(uint8_t channel);
+};
+
+constexpr uint16_t kHumidityDf5Full = 40000;  // 100 %RH
+constexpr uint32_t kPressurePaStandard = 101325;
+
+// Saturating float -> fixed-point conversions for drivers whose libraries
+// report floats. A NaN (failed read) maps to a value the range checks in
+// readSensorChannel() reject: INT16_MIN for temperature, 0xFFFF for
+// humidity. Humidity at or below 0 still clamps to 0 %RH.
+inline int16_t sensor_cdeg_from_c(float c) {
+  const float v = c * 100.0f;
+  if (!(v > INT16_MIN)) {
+    return INT16_MIN;
+  }
+  if (v >= INT16_MAX) {
+    return INT16_MAX;
+  }
+  return static_cast<int16_t>(lroundf(v));
+}
+
+inline uint16_t sensor_humidity_df5_from_rh(float rh) {
+  const float v = rh * 400.0f;
+  if (isnan(v)) {
+    return 0xFFFF;
+  }
+  if (v <= 0.0f) {
+    return 0;
+  }
+  if (v >= 65535.0f) {
+    return 0xFFFF;
+  }
+  return static_cast<uint16_t>(lroundf(v));
+}
+
+inline uint32_t sensor_pressure_pa_from_pa(float pa) {
+  if (!(pa > 0.0f)) {
+    return 0;
+  }
+  if (pa >= 16777215.0f) {
+    return 0xFFFFFF;  // Far beyond DF5 range; keeps lroundf() in range.
+  }
+  return static_cast<uint32_t>(lroundf(pa));
+}
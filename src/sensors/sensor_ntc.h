@@ -2,11 +2,17 @@
 
 #include "sensor_interface.h"
 #include <Arduino.h>
-#include "ntc_lut.h"
+#include "adc/adc_cal.h"
+#include "adc/adc_engine.h"
+#include "power/pm_lock.h"
 
 #ifndef NTC_ADC_PIN
 #define NTC_ADC_PIN 1
 #endif
+// One ADC pin per channel (virtual tag), e.g. -DNTC_ADC_PINS="{1,2,3}".
+#ifndef NTC_ADC_PINS
+#define NTC_ADC_PINS {NTC_ADC_PIN}
+#endif
 #ifndef NTC_SERIES_OHMS
 #define NTC_SERIES_OHMS 10000.0f
 #endif
@@ -19,6 +25,65 @@
 #ifndef NTC_BETA
 #define NTC_BETA 3950.0f
 #endif
+// 1 = convert with the generated integer table (src/ntc_table.h),
+// 0 = ADC LUT + Beta equation in float on every read.
+#ifndef NTC_TABLE
+#define NTC_TABLE 1
+#endif
+// Correct the ADC with the chip's eFuse calibration instead of the LUT
+// (when the chip has calibration data). Off by default with a board-specific
+// USE_FULL_NTC_LUT.
+#ifndef NTC_ADC_CAL
+#ifdef USE_FULL_NTC_LUT
+#define NTC_ADC_CAL 0
+#else
+#define NTC_ADC_CAL ADC_CAL_ENABLE
+#endif
+#endif
+// Voltage across the divider (mV), to turn calibrated millivolts into a
+// ratio.
+#ifndef NTC_SUPPLY_MV
+#define NTC_SUPPLY_MV 3300
+#endif
+// 1 = advertise a fixed 50 %RH / 1013.25 hPa next to the temperature, as
+// NTC builds did before fields could be marked not available (for
+// gateways or dashboards that drop frames without them).
+#ifndef NTC_FIXED_ENV
+#define NTC_FIXED_ENV 0
+#endif
+
+#if NTC_FIXED_ENV
+constexpr uint8_t kNtcCaps = kSensorCapEnvironment;
+#else
+constexpr uint8_t kNtcCaps = kSensorCapTemperature;
+#endif
+
+#if NTC_TABLE
+#include "ntc_table.h"
+
+static_assert(NTC_SERIES_OHMS == NTC_TABLE_SERIES_OHMS &&
+                  NTC_NOMINAL_OHMS == NTC_TABLE_NOMINAL_OHMS &&
+                  NTC_NOMINAL_TEMP_C == NTC_TABLE_NOMINAL_TEMP_C &&
+                  NTC_BETA == NTC_TABLE_BETA,
+              "NTC parameters differ from src/ntc_table.h: rerun "
+              "scripts/gen_ntc_table.py with them, or build with NTC_TABLE=0");
+
+// raw16 (ADC counts * 16) -> centi-degrees C: one table step, linear
+// interpolation on the remaining bits.
+template <size_t N>
+inline int16_t ntc_table_lookup(const int16_t (&table)[N], uint8_t step_bits, uint16_t raw16) {
+  const uint8_t shift = step_bits + kAdcFracBits;
+  const uint16_t idx = raw16 >> shift;
+  if (idx >= N - 1) {
+    return table[N - 1];
+  }
+  const int32_t a = table[idx];
+  const int32_t b = table[idx + 1];
+  const int32_t frac = raw16 & ((1u << shift) - 1);
+  return static_cast<int16_t>(a + (b - a) * frac / (1 << shift));
+}
+#else
+#include "ntc_lut.h"
 
 inline uint16_t ntc_linearize_adc(uint16_t raw) {
 #ifdef USE_FULL_NTC_LUT
@@ -36,10 +101,50 @@ inline uint16_t ntc_linearize_adc(uint16_t raw) {
   return base + ((next - base) * rem) / step;
 #endif
 }
+#endif  // NTC_TABLE
 
-inline float ntc_read_celsius() {
-  uint16_t raw = analogRead(NTC_ADC_PIN);
-  uint16_t corrected = ntc_linearize_adc(raw);
+constexpr uint8_t kNtcSensorId = 1;
+static constexpr uint8_t kNtcPins[] = NTC_ADC_PINS;
+constexpr uint8_t kNtcChannelCount = sizeof(kNtcPins) / sizeof(kNtcPins[0]);
+
+// Filtered value from the ADC engine; a single read until it has one.
+inline uint16_t ntc_read_raw16(uint8_t pin) {
+  uint16_t raw16 = 0;
+  if (!adc_engine_read_raw16(pin, raw16)) {
+    PmLock bus(kPmLockBus);
+    raw16 = static_cast<uint16_t>(analogRead(pin) << kAdcFracBits);
+  }
+  return raw16;
+}
+
+// Calibrated ADC value as an ideal raw16 (ratio of NTC_SUPPLY_MV * 4095 * 16).
+// False without eFuse calibration.
+inline bool ntc_calibrated_raw16(uint16_t raw16, uint16_t &cal16) {
+  uint32_t mv16 = 0;
+  if (!NTC_ADC_CAL || !adc_cal_mv16_from_raw16(raw16, mv16)) {
+    return false;
+  }
+  const uint32_t v = mv16 * 4095u / NTC_SUPPLY_MV;
+  cal16 = static_cast<uint16_t>(v > 0xFFFF ? 0xFFFF : v);
+  return true;
+}
+
+#if NTC_TABLE
+inline int16_t ntc_read_cdeg(uint8_t pin = NTC_ADC_PIN) {
+  const uint16_t raw16 = ntc_read_raw16(pin);
+  uint16_t cal16 = 0;
+  if (ntc_calibrated_raw16(raw16, cal16)) {
+    return ntc_table_lookup(kNtcTableCal, kNtcTableCalStepBits, cal16);
+  }
+  return ntc_table_lookup(kNtcTable, kNtcTableStepBits, raw16);
+}
+#else
+inline float ntc_read_celsius(uint8_t pin = NTC_ADC_PIN) {
+  const uint16_t raw16 = ntc_read_raw16(pin);
+  uint16_t cal16 = 0;
+  uint16_t corrected = ntc_calibrated_raw16(raw16, cal16)
+                           ? adc_raw12_from_raw16(cal16)
+                           : ntc_linearize_adc(adc_raw12_from_raw16(raw16));
   float voltage_ratio = corrected / 4095.0f;
   float resistance = NTC_SERIES_OHMS * voltage_ratio / (1.0f - voltage_ratio + 1e-6f);
   float steinhart = resistance / NTC_NOMINAL_OHMS;
@@ -50,21 +155,53 @@ inline float ntc_read_celsius() {
   return steinhart - 273.15f;
 }
 
-inline bool sensor_init() {
-  pinMode(NTC_ADC_PIN, INPUT);
-  return true;
+inline int16_t ntc_read_cdeg(uint8_t pin = NTC_ADC_PIN) {
+  return sensor_cdeg_from_c(ntc_read_celsius(pin));
+}
+#endif
+
+// A divider on an ADC pin cannot be told apart from a floating pin, so every
+// configured pin counts as present.
+inline uint8_t ntc_sensor_begin(const uint8_t *, bool) {
+  for (uint8_t i = 0; i < kNtcChannelCount; ++i) {
+    pinMode(kNtcPins[i], INPUT);
+    adc_engine_add(kNtcPins[i]);
+  }
+  return kNtcChannelCount;
+}
+
+inline uint8_t ntc_sensor_probe(uint8_t *topo) {
+  topo[0] = kNtcChannelCount;
+  return ntc_sensor_begin(topo, false);
+}
+
+// Synchronous driver: nothing to start ahead of ntc_sensor_read().
+inline uint32_t ntc_sensor_trigger(uint8_t) {
+  return 0;
 }
 
-inline SensorSample sensor_read() {
+inline SensorSample ntc_sensor_read(uint8_t channel) {
   SensorSample s{
-      .temperature_c = ntc_read_celsius(),
-      .humidity_rh = 50.0f,
-      .pressure_hpa = 1013.25f,
+      .temperature_cdeg = ntc_read_cdeg(kNtcPins[channel]),
+      .humidity_df5 = NTC_FIXED_ENV ? kHumidityDf5Full / 2 : 0,
+      .pressure_pa = NTC_FIXED_ENV ? kPressurePaStandard : 0,
       .battery_mv = 0,
       .tx_power_dbm = 0,
       .accel_x_mg = 0,
       .accel_y_mg = 0,
       .accel_z_mg = 0,
+      .caps = kNtcCaps,
   };
   return s;
 }
+
+constexpr SensorDriver kNtcSensorDriver = {
+    kNtcSensorId,
+    "ntc",
+    kNtcCaps,
+    ntc_sensor_probe,
+    ntc_sensor_begin,
+    nullptr,
+    ntc_sensor_trigger,
+    ntc_sensor_read,
+};
@@ -0,0 +1,253 @@
+#pragma once
+
+#include <Preferences.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "sensor_interface.h"
+
+// Runtime sensor registry.
+//
+// Several drivers can be built into one image. At boot the registry brings
+// up the topology cached in NVS (no probing), or, when there is no valid
+// cache or a cached sensor no longer answers, probes every driver in order
+// and caches what it found. The channels of all active drivers are numbered
+// consecutively: channel 0 is the first channel of the first driver found.
+//
+// A fallback driver (fake data) is used when nothing is found; it is never
+// cached, so a sensor plugged in later is found on the next boot.
+//
+// A cached bring-up can be split (fast boot): sensor_registry_init() with
+// `defer` brings up only what channel 0 needs, and sensor_registry_finish()
+// the rest once the first advertisement is out. Until then the other
+// channels read as "not available".
+
+// Cache the detected topology in NVS so later boots skip probing.
+#ifndef SENSOR_TOPOLOGY_CACHE
+#define SENSOR_TOPOLOGY_CACHE 1
+#endif
+
+constexpr uint8_t kSensorRegistryMax = 4;  // Active drivers
+constexpr uint8_t kSensorTopologyVersion = 1;
+
+// NVS blob ("sensors"/"topo").
+struct SensorTopology {
+  uint8_t version;
+  uint8_t count;
+  uint8_t id[kSensorRegistryMax];
+  uint8_t topo[kSensorRegistryMax][kSensorTopoLen];
+};
+
+static const SensorDriver *gSensorActive[kSensorRegistryMax] = {};
+static uint8_t gSensorActiveChannels[kSensorRegistryMax] = {};
+static uint8_t gSensorActiveCount = 0;
+static uint8_t gSensorChannelTotal = 0;
+static bool gSensorTopologyCached = false;  // Brought up from the NVS cache
+static bool gSensorDeferred = false;        // sensor_registry_finish() has work left
+static SensorTopology gSensorDeferredTopo;
+
+inline bool sensor_topology_load(SensorTopology &t) {
+  Preferences prefs;
+  if (!prefs.begin("sensors", true)) {
+    return false;
+  }
+  const size_t len = prefs.getBytes("topo", &t, sizeof(t));
+  prefs.end();
+  return len == sizeof(t) && t.version == kSensorTopologyVersion &&
+         t.count > 0 && t.count <= kSensorRegistryMax;
+}
+
+inline void sensor_topology_store(const SensorTopology &t) {
+  Preferences prefs;
+  if (!prefs.begin("sensors", false)) {
+    return;
+  }
+  prefs.putBytes("topo", &t, sizeof(t));
+  prefs.end();
+}
+
+inline void sensor_topology_clear() {
+  Preferences prefs;
+  if (!prefs.begin("sensors", false)) {
+    return;
+  }
+  prefs.remove("topo");
+  prefs.end();
+}
+
+inline void sensor_registry_reset() {
+  gSensorActiveCount = 0;
+  gSensorChannelTotal = 0;
+  gSensorTopologyCached = false;
+  gSensorDeferred = false;
+}
+
+inline void sensor_registry_add(const SensorDriver *driver, uint8_t channels) {
+  gSensorActive[gSensorActiveCount] = driver;
+  gSensorActiveChannels[gSensorActiveCount] = channels;
+  gSensorActiveCount++;
+  gSensorChannelTotal += channels;
+}
+
+inline const SensorDriver *sensor_registry_find(const SensorDriver *const *drivers,
+                                                size_t count,
+                                                uint8_t id) {
+  for (size_t i = 0; i < count; ++i) {
+    if (drivers[i]->id == id) {
+      return drivers[i];
+    }
+  }
+  return nullptr;
+}
+
+#if SENSOR_TOPOLOGY_CACHE
+// Bring up every driver of the cached topology (with `defer`, the first
+// one as far as channel 0 needs); false if any is unknown or no longer
+// answers.
+inline bool sensor_registry_begin_cached(const SensorTopology &t,
+                                         const SensorDriver *const *drivers,
+                                         size_t count,
+                                         bool defer) {
+  const uint8_t now = defer ? 1 : t.count;
+  for (uint8_t i = 0; i < now; ++i) {
+    const SensorDriver *driver = sensor_registry_find(drivers, count, t.id[i]);
+    const uint8_t channels = driver ? driver->begin(t.topo[i], defer) : 0;
+    if (channels == 0) {
+      sensor_registry_reset();
+      return false;
+    }
+    sensor_registry_add(driver, channels);
+  }
+  gSensorTopologyCached = true;
+  if (defer) {
+    gSensorDeferred = true;
+    gSensorDeferredTopo = t;
+  }
+  return true;
+}
+#endif
+
+// Returns the total channel count (0 = no sensor and no fallback). `defer`
+// only applies to a cached topology; probing always brings up everything.
+inline uint8_t sensor_registry_init(const SensorDriver *const *drivers,
+                                    size_t count,
+                                    const SensorDriver *fallback,
+                                    bool defer = false) {
+  sensor_registry_reset();
+#if SENSOR_TOPOLOGY_CACHE
+  SensorTopology cached;
+  const bool have_cache = sensor_topology_load(cached);
+  if (have_cache && sensor_registry_begin_cached(cached, drivers, count, defer)) {
+    return gSensorChannelTotal;
+  }
+#else
+  (void)defer;
+#endif
+
+  SensorTopology found;
+  memset(&found, 0, sizeof(found));
+  found.version = kSensorTopologyVersion;
+  for (size_t i = 0; i < count && gSensorActiveCount < kSensorRegistryMax; ++i) {
+    uint8_t topo[kSensorTopoLen] = {};
+    const uint8_t channels = drivers[i]->probe(topo);
+    if (channels == 0) {
+      continue;
+    }
+    found.id[found.count] = drivers[i]->id;
+    memcpy(found.topo[found.count], topo, kSensorTopoLen);
+    found.count++;
+    sensor_registry_add(drivers[i], channels);
+  }
+
+#if SENSOR_TOPOLOGY_CACHE
+  if (found.count > 0) {
+    sensor_topology_store(found);
+  } else if (have_cache) {
+    sensor_topology_clear();
+  }
+#endif
+
+  if (gSensorActiveCount == 0 && fallback != nullptr) {
+    uint8_t topo[kSensorTopoLen] = {};
+    const uint8_t channels = fallback->probe(topo);
+    if (channels > 0) {
+      sensor_registry_add(fallback, channels);
+    }
+  }
+  return gSensorChannelTotal;
+}
+
+// Bring up what a deferred sensor_registry_init() left out. If part of the
+// cached topology no longer answers, everything is probed again. Call
+// while nothing else reads the sensors (channel numbers can change).
+inline uint8_t sensor_registry_finish(const SensorDriver *const *drivers,
+                                      size_t count,
+                                      const SensorDriver *fallback) {
+  if (!gSensorDeferred) {
+    return gSensorChannelTotal;
+  }
+  gSensorDeferred = false;
+  const SensorTopology &t = gSensorDeferredTopo;
+  bool ok = gSensorActive[0]->finish == nullptr || gSensorActive[0]->finish();
+  for (uint8_t i = 1; ok && i < t.count; ++i) {
+    const SensorDriver *driver = sensor_registry_find(drivers, count, t.id[i]);
+    const uint8_t channels = driver ? driver->begin(t.topo[i], false) : 0;
+    if (channels == 0) {
+      ok = false;
+    } else {
+      sensor_registry_add(driver, channels);
+    }
+  }
+  return ok ? gSensorChannelTotal : sensor_registry_init(drivers, count, fallback);
+}
+
+// Map a global channel to its driver and the driver's own channel number.
+inline const SensorDriver *sensor_registry_channel(uint8_t channel, uint8_t &local) {
+  for (uint8_t i = 0; i < gSensorActiveCount; ++i) {
+    if (channel < gSensorActiveChannels[i]) {
+      local = channel;
+      return gSensorActive[i];
+    }
+    channel -= gSensorActiveChannels[i];
+  }
+  return nullptr;
+}
+
+inline uint32_t sensor_registry_trigger(uint8_t channel) {
+  uint8_t local = 0;
+  const SensorDriver *driver = sensor_registry_channel(channel, local);
+  return driver ? driver->trigger(local) : 0;
+}
+
+// A channel without a sensor reads as a sample with no capabilities, which
+// the encoders send as "not available".
+inline SensorSample sensor_registry_read(uint8_t channel) {
+  uint8_t local = 0;
+  const SensorDriver *driver = sensor_registry_channel(channel, local);
+  if (driver == nullptr) {
+    SensorSample none;
+    memset(&none, 0, sizeof(none));
+    return none;
+  }
+  return driver->read(local);
+}
+
+inline uint8_t sensor_registry_caps(uint8_t channel) {
+  uint8_t local = 0;
+  const SensorDriver *driver = sensor_registry_channel(channel, local);
+  return driver ? driver->caps : 0;
+}
+
+// e.g. "env3x2 ntcx1" for logs.
+inline void sensor_registry_describe(char *buf, size_t len) {
+  size_t n = 0;
+  buf[0] = '\0';
+  for (uint8_t i = 0; i < gSensorActiveCount && n < len; ++i) {
+    const int w = snprintf(buf + n, len - n, "%s%sx%u", i ? " " : "",
+                           gSensorActive[i]->name, gSensorActiveChannels[i]);
+    if (w < 0) {
+      break;
+    }
+    n += static_cast<size_t>(w);
+  }
+}
@@ -4,23 +4,93 @@
 #define SENSOR_PROFILE_FAKE 0
 #define SENSOR_PROFILE_NTC 1
 #define SENSOR_PROFILE_ENV3 2
+#define SENSOR_PROFILE_AUTO 3  // All drivers built in; detect at boot
 
 #ifndef SENSOR_PROFILE
 #define SENSOR_PROFILE SENSOR_PROFILE_FAKE
 #endif
 
-#if SENSOR_PROFILE == SENSOR_PROFILE_ENV3
+// AUTO: also bring up the NTC driver. ADC pins cannot be probed, so this
+// assumes the configured NTC_ADC_PINS are wired.
+#ifndef SENSOR_AUTO_NTC
+#define SENSOR_AUTO_NTC 0
+#endif
+
+#include "sensor_registry.h"
+
+#if SENSOR_PROFILE == SENSOR_PROFILE_AUTO
 #include "sensor_env3.h"
+#include "sensor_ntc.h"
+#include "sensor_fake.h"
+static const SensorDriver *const kSensorDrivers[] = {
+    &kEnv3SensorDriver,
+#if SENSOR_AUTO_NTC
+    &kNtcSensorDriver,
+#endif
+};
+static const SensorDriver *const kSensorFallbackDriver = &kFakeSensorDriver;
+constexpr uint8_t kSensorDetectedMax = kEnv3ChannelCount + (SENSOR_AUTO_NTC ? kNtcChannelCount : 0);
+constexpr uint8_t kSensorChannelCount =
+    kSensorDetectedMax > kFakeChannelCount ? kSensorDetectedMax : kFakeChannelCount;
+#elif SENSOR_PROFILE == SENSOR_PROFILE_ENV3
+#include "sensor_env3.h"
+static const SensorDriver *const kSensorDrivers[] = {&kEnv3SensorDriver};
+static const SensorDriver *const kSensorFallbackDriver = nullptr;
+constexpr uint8_t kSensorChannelCount = kEnv3ChannelCount;
 #elif SENSOR_PROFILE == SENSOR_PROFILE_NTC
 #include "sensor_ntc.h"
+static const SensorDriver *const kSensorDrivers[] = {&kNtcSensorDriver};
+static const SensorDriver *const kSensorFallbackDriver = nullptr;
+constexpr uint8_t kSensorChannelCount = kNtcChannelCount;
 #else
 #include "sensor_fake.h"
+static const SensorDriver *const kSensorDrivers[] = {&kFakeSensorDriver};
+static const SensorDriver *const kSensorFallbackDriver = nullptr;
+constexpr uint8_t kSensorChannelCount = kFakeChannelCount;
 #endif
 
-inline bool sensors_init() {
-  return sensor_init();
+// kSensorChannelCount is the most channels the built-in drivers can provide;
+// sensors_channel_count() is what was found at boot. Channel 0 is the
+// single-tag default.
+//
+// Drivers with slow conversions are split-phase: sensors_trigger() starts a
+// measurement and returns how long (ms) it needs; sensors_read() after that
+// collects it without blocking. Without a trigger, sensors_read() measures
+// synchronously.
+//
+// sensors_init(true) brings up only channel 0 from a cached topology;
+// sensors_finish_init() does the rest (see sensor_registry.h).
+inline bool sensors_init(bool defer = false) {
+  return sensor_registry_init(kSensorDrivers,
+                              sizeof(kSensorDrivers) / sizeof(kSensorDrivers[0]),
+                              kSensorFallbackDriver,
+                              defer) > 0;
+}
+
+inline bool sensors_finish_init() {
+  return sensor_registry_finish(kSensorDrivers,
+                                sizeof(kSensorDrivers) / sizeof(kSensorDrivers[0]),
+                                kSensorFallbackDriver) > 0;
+}
+
+inline uint8_t sensors_channel_count() {
+  return gSensorChannelTotal;
+}
+
+// True if this boot used the cached topology instead of probing.
+inline bool sensors_topology_cached() {
+  return gSensorTopologyCached;
+}
+
+// kSensorCap* bits the sensor on `channel` measures.
+inline uint8_t sensors_caps(uint8_t channel = 0) {
+  return sensor_registry_caps(channel);
+}
+
+inline uint32_t sensors_trigger(uint8_t channel = 0) {
+  return sensor_registry_trigger(channel);
 }
 
-inline SensorSample sensors_read() {
-  return sensor_read();
+inline SensorSample sensors_read(uint8_t channel = 0) {
+  return sensor_registry_read(channel);
 }
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <Arduino.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <esp_timer.h>
+
+// Boot timeline: setup() stamps the end of each init stage with the CPU
+// cycle counter,
+//
+//   boot_mark("ble");  // NimBLEDevice::init() done
+//
+// and boot_timeline_format() turns the marks into one compact line:
+//
+//   setup@<ms> board=<ms>/<kcycles> ble=<ms>/<kcycles> ...
+//
+// "setup@" is when the first mark was taken (app start to setup()); every
+// stage after it is the time since the previous mark. The cycle counter
+// runs at the CPU clock, which changes during boot (board_init_late(),
+// DFS), so each mark also keeps the esp_timer time; the milliseconds
+// compare stages, the cycles show the CPU work inside them. A stage must
+// stay below one counter wrap (17 s at 240 MHz).
+
+#ifndef BOOT_TIMELINE
+#define BOOT_TIMELINE 1
+#endif
+
+constexpr uint8_t kBootMarksMax = 16;
+
+struct BootMark {
+  const char *label;  // Stage that ended here (string literal)
+  uint32_t cycles;
+  uint32_t us;        // esp_timer_get_time()
+};
+
+static BootMark gBootMarks[kBootMarksMax];
+static uint8_t gBootMarkCount = 0;
+
+inline void boot_mark(const char *label) {
+#if BOOT_TIMELINE
+  if (gBootMarkCount < kBootMarksMax) {
+    BootMark &m = gBootMarks[gBootMarkCount++];
+    m.cycles = ESP.getCycleCount();
+    m.us = static_cast<uint32_t>(esp_timer_get_time());
+    m.label = label;
+  }
+#else
+  (void)label;
+#endif
+}
+
+// Writes the timeline into buf (truncated to len); returns false without
+// marks.
+inline bool boot_timeline_format(char *buf, size_t len) {
+  if (gBootMarkCount == 0 || len == 0) {
+    return false;
+  }
+  size_t n = 0;
+  int w = snprintf(buf, len, "setup@%lums", static_cast<unsigned long>(gBootMarks[0].us / 1000));
+  for (uint8_t i = 1; i < gBootMarkCount && w >= 0 && n + w < len; ++i) {
+    n += static_cast<size_t>(w);
+    const BootMark &prev = gBootMarks[i - 1];
+    const BootMark &m = gBootMarks[i];
+    const uint32_t us = m.us - prev.us;
+    w = snprintf(buf + n, len - n, " %s=%lu.%lums/%luk",
+                 m.label,
+                 static_cast<unsigned long>(us / 1000),
+                 static_cast<unsigned long>((us / 100) % 10),
+                 static_cast<unsigned long>((m.cycles - prev.cycles) / 1000));
+  }
+  return true;
+}
@@ -0,0 +1,180 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Fixed-size cycle histograms and the binary report record for the
+// hot-path profiler (util/cycle_profiler.h).
+//
+// Buckets are log-linear: values below 4 get their own bucket, above that
+// every power of two is split into 4 equal buckets, so a bucket spans at
+// most a quarter of its lower bound and the whole uint32_t range fits in
+// 124 buckets. Percentiles are read back as the upper bound of the bucket
+// the rank falls into (capped at the exact maximum), so they err high by
+// at most 25%. Min, max and the sum (for the average) are exact.
+//
+// Report record, little-endian:
+//
+//   "PROF" u8 version u8 stages u32 window_ms u16 cpu_mhz
+//   per stage:
+//     u8 name_len, name, u32 count, u32 min, u32 max, u64 sum,
+//     u8 buckets_used, then (u8 bucket, u16 count) per used bucket
+//   u16 Fletcher-16 over everything after the magic
+//
+// scripts/prof_decode.py finds records in a raw serial capture and renders
+// the report; its --self-test compiles this header on the host.
+
+constexpr uint8_t kCycleHistBuckets = 124;
+constexpr uint8_t kCycleRecordVersion = 1;
+
+inline uint8_t cycle_hist_bucket(uint32_t v) {
+  if (v < 4) {
+    return static_cast<uint8_t>(v);
+  }
+  const uint8_t msb = static_cast<uint8_t>(31 - __builtin_clz(v));
+  return static_cast<uint8_t>((msb - 1) * 4 + ((v >> (msb - 2)) & 3));
+}
+
+// Smallest value that falls into bucket b.
+inline uint32_t cycle_hist_bucket_low(uint8_t b) {
+  if (b < 4) {
+    return b;
+  }
+  return static_cast<uint32_t>(4 + b % 4) << (b / 4 - 1);
+}
+
+// Largest value that falls into bucket b.
+inline uint32_t cycle_hist_bucket_high(uint8_t b) {
+  return b + 1 < kCycleHistBuckets ? cycle_hist_bucket_low(b + 1) - 1 : UINT32_MAX;
+}
+
+struct CycleHist {
+  uint32_t count;
+  uint32_t min;
+  uint32_t max;
+  uint64_t sum;
+  uint16_t buckets[kCycleHistBuckets];  // Saturating
+
+  void reset() { *this = CycleHist(); }
+
+  void add(uint32_t cycles) {
+    if (count == 0 || cycles < min) {
+      min = cycles;
+    }
+    if (cycles > max) {
+      max = cycles;
+    }
+    ++count;
+    sum += cycles;
+    uint16_t &b = buckets[cycle_hist_bucket(cycles)];
+    if (b != UINT16_MAX) {
+      ++b;
+    }
+  }
+
+  // Upper bound of the value at `permille` (e.g. 990 for p99).
+  uint32_t percentile(uint16_t permille) const {
+    if (count == 0) {
+      return 0;
+    }
+    const uint64_t rank = (uint64_t(count) * permille + 999) / 1000;
+    uint64_t seen = 0;
+    for (uint8_t b = 0; b < kCycleHistBuckets; ++b) {
+      seen += buckets[b];
+      if (seen >= rank) {
+        const uint32_t high = cycle_hist_bucket_high(b);
+        return high < max ? high : max;
+      }
+    }
+    return max;
+  }
+};
+
+// Largest record for `stages` stages with names up to `name_max` chars.
+constexpr size_t cycle_record_max(uint8_t stages, uint8_t name_max) {
+  return 12 + stages * (1 + name_max + 20 + 1 + 3 * size_t(kCycleHistBuckets)) + 2;
+}
+
+// Writes one report record into a caller-provided buffer:
+//
+//   CycleRecordWriter w(buf, sizeof(buf));
+//   w.begin(stages, window_ms, cpu_mhz);
+//   w.stage("loop", hist);  // once per stage
+//   const size_t n = w.finish();  // 0 if the buffer was too small
+class CycleRecordWriter {
+ public:
+  CycleRecordWriter(uint8_t *buf, size_t cap) : buf_(buf), cap_(cap) {}
+
+  void begin(uint8_t stages, uint32_t window_ms, uint16_t cpu_mhz) {
+    n_ = 0;
+    ok_ = true;
+    put8('P');
+    put8('R');
+    put8('O');
+    put8('F');
+    put8(kCycleRecordVersion);
+    put8(stages);
+    put32(window_ms);
+    put16(cpu_mhz);
+  }
+
+  void stage(const char *name, const CycleHist &h) {
+    uint8_t len = 0;
+    while (name[len] != '\0' && len < UINT8_MAX) {
+      ++len;
+    }
+    put8(len);
+    for (uint8_t i = 0; i < len; ++i) {
+      put8(static_cast<uint8_t>(name[i]));
+    }
+    put32(h.count);
+    put32(h.min);
+    put32(h.max);
+    put32(static_cast<uint32_t>(h.sum));
+    put32(static_cast<uint32_t>(h.sum >> 32));
+    uint8_t used = 0;
+    for (uint8_t b = 0; b < kCycleHistBuckets; ++b) {
+      used += h.buckets[b] != 0;
+    }
+    put8(used);
+    for (uint8_t b = 0; b < kCycleHistBuckets; ++b) {
+      if (h.buckets[b] != 0) {
+        put8(b);
+        put16(h.buckets[b]);
+      }
+    }
+  }
+
+  size_t finish() {
+    uint16_t s1 = 0;
+    uint16_t s2 = 0;
+    for (size_t i = 4; i < n_ && ok_; ++i) {
+      s1 = (s1 + buf_[i]) % 255;
+      s2 = (s2 + s1) % 255;
+    }
+    put16(static_cast<uint16_t>(s2 << 8 | s1));
+    return ok_ ? n_ : 0;
+  }
+
+ private:
+  void put8(uint8_t v) {
+    if (n_ < cap_) {
+      buf_[n_++] = v;
+    } else {
+      ok_ = false;
+    }
+  }
+  void put16(uint16_t v) {
+    put8(static_cast<uint8_t>(v));
+    put8(static_cast<uint8_t>(v >> 8));
+  }
+  void put32(uint32_t v) {
+    put16(static_cast<uint16_t>(v));
+    put16(static_cast<uint16_t>(v >> 16));
+  }
+
+  uint8_t *buf_;
+  size_t cap_;
+  size_t n_ = 0;
+  bool ok_ = true;
+};
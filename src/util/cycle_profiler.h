@@ -0,0 +1,130 @@
+#pragma once
+
+#include <Arduino.h>
+#include <stdint.h>
+#include <freertos/FreeRTOS.h>
+
+#include "power/power_mgmt.h"
+#include "util/cycle_hist.h"
+
+// Hot-path profiler (opt-in, CYCLE_PROFILER=1).
+//
+// Each stage of the sensor and advertising path is timed with the CPU
+// cycle counter,
+//
+//   { PROF_SCOPE(kProfLcd); board_debug_refresh(...); }
+//
+// or, where a scope does not fit, prof_now() / prof_record(). Every stage
+// keeps count, min, max, sum and a log-linear histogram (util/cycle_hist.h)
+// for the current window. Every CYCLE_PROFILER_DUMP_MS, loop() writes the
+// window out as one binary record on the serial port and starts the next;
+// scripts/prof_decode.py turns a raw capture into min/avg/p50/p99/max per
+// stage.
+//
+// The counts are elapsed cycles on the core the stage ran on: preemption
+// and blocking inside a scope count too, and so does the clock the stage
+// ran at (the advertising and LCD stages hold the CPU lock, bus work the
+// APB lock; see power/pm_lock.h). The record carries PM_MAX_FREQ_MHZ for
+// the decoder's microsecond column. A stage must stay below one counter
+// wrap (17 s at 240 MHz).
+//
+// With CYCLE_PROFILER=0 (default) the scopes expand to nothing and
+// prof_now() / prof_record() are empty inline functions: no code, no RAM.
+
+#ifndef CYCLE_PROFILER
+#define CYCLE_PROFILER 0
+#endif
+#ifndef CYCLE_PROFILER_DUMP_MS
+#define CYCLE_PROFILER_DUMP_MS 60000
+#endif
+
+enum ProfStage : uint8_t {
+  kProfLoop = 0,        // One loop() pass, wait excluded
+  kProfSensorRead = 1,  // readAllChannels(): drivers and board fields
+  kProfFilter = 2,      // filterSamples()
+  kProfBattery = 3,     // Battery read and USB trend detection
+  kProfMotion = 4,      // IMU FIFO drain and motion classifier
+  kProfPayload = 5,     // Ruuvi payload encode / frame patch
+  kProfAdvHost = 6,     // NimBLE calls: data push, stop/start
+  kProfLcd = 7,         // board_debug_refresh()
+  kProfStatus = 8,      // [STATUS] block (serial formatting)
+  kProfStages = 9,
+};
+
+#if CYCLE_PROFILER
+
+static const char *const kProfStageNames[kProfStages] = {
+    "loop", "sensor_read", "filter", "battery", "motion", "payload", "adv_host", "lcd", "status",
+};
+
+static portMUX_TYPE gProfMux = portMUX_INITIALIZER_UNLOCKED;
+static CycleHist gProfHist[kProfStages];
+static uint32_t gProfWindowMs = 0;  // millis() at the start of the window
+static uint8_t gProfRecord[cycle_record_max(kProfStages, 11)];
+
+inline uint32_t prof_now() {
+  return ESP.getCycleCount();
+}
+
+// Stages are recorded from loop() and the sensor task, which run on
+// different cores; the critical section keeps each update whole.
+inline void prof_record(ProfStage stage, uint32_t cycles) {
+  portENTER_CRITICAL(&gProfMux);
+  gProfHist[stage].add(cycles);
+  portEXIT_CRITICAL(&gProfMux);
+}
+
+class ProfScope {
+ public:
+  explicit ProfScope(ProfStage stage) : stage_(stage), t0_(prof_now()) {}
+  ~ProfScope() { prof_record(stage_, prof_now() - t0_); }
+  ProfScope(const ProfScope &) = delete;
+  ProfScope &operator=(const ProfScope &) = delete;
+
+ private:
+  ProfStage stage_;
+  uint32_t t0_;
+};
+
+#define PROF_CONCAT_(a, b) a##b
+#define PROF_CONCAT(a, b) PROF_CONCAT_(a, b)
+#define PROF_SCOPE(stage) ProfScope PROF_CONCAT(prof_scope_, __LINE__)(stage)
+
+// Write the window as one record (a single Serial.write(), so other
+// tasks' log lines cannot split it) and start the next one.
+inline void prof_dump_if_due(uint32_t now_ms) {
+  if (now_ms - gProfWindowMs < CYCLE_PROFILER_DUMP_MS) {
+    return;
+  }
+  CycleRecordWriter w(gProfRecord, sizeof(gProfRecord));
+  w.begin(kProfStages, now_ms - gProfWindowMs, PM_MAX_FREQ_MHZ);
+  gProfWindowMs = now_ms;
+  for (uint8_t i = 0; i < kProfStages; ++i) {
+    CycleHist h;
+    portENTER_CRITICAL(&gProfMux);
+    h = gProfHist[i];
+    gProfHist[i].reset();
+    portEXIT_CRITICAL(&gProfMux);
+    w.stage(kProfStageNames[i], h);
+  }
+  const size_t n = w.finish();
+  if (n > 0) {
+    Serial.write(gProfRecord, n);
+  }
+}
+
+#else
+
+inline uint32_t prof_now() {
+  return 0;
+}
+
+inline void prof_record(ProfStage, uint32_t) {}
+
+#define PROF_SCOPE(stage) \
+  do {                    \
+  } while (0)
+
+inline void prof_dump_if_due(uint32_t) {}
+
+#endif
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <Arduino.h>
+#include <stdint.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include "util/dlog_ring.h"
+
+// Deferred serial logging (opt-in, DEBUG_LOG_DEFERRED=1).
+//
+// Hot-path log lines go through DLOG() instead of Serial.printf():
+//
+//   if (DEBUG_SERIAL) {
+//     DLOG("[ADV] Mode=%s interval=%lums\n", mode_label, adv_interval_ms);
+//   }
+//
+// With DEBUG_LOG_DEFERRED=1 the call only copies the format string's
+// address and the raw arguments into a lock-free ring (util/dlog_ring.h).
+// A task at idle priority drains the ring onto the serial port as binary
+// frames, so the formatting and the wait for the UART leave the caller.
+// scripts/dlog_decode.py turns a raw capture back into text with the
+// format strings from the firmware ELF; other serial output passes through
+// unchanged. Deferred lines come out when the drain task gets to run, so
+// they can trail direct Serial.printf() lines; their frames carry the
+// time of the call.
+//
+// The format must be a string literal. It is checked against the
+// arguments as for printf(). Strings are cut to kDlogStrMax characters and
+// floats sent as single precision.
+//
+// With DEBUG_LOG_DEFERRED=0 (default), DLOG() is Serial.printf().
+
+#ifndef DEBUG_LOG_DEFERRED
+#define DEBUG_LOG_DEFERRED 0
+#endif
+#ifndef DLOG_SLOTS
+#define DLOG_SLOTS 32  // Ring entries (power of two), 80 bytes each
+#endif
+#ifndef DLOG_TASK_STACK
+#define DLOG_TASK_STACK 2048
+#endif
+
+#if DEBUG_LOG_DEFERRED
+
+static DlogRing<DLOG_SLOTS> gDlogRing;
+static TaskHandle_t gDlogTask = nullptr;
+
+inline void dlog_check_format(const char *, ...) __attribute__((format(printf, 1, 2)));
+inline void dlog_check_format(const char *, ...) {}
+
+template <typename... Args>
+inline void dlog_push(const char *fmt, Args... args) {
+  if (gDlogRing.push(fmt, micros(), args...) && gDlogTask != nullptr) {
+    if (xPortInIsrContext()) {
+      BaseType_t woken = pdFALSE;
+      vTaskNotifyGiveFromISR(gDlogTask, &woken);
+      portYIELD_FROM_ISR(woken);
+    } else {
+      xTaskNotifyGive(gDlogTask);
+    }
+  }
+}
+
+#define DLOG(fmt, ...)                            \
+  do {                                            \
+    if (false) {                                  \
+      dlog_check_format(fmt, ##__VA_ARGS__);      \
+    }                                             \
+    dlog_push("" fmt, ##__VA_ARGS__);             \
+  } while (0)
+
+// Runs only when loop() and the sensor task are blocked. A producer wakes
+// it when the ring was drained up to its entry; while a claimed slot is
+// still being written it polls once per tick.
+inline void dlog_task(void *) {
+  static DlogEntry e;
+  static uint8_t frame[kDlogFrameMax];
+  for (;;) {
+    while (gDlogRing.pop(e)) {
+      Serial.write(frame, dlog_frame(e, frame));
+    }
+    const uint32_t dropped = gDlogRing.takeDropped();
+    if (dropped > 0) {
+      Serial.write(frame, dlog_drop_frame(dropped, micros(), frame));
+    }
+    if (gDlogRing.pending()) {
+      vTaskDelay(1);
+    } else {
+      ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+  }
+}
+
+// Start the drain task; call once from setup() after Serial.begin().
+inline bool dlog_begin() {
+  return xTaskCreatePinnedToCore(dlog_task, "dlog", DLOG_TASK_STACK, nullptr, tskIDLE_PRIORITY, &gDlogTask,
+                                 tskNO_AFFINITY) == pdPASS;
+}
+
+#else
+
+inline bool dlog_begin() {
+  return false;
+}
+
+#define DLOG(fmt, ...) Serial.printf(fmt, ##__VA_ARGS__)
+
+#endif
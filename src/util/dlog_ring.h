@@ -0,0 +1,231 @@
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+
+// Lock-free entry ring and binary frame format for deferred logging
+// (util/deferred_log.h).
+//
+// A log call stores the address of its format string, a microsecond
+// timestamp and its arguments in raw form; nothing is formatted on the
+// device. Arguments are packed by their C++ type, little-endian:
+//
+//   integers and enums up to 32 bits   4 bytes
+//   64-bit integers                    8 bytes
+//   float, double                      4 bytes (IEEE single)
+//   strings                            u8 length + up to kDlogStrMax chars
+//
+// The format string says how to read them back, so the host decoder
+// (scripts/dlog_decode.py) needs only the firmware ELF: it looks the
+// address up there. `long` is as wide as a pointer in that ELF.
+//
+// The ring is a bounded multi-producer queue (one sequence number per
+// slot): producers claim a slot with a CAS on the head and publish it by
+// advancing the slot's sequence; the single consumer frees it the same
+// way. No locks, so loop(), the sensor task and the BLE host callbacks can
+// log concurrently. A full ring drops the entry and counts it.
+//
+// Frame on the wire:
+//
+//   0xDB 0x7E u8 len u32 fmt_addr u32 t_us, len argument bytes,
+//   u8 check = ~(sum of the bytes from len on)
+//
+// fmt_addr 0 is a drop report with one u32 argument: entries lost since
+// the last one.
+
+constexpr uint8_t kDlogArgBytes = 64;
+constexpr uint8_t kDlogStrMax = 15;
+constexpr uint8_t kDlogSync0 = 0xDB;
+constexpr uint8_t kDlogSync1 = 0x7E;
+constexpr size_t kDlogFrameMax = 2 + 1 + 4 + 4 + kDlogArgBytes + 1;
+
+struct DlogEntry {
+  const char *fmt;
+  uint32_t t_us;
+  uint8_t len;
+  uint8_t args[kDlogArgBytes];
+};
+
+class DlogArgs {
+ public:
+  explicit DlogArgs(uint8_t *buf) : buf_(buf) {}
+
+  uint8_t size() const { return n_; }
+
+  void put32(uint32_t v) {
+    memcpy(buf_ + n_, &v, 4);  // Little-endian on the ESP32 and the host
+    n_ += 4;
+  }
+  void put64(uint64_t v) {
+    memcpy(buf_ + n_, &v, 8);
+    n_ += 8;
+  }
+  void putFloat(float v) {
+    memcpy(buf_ + n_, &v, 4);
+    n_ += 4;
+  }
+  void putString(const char *s) {
+    uint8_t len = 0;
+    while (s != nullptr && s[len] != '\0' && len < kDlogStrMax) {
+      buf_[n_ + 1 + len] = static_cast<uint8_t>(s[len]);
+      ++len;
+    }
+    buf_[n_] = len;
+    n_ += 1 + len;
+  }
+
+ private:
+  uint8_t *buf_;
+  uint8_t n_ = 0;
+};
+
+template <typename T>
+typename std::enable_if<(std::is_integral<T>::value || std::is_enum<T>::value) && sizeof(T) <= 4>::type
+dlog_put(DlogArgs &a, T v) {
+  a.put32(static_cast<uint32_t>(v));
+}
+
+template <typename T>
+typename std::enable_if<std::is_integral<T>::value && sizeof(T) == 8>::type dlog_put(DlogArgs &a, T v) {
+  a.put64(static_cast<uint64_t>(v));
+}
+
+inline void dlog_put(DlogArgs &a, double v) {
+  a.putFloat(static_cast<float>(v));
+}
+
+inline void dlog_put(DlogArgs &a, const char *s) {
+  a.putString(s);
+}
+
+// Largest encoded size of each argument type, for the compile-time check
+// that a call fits one entry.
+template <typename T>
+constexpr size_t dlog_arg_max() {
+  return std::is_floating_point<T>::value ? 4
+         : std::is_pointer<T>::value      ? 1 + kDlogStrMax
+                                          : (sizeof(T) == 8 ? 8 : 4);
+}
+
+template <typename... Ts>
+struct DlogArgsMax;
+
+template <>
+struct DlogArgsMax<> {
+  static constexpr size_t value = 0;
+};
+
+template <typename T, typename... Ts>
+struct DlogArgsMax<T, Ts...> {
+  static constexpr size_t value = dlog_arg_max<typename std::decay<T>::type>() + DlogArgsMax<Ts...>::value;
+};
+
+template <uint32_t kSlots>
+class DlogRing {
+  static_assert(kSlots >= 2 && (kSlots & (kSlots - 1)) == 0, "DLOG_SLOTS must be a power of two");
+
+ public:
+  DlogRing() {
+    for (uint32_t i = 0; i < kSlots; ++i) {
+      slots_[i].seq.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  // Encode and enqueue one entry. Returns true if the consumer may be
+  // waiting for it (it was at this entry), i.e. needs a wakeup; a full
+  // ring drops the entry.
+  template <typename... Args>
+  bool push(const char *fmt, uint32_t t_us, Args... args) {
+    static_assert(DlogArgsMax<Args...>::value <= kDlogArgBytes, "too many arguments for one deferred log entry");
+    uint32_t pos = head_.load(std::memory_order_relaxed);
+    Slot *s;
+    for (;;) {
+      s = &slots_[pos & (kSlots - 1)];
+      const int32_t diff = static_cast<int32_t>(s->seq.load(std::memory_order_acquire) - pos);
+      if (diff == 0) {
+        if (head_.compare_exchange_weak(pos, pos + 1)) {
+          break;
+        }
+      } else if (diff < 0) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+      } else {
+        pos = head_.load(std::memory_order_relaxed);
+      }
+    }
+    s->e.fmt = fmt;
+    s->e.t_us = t_us;
+    DlogArgs a(s->e.args);
+    const int expand[] = {0, (dlog_put(a, args), 0)...};
+    (void)expand;
+    s->e.len = a.size();
+    s->seq.store(pos + 1);
+    return tail_.load() == pos;
+  }
+
+  // Consumer only.
+  bool pop(DlogEntry &out) {
+    const uint32_t pos = tail_.load(std::memory_order_relaxed);
+    Slot &s = slots_[pos & (kSlots - 1)];
+    if (s.seq.load() != pos + 1) {
+      return false;
+    }
+    out.fmt = s.e.fmt;
+    out.t_us = s.e.t_us;
+    out.len = s.e.len;
+    memcpy(out.args, s.e.args, s.e.len);
+    s.seq.store(pos + kSlots, std::memory_order_release);
+    tail_.store(pos + 1);
+    return true;
+  }
+
+  // Entries claimed but not consumed yet (some may still be being written).
+  bool pending() const { return head_.load() != tail_.load(); }
+
+  uint32_t takeDropped() { return dropped_.exchange(0, std::memory_order_relaxed); }
+
+ private:
+  struct Slot {
+    std::atomic<uint32_t> seq;
+    DlogEntry e;
+  };
+
+  Slot slots_[kSlots];
+  std::atomic<uint32_t> head_{0};
+  std::atomic<uint32_t> tail_{0};
+  std::atomic<uint32_t> dropped_{0};
+};
+
+inline size_t dlog_frame_finish(uint8_t *out, size_t n) {
+  uint8_t sum = 0;
+  for (size_t i = 2; i < n; ++i) {
+    sum = static_cast<uint8_t>(sum + out[i]);
+  }
+  out[n] = static_cast<uint8_t>(~sum);
+  return n + 1;
+}
+
+inline size_t dlog_frame_header(uint8_t *out, uint8_t len, uint32_t fmt_addr, uint32_t t_us) {
+  out[0] = kDlogSync0;
+  out[1] = kDlogSync1;
+  out[2] = len;
+  memcpy(out + 3, &fmt_addr, 4);
+  memcpy(out + 7, &t_us, 4);
+  return 11;
+}
+
+// One entry as a frame into `out` (kDlogFrameMax bytes); returns its size.
+inline size_t dlog_frame(const DlogEntry &e, uint8_t *out) {
+  size_t n = dlog_frame_header(out, e.len, static_cast<uint32_t>(reinterpret_cast<uintptr_t>(e.fmt)), e.t_us);
+  memcpy(out + n, e.args, e.len);
+  return dlog_frame_finish(out, n + e.len);
+}
+
+inline size_t dlog_drop_frame(uint32_t dropped, uint32_t t_us, uint8_t *out) {
+  const size_t n = dlog_frame_header(out, 4, 0, t_us);
+  memcpy(out + n, &dropped, 4);
+  return dlog_frame_finish(out, n + 4);
+}
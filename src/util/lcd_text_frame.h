@@ -0,0 +1,62 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+// Retained text frame for the debug LCD: the characters currently on
+// screen, row by row, so a refresh can push only the columns that changed
+// instead of clearing and redrawing the whole panel.
+//
+//   uint8_t first, last;
+//   if (frame.update(row, text, first, last)) {
+//     // draw frame.row(row)[first..last] at column `first`
+//   }
+//
+// Rows are padded with spaces to kCols, so a shorter value overwrites the
+// tail of a longer one. After invalidate() (panel cleared or woken) the
+// next update of every row reports it whole.
+
+template <uint8_t kRows, uint8_t kCols>
+class LcdTextFrame {
+ public:
+  LcdTextFrame() { invalidate(); }
+
+  void invalidate() {
+    for (uint8_t r = 0; r < kRows; ++r) {
+      memset(rows_[r], 0, sizeof(rows_[r]));  // Matches no printable text
+    }
+  }
+
+  // Record `text` (cut to kCols) as row `row`. Returns false if the screen
+  // already shows it; otherwise the changed column span [first, last].
+  bool update(uint8_t row, const char *text, uint8_t &first, uint8_t &last) {
+    char padded[kCols];
+    uint8_t n = 0;
+    while (n < kCols && text[n] != '\0') {
+      padded[n] = text[n];
+      ++n;
+    }
+    memset(padded + n, ' ', kCols - n);
+    uint8_t f = 0;
+    while (f < kCols && padded[f] == rows_[row][f]) {
+      ++f;
+    }
+    if (f == kCols) {
+      return false;
+    }
+    uint8_t l = kCols - 1;
+    while (padded[l] == rows_[row][l]) {
+      --l;
+    }
+    memcpy(rows_[row], padded, kCols);
+    first = f;
+    last = l;
+    return true;
+  }
+
+  // Row as on screen, kCols characters, NUL-terminated.
+  const char *row(uint8_t row) const { return rows_[row]; }
+
+ private:
+  char rows_[kRows][kCols + 1];
+};
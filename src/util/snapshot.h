@@ -0,0 +1,46 @@
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+
+// Single-writer, multi-reader snapshot (seqlock).
+//
+// The writer never blocks: publish() bumps the sequence to odd, copies the
+// value and bumps it to even again. Readers copy the value and retry if the
+// sequence was odd or changed meanwhile, so they always get a value from a
+// single publish() and never hold up the writer. Meant for small, trivially
+// copyable values handed from one task (or core) to another.
+template <typename T>
+class SeqlockSnapshot {
+ public:
+  // Only one task may publish.
+  void publish(const T &value) {
+    const uint32_t seq = seq_.load(std::memory_order_relaxed);
+    seq_.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    value_ = value;
+    seq_.store(seq + 2, std::memory_order_release);
+  }
+
+  T read() const {
+    T out;
+    for (;;) {
+      const uint32_t before = seq_.load(std::memory_order_acquire);
+      if (before & 1) {
+        continue;  // Write in progress.
+      }
+      out = value_;
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (seq_.load(std::memory_order_relaxed) == before) {
+        return out;
+      }
+    }
+  }
+
+  // Number of completed publishes (0 = nothing published yet).
+  uint32_t version() const { return seq_.load(std::memory_order_acquire) / 2; }
+
+ private:
+  std::atomic<uint32_t> seq_{0};
+  T value_{};
+};